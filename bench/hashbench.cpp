@@ -0,0 +1,451 @@
+/*
+ * Copyright (C) 2017 Larry Lopez
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to
+ * deal in the Software without restriction, including without limitation the
+ * rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+ * sell copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ */
+
+/*
+ * Throughput and latency of every HashAlgorithm, written as JSON.
+ *
+ *   keegbench [--filter=text] [--min-size=4] [--max-size=1G] [--min-time=0.2]
+ *             [--no-misaligned] [--no-stream] [--out=file.json] [--list]
+ *
+ * Each case hashes one input size from memory, aligned and one byte off, and
+ * through std::istream. The iteration count doubles until a run takes at least
+ * min-time seconds. KEEG_BACKEND forces backends, see BackendRegistry, and the
+ * backends used are listed in the context block.
+ */
+
+#include <keeg/common/backendregistry.hpp>
+#include <keeg/common/cpufeatures.hpp>
+#include <keeg/hashing/checksum/adler32.hpp>
+#include <keeg/hashing/crc/crc32.hpp>
+#include <keeg/hashing/crc/crc64.hpp>
+#include <keeg/hashing/noncryptographic/aphash32.hpp>
+#include <keeg/hashing/noncryptographic/bkdrhash32.hpp>
+#include <keeg/hashing/noncryptographic/djb2hash32.hpp>
+#include <keeg/hashing/noncryptographic/elfhash32.hpp>
+#include <keeg/hashing/noncryptographic/fnv1hash.hpp>
+#include <keeg/hashing/noncryptographic/fnv1ahash.hpp>
+#include <keeg/hashing/noncryptographic/joaathash32.hpp>
+#include <keeg/hashing/noncryptographic/jshash32.hpp>
+#include <keeg/hashing/noncryptographic/pjwhash32.hpp>
+#include <keeg/hashing/noncryptographic/saxhash32.hpp>
+#include <keeg/hashing/noncryptographic/sdbmhash32.hpp>
+#include <keeg/hashing/noncryptographic/siphash.hpp>
+#include <keeg/hashing/noncryptographic/superfasthash32.hpp>
+#include <keeg/hashing/noncryptographic/xxhash32.hpp>
+#include <keeg/hashing/noncryptographic/xxhash64.hpp>
+#include <keeg/hashing/noncryptographic/xxh3.hpp>
+#include <keeg/hashing/cryptographic/hmac.hpp>
+#include <keeg/hashing/cryptographic/md5.hpp>
+#include <keeg/hashing/cryptographic/sha1.hpp>
+#include <keeg/hashing/cryptographic/sha256.hpp>
+#include <keeg/hashing/cryptographic/sha3.hpp>
+#include <keeg/hashing/cryptographic/shake.hpp>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <ctime>
+#include <fstream>
+#include <map>
+#include <functional>
+#include <iostream>
+#include <memory>
+#include <random>
+#include <sstream>
+#include <streambuf>
+#include <string>
+#include <vector>
+
+namespace {
+
+using namespace keeg::hashing;
+
+struct Algorithm
+{
+    std::string name;
+    std::function<std::unique_ptr<HashAlgorithm>()> create;
+};
+
+template<typename T, typename... Args>
+Algorithm algorithm(const std::string &name, Args... args)
+{
+    return { name, [=]() { return std::unique_ptr<HashAlgorithm>(new T(args...)); } };
+}
+
+/// Fixed key for the keyed algorithms, so runs are comparable.
+std::vector<uint8_t> benchKey(const std::size_t &size)
+{
+    std::vector<uint8_t> key(size);
+    for (std::size_t i = 0; i < size; ++i)
+        key[i] = static_cast<uint8_t>(i);
+    return key;
+}
+
+std::vector<Algorithm> algorithms()
+{
+    using namespace checksum;
+    using namespace crc;
+    using namespace noncryptographic;
+    using namespace cryptographic;
+
+    const std::vector<uint8_t> macKey = benchKey(32);
+
+    return {
+        algorithm<Adler32>("Adler32"),
+        algorithm<Crc32>("Crc32"),
+        algorithm<Crc32>("Crc32C", CASTAGNOLI_POLYNOMIAL),
+        algorithm<Crc64>("Crc64"),
+        algorithm<APHash32>("APHash32"),
+        algorithm<BKDRHash32>("BKDRHash32"),
+        algorithm<Djb2Hash32>("Djb2Hash32"),
+        algorithm<ELFHash32>("ELFHash32"),
+        algorithm<Fnv1Hash>("Fnv1Hash32", FnvBits::Bits32),
+        algorithm<Fnv1Hash>("Fnv1Hash64", FnvBits::Bits64),
+        algorithm<Fnv1Hash>("Fnv1Hash128", FnvBits::Bits128),
+        algorithm<Fnv1Hash>("Fnv1Hash256", FnvBits::Bits256),
+        algorithm<Fnv1Hash>("Fnv1Hash512", FnvBits::Bits512),
+        algorithm<Fnv1aHash>("Fnv1aHash32", FnvBits::Bits32),
+        algorithm<Fnv1aHash>("Fnv1aHash64", FnvBits::Bits64),
+        algorithm<Fnv1aHash>("Fnv1aHash128", FnvBits::Bits128),
+        algorithm<Fnv1aHash>("Fnv1aHash256", FnvBits::Bits256),
+        algorithm<Fnv1aHash>("Fnv1aHash512", FnvBits::Bits512),
+        algorithm<JOAATHash32>("JOAATHash32"),
+        algorithm<JSHash32>("JSHash32"),
+        algorithm<PJWHash32>("PJWHash32"),
+        algorithm<Sax>("Sax"),
+        algorithm<SDBMHash32>("SDBMHash32"),
+        algorithm<SipHash24>("SipHash24", benchKey(16)),
+        algorithm<SipHash13>("SipHash13", benchKey(16)),
+        algorithm<HalfSipHash24>("HalfSipHash24", benchKey(8)),
+        algorithm<SuperFastHash32>("SuperFastHash32"),
+        algorithm<XxHash32>("XxHash32"),
+        algorithm<XxHash64>("XxHash64"),
+        algorithm<Xxh3Hash64>("Xxh3Hash64"),
+        algorithm<Xxh3Hash128>("Xxh3Hash128"),
+        algorithm<Md5>("Md5"),
+        algorithm<Sha1>("Sha1"),
+        algorithm<Sha256>("Sha256"),
+        algorithm<Sha3>("Sha3-224", Sha3Bits::Bits224),
+        algorithm<Sha3>("Sha3-256", Sha3Bits::Bits256),
+        algorithm<Sha3>("Sha3-384", Sha3Bits::Bits384),
+        algorithm<Sha3>("Sha3-512", Sha3Bits::Bits512),
+        algorithm<Shake>("Shake128", ShakeBits::Bits128),
+        algorithm<Shake>("Shake256", ShakeBits::Bits256),
+        algorithm<HmacMd5>("HmacMd5", Md5(), macKey),
+        algorithm<HmacSha1>("HmacSha1", Sha1(), macKey),
+        algorithm<HmacSha256>("HmacSha256", Sha256(), macKey),
+        algorithm<HmacSha3>("HmacSha3-256", Sha3(Sha3Bits::Bits256), macKey),
+        algorithm<HmacSha3>("HmacSha3-512", Sha3(Sha3Bits::Bits512), macKey)
+    };
+}
+
+struct Options
+{
+    std::string filter;
+    std::size_t minSize = 4;
+    std::size_t maxSize = std::size_t(1) << 30;
+    double minTime = 0.2;
+    bool misaligned = true;
+    bool stream = true;
+    bool list = false;
+    std::string output;
+};
+
+struct Result
+{
+    std::string algorithm;
+    std::string source;
+    std::size_t size;
+    std::size_t offset;
+    uint64_t iterations;
+    double seconds;
+};
+
+/// Read only stream over memory, so a stream run doesn't also measure a copy of the input.
+class MemoryStreamBuffer : public std::streambuf
+{
+public:
+    MemoryStreamBuffer(const uint8_t *data, const std::size_t &size)
+    {
+        char *begin = const_cast<char*>(reinterpret_cast<const char*>(data));
+        setg(begin, begin, begin + size);
+    }
+
+protected:
+    virtual pos_type seekoff(off_type offset, std::ios_base::seekdir direction, std::ios_base::openmode) override
+    {
+        char *position = (direction == std::ios_base::beg) ? eback() :
+                         (direction == std::ios_base::cur) ? gptr() : egptr();
+        position += offset;
+        if (position < eback() || position > egptr())
+            return pos_type(off_type(-1));
+
+        setg(eback(), position, egptr());
+        return pos_type(position - eback());
+    }
+
+    virtual pos_type seekpos(pos_type position, std::ios_base::openmode mode) override
+    {
+        return seekoff(off_type(position), std::ios_base::beg, mode);
+    }
+};
+
+/// 4, 16, 64 ... up to maxSize, maxSize included even when it isn't a power of four.
+std::vector<std::size_t> inputSizes(const Options &options)
+{
+    std::vector<std::size_t> sizes;
+    for (std::size_t size = 4; size < options.maxSize && size <= (std::size_t(1) << 62); size *= 4)
+    {
+        if (size >= options.minSize)
+            sizes.push_back(size);
+    }
+
+    if (options.maxSize >= options.minSize)
+        sizes.push_back(options.maxSize);
+
+    return sizes;
+}
+
+uint8_t g_sink = 0;
+
+/// Runs one case, doubling iterations until minTime. Calling run once is one iteration.
+template<typename Run>
+void measure(const Options &options, const Run &run, uint64_t &iterations, double &seconds)
+{
+    using Clock = std::chrono::steady_clock;
+
+    run();
+    iterations = 1;
+    for (;;)
+    {
+        const Clock::time_point start = Clock::now();
+        for (uint64_t i = 0; i < iterations; ++i)
+            run();
+        seconds = std::chrono::duration<double>(Clock::now() - start).count();
+
+        if (seconds >= options.minTime)
+            return;
+
+        // Aim straight for minTime once a run is long enough to time.
+        const double target = seconds > 0.01 ? (options.minTime / seconds) * 1.2 * iterations : iterations * 10.0;
+        iterations = std::max<uint64_t>(iterations + 1, static_cast<uint64_t>(target));
+    }
+}
+
+void runBenchmarks(const Options &options, std::vector<Result> &results)
+{
+    const std::vector<std::size_t> sizes = inputSizes(options);
+    if (sizes.empty())
+        return;
+
+    // One buffer for everything, 64 byte aligned with room for the misaligned runs.
+    const std::size_t largest = sizes.back();
+    std::unique_ptr<uint8_t[]> storage(new uint8_t[largest + 128]);
+    uint8_t *buffer = storage.get() + (64 - reinterpret_cast<uintptr_t>(storage.get()) % 64);
+    std::mt19937_64 random(42);
+    for (std::size_t i = 0; i < largest + 64; i += 8)
+    {
+        const uint64_t value = random();
+        std::memcpy(buffer + i, &value, std::min<std::size_t>(8, largest + 64 - i));
+    }
+
+    const std::vector<Algorithm> list = algorithms();
+    for (const Algorithm &entry : list)
+    {
+        if (!options.filter.empty() && entry.name.find(options.filter) == std::string::npos)
+            continue;
+
+        std::unique_ptr<HashAlgorithm> hash = entry.create();
+        uint8_t digest[64];
+
+        for (const std::size_t &size : sizes)
+        {
+            for (std::size_t offset = 0; offset <= (options.misaligned ? 1u : 0u); ++offset)
+            {
+                Result result { entry.name, "memory", size, offset, 0, 0.0 };
+                const uint8_t *data = buffer + offset;
+                measure(options, [&]() {
+                    hash->computeHash(data, size, digest, sizeof(digest));
+                    g_sink ^= digest[0];
+                }, result.iterations, result.seconds);
+                results.push_back(result);
+                std::cerr << entry.name << " memory " << size << " +" << offset << std::endl;
+            }
+
+            if (options.stream)
+            {
+                Result result { entry.name, "stream", size, 0, 0, 0.0 };
+                MemoryStreamBuffer streamBuffer(buffer, size);
+                std::istream stream(&streamBuffer);
+                measure(options, [&]() {
+                    stream.clear();
+                    const std::vector<uint8_t> value = hash->computeHash(stream);
+                    g_sink ^= value.empty() ? 0 : value[0];
+                }, result.iterations, result.seconds);
+                results.push_back(result);
+                std::cerr << entry.name << " stream " << size << std::endl;
+            }
+        }
+    }
+}
+
+void writeJson(std::ostream &out, const std::vector<Result> &results)
+{
+    const keeg::common::CpuFeatures &features = keeg::common::cpuFeatures();
+    const std::time_t now = std::time(nullptr);
+    char date[32];
+    std::strftime(date, sizeof(date), "%Y-%m-%dT%H:%M:%SZ", std::gmtime(&now));
+
+    out << "{\n  \"context\": {\n";
+    out << "    \"date\": \"" << date << "\",\n";
+    out << "    \"pointer_bits\": " << sizeof(void*) * 8 << ",\n";
+    out << "    \"cpu_features\": {"
+        << " \"ssse3\": " << features.ssse3 << ", \"sse41\": " << features.sse41
+        << ", \"sse42\": " << features.sse42 << ", \"pclmul\": " << features.pclmul
+        << ", \"avx2\": " << features.avx2 << ", \"avx512f\": " << features.avx512f
+        << ", \"avx512bw\": " << features.avx512bw << ", \"avx512vl\": " << features.avx512vl
+        << ", \"bmi1\": " << features.bmi1 << ", \"bmi2\": " << features.bmi2
+        << ", \"sha\": " << features.sha << ", \"neon\": " << features.neon
+        << ", \"arm_crc32\": " << features.armCrc32 << ", \"arm_pmull\": " << features.armPmull
+        << ", \"arm_aes\": " << features.armAes << ", \"arm_sha2\": " << features.armSha2 << " },\n";
+
+    out << "    \"backends\": {";
+    const std::map<std::string, std::string> backends = keeg::common::BackendRegistry::instance().selections();
+    for (auto it = backends.begin(); it != backends.end(); ++it)
+        out << (it == backends.begin() ? " \"" : ", \"") << it->first << "\": \"" << it->second << "\"";
+    out << " }\n";
+    out << "  },\n  \"benchmarks\": [\n";
+
+    for (std::size_t i = 0; i < results.size(); ++i)
+    {
+        const Result &r = results[i];
+        const double nanoseconds = r.seconds * 1e9 / static_cast<double>(r.iterations);
+        const double bytesPerSecond = static_cast<double>(r.size) * r.iterations / r.seconds;
+
+        out << "    { \"name\": \"" << r.algorithm << "/" << r.source << "/" << r.size
+            << (r.offset != 0 ? "/misaligned" : "") << "\""
+            << ", \"algorithm\": \"" << r.algorithm << "\""
+            << ", \"source\": \"" << r.source << "\""
+            << ", \"bytes\": " << r.size
+            << ", \"offset\": " << r.offset
+            << ", \"iterations\": " << r.iterations
+            << ", \"latency_ns\": " << nanoseconds
+            << ", \"bytes_per_second\": " << bytesPerSecond << " }"
+            << (i + 1 < results.size() ? ",\n" : "\n");
+    }
+
+    out << "  ]\n}\n";
+}
+
+/// Size with an optional K, M or G suffix, powers of 1024.
+bool parseSize(const std::string &text, std::size_t &size)
+{
+    char *end = nullptr;
+    const unsigned long long value = std::strtoull(text.c_str(), &end, 10);
+    if (end == text.c_str())
+        return false;
+
+    unsigned shift = 0;
+    switch (*end)
+    {
+    case '\0':           break;
+    case 'k': case 'K': shift = 10; ++end; break;
+    case 'm': case 'M': shift = 20; ++end; break;
+    case 'g': case 'G': shift = 30; ++end; break;
+    default:            return false;
+    }
+
+    size = static_cast<std::size_t>(value << shift);
+    return *end == '\0';
+}
+
+bool parseOptions(int argc, char *argv[], Options &options)
+{
+    for (int i = 1; i < argc; ++i)
+    {
+        const std::string argument = argv[i];
+        const std::size_t equals = argument.find('=');
+        const std::string key = argument.substr(0, equals);
+        const std::string value = (equals == std::string::npos) ? std::string() : argument.substr(equals + 1);
+
+        if (key == "--filter")
+            options.filter = value;
+        else if (key == "--min-size" && parseSize(value, options.minSize))
+            continue;
+        else if (key == "--max-size" && parseSize(value, options.maxSize))
+            continue;
+        else if (key == "--min-time" && !value.empty())
+            options.minTime = std::atof(value.c_str());
+        else if (key == "--no-misaligned")
+            options.misaligned = false;
+        else if (key == "--no-stream")
+            options.stream = false;
+        else if (key == "--out" && !value.empty())
+            options.output = value;
+        else if (key == "--list")
+            options.list = true;
+        else
+        {
+            std::cerr << "unknown or invalid option " << argument << "\n"
+                      << "usage: keegbench [--filter=text] [--min-size=4] [--max-size=1G] [--min-time=0.2]\n"
+                      << "                 [--no-misaligned] [--no-stream] [--out=file.json] [--list]\n";
+            return false;
+        }
+    }
+
+    return true;
+}
+
+} // anonymous namespace
+
+int main(int argc, char *argv[])
+{
+    Options options;
+    if (!parseOptions(argc, argv, options))
+        return EXIT_FAILURE;
+
+    if (options.list)
+    {
+        for (const Algorithm &entry : algorithms())
+            std::cout << entry.name << "\n";
+        return EXIT_SUCCESS;
+    }
+
+    std::vector<Result> results;
+    runBenchmarks(options, results);
+
+    if (options.output.empty())
+    {
+        writeJson(std::cout, results);
+    }
+    else
+    {
+        std::ofstream out(options.output);
+        writeJson(out, results);
+        if (!out)
+        {
+            std::cerr << "could not write " << options.output << "\n";
+            return EXIT_FAILURE;
+        }
+    }
+
+    return (g_sink == 0xFF) ? 2 : EXIT_SUCCESS;
+}
@@ -0,0 +1,39 @@
+#-------------------------------------------------
+#
+# Hash benchmarks, writes results as JSON.
+#   keegbench --max-size=64M --out=results.json
+#
+#-------------------------------------------------
+
+QT       -= core gui
+
+TARGET = keegbench
+TEMPLATE = app
+CONFIG += console c++14
+CONFIG -= app_bundle
+
+INCLUDEPATH += ../src $$(BOOST_ROOT)
+
+SOURCES += \
+    hashbench.cpp
+
+unix {
+    LIBS += -pthread
+}
+
+###############################
+## COMPILER SCOPES
+###############################
+
+*msvc* {
+        # Same optimization as the library
+        QMAKE_CXXFLAGS_RELEASE *= /O2 /Ot /Ox /GL
+        QMAKE_CXXFLAGS += -MP
+        QMAKE_LFLAGS_RELEASE += /LTCG
+}
+
+*-g++ {
+        # Same optimization as the library
+        QMAKE_CXXFLAGS_RELEASE += -O3 -mfpmath=sse -std=c++14
+        QMAKE_CXXFLAGS_RELEASE += -msse2 -msse
+}
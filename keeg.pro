@@ -23,24 +23,46 @@ DEFINES += QT_DEPRECATED_WARNINGS
 # You can also select to disable deprecated APIs only up to a certain version of Qt.
 #DEFINES += QT_DISABLE_DEPRECATED_BEFORE=0x060000    # disables all the APIs deprecated before Qt 6.0.0
 
-DEFINES += FNV_USE_BOOST=1
-
 SOURCES += \
 
 HEADERS += \
     src/keeg/common/macrohelpers.hpp \
+    src/keeg/common/backendregistry.hpp \
+    src/keeg/common/cpufeatures.hpp \
+    src/keeg/common/instrumentation.hpp \
     src/keeg/common/enums.hpp \
     src/keeg/common/stringutils.hpp \
     src/keeg/common/stringencoding.hpp \
+    src/keeg/common/arena.hpp \
+    src/keeg/common/threadgroup.hpp \
     src/keeg/endian/conversion.hpp \
+    src/keeg/endian/byteswaparray.hpp \
+    src/keeg/endian/recordswap.hpp \
     src/keeg/io/binaryreaders.hpp \
     src/keeg/io/binarywriters.hpp \
     src/keeg/io/binaryhelpers.hpp \
+    src/keeg/io/mappedfile.hpp \
+    src/keeg/io/memoryreader.hpp \
+    src/keeg/io/views.hpp \
+    src/keeg/io/bufferedwriter.hpp \
     src/keeg/hashing/hashalgorithm.hpp \
+    src/keeg/hashing/hashliterals.hpp \
+    src/keeg/hashing/integerhashalgorithm.hpp \
+    src/keeg/hashing/statichash.hpp \
+    src/keeg/hashing/blockqueue.hpp \
+    src/keeg/hashing/hasherpool.hpp \
+    src/keeg/hashing/batchhash.hpp \
+    src/keeg/hashing/digestcache.hpp \
+    src/keeg/hashing/multihash.hpp \
+    src/keeg/hashing/merkletree.hpp \
     src/keeg/hashing/keyedhashalgorithm.hpp \
     src/keeg/hashing/crc/crc32.hpp \
+    src/keeg/hashing/crc/crc32accelerated.hpp \
     src/keeg/hashing/crc/crc64.hpp \
+    src/keeg/hashing/crc/crctables.hpp \
+    src/keeg/hashing/crc/crccombine.hpp \
     src/keeg/hashing/checksum/adler32.hpp \
+    src/keeg/hashing/checksum/adler32accelerated.hpp \
     src/keeg/hashing/noncryptographic/aphash32.hpp \
     src/keeg/hashing/noncryptographic/bkdrhash32.hpp \
     src/keeg/hashing/noncryptographic/djb2hash32.hpp \
@@ -53,13 +75,22 @@ HEADERS += \
     src/keeg/hashing/noncryptographic/pjwhash32.hpp \
     src/keeg/hashing/noncryptographic/saxhash32.hpp \
     src/keeg/hashing/noncryptographic/sdbmhash32.hpp \
+    src/keeg/hashing/noncryptographic/siphash.hpp \
+    src/keeg/hashing/noncryptographic/stringhashkernels.hpp \
     src/keeg/hashing/noncryptographic/superfasthash32.hpp \
     src/keeg/hashing/noncryptographic/xxhash32.hpp \
     src/keeg/hashing/noncryptographic/xxhash64.hpp \
+    src/keeg/hashing/noncryptographic/xxh3.hpp \
+    src/keeg/hashing/noncryptographic/xxh3accelerated.hpp \
+    src/keeg/hashing/cryptographic/hashmessage.hpp \
+    src/keeg/hashing/cryptographic/hmac.hpp \
+    src/keeg/hashing/cryptographic/keccak.hpp \
     src/keeg/hashing/cryptographic/md5.hpp \
     src/keeg/hashing/cryptographic/sha1.hpp \
     src/keeg/hashing/cryptographic/sha256.hpp \
-    src/keeg/hashing/cryptographic/sha3.hpp
+    src/keeg/hashing/cryptographic/sha256accelerated.hpp \
+    src/keeg/hashing/cryptographic/sha3.hpp \
+    src/keeg/hashing/cryptographic/shake.hpp
 
 unix {
     target.path = /usr/lib
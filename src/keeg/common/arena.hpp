@@ -0,0 +1,241 @@
+/*
+ * Copyright (C) 2017 Larry Lopez
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to
+ * deal in the Software without restriction, including without limitation the
+ * rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+ * sell copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ */
+#ifndef ARENA_HPP
+#define ARENA_HPP
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <memory>
+#include <vector>
+
+/// First block of a MonotonicArena, later blocks double up to ARENA_MAX_BLOCK_SIZE.
+#ifndef ARENA_BLOCK_SIZE
+    #define ARENA_BLOCK_SIZE (64 * 1024)
+#endif
+
+#ifndef ARENA_MAX_BLOCK_SIZE
+    #define ARENA_MAX_BLOCK_SIZE (16 * 1024 * 1024)
+#endif
+
+namespace keeg { namespace common {
+
+/// Bump allocator for data that all dies together, like the fields of a parsed file.
+/// Allocations are never freed one at a time, release() hands every block back at once
+/// and reset() rewinds to reuse the largest block. Not thread safe, use one per thread.
+/// A std::pmr::monotonic_buffer_resource for C++14.
+class MonotonicArena
+{
+public:
+    explicit MonotonicArena(const std::size_t &blockSize = ARENA_BLOCK_SIZE);
+    MonotonicArena(const MonotonicArena &) = delete;
+    MonotonicArena &operator=(const MonotonicArena &) = delete;
+    MonotonicArena(MonotonicArena &&other) noexcept;
+    MonotonicArena &operator=(MonotonicArena &&other) noexcept;
+
+    /// size bytes aligned to alignment, a power of two. Throws std::bad_alloc.
+    void *allocate(const std::size_t &size, const std::size_t &alignment = alignof(std::max_align_t));
+    /// Uninitialized storage for count T, T should be trivially destructible.
+    template<typename T>
+    T *allocateArray(const std::size_t &count);
+    /// Copy of length bytes.
+    void *copy(const void *data, const std::size_t &length, const std::size_t &alignment = 1);
+
+    /// Frees every block, everything allocated is gone.
+    void release();
+    /// Everything allocated is gone but the largest block is kept for the next use.
+    void reset();
+
+    /// Bytes handed out since the last release or reset.
+    std::size_t used() const;
+    /// Bytes held in blocks.
+    std::size_t capacity() const;
+    std::size_t blockCount() const;
+
+private:
+    struct Block
+    {
+        std::unique_ptr<uint8_t[]> data;
+        std::size_t size;
+    };
+
+    std::vector<Block> m_blocks;
+    uint8_t *m_current;
+    std::size_t m_remaining;
+    std::size_t m_blockSize;
+    std::size_t m_nextBlockSize;
+    std::size_t m_used;
+
+    /// Aligned pointer into the current block, nullptr if it doesn't fit.
+    uint8_t *fit(const std::size_t &size, const std::size_t &alignment);
+};
+
+MonotonicArena::MonotonicArena(const std::size_t &blockSize) :
+    m_current(nullptr), m_remaining(0), m_blockSize(std::max<std::size_t>(blockSize, 64)),
+    m_nextBlockSize(m_blockSize), m_used(0)
+{
+}
+
+MonotonicArena::MonotonicArena(MonotonicArena &&other) noexcept :
+    m_blocks(std::move(other.m_blocks)), m_current(other.m_current), m_remaining(other.m_remaining),
+    m_blockSize(other.m_blockSize), m_nextBlockSize(other.m_nextBlockSize), m_used(other.m_used)
+{
+    other.m_blocks.clear();
+    other.m_current = nullptr;
+    other.m_remaining = 0;
+    other.m_nextBlockSize = other.m_blockSize;
+    other.m_used = 0;
+}
+
+MonotonicArena &MonotonicArena::operator=(MonotonicArena &&other) noexcept
+{
+    if (this != &other)
+    {
+        m_blocks = std::move(other.m_blocks);
+        m_current = other.m_current;
+        m_remaining = other.m_remaining;
+        m_blockSize = other.m_blockSize;
+        m_nextBlockSize = other.m_nextBlockSize;
+        m_used = other.m_used;
+
+        other.m_blocks.clear();
+        other.m_current = nullptr;
+        other.m_remaining = 0;
+        other.m_nextBlockSize = other.m_blockSize;
+        other.m_used = 0;
+    }
+
+    return *this;
+}
+
+uint8_t *MonotonicArena::fit(const std::size_t &size, const std::size_t &alignment)
+{
+    if (m_current == nullptr)
+        return nullptr;
+
+    const std::size_t padding = (alignment - (reinterpret_cast<uintptr_t>(m_current) & (alignment - 1))) & (alignment - 1);
+    if (padding > m_remaining || size > m_remaining - padding)
+        return nullptr;
+
+    uint8_t *result = m_current + padding;
+    m_current = result + size;
+    m_remaining -= padding + size;
+    m_used += size;
+    return result;
+}
+
+void *MonotonicArena::allocate(const std::size_t &size, const std::size_t &alignment)
+{
+    uint8_t *result = fit(size, alignment);
+    if (result != nullptr)
+        return result;
+
+    // Room for the worst case padding as well.
+    const std::size_t needed = size + alignment - 1;
+    if (needed > m_nextBlockSize)
+    {
+        // Too big for the block sizes, it gets a block of its own and the current
+        // block stays in use for the small allocations after it.
+        Block block{ std::unique_ptr<uint8_t[]>(new uint8_t[needed]), needed };
+        uint8_t *data = block.data.get();
+        m_blocks.push_back(std::move(block));
+
+        m_used += size;
+        return data + ((alignment - (reinterpret_cast<uintptr_t>(data) & (alignment - 1))) & (alignment - 1));
+    }
+
+    Block block{ std::unique_ptr<uint8_t[]>(new uint8_t[m_nextBlockSize]), m_nextBlockSize };
+    m_current = block.data.get();
+    m_remaining = block.size;
+    m_blocks.push_back(std::move(block));
+    m_nextBlockSize = std::min<std::size_t>(m_nextBlockSize * 2, std::max<std::size_t>(ARENA_MAX_BLOCK_SIZE, m_blockSize));
+
+    return fit(size, alignment);
+}
+
+template<typename T>
+T *MonotonicArena::allocateArray(const std::size_t &count)
+{
+    return static_cast<T*>(allocate(sizeof(T) * count, alignof(T)));
+}
+
+void *MonotonicArena::copy(const void *data, const std::size_t &length, const std::size_t &alignment)
+{
+    void *result = allocate(length, alignment);
+    if (length > 0)
+        std::memcpy(result, data, length);
+    return result;
+}
+
+void MonotonicArena::release()
+{
+    m_blocks.clear();
+    m_blocks.shrink_to_fit();
+    m_current = nullptr;
+    m_remaining = 0;
+    m_nextBlockSize = m_blockSize;
+    m_used = 0;
+}
+
+void MonotonicArena::reset()
+{
+    if (m_blocks.empty())
+        return;
+
+    auto largest = std::max_element(m_blocks.begin(), m_blocks.end(), [](const Block &a, const Block &b)
+    {
+        return a.size < b.size;
+    });
+
+    Block kept = std::move(*largest);
+    m_blocks.clear();
+    m_current = kept.data.get();
+    m_remaining = kept.size;
+    m_nextBlockSize = std::min<std::size_t>(std::max(kept.size * 2, m_blockSize),
+                                            std::max<std::size_t>(ARENA_MAX_BLOCK_SIZE, m_blockSize));
+    m_blocks.push_back(std::move(kept));
+    m_used = 0;
+}
+
+std::size_t MonotonicArena::used() const
+{
+    return m_used;
+}
+
+std::size_t MonotonicArena::capacity() const
+{
+    std::size_t total = 0;
+    for (const Block &block : m_blocks)
+        total += block.size;
+    return total;
+}
+
+std::size_t MonotonicArena::blockCount() const
+{
+    return m_blocks.size();
+}
+
+} // common namespace
+} // keeg namespace
+
+#endif // ARENA_HPP
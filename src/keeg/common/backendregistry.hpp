@@ -0,0 +1,208 @@
+/*
+ * Copyright (C) 2017 Larry Lopez
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to
+ * deal in the Software without restriction, including without limitation the
+ * rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+ * sell copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ */
+#ifndef BACKENDREGISTRY_HPP
+#define BACKENDREGISTRY_HPP
+
+#include <atomic>
+#include <cctype>
+#include <cstddef>
+#include <cstdlib>
+#include <map>
+#include <mutex>
+#include <string>
+#include <keeg/common/cpufeatures.hpp>
+
+namespace keeg { namespace common {
+
+/// One implementation of an algorithm for selectBackend, supported when the cpu and the
+/// build both allow it.
+template<typename Backend>
+struct BackendOption
+{
+    Backend backend;
+    const char *name;
+    bool supported;
+};
+
+/// Process wide overrides of the backend selection, for benchmarking and debugging.
+/// Overrides come from setOverride or from the KEEG_BACKEND environment variable, read
+/// at first use, as comma separated algorithm=backend pairs:
+///   KEEG_BACKEND=crc32=table,sha256=scalar,xxh3=sse2
+/// A backend the cpu doesn't support, or an unknown name, is ignored in favour of the
+/// fastest supported one. Every algorithm chooses once for the process, at its first use,
+/// so set overrides before hashing anything.
+class BackendRegistry
+{
+public:
+    static BackendRegistry &instance();
+
+    void setOverride(const std::string &algorithm, const std::string &backend);
+    void clearOverride(const std::string &algorithm);
+    void clearOverrides();
+    /// The forced backend name, empty when there is none.
+    std::string backendOverride(const std::string &algorithm) const;
+
+    /// Records the backend selectBackend chose, see selections.
+    void recordSelection(const std::string &algorithm, const std::string &backend);
+    /// Last backend chosen for every algorithm selected so far.
+    std::map<std::string, std::string> selections() const;
+
+private:
+    BackendRegistry();
+    BackendRegistry(const BackendRegistry&) = delete;
+    BackendRegistry &operator=(const BackendRegistry&) = delete;
+
+    void parseOverrides(const std::string &text);
+
+    mutable std::mutex m_mutex;
+    std::map<std::string, std::string> m_overrides;
+    std::map<std::string, std::string> m_selections;
+    /// Lets backendOverride skip the lock in the usual case of no overrides.
+    std::atomic<bool> m_hasOverrides;
+};
+
+BackendRegistry &BackendRegistry::instance()
+{
+    static BackendRegistry registry;
+    return registry;
+}
+
+BackendRegistry::BackendRegistry() : m_hasOverrides(false)
+{
+    const char *environment = std::getenv("KEEG_BACKEND");
+    if (environment != nullptr)
+        parseOverrides(environment);
+}
+
+void BackendRegistry::setOverride(const std::string &algorithm, const std::string &backend)
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_overrides[algorithm] = backend;
+    m_hasOverrides = true;
+}
+
+void BackendRegistry::clearOverride(const std::string &algorithm)
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_overrides.erase(algorithm);
+    m_hasOverrides = !m_overrides.empty();
+}
+
+void BackendRegistry::clearOverrides()
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_overrides.clear();
+    m_hasOverrides = false;
+}
+
+std::string BackendRegistry::backendOverride(const std::string &algorithm) const
+{
+    if (!m_hasOverrides)
+        return std::string();
+
+    std::lock_guard<std::mutex> lock(m_mutex);
+    const auto found = m_overrides.find(algorithm);
+    return (found != m_overrides.end()) ? found->second : std::string();
+}
+
+void BackendRegistry::recordSelection(const std::string &algorithm, const std::string &backend)
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_selections[algorithm] = backend;
+}
+
+std::map<std::string, std::string> BackendRegistry::selections() const
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return m_selections;
+}
+
+void BackendRegistry::parseOverrides(const std::string &text)
+{
+    std::size_t start = 0;
+    while (start < text.size())
+    {
+        std::size_t end = text.find(',', start);
+        if (end == std::string::npos)
+            end = text.size();
+
+        // algorithm=backend, surrounding spaces ignored
+        std::string entry;
+        for (std::size_t i = start; i < end; ++i)
+        {
+            if (!std::isspace(static_cast<unsigned char>(text[i])))
+                entry += text[i];
+        }
+
+        const std::size_t equals = entry.find('=');
+        if (equals != std::string::npos && equals > 0 && equals + 1 < entry.size())
+            m_overrides[entry.substr(0, equals)] = entry.substr(equals + 1);
+
+        start = end + 1;
+    }
+
+    m_hasOverrides = !m_overrides.empty();
+}
+
+/// Picks from options, listed fastest first: the override for algorithm if it is supported,
+/// otherwise the first supported option. The last option should be a portable fallback.
+template<typename Backend, std::size_t Count>
+Backend selectBackend(const char *algorithm, const BackendOption<Backend> (&options)[Count])
+{
+    static_assert(Count > 0, "At least one backend is required!");
+
+    BackendRegistry &registry = BackendRegistry::instance();
+    const std::string forced = registry.backendOverride(algorithm);
+
+    const BackendOption<Backend> *chosen = nullptr;
+    for (std::size_t i = 0; i < Count && !forced.empty(); ++i)
+    {
+        if (options[i].supported && forced == options[i].name)
+            chosen = &options[i];
+    }
+
+    for (std::size_t i = 0; i < Count && chosen == nullptr; ++i)
+    {
+        if (options[i].supported)
+            chosen = &options[i];
+    }
+
+    if (chosen == nullptr)
+        chosen = &options[Count - 1];
+
+    registry.recordSelection(algorithm, chosen->name);
+    return chosen->backend;
+}
+
+/// Sets or, with an empty backend, clears the forced backend of algorithm.
+inline void setBackendOverride(const std::string &algorithm, const std::string &backend)
+{
+    if (backend.empty())
+        BackendRegistry::instance().clearOverride(algorithm);
+    else
+        BackendRegistry::instance().setOverride(algorithm, backend);
+}
+
+} // common namespace
+} // keeg namespace
+
+#endif // BACKENDREGISTRY_HPP
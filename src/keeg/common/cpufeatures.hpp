@@ -0,0 +1,177 @@
+/*
+ * Copyright (C) 2017 Larry Lopez
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to
+ * deal in the Software without restriction, including without limitation the
+ * rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+ * sell copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ */
+#ifndef CPUFEATURES_HPP
+#define CPUFEATURES_HPP
+
+#include <cstdint>
+#include <keeg/common/macrohelpers.hpp>
+
+#if defined(ARCH_X86)
+    #if defined(_MSC_VER)
+        #include <intrin.h>
+    #else
+        #include <cpuid.h>
+    #endif
+#elif defined(ARCH_ARM64) && defined(__linux__)
+    #include <sys/auxv.h>
+    #include <asm/hwcap.h>
+#endif
+
+namespace keeg { namespace common {
+
+/// Instruction set extensions supported by the cpu the program is running on.
+struct CpuFeatures
+{
+    bool ssse3    = false;
+    bool sse41    = false;
+    bool sse42    = false;
+    bool pclmul   = false;
+    bool avx2     = false;
+    bool avx512f  = false;
+    bool avx512bw = false;
+    bool avx512vl = false;
+    bool bmi1     = false;
+    bool bmi2     = false;
+    bool sha      = false;
+    bool neon     = false;
+    bool armCrc32 = false;
+    bool armPmull = false;
+    bool armAes   = false;
+    bool armSha2  = false;
+};
+
+#if defined(ARCH_X86)
+/// Executes cpuid for the given leaf, filling eax, ebx, ecx, edx in that order.
+inline void cpuid(const uint32_t &leaf, const uint32_t &subLeaf, uint32_t (&registers)[4])
+{
+#if defined(_MSC_VER)
+    int info[4];
+    __cpuidex(info, static_cast<int>(leaf), static_cast<int>(subLeaf));
+    for (int i = 0; i < 4; ++i)
+        registers[i] = static_cast<uint32_t>(info[i]);
+#else
+    __cpuid_count(leaf, subLeaf, registers[0], registers[1], registers[2], registers[3]);
+#endif
+}
+
+/// Reads the extended control register, tells which register states the OS saves on a context switch.
+inline uint64_t xgetbv(const uint32_t &index)
+{
+#if defined(_MSC_VER)
+    return _xgetbv(index);
+#else
+    uint32_t eax, edx;
+    __asm__ __volatile__("xgetbv" : "=a"(eax), "=d"(edx) : "c"(index));
+    return (static_cast<uint64_t>(edx) << 32) | eax;
+#endif
+}
+#endif
+
+/// Queries the cpu for its supported extensions. Prefer cpuFeatures() which caches the result.
+inline CpuFeatures detectCpuFeatures()
+{
+    CpuFeatures features;
+
+#if defined(ARCH_X86)
+    uint32_t registers[4] = {0};
+    cpuid(0, 0, registers);
+    const uint32_t maxLeaf = registers[0];
+
+    bool osSavesYmm = false;
+    bool osSavesZmm = false;
+
+    if (maxLeaf >= 1)
+    {
+        cpuid(1, 0, registers);
+        features.pclmul = (registers[2] & (UINT32_C(1) <<  1)) != 0;
+        features.ssse3  = (registers[2] & (UINT32_C(1) <<  9)) != 0;
+        features.sse41  = (registers[2] & (UINT32_C(1) << 19)) != 0;
+        features.sse42  = (registers[2] & (UINT32_C(1) << 20)) != 0;
+
+        // AVX registers are only usable when the OS has enabled saving them.
+        const bool osxsave = (registers[2] & (UINT32_C(1) << 27)) != 0;
+        const bool avx     = (registers[2] & (UINT32_C(1) << 28)) != 0;
+        if (osxsave && avx)
+        {
+            const uint64_t xcr0 = xgetbv(0);
+            osSavesYmm = (xcr0 & 0x06) == 0x06;
+            osSavesZmm = (xcr0 & 0xE6) == 0xE6;
+        }
+    }
+
+    if (maxLeaf >= 7)
+    {
+        cpuid(7, 0, registers);
+        features.avx2     = osSavesYmm && (registers[1] & (UINT32_C(1) <<  5)) != 0;
+        features.avx512f  = osSavesZmm && (registers[1] & (UINT32_C(1) << 16)) != 0;
+        features.avx512bw = osSavesZmm && (registers[1] & (UINT32_C(1) << 30)) != 0;
+        features.avx512vl = osSavesZmm && (registers[1] & (UINT32_C(1) << 31)) != 0;
+        features.sha      = (registers[1] & (UINT32_C(1) << 29)) != 0;
+        features.bmi1     = (registers[1] & (UINT32_C(1) <<  3)) != 0;
+        features.bmi2     = (registers[1] & (UINT32_C(1) <<  8)) != 0;
+    }
+#elif defined(ARCH_ARM64)
+    #if defined(__linux__)
+        const unsigned long hwcaps = getauxval(AT_HWCAP);
+        features.neon     = (hwcaps & HWCAP_ASIMD) != 0;
+        features.armCrc32 = (hwcaps & HWCAP_CRC32) != 0;
+        features.armPmull = (hwcaps & HWCAP_PMULL) != 0;
+        features.armAes   = (hwcaps & HWCAP_AES) != 0;
+        features.armSha2  = (hwcaps & HWCAP_SHA2) != 0;
+    #elif defined(__APPLE__)
+        // Every 64 bit Apple cpu implements the crc and crypto extensions.
+        features.neon     = true;
+        features.armCrc32 = true;
+        features.armPmull = true;
+        features.armAes   = true;
+        features.armSha2  = true;
+    #else
+        // No portable way to ask, trust what the compiler was told to target.
+        // Advanced SIMD is part of every ARMv8-A cpu.
+        features.neon = true;
+        #if defined(__ARM_FEATURE_CRC32)
+            features.armCrc32 = true;
+        #endif
+        #if defined(__ARM_FEATURE_CRYPTO) || defined(__ARM_FEATURE_AES)
+            features.armPmull = true;
+            features.armAes   = true;
+        #endif
+        #if defined(__ARM_FEATURE_CRYPTO) || defined(__ARM_FEATURE_SHA2)
+            features.armSha2  = true;
+        #endif
+    #endif
+#endif
+
+    return features;
+}
+
+/// Supported cpu extensions, detected once on first use.
+inline const CpuFeatures &cpuFeatures()
+{
+    static const CpuFeatures features = detectCpuFeatures();
+    return features;
+}
+
+} // common namespace
+} // keeg namespace
+
+#endif // CPUFEATURES_HPP
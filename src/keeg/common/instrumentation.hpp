@@ -0,0 +1,363 @@
+/*
+ * Copyright (C) 2017 Larry Lopez
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to
+ * deal in the Software without restriction, including without limitation the
+ * rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+ * sell copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ */
+#ifndef INSTRUMENTATION_HPP
+#define INSTRUMENTATION_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <map>
+#include <string>
+#include <vector>
+#include <keeg/common/backendregistry.hpp>
+
+#if defined(KEEG_INSTRUMENTATION)
+    #include <atomic>
+    #include <chrono>
+    #include <memory>
+    #include <mutex>
+    #include <typeinfo>
+    #if defined(__GNUC__) || defined(__clang__)
+        #include <cxxabi.h>
+        #include <cstdlib>
+    #endif
+#endif
+
+/// Counters for where time goes inside keeg, built only with KEEG_INSTRUMENTATION defined.
+/// Without it the hooks below expand to nothing and instrumentationSnapshot() has no counters.
+///   KEEG_INSTRUMENT_HASH_CORE(type, bytes)  times the rest of the scope as hashCore of bytes
+///   KEEG_INSTRUMENT_HASH_FINAL(type)        times the rest of the scope as hashFinal
+///   KEEG_INSTRUMENT_STREAM_STALL(type)      times the rest of the scope as waiting for input
+///   KEEG_INSTRUMENT_READ(bytes)             one read call in io
+///   KEEG_INSTRUMENT_WRITE(bytes)            one write call in io
+///   KEEG_INSTRUMENT_FLUSH(bytes)            one write to the device or stream behind a buffer
+/// type is the std::type_info of the algorithm, usually typeid(*this).
+#if defined(KEEG_INSTRUMENTATION)
+    #define KEEG_INSTRUMENT_HASH_CORE(type, bytes) \
+        ::keeg::common::detail::ScopedTimer keegInstrumentTimer(::keeg::common::detail::algorithmCounters(type).core, bytes)
+    #define KEEG_INSTRUMENT_HASH_FINAL(type) \
+        ::keeg::common::detail::ScopedTimer keegInstrumentTimer(::keeg::common::detail::algorithmCounters(type).final, 0)
+    #define KEEG_INSTRUMENT_STREAM_STALL(type) \
+        ::keeg::common::detail::ScopedTimer keegInstrumentTimer(::keeg::common::detail::algorithmCounters(type).stall, 0)
+    #define KEEG_INSTRUMENT_READ(bytes)  ::keeg::common::detail::threadCounters().read.add(bytes)
+    #define KEEG_INSTRUMENT_WRITE(bytes) ::keeg::common::detail::threadCounters().write.add(bytes)
+    #define KEEG_INSTRUMENT_FLUSH(bytes) ::keeg::common::detail::threadCounters().flush.add(bytes)
+#else
+    #define KEEG_INSTRUMENT_HASH_CORE(type, bytes)
+    #define KEEG_INSTRUMENT_HASH_FINAL(type)
+    #define KEEG_INSTRUMENT_STREAM_STALL(type)
+    #define KEEG_INSTRUMENT_READ(bytes)  ((void)0)
+    #define KEEG_INSTRUMENT_WRITE(bytes) ((void)0)
+    #define KEEG_INSTRUMENT_FLUSH(bytes) ((void)0)
+#endif
+
+namespace keeg { namespace common {
+
+/// Calls, bytes and time of one kind of operation, summed over every thread.
+struct OperationCounters
+{
+    uint64_t calls = 0;
+    uint64_t bytes = 0;
+    uint64_t nanoseconds = 0;
+};
+
+/// Counters of one HashAlgorithm class.
+struct AlgorithmCounters
+{
+    std::string name;
+    /// hashCore: the data hashed.
+    OperationCounters core;
+    /// hashFinal: padding and the digest.
+    OperationCounters final;
+    /// Time computeHash(std::istream&) and computeHashAsync spent waiting for input.
+    OperationCounters stall;
+};
+
+/// Totals across threads, including threads that have exited, since the last reset.
+struct InstrumentationSnapshot
+{
+    /// false when built without KEEG_INSTRUMENTATION, the counters are then all zero.
+    bool enabled = false;
+    std::vector<AlgorithmCounters> algorithms;
+    /// Reads of the io readers, calls and bytes.
+    OperationCounters reads;
+    /// Writes of the io writers, calls and bytes.
+    OperationCounters writes;
+    /// Writes a BufferedWriter passed on to its stream or descriptor.
+    OperationCounters flushes;
+    /// Backend chosen for each runtime dispatched algorithm, from BackendRegistry.
+    std::map<std::string, std::string> backends;
+};
+
+/// Sums the counters of every thread. Counters of running threads are read as they are,
+/// so an operation in progress may or may not be included.
+InstrumentationSnapshot instrumentationSnapshot();
+/// Zeroes every counter. Meant for between runs, an update racing with it may survive.
+void resetInstrumentation();
+
+#if defined(KEEG_INSTRUMENTATION)
+namespace detail {
+
+/// Counter written by its own thread only and read by snapshots, so a relaxed load and
+/// store take the place of a locked add.
+class RelaxedCounter
+{
+public:
+    void add(const uint64_t &value) { m_value.store(m_value.load(std::memory_order_relaxed) + value, std::memory_order_relaxed); }
+    uint64_t load() const { return m_value.load(std::memory_order_relaxed); }
+    void reset() { m_value.store(0, std::memory_order_relaxed); }
+
+private:
+    std::atomic<uint64_t> m_value{0};
+};
+
+struct OperationSlot
+{
+    RelaxedCounter calls;
+    RelaxedCounter bytes;
+    RelaxedCounter nanoseconds;
+
+    void add(const uint64_t &byteCount) { calls.add(1); bytes.add(byteCount); }
+    void addTo(OperationCounters &counters) const;
+    void reset();
+};
+
+struct AlgorithmSlot
+{
+    const std::type_info *type;
+    OperationSlot core;
+    OperationSlot final;
+    OperationSlot stall;
+};
+
+/// Counters of one thread. Only the owner adds algorithms, under the mutex so a snapshot
+/// can walk the list meanwhile, the counters themselves are updated without a lock.
+struct ThreadCounters
+{
+    std::mutex mutex;
+    std::vector<std::unique_ptr<AlgorithmSlot>> algorithms;
+    OperationSlot read;
+    OperationSlot write;
+    OperationSlot flush;
+
+    ThreadCounters();
+    ~ThreadCounters();
+};
+
+/// Every live thread's counters and the totals of exited threads.
+struct InstrumentationRegistry
+{
+    std::mutex mutex;
+    std::vector<ThreadCounters*> threads;
+    std::map<std::string, AlgorithmCounters> retiredAlgorithms;
+    OperationCounters retiredReads;
+    OperationCounters retiredWrites;
+    OperationCounters retiredFlushes;
+};
+
+/// Never destroyed, threads may exit after static destructors have run.
+inline InstrumentationRegistry &instrumentationRegistry()
+{
+    static InstrumentationRegistry *registry = new InstrumentationRegistry();
+    return *registry;
+}
+
+inline ThreadCounters &threadCounters()
+{
+    thread_local ThreadCounters counters;
+    return counters;
+}
+
+/// Readable class name, type_info::name() is mangled with gcc and clang.
+inline std::string algorithmName(const std::type_info &type)
+{
+#if defined(__GNUC__) || defined(__clang__)
+    int status = 0;
+    char *demangled = abi::__cxa_demangle(type.name(), nullptr, nullptr, &status);
+    if (status == 0 && demangled != nullptr)
+    {
+        std::string name(demangled);
+        std::free(demangled);
+        return name;
+    }
+#endif
+    return type.name();
+}
+
+/// The calling thread's counters for the algorithm, a short scan of the classes it has used.
+inline AlgorithmSlot &algorithmCounters(const std::type_info &type)
+{
+    ThreadCounters &counters = threadCounters();
+    for (const std::unique_ptr<AlgorithmSlot> &slot : counters.algorithms)
+    {
+        if (*slot->type == type)
+            return *slot;
+    }
+
+    std::unique_ptr<AlgorithmSlot> slot(new AlgorithmSlot());
+    slot->type = &type;
+    AlgorithmSlot &added = *slot;
+    std::lock_guard<std::mutex> lock(counters.mutex);
+    counters.algorithms.push_back(std::move(slot));
+    return added;
+}
+
+/// Adds a call of bytes and the time until it goes out of scope.
+class ScopedTimer
+{
+public:
+    ScopedTimer(OperationSlot &slot, const uint64_t &bytes) :
+        m_slot(slot), m_start(std::chrono::steady_clock::now())
+    {
+        m_slot.add(bytes);
+    }
+
+    ~ScopedTimer()
+    {
+        const auto elapsed = std::chrono::steady_clock::now() - m_start;
+        m_slot.nanoseconds.add(static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(elapsed).count()));
+    }
+
+    ScopedTimer(const ScopedTimer&) = delete;
+    ScopedTimer &operator=(const ScopedTimer&) = delete;
+
+private:
+    OperationSlot &m_slot;
+    std::chrono::steady_clock::time_point m_start;
+};
+
+inline void OperationSlot::addTo(OperationCounters &counters) const
+{
+    counters.calls += calls.load();
+    counters.bytes += bytes.load();
+    counters.nanoseconds += nanoseconds.load();
+}
+
+inline void OperationSlot::reset()
+{
+    calls.reset();
+    bytes.reset();
+    nanoseconds.reset();
+}
+
+inline void addAlgorithm(std::map<std::string, AlgorithmCounters> &totals, const AlgorithmSlot &slot)
+{
+    const std::string name = algorithmName(*slot.type);
+    AlgorithmCounters &counters = totals[name];
+    counters.name = name;
+    slot.core.addTo(counters.core);
+    slot.final.addTo(counters.final);
+    slot.stall.addTo(counters.stall);
+}
+
+inline ThreadCounters::ThreadCounters()
+{
+    InstrumentationRegistry &registry = instrumentationRegistry();
+    std::lock_guard<std::mutex> lock(registry.mutex);
+    registry.threads.push_back(this);
+}
+
+inline ThreadCounters::~ThreadCounters()
+{
+    InstrumentationRegistry &registry = instrumentationRegistry();
+    std::lock_guard<std::mutex> lock(registry.mutex);
+    for (const std::unique_ptr<AlgorithmSlot> &slot : algorithms)
+        addAlgorithm(registry.retiredAlgorithms, *slot);
+    read.addTo(registry.retiredReads);
+    write.addTo(registry.retiredWrites);
+    flush.addTo(registry.retiredFlushes);
+
+    for (std::size_t i = 0; i < registry.threads.size(); ++i)
+    {
+        if (registry.threads[i] == this)
+        {
+            registry.threads.erase(registry.threads.begin() + static_cast<std::ptrdiff_t>(i));
+            break;
+        }
+    }
+}
+
+} // detail namespace
+#endif
+
+inline InstrumentationSnapshot instrumentationSnapshot()
+{
+    InstrumentationSnapshot snapshot;
+    snapshot.backends = BackendRegistry::instance().selections();
+
+#if defined(KEEG_INSTRUMENTATION)
+    snapshot.enabled = true;
+    detail::InstrumentationRegistry &registry = detail::instrumentationRegistry();
+    std::lock_guard<std::mutex> lock(registry.mutex);
+
+    std::map<std::string, AlgorithmCounters> algorithms = registry.retiredAlgorithms;
+    snapshot.reads = registry.retiredReads;
+    snapshot.writes = registry.retiredWrites;
+    snapshot.flushes = registry.retiredFlushes;
+
+    for (detail::ThreadCounters *thread : registry.threads)
+    {
+        std::lock_guard<std::mutex> threadLock(thread->mutex);
+        for (const std::unique_ptr<detail::AlgorithmSlot> &slot : thread->algorithms)
+            detail::addAlgorithm(algorithms, *slot);
+        thread->read.addTo(snapshot.reads);
+        thread->write.addTo(snapshot.writes);
+        thread->flush.addTo(snapshot.flushes);
+    }
+
+    for (auto &entry : algorithms)
+        snapshot.algorithms.push_back(std::move(entry.second));
+#endif
+
+    return snapshot;
+}
+
+inline void resetInstrumentation()
+{
+#if defined(KEEG_INSTRUMENTATION)
+    detail::InstrumentationRegistry &registry = detail::instrumentationRegistry();
+    std::lock_guard<std::mutex> lock(registry.mutex);
+
+    registry.retiredAlgorithms.clear();
+    registry.retiredReads = OperationCounters();
+    registry.retiredWrites = OperationCounters();
+    registry.retiredFlushes = OperationCounters();
+
+    for (detail::ThreadCounters *thread : registry.threads)
+    {
+        std::lock_guard<std::mutex> threadLock(thread->mutex);
+        for (const std::unique_ptr<detail::AlgorithmSlot> &slot : thread->algorithms)
+        {
+            slot->core.reset();
+            slot->final.reset();
+            slot->stall.reset();
+        }
+        thread->read.reset();
+        thread->write.reset();
+        thread->flush.reset();
+    }
+#endif
+}
+
+} // common namespace
+} // keeg namespace
+
+#endif // INSTRUMENTATION_HPP
@@ -23,6 +23,7 @@
 #define MACROHELPERS_HPP
 
 #include <cstdint>
+#include <cstring>
 
 /// define endianess and prefetching
 #if defined(_MSC_VER) || defined(__MINGW32__) || defined(__MINGW64__)
@@ -45,7 +46,11 @@
     // defines __BYTE_ORDER as __LITTLE_ENDIAN or __BIG_ENDIAN
     #include <sys/param.h>
     // includes intrinsic cpu instructions.
-    #include <x86intrin.h>
+    #if defined(__x86_64__) || defined(__i386)
+        #include <x86intrin.h>
+    #elif defined(__aarch64__)
+        #include <arm_neon.h>
+    #endif
     #ifdef __GNUC__
         #define PREFETCH(location) __builtin_prefetch(location)
     #else
@@ -53,6 +58,34 @@
     #endif
 #endif
 
+/// Target architecture, used to select hardware accelerated code paths.
+#if defined(__x86_64__) || defined(__i386) || defined(_M_IX86) || defined(_M_X64)
+    #define ARCH_X86 1
+    #if defined(__x86_64__) || defined(_M_X64)
+        #define ARCH_X86_64 1
+    #endif
+#elif defined(__aarch64__) || defined(_M_ARM64)
+    #define ARCH_ARM64 1
+#endif
+
+/// Enables an instruction set for a single function, so it can be selected at runtime
+/// without compiling the whole project for that instruction set.
+/// MSVC allows intrinsics in any function, so there it expands to nothing.
+#if defined(__GNUC__) || defined(__clang__)
+    #define TARGET_ATTRIBUTE(x) __attribute__((target(x)))
+#else
+    #define TARGET_ATTRIBUTE(x)
+#endif
+
+/// Forces inlining, lets generic code be compiled for the instruction set of a caller that uses TARGET_ATTRIBUTE.
+#if defined(_MSC_VER)
+    #define FORCE_INLINE __forceinline
+#elif defined(__GNUC__) || defined(__clang__)
+    #define FORCE_INLINE inline __attribute__((always_inline))
+#else
+    #define FORCE_INLINE inline
+#endif
+
 /// Try to determine endianness at runtime.
 #define IS_BIG_ENDIANV1 (!*(unsigned char *)&(uint16_t){1})
 #define IS_BIG_ENDIANV2 (*(uint16_t *)"\0\xff" < 0x100)
@@ -73,16 +106,17 @@
 #define INT64CONST(x)  (INT64CAST(INT64_C((x))
 #define UINT64CONST(x) (UINT64CAST(UINT64_C(x)))
 
+/// Native order reads at any alignment, the memcpy compiles to a single load.
 #ifndef GET16BITS
-    #define GET16BITS(x) (*reinterpret_cast<const uint16_t*>(x))
+    #define GET16BITS(x) ([](const void *p) { uint16_t v; std::memcpy(&v, p, sizeof(v)); return v; }(x))
 #endif
 
 #ifndef GET32BITS
-    #define GET32BITS(x) (*reinterpret_cast<const uint32_t*>(x))
+    #define GET32BITS(x) ([](const void *p) { uint32_t v; std::memcpy(&v, p, sizeof(v)); return v; }(x))
 #endif
 
 #ifndef GET64BITS
-    #define GET64BITS(x) (*reinterpret_cast<const uint64_t*>(x))
+    #define GET64BITS(x) ([](const void *p) { uint64_t v; std::memcpy(&v, p, sizeof(v)); return v; }(x))
 #endif
 
 /**
@@ -22,43 +22,434 @@
 #ifndef STRINGENCODING_HPP
 #define STRINGENCODING_HPP
 
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
 #include <exception>
 #include <locale>
+#include <stdexcept>
 #include <string>
 #include <boost/locale.hpp>
 #include <boost/algorithm/string.hpp>
+#include <keeg/common/macrohelpers.hpp>
 
 namespace keeg { namespace common {
 
-inline std::string fromUTF8(const std::string &text, const std::string &charset)
+namespace detail {
+
+/// Charsets converted without boost::locale.
+enum class CharsetKind
 {
-    try
+    Utf8,
+    Latin1,          ///< ISO-8859-1, every byte is the code point of the same value
+    AsciiCompatible, ///< pure ASCII text is the same in UTF-8, anything else goes through boost
+    Other
+};
+
+/// Classifies a charset name, ignoring case, '-' and '_'.
+inline CharsetKind charsetKind(const std::string &charset)
+{
+    std::string name;
+    name.reserve(charset.size());
+    for (const char c : charset)
     {
-        return boost::locale::conv::from_utf<char>(text, charset, boost::locale::conv::stop);
+        if (c != '-' && c != '_')
+            name.push_back(static_cast<char>((c >= 'A' && c <= 'Z') ? c + ('a' - 'A') : c));
     }
-    catch (boost::locale::conv::conversion_error &ex)
+
+    if (name == "utf8")
+        return CharsetKind::Utf8;
+    if (name == "iso88591" || name == "latin1" || name == "l1")
+        return CharsetKind::Latin1;
+    if (name == "ascii" || name == "usascii" || name.compare(0, 7, "iso8859") == 0 ||
+        name.compare(0, 10, "windows125") == 0 || name.compare(0, 5, "cp125") == 0 ||
+        name.compare(0, 5, "latin") == 0)
+        return CharsetKind::AsciiCompatible;
+
+    return CharsetKind::Other;
+}
+
+/// Same message as a boost::locale::conv::stop failure rethrown by this file.
+[[noreturn]] inline void throwConversionError()
+{
+    throw std::runtime_error("Conversion failed");
+}
+
+#if defined(ARCH_X86)
+/// Bytes before the first one above 0x7F, 16 at a time.
+TARGET_ATTRIBUTE("sse2")
+inline std::size_t asciiLengthSse2(const uint8_t *data, const std::size_t &length)
+{
+    std::size_t i = 0;
+    for (; i + 16 <= length; i += 16)
     {
-        throw std::runtime_error(ex.what());
+        const int mask = _mm_movemask_epi8(_mm_loadu_si128(reinterpret_cast<const __m128i*>(data + i)));
+        if (mask != 0)
+        {
+#if defined(_MSC_VER)
+            unsigned long first;
+            _BitScanForward(&first, static_cast<unsigned long>(mask));
+            return i + static_cast<std::size_t>(first);
+#else
+            return i + static_cast<std::size_t>(__builtin_ctz(static_cast<unsigned>(mask)));
+#endif
+        }
     }
+
+    return i;
 }
 
-inline std::string toUTF8(const std::string &text, const std::string &charset)
+/// Narrows whole blocks of 8 ASCII code units, returns the units done.
+/// Stops at the first block with a unit above 0x7F.
+TARGET_ATTRIBUTE("sse2")
+inline std::size_t narrowAsciiSse2(const char16_t *text, const std::size_t &length, char *output)
 {
-    try
+    const __m128i high = _mm_set1_epi16(static_cast<short>(0xFF80));
+    std::size_t i = 0;
+    for (; i + 8 <= length; i += 8)
     {
-        return boost::locale::conv::to_utf<char>(text, charset, boost::locale::conv::stop);
+        const __m128i units = _mm_loadu_si128(reinterpret_cast<const __m128i*>(text + i));
+        if (_mm_movemask_epi8(_mm_cmpeq_epi16(_mm_and_si128(units, high), _mm_setzero_si128())) != 0xFFFF)
+            break;
+        _mm_storel_epi64(reinterpret_cast<__m128i*>(output + i), _mm_packus_epi16(units, units));
     }
-    catch (boost::locale::conv::conversion_error &ex)
+
+    return i;
+}
+
+/// Widens whole blocks of 16 ASCII bytes, returns the bytes done.
+/// Stops at the first block with a byte above 0x7F.
+TARGET_ATTRIBUTE("sse2")
+inline std::size_t widenAsciiSse2(const uint8_t *text, const std::size_t &length, char16_t *output)
+{
+    const __m128i zero = _mm_setzero_si128();
+    std::size_t i = 0;
+    for (; i + 16 <= length; i += 16)
     {
-        throw std::runtime_error(ex.what());
+        const __m128i bytes = _mm_loadu_si128(reinterpret_cast<const __m128i*>(text + i));
+        if (_mm_movemask_epi8(bytes) != 0)
+            break;
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(output + i),     _mm_unpacklo_epi8(bytes, zero));
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(output + i + 8), _mm_unpackhi_epi8(bytes, zero));
     }
+
+    return i;
 }
+#elif defined(ARCH_ARM64)
+inline std::size_t asciiLengthNeon(const uint8_t *data, const std::size_t &length)
+{
+    std::size_t i = 0;
+    for (; i + 16 <= length; i += 16)
+    {
+        if (vmaxvq_u8(vld1q_u8(data + i)) >= 0x80)
+            break;
+    }
 
-inline std::string toUTF8(const std::u16string &text)
+    return i;
+}
+
+inline std::size_t narrowAsciiNeon(const char16_t *text, const std::size_t &length, char *output)
+{
+    std::size_t i = 0;
+    for (; i + 8 <= length; i += 8)
+    {
+        const uint16x8_t units = vld1q_u16(reinterpret_cast<const uint16_t*>(text + i));
+        if (vmaxvq_u16(units) >= 0x80)
+            break;
+        vst1_u8(reinterpret_cast<uint8_t*>(output + i), vmovn_u16(units));
+    }
+
+    return i;
+}
+
+inline std::size_t widenAsciiNeon(const uint8_t *text, const std::size_t &length, char16_t *output)
 {
+    std::size_t i = 0;
+    for (; i + 16 <= length; i += 16)
+    {
+        const uint8x16_t bytes = vld1q_u8(text + i);
+        if (vmaxvq_u8(bytes) >= 0x80)
+            break;
+        vst1q_u16(reinterpret_cast<uint16_t*>(output + i),     vmovl_u8(vget_low_u8(bytes)));
+        vst1q_u16(reinterpret_cast<uint16_t*>(output + i + 8), vmovl_u8(vget_high_u8(bytes)));
+    }
+
+    return i;
+}
+#endif
+
+/// Bytes before the first one that isn't ASCII.
+inline std::size_t asciiLength(const uint8_t *data, const std::size_t &length)
+{
+    std::size_t i = 0;
+#if defined(ARCH_X86)
+    i = asciiLengthSse2(data, length);
+#elif defined(ARCH_ARM64)
+    i = asciiLengthNeon(data, length);
+#endif
+    while (i < length && data[i] < 0x80)
+        ++i;
+
+    return i;
+}
+
+/// Appends the UTF-8 encoding of length UTF-16 units, throws on an unpaired surrogate.
+inline void appendUTF8(const char16_t *text, const std::size_t &length, std::string &output)
+{
+    const std::size_t start = output.size();
+    // Worst case, 3 bytes for every unit, trimmed at the end.
+    output.resize(start + 3 * length);
+    char *out = &output[0] + start;
+
+    std::size_t i = 0;
+    while (i < length)
+    {
+#if defined(ARCH_X86)
+        const std::size_t ascii = narrowAsciiSse2(text + i, length - i, out);
+#elif defined(ARCH_ARM64)
+        const std::size_t ascii = narrowAsciiNeon(text + i, length - i, out);
+#else
+        const std::size_t ascii = 0;
+#endif
+        i += ascii;
+        out += ascii;
+
+        for (; i < length; ++i)
+        {
+            uint32_t unit = text[i];
+            if (unit < 0x80)
+            {
+                *out++ = static_cast<char>(unit);
+                // Back to the block loop once the text turns ASCII again.
+                if (i + 1 < length && text[i + 1] < 0x80)
+                {
+                    ++i;
+                    break;
+                }
+                continue;
+            }
+
+            if (unit < 0x800)
+            {
+                *out++ = static_cast<char>(0xC0 | (unit >> 6));
+                *out++ = static_cast<char>(0x80 | (unit & 0x3F));
+                continue;
+            }
+
+            if (unit >= 0xD800 && unit <= 0xDFFF)
+            {
+                if (unit > 0xDBFF || i + 1 >= length || text[i + 1] < 0xDC00 || text[i + 1] > 0xDFFF)
+                    throwConversionError();
+
+                unit = 0x10000 + ((unit - 0xD800) << 10) + (static_cast<uint32_t>(text[++i]) - 0xDC00);
+                *out++ = static_cast<char>(0xF0 | (unit >> 18));
+                *out++ = static_cast<char>(0x80 | ((unit >> 12) & 0x3F));
+                *out++ = static_cast<char>(0x80 | ((unit >> 6) & 0x3F));
+                *out++ = static_cast<char>(0x80 | (unit & 0x3F));
+                continue;
+            }
+
+            *out++ = static_cast<char>(0xE0 | (unit >> 12));
+            *out++ = static_cast<char>(0x80 | ((unit >> 6) & 0x3F));
+            *out++ = static_cast<char>(0x80 | (unit & 0x3F));
+        }
+    }
+
+    output.resize(static_cast<std::size_t>(out - output.data()));
+}
+
+/// Decodes the UTF-8 sequence at text[i], advancing i. Returns false for an invalid,
+/// overlong or truncated sequence, a surrogate or a value past U+10FFFF.
+inline bool decodeUTF8(const uint8_t *text, const std::size_t &length, std::size_t &i, uint32_t &codePoint)
+{
+    const uint8_t lead = text[i];
+    std::size_t extra;
+    uint32_t minimum;
+    if (lead < 0x80)      { codePoint = lead;        extra = 0; minimum = 0; }
+    else if (lead < 0xC2) { return false; }
+    else if (lead < 0xE0) { codePoint = lead & 0x1F; extra = 1; minimum = 0x80; }
+    else if (lead < 0xF0) { codePoint = lead & 0x0F; extra = 2; minimum = 0x800; }
+    else if (lead < 0xF5) { codePoint = lead & 0x07; extra = 3; minimum = 0x10000; }
+    else                  { return false; }
+
+    if (extra > length - i - 1)
+        return false;
+
+    for (std::size_t n = 1; n <= extra; ++n)
+    {
+        const uint8_t next = text[i + n];
+        if ((next & 0xC0) != 0x80)
+            return false;
+        codePoint = (codePoint << 6) | (next & 0x3F);
+    }
+
+    if (codePoint < minimum || codePoint > 0x10FFFF || (codePoint >= 0xD800 && codePoint <= 0xDFFF))
+        return false;
+
+    i += extra + 1;
+    return true;
+}
+
+/// Appends the UTF-16 encoding of length bytes of UTF-8, throws on invalid UTF-8.
+inline void appendUTF16(const char *text, const std::size_t &length, std::u16string &output)
+{
+    const uint8_t *bytes = reinterpret_cast<const uint8_t*>(text);
+    const std::size_t start = output.size();
+    // Never more units than bytes.
+    output.resize(start + length);
+    char16_t *out = &output[0] + start;
+
+    std::size_t i = 0;
+    while (i < length)
+    {
+#if defined(ARCH_X86)
+        const std::size_t ascii = widenAsciiSse2(bytes + i, length - i, out);
+#elif defined(ARCH_ARM64)
+        const std::size_t ascii = widenAsciiNeon(bytes + i, length - i, out);
+#else
+        const std::size_t ascii = 0;
+#endif
+        i += ascii;
+        out += ascii;
+
+        const std::size_t blockEnd = std::min(length, i + 16);
+        while (i < blockEnd)
+        {
+            uint32_t codePoint;
+            if (!decodeUTF8(bytes, length, i, codePoint))
+                throwConversionError();
+
+            if (codePoint < 0x10000)
+            {
+                *out++ = static_cast<char16_t>(codePoint);
+            }
+            else
+            {
+                codePoint -= 0x10000;
+                *out++ = static_cast<char16_t>(0xD800 + (codePoint >> 10));
+                *out++ = static_cast<char16_t>(0xDC00 + (codePoint & 0x3FF));
+            }
+        }
+    }
+
+    output.resize(static_cast<std::size_t>(out - output.data()));
+}
+
+/// Appends Latin-1 text as UTF-8.
+inline void appendUTF8FromLatin1(const char *text, const std::size_t &length, std::string &output)
+{
+    const uint8_t *bytes = reinterpret_cast<const uint8_t*>(text);
+    const std::size_t ascii = asciiLength(bytes, length);
+    output.append(text, ascii);
+    for (std::size_t i = ascii; i < length; ++i)
+    {
+        if (bytes[i] < 0x80)
+        {
+            output.push_back(static_cast<char>(bytes[i]));
+        }
+        else
+        {
+            output.push_back(static_cast<char>(0xC0 | (bytes[i] >> 6)));
+            output.push_back(static_cast<char>(0x80 | (bytes[i] & 0x3F)));
+        }
+    }
+}
+
+/// Appends UTF-8 text as Latin-1, false if it has a code point past U+00FF or isn't valid.
+inline bool appendLatin1FromUTF8(const char *text, const std::size_t &length, std::string &output)
+{
+    const uint8_t *bytes = reinterpret_cast<const uint8_t*>(text);
+    const std::size_t start = output.size();
+    std::size_t i = asciiLength(bytes, length);
+    output.append(text, i);
+    while (i < length)
+    {
+        uint32_t codePoint;
+        if (!decodeUTF8(bytes, length, i, codePoint) || codePoint > 0xFF)
+        {
+            output.resize(start);
+            return false;
+        }
+        output.push_back(static_cast<char>(codePoint));
+    }
+
+    return true;
+}
+
+/// The system locale, generated once, boost::locale::generator is costly.
+inline const std::locale &systemLocale()
+{
+    static const std::locale locale = [] {
+        boost::locale::generator g;
+        g.locale_cache_enabled(true);
+        return g(boost::locale::util::get_system_locale());
+    }();
+    return locale;
+}
+
+/// Whether the system locale encodes text as UTF-8.
+inline bool systemLocaleIsUTF8()
+{
+    static const bool utf8 = std::use_facet<boost::locale::info>(systemLocale()).utf8();
+    return utf8;
+}
+
+} // detail namespace
+
+/// true if every byte is 7 bit ASCII.
+inline bool isAscii(const void *data, const std::size_t &length)
+{
+    return detail::asciiLength(static_cast<const uint8_t*>(data), length) == length;
+}
+
+/// true if the bytes are well formed UTF-8: no overlong forms, surrogates or values past U+10FFFF.
+inline bool isValidUTF8(const char *text, const std::size_t &length)
+{
+    const uint8_t *bytes = reinterpret_cast<const uint8_t*>(text);
+    std::size_t i = detail::asciiLength(bytes, length);
+    while (i < length)
+    {
+        uint32_t codePoint;
+        if (!detail::decodeUTF8(bytes, length, i, codePoint))
+            return false;
+        i += detail::asciiLength(bytes + i, length - i);
+    }
+
+    return true;
+}
+
+/// UTF-8 text converted to charset into output, whose capacity is reused.
+/// UTF-8, Latin-1 and ASCII text for an ASCII compatible charset are handled here,
+/// everything else by boost::locale. Throws std::runtime_error when it can't be converted.
+inline void fromUTF8(const char *text, const std::size_t &length, const std::string &charset, std::string &output)
+{
+    output.clear();
+    switch (detail::charsetKind(charset))
+    {
+    case detail::CharsetKind::Utf8:
+        if (!isValidUTF8(text, length))
+            detail::throwConversionError();
+        output.assign(text, length);
+        return;
+    case detail::CharsetKind::Latin1:
+        if (detail::appendLatin1FromUTF8(text, length, output))
+            return;
+        break;
+    case detail::CharsetKind::AsciiCompatible:
+        if (isAscii(text, length))
+        {
+            output.assign(text, length);
+            return;
+        }
+        break;
+    default:
+        break;
+    }
+
     try
     {
-        return boost::locale::conv::utf_to_utf<char>(text, boost::locale::conv::stop);
+        output = boost::locale::conv::from_utf<char>(text, text + length, charset, boost::locale::conv::stop);
     }
     catch (boost::locale::conv::conversion_error &ex)
     {
@@ -66,11 +457,42 @@ inline std::string toUTF8(const std::u16string &text)
     }
 }
 
-inline std::u16string toUTF16(const std::string &text, const std::string &charset)
+inline std::string fromUTF8(const std::string &text, const std::string &charset)
+{
+    std::string output;
+    fromUTF8(text.data(), text.size(), charset, output);
+    return output;
+}
+
+/// Text in charset converted to UTF-8 into output, whose capacity is reused.
+/// Same fast paths as fromUTF8. Throws std::runtime_error when it can't be converted.
+inline void toUTF8(const char *text, const std::size_t &length, const std::string &charset, std::string &output)
 {
+    output.clear();
+    switch (detail::charsetKind(charset))
+    {
+    case detail::CharsetKind::Utf8:
+        if (!isValidUTF8(text, length))
+            detail::throwConversionError();
+        output.assign(text, length);
+        return;
+    case detail::CharsetKind::Latin1:
+        detail::appendUTF8FromLatin1(text, length, output);
+        return;
+    case detail::CharsetKind::AsciiCompatible:
+        if (isAscii(text, length))
+        {
+            output.assign(text, length);
+            return;
+        }
+        break;
+    default:
+        break;
+    }
+
     try
     {
-        return boost::locale::conv::to_utf<char16_t>(text, charset, boost::locale::conv::stop);
+        output = boost::locale::conv::to_utf<char>(text, text + length, charset, boost::locale::conv::stop);
     }
     catch (boost::locale::conv::conversion_error &ex)
     {
@@ -78,11 +500,61 @@ inline std::u16string toUTF16(const std::string &text, const std::string &charse
     }
 }
 
+inline std::string toUTF8(const std::string &text, const std::string &charset)
+{
+    std::string output;
+    toUTF8(text.data(), text.size(), charset, output);
+    return output;
+}
+
+/// UTF-16 converted to UTF-8 into output, whose capacity is reused.
+/// Throws std::runtime_error on an unpaired surrogate.
+inline void toUTF8(const char16_t *text, const std::size_t &length, std::string &output)
+{
+    output.clear();
+    detail::appendUTF8(text, length, output);
+}
+
+inline std::string toUTF8(const std::u16string &text)
+{
+    std::string output;
+    toUTF8(text.data(), text.size(), output);
+    return output;
+}
+
+/// UTF-8 converted to UTF-16 into output, whose capacity is reused.
+/// Throws std::runtime_error on invalid UTF-8.
+inline void toUTF16FromUTF8(const char *text, const std::size_t &length, std::u16string &output)
+{
+    output.clear();
+    detail::appendUTF16(text, length, output);
+}
+
 inline std::u16string toUTF16FromUTF8(const std::string &text)
 {
+    std::u16string output;
+    toUTF16FromUTF8(text.data(), text.size(), output);
+    return output;
+}
+
+inline std::u16string toUTF16(const std::string &text, const std::string &charset)
+{
+    const detail::CharsetKind kind = detail::charsetKind(charset);
+    if (kind == detail::CharsetKind::Utf8 ||
+        ((kind == detail::CharsetKind::AsciiCompatible || kind == detail::CharsetKind::Latin1) && isAscii(text.data(), text.size())))
+        return toUTF16FromUTF8(text);
+
+    if (kind == detail::CharsetKind::Latin1)
+    {
+        std::u16string output(text.size(), u'\0');
+        for (std::size_t i = 0; i < text.size(); ++i)
+            output[i] = static_cast<char16_t>(static_cast<uint8_t>(text[i]));
+        return output;
+    }
+
     try
     {
-        return boost::locale::conv::utf_to_utf<char16_t>(text, boost::locale::conv::stop);
+        return boost::locale::conv::to_utf<char16_t>(text, charset, boost::locale::conv::stop);
     }
     catch (boost::locale::conv::conversion_error &ex)
     {
@@ -90,15 +562,17 @@ inline std::u16string toUTF16FromUTF8(const std::string &text)
     }
 }
 
+/// Locale conversions skip what they can't convert, as boost::locale does by default.
+/// ASCII text, and valid UTF-8 text when the locale is UTF-8, is copied as is.
 inline std::string toUTF8FromLocale(const std::string &text)
 {
+    if (isAscii(text.data(), text.size()) ||
+        (detail::systemLocaleIsUTF8() && isValidUTF8(text.data(), text.size())))
+        return text;
+
     try
     {
-        boost::locale::generator g;
-        g.locale_cache_enabled(true);
-        std::locale loc = g(boost::locale::util::get_system_locale());
-
-        return boost::locale::conv::to_utf<char>(text, loc);
+        return boost::locale::conv::to_utf<char>(text, detail::systemLocale());
     }
     catch (boost::locale::conv::conversion_error &ex)
     {
@@ -108,13 +582,13 @@ inline std::string toUTF8FromLocale(const std::string &text)
 
 inline std::string fromUTF8ToLocale(const std::string &text)
 {
+    if (isAscii(text.data(), text.size()) ||
+        (detail::systemLocaleIsUTF8() && isValidUTF8(text.data(), text.size())))
+        return text;
+
     try
     {
-        boost::locale::generator g;
-        g.locale_cache_enabled(true);
-        std::locale loc = g(boost::locale::util::get_system_locale());
-
-        return boost::locale::conv::from_utf<char>(text, loc);
+        return boost::locale::conv::from_utf<char>(text, detail::systemLocale());
     }
     catch (boost::locale::conv::conversion_error &ex)
     {
@@ -124,13 +598,13 @@ inline std::string fromUTF8ToLocale(const std::string &text)
 
 inline std::u16string toUTF16FromLocale(const std::string &text)
 {
+    if (isAscii(text.data(), text.size()) ||
+        (detail::systemLocaleIsUTF8() && isValidUTF8(text.data(), text.size())))
+        return toUTF16FromUTF8(text);
+
     try
     {
-        boost::locale::generator g;
-        g.locale_cache_enabled(true);
-        std::locale loc = g(boost::locale::util::get_system_locale());
-
-        return boost::locale::conv::to_utf<char16_t>(text, loc);
+        return boost::locale::conv::to_utf<char16_t>(text, detail::systemLocale());
     }
     catch (boost::locale::conv::conversion_error &ex)
     {
@@ -140,14 +614,13 @@ inline std::u16string toUTF16FromLocale(const std::string &text)
 
 inline std::string fromUTF16ToLocale(const std::u16string &text)
 {
+    const std::string utf8string = toUTF8(text);
+    if (detail::systemLocaleIsUTF8() || isAscii(utf8string.data(), utf8string.size()))
+        return utf8string;
+
     try
     {
-        boost::locale::generator g;
-        g.locale_cache_enabled(true);
-        std::locale loc = g(boost::locale::util::get_system_locale());
-
-        std::string utf8string = toUTF8(text);
-        return boost::locale::conv::from_utf<char>(utf8string, loc);
+        return boost::locale::conv::from_utf<char>(utf8string, detail::systemLocale());
     }
     catch (boost::locale::conv::conversion_error &ex)
     {
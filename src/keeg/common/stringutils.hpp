@@ -22,14 +22,199 @@
 #ifndef STRINGUTILS_HPP
 #define STRINGUTILS_HPP
 
+#include <cstddef>
+#include <cstdint>
 #include <iomanip>
 #include <iterator>
 #include <locale>
 #include <string>
 #include <sstream>
+#include <vector>
+#include <keeg/common/cpufeatures.hpp>
+#include <keeg/common/macrohelpers.hpp>
 
 namespace keeg { namespace common {
 
+namespace detail {
+
+/// Both hex digits of every byte value, lower case then upper case.
+struct HexPairTable
+{
+    char pairs[2][256][2];
+
+    HexPairTable()
+    {
+        const char *digits[2] = { "0123456789abcdef", "0123456789ABCDEF" };
+        for (int upper = 0; upper < 2; ++upper)
+        {
+            for (int value = 0; value < 256; ++value)
+            {
+                pairs[upper][value][0] = digits[upper][value >> 4];
+                pairs[upper][value][1] = digits[upper][value & 0x0F];
+            }
+        }
+    }
+};
+
+inline const HexPairTable &hexPairTable()
+{
+    static const HexPairTable table;
+    return table;
+}
+
+#if defined(ARCH_X86)
+/// Encodes whole 16 byte blocks without separators, returns the bytes done.
+/// Each nibble picks its digit with a pshufb into the 16 digit string.
+TARGET_ATTRIBUTE("ssse3")
+inline std::size_t hexEncodeSsse3(const uint8_t *data, const std::size_t &length, char *output,
+                                  const bool &useUppercase)
+{
+    const __m128i digits = useUppercase ? _mm_setr_epi8('0','1','2','3','4','5','6','7','8','9','A','B','C','D','E','F')
+                                        : _mm_setr_epi8('0','1','2','3','4','5','6','7','8','9','a','b','c','d','e','f');
+    const __m128i nibble = _mm_set1_epi8(0x0F);
+
+    std::size_t i = 0;
+    for (; i + 16 <= length; i += 16)
+    {
+        const __m128i bytes = _mm_loadu_si128(reinterpret_cast<const __m128i*>(data + i));
+        const __m128i high = _mm_shuffle_epi8(digits, _mm_and_si128(_mm_srli_epi16(bytes, 4), nibble));
+        const __m128i low  = _mm_shuffle_epi8(digits, _mm_and_si128(bytes, nibble));
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(output + 2 * i),      _mm_unpacklo_epi8(high, low));
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(output + 2 * i + 16), _mm_unpackhi_epi8(high, low));
+    }
+
+    return i;
+}
+#endif
+
+/// Value of a hex digit of either case, or -1.
+inline int hexDigitValue(const char &c)
+{
+    if (c >= '0' && c <= '9')
+        return c - '0';
+
+    const char lower = static_cast<char>(c | 0x20);
+    if (lower >= 'a' && lower <= 'f')
+        return lower - 'a' + 10;
+
+    return -1;
+}
+
+} // detail namespace
+
+/// Characters hexEncode writes for length bytes, without a terminator.
+constexpr std::size_t hexEncodedSize(const std::size_t &length, const bool &insertSpaces = false)
+{
+    return length == 0 ? 0 : (insertSpaces ? 3 * length - 1 : 2 * length);
+}
+
+/// Writes length bytes as hex into output, which must have room for hexEncodedSize
+/// characters. No terminator is written. Returns the characters written.
+inline std::size_t hexEncode(const void *data, const std::size_t &length, char *output,
+                             const bool &useUppercase = true, const bool &insertSpaces = false)
+{
+    const uint8_t *bytes = static_cast<const uint8_t*>(data);
+    const char (*pairs)[2] = detail::hexPairTable().pairs[useUppercase ? 1 : 0];
+
+    if (insertSpaces)
+    {
+        for (std::size_t i = 0; i < length; ++i)
+        {
+            if (i > 0)
+                *output++ = ' ';
+            *output++ = pairs[bytes[i]][0];
+            *output++ = pairs[bytes[i]][1];
+        }
+
+        return hexEncodedSize(length, true);
+    }
+
+    std::size_t i = 0;
+#if defined(ARCH_X86)
+    if (length >= 16 && cpuFeatures().ssse3)
+        i = detail::hexEncodeSsse3(bytes, length, output, useUppercase);
+#endif
+
+    for (; i < length; ++i)
+    {
+        output[2 * i]     = pairs[bytes[i]][0];
+        output[2 * i + 1] = pairs[bytes[i]][1];
+    }
+
+    return hexEncodedSize(length, false);
+}
+
+/// Writes length bytes as zero terminated hex into a character array, a digest
+/// string without allocating. Returns the characters before the terminator, or 0
+/// with output left empty when the array is too small.
+template<std::size_t N>
+std::size_t hexZString(const void *data, const std::size_t &length, char (&output)[N],
+                       const bool &useUppercase = true, const bool &insertSpaces = false)
+{
+    static_assert(N > 0, "output needs room for the terminator!");
+
+    if (hexEncodedSize(length, insertSpaces) >= N)
+    {
+        output[0] = '\0';
+        return 0;
+    }
+
+    const std::size_t size = hexEncode(data, length, &output[0], useUppercase, insertSpaces);
+    output[size] = '\0';
+    return size;
+}
+
+/// length bytes as a hex string.
+inline std::string hexString(const void *data, const std::size_t &length,
+                             const bool &useUppercase = true, const bool &insertSpaces = false)
+{
+    std::string text(hexEncodedSize(length, insertSpaces), '\0');
+    if (!text.empty())
+        hexEncode(data, length, &text[0], useUppercase, insertSpaces);
+
+    return text;
+}
+
+/// Reads hex digits of either case into output, the reverse of hexEncode. Whitespace
+/// between byte pairs is skipped, so spaced output decodes too. output must have room
+/// for length / 2 bytes. Returns the bytes written, or 0 if the text isn't whole pairs
+/// of hex digits.
+inline std::size_t hexDecode(const char *text, const std::size_t &length, uint8_t *output)
+{
+    std::size_t written = 0;
+    std::size_t i = 0;
+    while (i < length)
+    {
+        const char c = text[i];
+        if (c == ' ' || c == '\t' || c == '\n' || c == '\r')
+        {
+            ++i;
+            continue;
+        }
+
+        if (i + 1 >= length)
+            return 0;
+
+        const int high = detail::hexDigitValue(c);
+        const int low = detail::hexDigitValue(text[i + 1]);
+        if (high < 0 || low < 0)
+            return 0;
+
+        output[written++] = static_cast<uint8_t>((high << 4) | low);
+        i += 2;
+    }
+
+    return written;
+}
+
+/// Decodes a hex string into a byte vector, empty if it isn't valid hex.
+inline std::vector<uint8_t> hexDecode(const std::string &text)
+{
+    std::vector<uint8_t> bytes(text.size() / 2);
+    bytes.resize(hexDecode(text.data(), text.size(), bytes.data()));
+    return bytes;
+}
+
 /**
  * Usage:
  *
@@ -40,24 +225,24 @@ namespace keeg { namespace common {
  * std::vector<uint8_t> byte_vector(std::begin(byte_array), std::end(byte_array));
  * auto from_vector = make_hex_string(byte_vector.begin(), byte_vector.end(), false);
  * assert(from_vector == "deadc0de00ff");
+ *
+ * For bytes in contiguous memory hexEncode and hexString are faster.
  **/
 template<typename TInputIter>
 std::string make_hex_string(TInputIter first, TInputIter last, bool useUppercase = true, bool insertSpaces = false)
 {
-    std::ostringstream ss;
-    ss << std::hex << std::setfill('0');
-
-    if (useUppercase)
-        ss << std::uppercase;
+    const char (*pairs)[2] = detail::hexPairTable().pairs[useUppercase ? 1 : 0];
 
+    std::string text;
     while (first != last)
     {
-        ss << std::setw(2) << static_cast<int16_t>(*first++ & 0xFF);
+        const uint8_t value = static_cast<uint8_t>(*first++ & 0xFF);
+        text.append(pairs[value], 2);
         if (insertSpaces && first != last)
-            ss << " ";
+            text.push_back(' ');
     }
 
-    return ss.str();
+    return text;
 }
 
 } // common namespace
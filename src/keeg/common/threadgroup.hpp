@@ -0,0 +1,147 @@
+/*
+ * Copyright (C) 2017 Larry Lopez
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to
+ * deal in the Software without restriction, including without limitation the
+ * rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+ * sell copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ */
+#ifndef THREADGROUP_HPP
+#define THREADGROUP_HPP
+
+#include <exception>
+#include <mutex>
+#include <system_error>
+#include <thread>
+#include <utility>
+#include <vector>
+
+namespace keeg { namespace common {
+
+/// Threads that are always joined, even when the caller leaves by an exception.
+/// An exception thrown by a task is kept and rethrown by join(), the first one wins.
+/// A task whose thread can't be started runs on the calling thread instead.
+class ThreadGroup
+{
+public:
+    ThreadGroup() = default;
+    ThreadGroup(const ThreadGroup&) = delete;
+    ThreadGroup &operator=(const ThreadGroup&) = delete;
+    /// Joins without rethrowing, join() first to see the tasks' exceptions.
+    ~ThreadGroup();
+
+    void reserve(const std::size_t &count);
+    /// Runs task() on a new thread.
+    template<typename Task>
+    void run(Task task);
+    /// Runs task() on a new thread, false without running it if the thread can't be
+    /// started. For tasks that wait on the caller and can't run in its place.
+    template<typename Task>
+    bool tryRun(Task task);
+    /// Waits for every task, then rethrows the first exception one threw.
+    void join();
+
+private:
+    std::vector<std::thread> m_threads;
+    std::mutex m_mutex;
+    std::exception_ptr m_exception;
+
+    template<typename Task>
+    void runGuarded(Task &task);
+    void joinAll();
+    void keepException(const std::exception_ptr &exception);
+};
+
+ThreadGroup::~ThreadGroup()
+{
+    joinAll();
+}
+
+void ThreadGroup::reserve(const std::size_t &count)
+{
+    m_threads.reserve(count);
+}
+
+template<typename Task>
+void ThreadGroup::run(Task task)
+{
+    // Out of threads, do the work here rather than lose it.
+    if (!tryRun(task))
+        runGuarded(task);
+}
+
+template<typename Task>
+bool ThreadGroup::tryRun(Task task)
+{
+    try
+    {
+        m_threads.emplace_back([this, task]() mutable { runGuarded(task); });
+        return true;
+    }
+    catch (const std::system_error&)
+    {
+        return false;
+    }
+}
+
+template<typename Task>
+void ThreadGroup::runGuarded(Task &task)
+{
+    try
+    {
+        task();
+    }
+    catch (...)
+    {
+        keepException(std::current_exception());
+    }
+}
+
+void ThreadGroup::join()
+{
+    joinAll();
+
+    std::exception_ptr exception;
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        std::swap(exception, m_exception);
+    }
+
+    if (exception)
+        std::rethrow_exception(exception);
+}
+
+void ThreadGroup::joinAll()
+{
+    for (std::thread &thread : m_threads)
+    {
+        if (thread.joinable())
+            thread.join();
+    }
+    m_threads.clear();
+}
+
+void ThreadGroup::keepException(const std::exception_ptr &exception)
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    if (!m_exception)
+        m_exception = exception;
+}
+
+} // common namespace
+} // keeg namespace
+
+#endif // THREADGROUP_HPP
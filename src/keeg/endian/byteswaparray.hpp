@@ -0,0 +1,278 @@
+/*
+ * Copyright (C) 2017 Larry Lopez
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to
+ * deal in the Software without restriction, including without limitation the
+ * rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+ * sell copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ */
+#ifndef BYTESWAPARRAY_HPP
+#define BYTESWAPARRAY_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <type_traits>
+#include <keeg/common/backendregistry.hpp>
+#include <keeg/common/cpufeatures.hpp>
+#include <keeg/common/macrohelpers.hpp>
+#include <keeg/endian/conversion.hpp>
+
+namespace keeg { namespace endian {
+
+/// Implementation used to reverse the bytes of whole arrays.
+enum class ByteSwapBackend
+{
+    Scalar,   ///< one bswap per element
+    Ssse3,    ///< 16 bytes per pshufb
+    Avx2,     ///< 32 bytes per vpshufb
+    Neon      ///< 16 bytes per rev16/rev32/rev64
+};
+
+namespace detail {
+
+/// Fastest backend the cpu supports, "byteswap" in the BackendRegistry.
+inline ByteSwapBackend selectByteSwapBackend()
+{
+    const common::CpuFeatures &features = common::cpuFeatures();
+    bool x86 = false, arm64 = false;
+#if defined(ARCH_X86)
+    x86 = true;
+#elif defined(ARCH_ARM64)
+    arm64 = true;
+#endif
+
+    const common::BackendOption<ByteSwapBackend> options[] =
+    {
+        { ByteSwapBackend::Avx2,   "avx2",   x86 && features.avx2 },
+        { ByteSwapBackend::Ssse3,  "ssse3",  x86 && features.ssse3 },
+        { ByteSwapBackend::Neon,   "neon",   arm64 && features.neon },
+        { ByteSwapBackend::Scalar, "scalar", true }
+    };
+    return common::selectBackend("byteswap", options);
+}
+
+/// Backend picked once for the process.
+inline ByteSwapBackend byteSwapBackend()
+{
+    static const ByteSwapBackend backend = selectByteSwapBackend();
+    return backend;
+}
+
+/// pshufb control reversing every size byte group of 16 bytes.
+inline void byteSwapShuffle(const std::size_t &size, uint8_t (&shuffle)[16])
+{
+    for (std::size_t i = 0; i < 16; ++i)
+        shuffle[i] = static_cast<uint8_t>((i / size) * size + (size - 1 - i % size));
+}
+
+#if defined(ARCH_X86)
+/// Shuffles whole 16 byte blocks of bytes with the pshufb control, returns the bytes done.
+TARGET_ATTRIBUTE("ssse3")
+inline std::size_t shuffleBlocksSsse3(uint8_t *destination, const uint8_t *source, const std::size_t &bytes,
+                                      const uint8_t (&control)[16])
+{
+    const __m128i shuffle = _mm_loadu_si128(reinterpret_cast<const __m128i*>(control));
+
+    std::size_t i = 0;
+    for (; i + 64 <= bytes; i += 64)
+    {
+        const __m128i a = _mm_loadu_si128(reinterpret_cast<const __m128i*>(source + i));
+        const __m128i b = _mm_loadu_si128(reinterpret_cast<const __m128i*>(source + i + 16));
+        const __m128i c = _mm_loadu_si128(reinterpret_cast<const __m128i*>(source + i + 32));
+        const __m128i d = _mm_loadu_si128(reinterpret_cast<const __m128i*>(source + i + 48));
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(destination + i),      _mm_shuffle_epi8(a, shuffle));
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(destination + i + 16), _mm_shuffle_epi8(b, shuffle));
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(destination + i + 32), _mm_shuffle_epi8(c, shuffle));
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(destination + i + 48), _mm_shuffle_epi8(d, shuffle));
+    }
+
+    for (; i + 16 <= bytes; i += 16)
+    {
+        const __m128i a = _mm_loadu_si128(reinterpret_cast<const __m128i*>(source + i));
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(destination + i), _mm_shuffle_epi8(a, shuffle));
+    }
+
+    return i;
+}
+
+/// Shuffles whole 32 byte blocks of bytes, each half with the pshufb control, returns the bytes done.
+TARGET_ATTRIBUTE("avx2")
+inline std::size_t shuffleBlocksAvx2(uint8_t *destination, const uint8_t *source, const std::size_t &bytes,
+                                     const uint8_t (&control)[16])
+{
+    const __m256i shuffle = _mm256_broadcastsi128_si256(_mm_loadu_si128(reinterpret_cast<const __m128i*>(control)));
+
+    std::size_t i = 0;
+    for (; i + 128 <= bytes; i += 128)
+    {
+        const __m256i a = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(source + i));
+        const __m256i b = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(source + i + 32));
+        const __m256i c = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(source + i + 64));
+        const __m256i d = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(source + i + 96));
+        _mm256_storeu_si256(reinterpret_cast<__m256i*>(destination + i),      _mm256_shuffle_epi8(a, shuffle));
+        _mm256_storeu_si256(reinterpret_cast<__m256i*>(destination + i + 32), _mm256_shuffle_epi8(b, shuffle));
+        _mm256_storeu_si256(reinterpret_cast<__m256i*>(destination + i + 64), _mm256_shuffle_epi8(c, shuffle));
+        _mm256_storeu_si256(reinterpret_cast<__m256i*>(destination + i + 96), _mm256_shuffle_epi8(d, shuffle));
+    }
+
+    for (; i + 32 <= bytes; i += 32)
+    {
+        const __m256i a = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(source + i));
+        _mm256_storeu_si256(reinterpret_cast<__m256i*>(destination + i), _mm256_shuffle_epi8(a, shuffle));
+    }
+
+    return i;
+}
+
+/// Swaps whole 16 byte blocks of bytes, returns the bytes done.
+inline std::size_t byteSwapBlocksSsse3(uint8_t *destination, const uint8_t *source, const std::size_t &bytes,
+                                       const std::size_t &size)
+{
+    uint8_t control[16];
+    byteSwapShuffle(size, control);
+    return shuffleBlocksSsse3(destination, source, bytes, control);
+}
+
+/// Swaps whole 32 byte blocks of bytes, returns the bytes done.
+inline std::size_t byteSwapBlocksAvx2(uint8_t *destination, const uint8_t *source, const std::size_t &bytes,
+                                      const std::size_t &size)
+{
+    uint8_t control[16];
+    byteSwapShuffle(size, control);
+    return shuffleBlocksAvx2(destination, source, bytes, control);
+}
+#endif
+
+#if defined(ARCH_ARM64)
+/// Swaps whole 16 byte blocks of bytes, returns the bytes done.
+inline std::size_t byteSwapBlocksNeon(uint8_t *destination, const uint8_t *source, const std::size_t &bytes,
+                                      const std::size_t &size)
+{
+    std::size_t i = 0;
+    for (; i + 16 <= bytes; i += 16)
+    {
+        const uint8x16_t a = vld1q_u8(source + i);
+        const uint8x16_t swapped = (size == 2) ? vrev16q_u8(a) : (size == 4) ? vrev32q_u8(a) : vrev64q_u8(a);
+        vst1q_u8(destination + i, swapped);
+    }
+
+    return i;
+}
+#endif
+
+/// Reverses the bytes of count T values from source into destination, which may be the
+/// same memory but must not otherwise overlap. Neither needs to be aligned.
+template<typename T>
+inline void byteSwapArray(void *destination, const void *source, const std::size_t &count)
+{
+    static_assert(std::is_integral<T>::value, "T must be any integral type!");
+
+    uint8_t *out = static_cast<uint8_t*>(destination);
+    const uint8_t *in = static_cast<const uint8_t*>(source);
+    const std::size_t bytes = count * sizeof(T);
+
+    if (sizeof(T) == 1)
+    {
+        if (out != in)
+            std::memmove(out, in, bytes);
+        return;
+    }
+
+    std::size_t done = 0;
+    switch (byteSwapBackend())
+    {
+#if defined(ARCH_X86)
+    case ByteSwapBackend::Avx2:
+        done = byteSwapBlocksAvx2(out, in, bytes, sizeof(T));
+        break;
+    case ByteSwapBackend::Ssse3:
+        done = byteSwapBlocksSsse3(out, in, bytes, sizeof(T));
+        break;
+#endif
+#if defined(ARCH_ARM64)
+    case ByteSwapBackend::Neon:
+        done = byteSwapBlocksNeon(out, in, bytes, sizeof(T));
+        break;
+#endif
+    default:
+        break;
+    }
+
+    using Unsigned = typename std::make_unsigned<T>::type;
+    for (; done < bytes; done += sizeof(T))
+    {
+        Unsigned value;
+        std::memcpy(&value, in + done, sizeof(T));
+        value = swap(value);
+        std::memcpy(out + done, &value, sizeof(T));
+    }
+}
+
+} // detail namespace
+
+/// Reverses the bytes of every value in data.
+template<typename T>
+inline void swapArray(T *data, const std::size_t &count)
+{
+    detail::byteSwapArray<T>(data, data, count);
+}
+
+/// Copies count values from source to destination, reversing the bytes of each.
+/// The arrays must not overlap unless they are the same.
+template<typename T>
+inline void swapArray(const T *source, T *destination, const std::size_t &count)
+{
+    detail::byteSwapArray<T>(destination, source, count);
+}
+
+/// Converts count native values in place to endian. Same as convertToEndianInplace on each.
+template<typename T>
+inline void convertToEndianInplace(T *data, const std::size_t &count, const Order &endian)
+{
+    if (endian != Order::native)
+        swapArray(data, count);
+}
+
+/// Converts count values stored as endian in place to native.
+template<typename T>
+inline void convertFromEndianInplace(T *data, const std::size_t &count, const Order &endian)
+{
+    if (endian != Order::native)
+        swapArray(data, count);
+}
+
+/// Copies count native values to destination as endian.
+template<typename T>
+inline void convertToEndian(const T *source, T *destination, const std::size_t &count, const Order &endian)
+{
+    if (endian != Order::native)
+        swapArray(source, destination, count);
+    else if (source != destination)
+        std::memmove(destination, source, count * sizeof(T));
+}
+
+/// Copies count values stored as endian to destination as native.
+template<typename T>
+inline void convertFromEndian(const T *source, T *destination, const std::size_t &count, const Order &endian)
+{
+    convertToEndian(source, destination, count, endian);
+}
+
+} // endian namespace
+} // keeg namespace
+
+#endif // BYTESWAPARRAY_HPP
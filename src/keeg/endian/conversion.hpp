@@ -24,6 +24,7 @@
 
 #include <assert.h>
 #include <cstdint>
+#include <cstring>
 #include <iterator>
 #include <limits>
 #include <type_traits>
@@ -43,6 +44,12 @@ enum class Order
 #endif
 };
 
+/// A single byte has nothing to reverse, lets generic code call swap on any width.
+static inline uint8_t swap(uint8_t x)
+{
+    return x;
+}
+
 static inline uint16_t swap(uint16_t x)
 {
 #if defined(_MSC_VER)
@@ -262,15 +269,65 @@ inline void native_to_little_inplace(T &x)
     boost::endian::native_to_little_inplace(x);
 }
 
+/// Reads a T from memory of any alignment. The memcpy compiles to a single load.
+template<typename T>
+inline T loadUnaligned(const void *source) noexcept
+{
+    static_assert(std::is_integral<T>::value, "T must be any integral type.");
+    T value;
+    std::memcpy(&value, source, sizeof(T));
+    return value;
+}
+
+/// Writes a T to memory of any alignment. The memcpy compiles to a single store.
+template<typename T>
+inline void storeUnaligned(void *destination, const T &value) noexcept
+{
+    static_assert(std::is_integral<T>::value, "T must be any integral type.");
+    std::memcpy(destination, &value, sizeof(T));
+}
+
+/// Unaligned loads of a fixed byte order, a mov plus a bswap (or a movbe) when swapped.
+inline uint16_t loadLE16(const void *source) noexcept { return little_to_native(loadUnaligned<uint16_t>(source)); }
+inline uint32_t loadLE32(const void *source) noexcept { return little_to_native(loadUnaligned<uint32_t>(source)); }
+inline uint64_t loadLE64(const void *source) noexcept { return little_to_native(loadUnaligned<uint64_t>(source)); }
+inline uint16_t loadBE16(const void *source) noexcept { return big_to_native(loadUnaligned<uint16_t>(source)); }
+inline uint32_t loadBE32(const void *source) noexcept { return big_to_native(loadUnaligned<uint32_t>(source)); }
+inline uint64_t loadBE64(const void *source) noexcept { return big_to_native(loadUnaligned<uint64_t>(source)); }
+
+/// Unaligned stores of a fixed byte order.
+inline void storeLE16(void *destination, const uint16_t &value) noexcept { storeUnaligned(destination, native_to_little(value)); }
+inline void storeLE32(void *destination, const uint32_t &value) noexcept { storeUnaligned(destination, native_to_little(value)); }
+inline void storeLE64(void *destination, const uint64_t &value) noexcept { storeUnaligned(destination, native_to_little(value)); }
+inline void storeBE16(void *destination, const uint16_t &value) noexcept { storeUnaligned(destination, native_to_big(value)); }
+inline void storeBE32(void *destination, const uint32_t &value) noexcept { storeUnaligned(destination, native_to_big(value)); }
+inline void storeBE64(void *destination, const uint64_t &value) noexcept { storeUnaligned(destination, native_to_big(value)); }
+
+/// Writes source big endian into the sizeof(T) bytes at destination.
+template <typename T>
+inline void integralToBytes(const T &source, uint8_t *destination)
+{
+    static_assert(std::is_integral<T>::value, "T must be and integral.");
+
+    storeUnaligned(destination, native_to_big(source));
+}
+
+/// Reads a big endian T from the sizeof(T) bytes at source.
+template <typename T>
+inline void bytesToIntegral(const uint8_t *source, T &destination)
+{
+    static_assert(std::is_integral<T>::value, "T must be and integral.");
+
+    destination = big_to_native(loadUnaligned<T>(source));
+}
+
 template <typename T>
 inline void integralToBytes(const T &source, std::vector<uint8_t> &destination)
 {
     static_assert(std::is_integral<T>::value, "T must be and integral.");
 
-    T data = native_to_big(source);
-    const uint8_t *src = reinterpret_cast<const uint8_t*>(&data);
-    destination.clear();
-    destination.insert(std::end(destination), src, src + sizeof(T));
+    destination.resize(sizeof(T));
+    integralToBytes(source, destination.data());
 }
 
 template <typename T>
@@ -278,7 +335,7 @@ inline void bytesToIntegral(const std::vector<uint8_t> &source, const std::size_
 {
     static_assert(std::is_integral<T>::value, "T must be and integral.");
 
-    destination = big_to_native(*reinterpret_cast<const T*>(&source[index]));
+    bytesToIntegral(source.data() + index, destination);
 }
 
 template<typename T>
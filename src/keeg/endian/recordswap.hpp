@@ -0,0 +1,333 @@
+/*
+ * Copyright (C) 2017 Larry Lopez
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to
+ * deal in the Software without restriction, including without limitation the
+ * rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+ * sell copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ */
+#ifndef RECORDSWAP_HPP
+#define RECORDSWAP_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <type_traits>
+#include <keeg/common/macrohelpers.hpp>
+#include <keeg/endian/byteswaparray.hpp>
+#include <keeg/endian/conversion.hpp>
+
+namespace keeg { namespace endian {
+
+/// An integer field of a record, Size bytes at Offset, whose bytes are reversed when the
+/// record changes endian. Usually written with RECORD_FIELD.
+template<std::size_t Size, std::size_t Offset>
+struct RecordField
+{
+    static_assert(Size == 1 || Size == 2 || Size == 4 || Size == 8, "a record field must be an 8, 16, 32 or 64 bit integer!");
+
+    static const std::size_t size = Size;
+    static const std::size_t offset = Offset;
+};
+
+/// The fields of a record to reverse, members left out are copied as they are.
+///   struct Entry { uint64_t key; uint32_t offset; uint16_t flags; char tag[2]; };
+///   using EntryFields = RecordFields<RECORD_FIELD(Entry, key), RECORD_FIELD(Entry, offset),
+///                                    RECORD_FIELD(Entry, flags)>;
+template<typename... Fields>
+struct RecordFields
+{ };
+
+/// RecordField of an integer member of a standard layout struct.
+#define RECORD_FIELD(Record, member) \
+    ::keeg::endian::RecordField<sizeof(Record::member), offsetof(Record, member)>
+
+namespace detail {
+
+/// Record sizes whose byte permutation repeats within this many bytes go through pshufb.
+static const std::size_t RECORD_SHUFFLE_MAX_PERIOD = 64;
+
+/// Unsigned integer of Size bytes.
+template<std::size_t Size>
+using RecordUnsigned = typename std::conditional<Size == 2, uint16_t,
+                       typename std::conditional<Size == 4, uint32_t,
+                       typename std::conditional<Size == 8, uint64_t, uint8_t>::type>::type>::type;
+
+template<typename... Fields>
+struct RecordFieldList;
+
+template<>
+struct RecordFieldList<>
+{
+    /// Bytes covered by the fields.
+    static const std::size_t totalSize = 0;
+    /// Size shared by every field, 0 when they differ.
+    static const std::size_t uniformSize = 0;
+
+    static void swap(uint8_t*) { }
+    static void permute(uint8_t*) { }
+};
+
+template<typename Field, typename... Rest>
+struct RecordFieldList<Field, Rest...>
+{
+    static const std::size_t totalSize = Field::size + RecordFieldList<Rest...>::totalSize;
+    static const std::size_t uniformSize =
+        (sizeof...(Rest) == 0 || RecordFieldList<Rest...>::uniformSize == Field::size) ? Field::size : 0;
+
+    /// Reverses the field in record, a memcpy load and store as the record may be unaligned.
+    static void swap(uint8_t *record)
+    {
+        using Unsigned = RecordUnsigned<Field::size>;
+        Unsigned value;
+        std::memcpy(&value, record + Field::offset, sizeof(Unsigned));
+        value = endian::swap(value);
+        std::memcpy(record + Field::offset, &value, sizeof(Unsigned));
+        RecordFieldList<Rest...>::swap(record);
+    }
+
+    /// Applies the field's reversal to a table of byte positions.
+    static void permute(uint8_t *positions)
+    {
+        for (std::size_t i = 0; i < Field::size / 2; ++i)
+        {
+            const uint8_t first = positions[Field::offset + i];
+            positions[Field::offset + i] = positions[Field::offset + Field::size - 1 - i];
+            positions[Field::offset + Field::size - 1 - i] = first;
+        }
+        RecordFieldList<Rest...>::permute(positions);
+    }
+};
+
+template<typename Fields>
+struct RecordFieldsTraits;
+
+template<typename... Fields>
+struct RecordFieldsTraits<RecordFields<Fields...>>
+{
+    using List = RecordFieldList<Fields...>;
+    static const std::size_t count = sizeof...(Fields);
+};
+
+/// pshufb controls for a run of records swapped together, once per record type.
+/// period is the least common multiple of the record size and 16, 0 when the records
+/// can't be shuffled a lane at a time and are swapped one field at a time instead.
+struct RecordShuffle
+{
+    std::size_t period = 0;
+    /// One pshufb control per 16 byte lane of the period.
+    uint8_t control[RECORD_SHUFFLE_MAX_PERIOD / 16][16];
+};
+
+template<typename Record, typename Fields>
+RecordShuffle makeRecordShuffle()
+{
+    RecordShuffle shuffle;
+    std::size_t period = sizeof(Record);
+    while (period % 16 != 0)
+        period += sizeof(Record);
+    if (period > RECORD_SHUFFLE_MAX_PERIOD)
+        return shuffle;
+
+    uint8_t positions[sizeof(Record)];
+    for (std::size_t i = 0; i < sizeof(Record); ++i)
+        positions[i] = static_cast<uint8_t>(i);
+    RecordFieldsTraits<Fields>::List::permute(positions);
+
+    // Each 16 byte lane of the period must only take bytes from itself.
+    for (std::size_t i = 0; i < period; ++i)
+    {
+        const std::size_t source = (i / sizeof(Record)) * sizeof(Record) + positions[i % sizeof(Record)];
+        if (source / 16 != i / 16)
+            return shuffle;
+        shuffle.control[i / 16][i % 16] = static_cast<uint8_t>(source % 16);
+    }
+
+    shuffle.period = period;
+    return shuffle;
+}
+
+#if defined(ARCH_X86)
+/// Shuffles whole periods of Lanes * 16 bytes, the controls held in registers. Returns the bytes done.
+template<std::size_t Lanes>
+TARGET_ATTRIBUTE("ssse3")
+inline std::size_t shuffleRecordLanesSsse3(uint8_t *destination, const uint8_t *source, const std::size_t &bytes,
+                                           const RecordShuffle &shuffle)
+{
+    // Written out lane by lane, the compiler doesn't unroll a loop over them on its own.
+    const __m128i control0 = _mm_loadu_si128(reinterpret_cast<const __m128i*>(shuffle.control[0]));
+    const __m128i control1 = _mm_loadu_si128(reinterpret_cast<const __m128i*>(shuffle.control[Lanes > 1 ? 1 : 0]));
+    const __m128i control2 = _mm_loadu_si128(reinterpret_cast<const __m128i*>(shuffle.control[Lanes > 2 ? 2 : 0]));
+    const __m128i control3 = _mm_loadu_si128(reinterpret_cast<const __m128i*>(shuffle.control[Lanes > 3 ? 3 : 0]));
+    const std::size_t length = bytes;
+
+    std::size_t i = 0;
+    for (; i + Lanes * 16 <= length; i += Lanes * 16)
+    {
+        const __m128i a = _mm_loadu_si128(reinterpret_cast<const __m128i*>(source + i));
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(destination + i), _mm_shuffle_epi8(a, control0));
+        if (Lanes > 1)
+        {
+            const __m128i b = _mm_loadu_si128(reinterpret_cast<const __m128i*>(source + i + 16));
+            _mm_storeu_si128(reinterpret_cast<__m128i*>(destination + i + 16), _mm_shuffle_epi8(b, control1));
+        }
+        if (Lanes > 2)
+        {
+            const __m128i c = _mm_loadu_si128(reinterpret_cast<const __m128i*>(source + i + 32));
+            _mm_storeu_si128(reinterpret_cast<__m128i*>(destination + i + 32), _mm_shuffle_epi8(c, control2));
+        }
+        if (Lanes > 3)
+        {
+            const __m128i d = _mm_loadu_si128(reinterpret_cast<const __m128i*>(source + i + 48));
+            _mm_storeu_si128(reinterpret_cast<__m128i*>(destination + i + 48), _mm_shuffle_epi8(d, control3));
+        }
+    }
+
+    return i;
+}
+
+inline std::size_t shuffleRecordsSsse3(uint8_t *destination, const uint8_t *source, const std::size_t &bytes,
+                                       const RecordShuffle &shuffle)
+{
+    switch (shuffle.period / 16)
+    {
+    case 1:  return shuffleBlocksSsse3(destination, source, bytes, shuffle.control[0]);
+    case 2:  return shuffleRecordLanesSsse3<2>(destination, source, bytes, shuffle);
+    case 3:  return shuffleRecordLanesSsse3<3>(destination, source, bytes, shuffle);
+    case 4:  return shuffleRecordLanesSsse3<4>(destination, source, bytes, shuffle);
+    default: return 0;
+    }
+}
+#endif
+
+#if defined(ARCH_ARM64)
+/// Shuffles whole periods of Lanes * 16 bytes, the controls held in registers. Returns the bytes done.
+template<std::size_t Lanes>
+inline std::size_t shuffleRecordLanesNeon(uint8_t *destination, const uint8_t *source, const std::size_t &bytes,
+                                          const RecordShuffle &shuffle)
+{
+    const uint8x16_t control0 = vld1q_u8(shuffle.control[0]);
+    const uint8x16_t control1 = vld1q_u8(shuffle.control[Lanes > 1 ? 1 : 0]);
+    const uint8x16_t control2 = vld1q_u8(shuffle.control[Lanes > 2 ? 2 : 0]);
+    const uint8x16_t control3 = vld1q_u8(shuffle.control[Lanes > 3 ? 3 : 0]);
+    const std::size_t length = bytes;
+
+    std::size_t i = 0;
+    for (; i + Lanes * 16 <= length; i += Lanes * 16)
+    {
+        vst1q_u8(destination + i, vqtbl1q_u8(vld1q_u8(source + i), control0));
+        if (Lanes > 1)
+            vst1q_u8(destination + i + 16, vqtbl1q_u8(vld1q_u8(source + i + 16), control1));
+        if (Lanes > 2)
+            vst1q_u8(destination + i + 32, vqtbl1q_u8(vld1q_u8(source + i + 32), control2));
+        if (Lanes > 3)
+            vst1q_u8(destination + i + 48, vqtbl1q_u8(vld1q_u8(source + i + 48), control3));
+    }
+
+    return i;
+}
+
+inline std::size_t shuffleRecordsNeon(uint8_t *destination, const uint8_t *source, const std::size_t &bytes,
+                                      const RecordShuffle &shuffle)
+{
+    switch (shuffle.period / 16)
+    {
+    case 1:  return shuffleRecordLanesNeon<1>(destination, source, bytes, shuffle);
+    case 2:  return shuffleRecordLanesNeon<2>(destination, source, bytes, shuffle);
+    case 3:  return shuffleRecordLanesNeon<3>(destination, source, bytes, shuffle);
+    case 4:  return shuffleRecordLanesNeon<4>(destination, source, bytes, shuffle);
+    default: return 0;
+    }
+}
+#endif
+
+} // detail namespace
+
+/// Copies count records from source to destination reversing the bytes of every field in
+/// Fields. The arrays may be the same but must not otherwise overlap, neither needs to be
+/// aligned. Records whose fields all have one size and fill the record are swapped as a
+/// plain array, records whose layout repeats within 64 bytes are shuffled 16 bytes at a
+/// time, the rest one field at a time.
+template<typename Record, typename Fields>
+void swapRecords(const Record *source, Record *destination, const std::size_t &count)
+{
+    static_assert(std::is_trivially_copyable<Record>::value, "Record must be trivially copyable!");
+    using Traits = detail::RecordFieldsTraits<Fields>;
+
+    const uint8_t *in = reinterpret_cast<const uint8_t*>(source);
+    uint8_t *out = reinterpret_cast<uint8_t*>(destination);
+    const std::size_t bytes = count * sizeof(Record);
+
+    if (Traits::count == 0 || count == 0)
+    {
+        if (out != in)
+            std::memmove(out, in, bytes);
+        return;
+    }
+
+    // Fields of one size that fill the record, such as a struct of uint32_t, are a plain array.
+    if (Traits::List::totalSize == sizeof(Record) && Traits::List::uniformSize != 0)
+    {
+        detail::byteSwapArray<detail::RecordUnsigned<Traits::List::uniformSize>>(out, in, bytes / Traits::List::uniformSize);
+        return;
+    }
+
+    static const detail::RecordShuffle shuffle = detail::makeRecordShuffle<Record, Fields>();
+
+    std::size_t done = 0;
+    if (shuffle.period != 0)
+    {
+        switch (detail::byteSwapBackend())
+        {
+#if defined(ARCH_X86)
+        // A 16 byte period is one control for every block, the unrolled array kernels apply.
+        case ByteSwapBackend::Avx2:
+            if (shuffle.period == 16)
+                done = detail::shuffleBlocksAvx2(out, in, bytes, shuffle.control[0]);
+            done += detail::shuffleRecordsSsse3(out + done, in + done, bytes - done, shuffle);
+            break;
+        case ByteSwapBackend::Ssse3:
+            done = detail::shuffleRecordsSsse3(out, in, bytes, shuffle);
+            break;
+#endif
+#if defined(ARCH_ARM64)
+        case ByteSwapBackend::Neon:
+            done = detail::shuffleRecordsNeon(out, in, bytes, shuffle);
+            break;
+#endif
+        default:
+            break;
+        }
+    }
+
+    // What is left is whole records, a period is a multiple of the record size.
+    if (out != in)
+        std::memmove(out + done, in + done, bytes - done);
+    for (; done < bytes; done += sizeof(Record))
+        Traits::List::swap(out + done);
+}
+
+/// Reverses the bytes of every field in Fields of count records in place.
+template<typename Record, typename Fields>
+void swapRecords(Record *records, const std::size_t &count)
+{
+    swapRecords<Record, Fields>(records, records, count);
+}
+
+} // endian namespace
+} // keeg namespace
+
+#endif // RECORDSWAP_HPP
@@ -0,0 +1,334 @@
+/*
+ * Copyright (C) 2017 Larry Lopez
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to
+ * deal in the Software without restriction, including without limitation the
+ * rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+ * sell copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ */
+#ifndef BATCHHASH_HPP
+#define BATCHHASH_HPP
+
+#include <algorithm>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+#include <keeg/common/threadgroup.hpp>
+#include <keeg/hashing/hashalgorithm.hpp>
+#include <keeg/hashing/cryptographic/hashmessage.hpp>
+
+#ifndef BATCH_HASH_MAX_OPEN_FILES
+    // Files a batch keeps open at the same time, whatever the thread count.
+    #define BATCH_HASH_MAX_OPEN_FILES 64
+#endif
+
+#ifndef BATCH_HASH_READ_SIZE
+    // Bytes per read of a batch worker, most small files are read in one call.
+    #define BATCH_HASH_READ_SIZE (UINT64_C(1) << 20)
+#endif
+
+namespace keeg { namespace hashing {
+
+namespace detail {
+
+/// Counts down free slots, blocking while there are none.
+class CountingSemaphore
+{
+public:
+    explicit CountingSemaphore(const std::size_t &count) : m_count(count) { }
+
+    void acquire()
+    {
+        std::unique_lock<std::mutex> lock(m_mutex);
+        m_available.wait(lock, [this] { return m_count > 0; });
+        --m_count;
+    }
+
+    void release()
+    {
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            ++m_count;
+        }
+        m_available.notify_one();
+    }
+
+private:
+    std::size_t m_count;
+    std::mutex m_mutex;
+    std::condition_variable m_available;
+};
+
+/// Holds one slot of a CountingSemaphore while in scope.
+class SemaphoreSlot
+{
+public:
+    explicit SemaphoreSlot(CountingSemaphore &semaphore) : m_semaphore(semaphore) { m_semaphore.acquire(); }
+    SemaphoreSlot(const SemaphoreSlot&) = delete;
+    SemaphoreSlot &operator=(const SemaphoreSlot&) = delete;
+    ~SemaphoreSlot() { m_semaphore.release(); }
+
+private:
+    CountingSemaphore &m_semaphore;
+};
+
+/// Indexes [next, end) still to do by one worker, thieves take the upper half.
+struct WorkRange
+{
+    std::mutex mutex;
+    std::size_t next = 0;
+    std::size_t end = 0;
+};
+
+} // detail namespace
+
+/// Hashes many files or buffers on all cores, one digest per input in input order.
+///
+///   BatchHash batch = BatchHash::create<cryptographic::Sha256>();
+///   batch.setProgressCallback([](std::size_t done, std::size_t total) { ... });
+///   std::vector<std::vector<uint8_t>> digests = batch.computeHashFiles(paths);
+///
+/// Each worker starts with an equal slice of the inputs and, once it runs out, steals half
+/// of what is left from another worker, so a few large files don't hold up the rest.
+/// Every worker makes one algorithm with the factory and one read buffer, reused for all
+/// its inputs. Files are read with large unbuffered reads, at most maxOpenFiles at a time.
+/// Hashing many small files is bound by the drive's latency more than by the cpu, a thread
+/// count above the core count keeps more requests in flight.
+/// An exception thrown by the factory or the progress callback reaches the caller once
+/// every worker has stopped.
+class BatchHash
+{
+public:
+    using AlgorithmFactory = std::function<std::unique_ptr<HashAlgorithm>()>;
+    /// Called after each input with the number done so far and the total. The calls come
+    /// from the worker threads, one at a time.
+    using ProgressCallback = std::function<void(std::size_t, std::size_t)>;
+
+    /// threadCount 0 uses every hardware thread.
+    explicit BatchHash(const AlgorithmFactory &factory, const std::size_t &threadCount = 0,
+                       const std::size_t &maxOpenFiles = BATCH_HASH_MAX_OPEN_FILES);
+
+    /// Batch of a default constructible algorithm.
+    template<typename Algorithm>
+    static BatchHash create(const std::size_t &threadCount = 0,
+                            const std::size_t &maxOpenFiles = BATCH_HASH_MAX_OPEN_FILES);
+
+    std::size_t threadCount() const;
+    std::size_t maxOpenFiles() const;
+    void setProgressCallback(const ProgressCallback &callback);
+
+    /// Digest of each file, empty for a file that can't be read.
+    std::vector<std::vector<uint8_t>> computeHashFiles(const std::vector<std::string> &paths);
+    /// Digest of each memory block.
+    std::vector<std::vector<uint8_t>> computeHash(const cryptographic::HashMessage *messages, const std::size_t &count);
+    std::vector<std::vector<uint8_t>> computeHash(const std::vector<cryptographic::HashMessage> &messages);
+
+private:
+    /// Work on one input: the worker's algorithm, its read buffer and the input index.
+    using Job = std::function<void(HashAlgorithm&, std::vector<uint8_t>&, const std::size_t&)>;
+
+    AlgorithmFactory m_factory;
+    std::size_t m_threadCount;
+    std::size_t m_maxOpenFiles;
+    ProgressCallback m_progress;
+
+    void run(const std::size_t &count, const std::size_t &bufferSize, const Job &job);
+    /// Next index for worker from its own range, stealing when it's empty. false when all are taken.
+    static bool nextIndex(detail::WorkRange *ranges, const std::size_t &rangeCount,
+                          const std::size_t &worker, std::size_t &index);
+    static std::vector<uint8_t> hashFile(HashAlgorithm &algorithm, std::vector<uint8_t> &buffer,
+                                         const std::string &path);
+};
+
+BatchHash::BatchHash(const AlgorithmFactory &factory, const std::size_t &threadCount, const std::size_t &maxOpenFiles) :
+    m_factory(factory),
+    m_threadCount(threadCount),
+    m_maxOpenFiles(std::max<std::size_t>(maxOpenFiles, 1))
+{
+    if (m_threadCount == 0)
+        m_threadCount = std::max<std::size_t>(std::thread::hardware_concurrency(), 1);
+}
+
+template<typename Algorithm>
+BatchHash BatchHash::create(const std::size_t &threadCount, const std::size_t &maxOpenFiles)
+{
+    return BatchHash([] { return std::unique_ptr<HashAlgorithm>(new Algorithm()); }, threadCount, maxOpenFiles);
+}
+
+std::size_t BatchHash::threadCount() const
+{
+    return m_threadCount;
+}
+
+std::size_t BatchHash::maxOpenFiles() const
+{
+    return m_maxOpenFiles;
+}
+
+void BatchHash::setProgressCallback(const ProgressCallback &callback)
+{
+    m_progress = callback;
+}
+
+std::vector<std::vector<uint8_t>> BatchHash::computeHashFiles(const std::vector<std::string> &paths)
+{
+    std::vector<std::vector<uint8_t>> digests(paths.size());
+    detail::CountingSemaphore openFiles(m_maxOpenFiles);
+
+    run(paths.size(), BATCH_HASH_READ_SIZE,
+        [&](HashAlgorithm &algorithm, std::vector<uint8_t> &buffer, const std::size_t &index) {
+            // Released even if hashFile throws, the other workers would wait for it forever.
+            detail::SemaphoreSlot openFile(openFiles);
+            digests[index] = hashFile(algorithm, buffer, paths[index]);
+        });
+
+    return digests;
+}
+
+std::vector<std::vector<uint8_t>> BatchHash::computeHash(const cryptographic::HashMessage *messages, const std::size_t &count)
+{
+    std::vector<std::vector<uint8_t>> digests(count);
+
+    run(count, 0, [&](HashAlgorithm &algorithm, std::vector<uint8_t>&, const std::size_t &index) {
+        algorithm.initialize();
+        algorithm.update(messages[index].data, messages[index].length);
+        digests[index] = algorithm.finalize();
+    });
+
+    return digests;
+}
+
+std::vector<std::vector<uint8_t>> BatchHash::computeHash(const std::vector<cryptographic::HashMessage> &messages)
+{
+    return computeHash(messages.data(), messages.size());
+}
+
+void BatchHash::run(const std::size_t &count, const std::size_t &bufferSize, const Job &job)
+{
+    if (count == 0)
+        return;
+
+    const std::size_t threadCount = std::min(m_threadCount, count);
+    std::unique_ptr<detail::WorkRange[]> ranges(new detail::WorkRange[threadCount]);
+    for (std::size_t i = 0; i < threadCount; ++i)
+    {
+        ranges[i].next = count * i / threadCount;
+        ranges[i].end = count * (i + 1) / threadCount;
+    }
+
+    std::mutex progressMutex;
+    std::size_t done = 0;
+
+    auto worker = [&](const std::size_t &self) {
+        std::unique_ptr<HashAlgorithm> algorithm = m_factory();
+        std::vector<uint8_t> buffer(bufferSize);
+        std::size_t index;
+        while (nextIndex(ranges.get(), threadCount, self, index))
+        {
+            job(*algorithm, buffer, index);
+
+            if (m_progress)
+            {
+                std::lock_guard<std::mutex> lock(progressMutex);
+                m_progress(++done, count);
+            }
+        }
+    };
+
+    common::ThreadGroup threads;
+    threads.reserve(threadCount - 1);
+    for (std::size_t i = 1; i < threadCount; ++i)
+        threads.run([&worker, i] { worker(i); });
+
+    worker(0);
+    threads.join();
+}
+
+bool BatchHash::nextIndex(detail::WorkRange *ranges, const std::size_t &rangeCount,
+                          const std::size_t &worker, std::size_t &index)
+{
+    detail::WorkRange &own = ranges[worker];
+    {
+        std::lock_guard<std::mutex> lock(own.mutex);
+        if (own.next < own.end)
+        {
+            index = own.next++;
+            return true;
+        }
+    }
+
+    for (std::size_t i = 1; i < rangeCount; ++i)
+    {
+        detail::WorkRange &victim = ranges[(worker + i) % rangeCount];
+        std::size_t first, last;
+        {
+            std::lock_guard<std::mutex> lock(victim.mutex);
+            if (victim.next >= victim.end)
+                continue;
+
+            last = victim.end;
+            first = victim.next + (victim.end - victim.next) / 2;
+            victim.end = first;
+        }
+
+        // The first index is taken now, the rest becomes this worker's range to be stolen from in turn.
+        std::lock_guard<std::mutex> lock(own.mutex);
+        index = first;
+        own.next = first + 1;
+        own.end = last;
+        return true;
+    }
+
+    return false;
+}
+
+std::vector<uint8_t> BatchHash::hashFile(HashAlgorithm &algorithm, std::vector<uint8_t> &buffer, const std::string &path)
+{
+    std::FILE *file = std::fopen(path.c_str(), "rb");
+    if (file == nullptr)
+        return std::vector<uint8_t>();
+
+    // Mapping costs more than reading for the small files that make up most batches.
+    std::setvbuf(file, nullptr, _IONBF, 0);
+
+    algorithm.initialize();
+    std::size_t numBytesRead;
+    do
+    {
+        // A short read is the end of the file or an error, no need for another call to find out.
+        numBytesRead = std::fread(buffer.data(), 1, buffer.size(), file);
+        algorithm.update(buffer.data(), numBytesRead);
+    } while (numBytesRead == buffer.size());
+
+    const bool failed = std::ferror(file) != 0;
+    std::fclose(file);
+    if (failed)
+        return std::vector<uint8_t>();
+
+    return algorithm.finalize();
+}
+
+} // hashing namespace
+} // keeg namespace
+
+#endif // BATCHHASH_HPP
@@ -0,0 +1,195 @@
+/*
+ * Copyright (C) 2017 Larry Lopez
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to
+ * deal in the Software without restriction, including without limitation the
+ * rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+ * sell copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ */
+#ifndef BLOCKQUEUE_HPP
+#define BLOCKQUEUE_HPP
+
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <exception>
+#include <istream>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+namespace keeg { namespace hashing {
+
+/// Bounded ring of reusable buffers passed from one producer to a fixed number of consumers.
+/// Every consumer sees every block, in the order they were published; a buffer is refilled
+/// only after all consumers released it. The producer blocks when all buffers are in use.
+/// A consumer that fails calls cancel(), which stops the producer and the other consumers.
+class BlockQueue
+{
+public:
+    struct Block
+    {
+        std::unique_ptr<uint8_t[]> data;
+        std::size_t length = 0;
+    };
+
+    BlockQueue(const std::size_t &blockCount, const std::size_t &blockSize, const std::size_t &consumerCount);
+    BlockQueue(const BlockQueue&) = delete;
+    BlockQueue &operator=(const BlockQueue&) = delete;
+
+    std::size_t blockSize() const;
+
+    /// Producer: waits for a free buffer to fill, blockSize() bytes, nullptr once cancelled.
+    Block *acquire();
+    /// Producer: hands the buffer from acquire() to the consumers.
+    void publish(const std::size_t &length);
+    /// Producer: no more blocks, consumers get nullptr from next() once they drain the queue.
+    void close();
+
+    /// Consumer: waits for the next block, or nullptr when the producer closed the queue.
+    const Block *next(const std::size_t &consumer);
+    /// Consumer: done with the block from next().
+    void release(const std::size_t &consumer);
+    /// Either side: gives up, acquire() and next() return nullptr from then on. Blocks
+    /// consumers still hold stay untouched until they release them.
+    void cancel();
+
+private:
+    std::vector<Block> m_blocks;
+    std::vector<std::size_t> m_pending;   // consumers still using each block
+    std::vector<std::size_t> m_consumed;  // blocks each consumer has released
+    const std::size_t m_blockSize;
+    std::size_t m_produced = 0;
+    bool m_closed = false;
+    bool m_cancelled = false;
+
+    std::mutex m_mutex;
+    std::condition_variable m_blockReady;
+    std::condition_variable m_blockFree;
+};
+
+BlockQueue::BlockQueue(const std::size_t &blockCount, const std::size_t &blockSize, const std::size_t &consumerCount) :
+    m_blocks(blockCount < 1 ? 1 : blockCount),
+    m_pending(m_blocks.size(), 0),
+    m_consumed(consumerCount, 0),
+    m_blockSize(blockSize < 1 ? 1 : blockSize)
+{
+    for (Block &block : m_blocks)
+        block.data = std::make_unique<uint8_t[]>(m_blockSize);
+}
+
+std::size_t BlockQueue::blockSize() const
+{
+    return m_blockSize;
+}
+
+BlockQueue::Block *BlockQueue::acquire()
+{
+    const std::size_t slot = m_produced % m_blocks.size();
+    std::unique_lock<std::mutex> lock(m_mutex);
+    m_blockFree.wait(lock, [&] { return m_pending[slot] == 0 || m_cancelled; });
+    return m_cancelled ? nullptr : &m_blocks[slot];
+}
+
+void BlockQueue::publish(const std::size_t &length)
+{
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        const std::size_t slot = m_produced % m_blocks.size();
+        m_blocks[slot].length = length;
+        m_pending[slot] = m_consumed.size();
+        ++m_produced;
+    }
+    m_blockReady.notify_all();
+}
+
+void BlockQueue::close()
+{
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_closed = true;
+    }
+    m_blockReady.notify_all();
+}
+
+const BlockQueue::Block *BlockQueue::next(const std::size_t &consumer)
+{
+    std::unique_lock<std::mutex> lock(m_mutex);
+    m_blockReady.wait(lock, [&] { return m_consumed[consumer] < m_produced || m_closed || m_cancelled; });
+    if (m_cancelled || m_consumed[consumer] == m_produced)
+        return nullptr;
+
+    return &m_blocks[m_consumed[consumer] % m_blocks.size()];
+}
+
+void BlockQueue::release(const std::size_t &consumer)
+{
+    bool freed;
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        const std::size_t slot = m_consumed[consumer]++ % m_blocks.size();
+        freed = --m_pending[slot] == 0;
+    }
+    if (freed)
+        m_blockFree.notify_one();
+}
+
+void BlockQueue::cancel()
+{
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_cancelled = true;
+    }
+    m_blockReady.notify_all();
+    m_blockFree.notify_all();
+}
+
+/// Producer loop reading a stream to its end into the queue, then closing it.
+/// Returns false if reading threw or the queue was cancelled, the queue is closed either
+/// way so consumers finish.
+inline bool readIntoQueue(std::istream &instream, BlockQueue &queue)
+{
+    bool ok = true;
+    try
+    {
+        while (instream)
+        {
+            BlockQueue::Block *block = queue.acquire();
+            if (block == nullptr)
+            {
+                ok = false;
+                break;
+            }
+
+            instream.read(reinterpret_cast<char*>(block->data.get()), static_cast<std::streamsize>(queue.blockSize()));
+            const std::size_t numBytesRead = static_cast<std::size_t>(instream.gcount());
+            if (numBytesRead > 0)
+                queue.publish(numBytesRead);
+        }
+    }
+    catch(...)
+    {
+        ok = false;
+    }
+
+    queue.close();
+    return ok;
+}
+
+} // hashing namespace
+} // keeg namespace
+
+#endif // BLOCKQUEUE_HPP
@@ -22,7 +22,8 @@
 #ifndef ADLER32_HPP
 #define ADLER32_HPP
 
-#include <keeg/hashing/hashalgorithm.hpp>
+#include <keeg/hashing/integerhashalgorithm.hpp>
+#include <keeg/hashing/checksum/adler32accelerated.hpp>
 #include <keeg/endian/conversion.hpp>
 
 namespace keeg { namespace hashing { namespace checksum {
@@ -37,32 +38,38 @@ namespace keeg { namespace hashing { namespace checksum {
 
 #define MOD(a) ((a) %= MOD_ADLER32)
 
-class Adler32 : public HashAlgorithm
+class Adler32 : public IntegerHashAlgorithm<uint32_t>
 {
 public:
     Adler32();
 
+    /// Implementation picked for this cpu.
+    Adler32Backend backend() const { return m_backend; }
+
     // HashAlgorithm interface
 public:
     virtual std::size_t hashSize() override;
+    virtual std::unique_ptr<HashAlgorithm> copy() const override;
     virtual void initialize() override;
 
 protected:
     virtual void hashCore(const void *data, const std::size_t &dataLength, const std::size_t &startIndex) override;
 
-    virtual std::vector<uint8_t> hashFinal() override;
+    virtual uint32_t hashFinalValue() override;
 
 private:
     static const std::size_t m_hashSize = std::numeric_limits<uint32_t>::digits;
     const uint32_t m_modAdler = UINT32_C(65521); // largest prime smaller than 65536
     const uint32_t m_nmax     = UINT32_C(5552);
     uint32_t m_hash           = UINT32_C(1);
+    Adler32Backend m_backend;
 
     static_assert(std::is_same<uint8_t, unsigned char>::value,
                   "uint8_t is required to be implemented as unsigned char!");
 };
 
-Adler32::Adler32() : HashAlgorithm()
+Adler32::Adler32() : IntegerHashAlgorithm<uint32_t>(),
+    m_backend(detail::adler32Backend())
 {
     initialize();
 }
@@ -72,6 +79,11 @@ std::size_t Adler32::hashSize()
     return m_hashSize;
 }
 
+std::unique_ptr<HashAlgorithm> Adler32::copy() const
+{
+    return std::unique_ptr<HashAlgorithm>(new Adler32(*this));
+}
+
 void Adler32::initialize()
 {
     m_hash = UINT32_C(1);
@@ -103,6 +115,30 @@ void Adler32::hashCore(const void *data, const std::size_t &dataLength, const st
     {
         std::size_t length = dataLength;
         std::size_t k;
+
+        // Whole vector blocks first, the loop below takes the rest.
+        std::size_t consumed = 0;
+        switch (m_backend)
+        {
+#if defined(ARCH_X86)
+        case Adler32Backend::Avx2:
+            consumed = detail::adler32BlocksAvx2(a, b, current, length);
+            break;
+        case Adler32Backend::Ssse3:
+            consumed = detail::adler32BlocksSsse3(a, b, current, length);
+            break;
+#endif
+#if defined(ARCH_ARM64)
+        case Adler32Backend::Neon:
+            consumed = detail::adler32BlocksNeon(a, b, current, length);
+            break;
+#endif
+        default:
+            break;
+        }
+        current += consumed;
+        length -= consumed;
+
         while (length > 0)
         {
             k = length < m_nmax ? length : m_nmax;
@@ -141,15 +177,9 @@ void Adler32::hashCore(const void *data, const std::size_t &dataLength, const st
     //        }
 }
 
-std::vector<uint8_t> Adler32::hashFinal()
+uint32_t Adler32::hashFinalValue()
 {
-    /// Make sure the hash is Big-Endian.
-    uint32_t data = endian::native_to_big(m_hash);
-
-    /// Convert the hash to a vector of bytes.
-    std::vector<uint8_t> v(reinterpret_cast<uint8_t*>(&data),
-                           reinterpret_cast<uint8_t*>(&data) + sizeof(uint32_t));
-    return std::move(v);
+    return m_hash;
 }
 
 } // checksum namespace
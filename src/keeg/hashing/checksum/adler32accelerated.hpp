@@ -0,0 +1,245 @@
+/*
+ * Copyright (C) 2017 Larry Lopez
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to
+ * deal in the Software without restriction, including without limitation the
+ * rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+ * sell copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ */
+/*
+ * The vector kernels follow the approach of Chromium's zlib adler32_simd.c: the byte sums
+ * of a block go to `a`, weighted by their distance from the block end to `b`, and the
+ * modulo is only taken once per NMAX bytes.
+ */
+
+#ifndef ADLER32ACCELERATED_HPP
+#define ADLER32ACCELERATED_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <keeg/common/backendregistry.hpp>
+#include <keeg/common/cpufeatures.hpp>
+#include <keeg/common/macrohelpers.hpp>
+
+namespace keeg { namespace hashing { namespace checksum {
+
+/// Implementation used to sum whole blocks, picked when an Adler32 is constructed.
+enum class Adler32Backend
+{
+    Scalar,   ///< portable unrolled loop
+    Ssse3,    ///< 32 bytes per step with SSSE3 multiply-add
+    Avx2,     ///< 64 bytes per step with AVX2 multiply-add
+    Neon      ///< 32 bytes per step with NEON widening adds
+};
+
+namespace detail {
+
+const uint32_t Adler32Modulus = UINT32_C(65521);
+/// Most bytes that can be summed before b may overflow 32 bits.
+const std::size_t Adler32NMax = 5552;
+
+/// Fastest backend the cpu supports, "adler32" in the BackendRegistry.
+inline Adler32Backend selectAdler32Backend()
+{
+    const common::CpuFeatures &features = common::cpuFeatures();
+    bool x86 = false, arm64 = false;
+#if defined(ARCH_X86)
+    x86 = true;
+#elif defined(ARCH_ARM64)
+    arm64 = true;
+#endif
+
+    const common::BackendOption<Adler32Backend> options[] =
+    {
+        { Adler32Backend::Avx2,   "avx2",   x86 && features.avx2 },
+        { Adler32Backend::Ssse3,  "ssse3",  x86 && features.ssse3 },
+        { Adler32Backend::Neon,   "neon",   arm64 && features.neon },
+        { Adler32Backend::Scalar, "scalar", true }
+    };
+    return common::selectBackend("adler32", options);
+}
+
+/// Backend picked once for the process.
+inline Adler32Backend adler32Backend()
+{
+    static const Adler32Backend backend = selectAdler32Backend();
+    return backend;
+}
+
+#if defined(ARCH_X86)
+TARGET_ATTRIBUTE("ssse3")
+inline uint32_t adler32HorizontalSumSse(const __m128i &v)
+{
+    const __m128i sum = _mm_add_epi32(v, _mm_shuffle_epi32(v, _MM_SHUFFLE(1, 0, 3, 2)));
+    return static_cast<uint32_t>(_mm_cvtsi128_si32(_mm_add_epi32(sum, _mm_shuffle_epi32(sum, _MM_SHUFFLE(2, 3, 0, 1)))));
+}
+
+/// Sums the whole 32 byte blocks of data into a and b, both reduced. Returns the bytes consumed.
+TARGET_ATTRIBUTE("ssse3")
+inline std::size_t adler32BlocksSsse3(uint32_t &a, uint32_t &b, const uint8_t *data, const std::size_t &length)
+{
+    const std::size_t BlockSize = 32;
+    std::size_t blocks = length / BlockSize;
+    const std::size_t consumed = blocks * BlockSize;
+
+    const __m128i tap1 = _mm_setr_epi8(32, 31, 30, 29, 28, 27, 26, 25, 24, 23, 22, 21, 20, 19, 18, 17);
+    const __m128i tap2 = _mm_setr_epi8(16, 15, 14, 13, 12, 11, 10,  9,  8,  7,  6,  5,  4,  3,  2,  1);
+    const __m128i zero = _mm_setzero_si128();
+    const __m128i ones = _mm_set1_epi16(1);
+
+    while (blocks > 0)
+    {
+        std::size_t n = Adler32NMax / BlockSize;
+        if (n > blocks)
+            n = blocks;
+        blocks -= n;
+
+        // Every block adds BlockSize * (a before it) to b, collected in previousSums.
+        __m128i previousSums = _mm_set_epi32(0, 0, 0, static_cast<int>(a * n));
+        __m128i sumA = zero;
+        __m128i sumB = _mm_set_epi32(0, 0, 0, static_cast<int>(b));
+        do
+        {
+            const __m128i bytes1 = _mm_loadu_si128(reinterpret_cast<const __m128i*>(data));
+            const __m128i bytes2 = _mm_loadu_si128(reinterpret_cast<const __m128i*>(data + 16));
+            previousSums = _mm_add_epi32(previousSums, sumA);
+            sumA = _mm_add_epi32(sumA, _mm_sad_epu8(bytes1, zero));
+            sumA = _mm_add_epi32(sumA, _mm_sad_epu8(bytes2, zero));
+            sumB = _mm_add_epi32(sumB, _mm_madd_epi16(_mm_maddubs_epi16(bytes1, tap1), ones));
+            sumB = _mm_add_epi32(sumB, _mm_madd_epi16(_mm_maddubs_epi16(bytes2, tap2), ones));
+            data += BlockSize;
+        } while (--n);
+
+        sumB = _mm_add_epi32(sumB, _mm_slli_epi32(previousSums, 5));
+        a = (a + adler32HorizontalSumSse(sumA)) % Adler32Modulus;
+        b = adler32HorizontalSumSse(sumB) % Adler32Modulus;
+    }
+
+    return consumed;
+}
+
+TARGET_ATTRIBUTE("avx2")
+inline uint32_t adler32HorizontalSumAvx2(const __m256i &v)
+{
+    __m128i sum = _mm_add_epi32(_mm256_castsi256_si128(v), _mm256_extracti128_si256(v, 1));
+    sum = _mm_add_epi32(sum, _mm_shuffle_epi32(sum, _MM_SHUFFLE(1, 0, 3, 2)));
+    return static_cast<uint32_t>(_mm_cvtsi128_si32(_mm_add_epi32(sum, _mm_shuffle_epi32(sum, _MM_SHUFFLE(2, 3, 0, 1)))));
+}
+
+/// Same as the SSSE3 kernel over 64 byte blocks.
+TARGET_ATTRIBUTE("avx2")
+inline std::size_t adler32BlocksAvx2(uint32_t &a, uint32_t &b, const uint8_t *data, const std::size_t &length)
+{
+    const std::size_t BlockSize = 64;
+    std::size_t blocks = length / BlockSize;
+    const std::size_t consumed = blocks * BlockSize;
+
+    const __m256i tap1 = _mm256_setr_epi8(64, 63, 62, 61, 60, 59, 58, 57, 56, 55, 54, 53, 52, 51, 50, 49,
+                                          48, 47, 46, 45, 44, 43, 42, 41, 40, 39, 38, 37, 36, 35, 34, 33);
+    const __m256i tap2 = _mm256_setr_epi8(32, 31, 30, 29, 28, 27, 26, 25, 24, 23, 22, 21, 20, 19, 18, 17,
+                                          16, 15, 14, 13, 12, 11, 10,  9,  8,  7,  6,  5,  4,  3,  2,  1);
+    const __m256i zero = _mm256_setzero_si256();
+    const __m256i ones = _mm256_set1_epi16(1);
+
+    while (blocks > 0)
+    {
+        std::size_t n = Adler32NMax / BlockSize;
+        if (n > blocks)
+            n = blocks;
+        blocks -= n;
+
+        __m256i previousSums = _mm256_setr_epi32(static_cast<int>(a * n), 0, 0, 0, 0, 0, 0, 0);
+        __m256i sumA = zero;
+        __m256i sumB = _mm256_setr_epi32(static_cast<int>(b), 0, 0, 0, 0, 0, 0, 0);
+        do
+        {
+            const __m256i bytes1 = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(data));
+            const __m256i bytes2 = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(data + 32));
+            previousSums = _mm256_add_epi32(previousSums, sumA);
+            sumA = _mm256_add_epi32(sumA, _mm256_add_epi32(_mm256_sad_epu8(bytes1, zero), _mm256_sad_epu8(bytes2, zero)));
+            sumB = _mm256_add_epi32(sumB, _mm256_madd_epi16(_mm256_maddubs_epi16(bytes1, tap1), ones));
+            sumB = _mm256_add_epi32(sumB, _mm256_madd_epi16(_mm256_maddubs_epi16(bytes2, tap2), ones));
+            data += BlockSize;
+        } while (--n);
+
+        sumB = _mm256_add_epi32(sumB, _mm256_slli_epi32(previousSums, 6));
+        a = (a + adler32HorizontalSumAvx2(sumA)) % Adler32Modulus;
+        b = adler32HorizontalSumAvx2(sumB) % Adler32Modulus;
+    }
+
+    return consumed;
+}
+#endif
+
+#if defined(ARCH_ARM64)
+/// Same as the SSSE3 kernel, the weights are applied to per column byte sums once per NMAX.
+inline std::size_t adler32BlocksNeon(uint32_t &a, uint32_t &b, const uint8_t *data, const std::size_t &length)
+{
+    const std::size_t BlockSize = 32;
+    std::size_t blocks = length / BlockSize;
+    const std::size_t consumed = blocks * BlockSize;
+
+    static const uint16_t taps[32] =
+    {
+        32, 31, 30, 29, 28, 27, 26, 25, 24, 23, 22, 21, 20, 19, 18, 17,
+        16, 15, 14, 13, 12, 11, 10,  9,  8,  7,  6,  5,  4,  3,  2,  1
+    };
+
+    while (blocks > 0)
+    {
+        std::size_t n = Adler32NMax / BlockSize;
+        if (n > blocks)
+            n = blocks;
+        blocks -= n;
+
+        uint32x4_t sumB = vsetq_lane_u32(static_cast<uint32_t>(a * n), vdupq_n_u32(0), 0);
+        uint32x4_t sumA = vdupq_n_u32(0);
+        uint16x8_t columns[4] = { vdupq_n_u16(0), vdupq_n_u16(0), vdupq_n_u16(0), vdupq_n_u16(0) };
+        do
+        {
+            const uint8x16_t bytes1 = vld1q_u8(data);
+            const uint8x16_t bytes2 = vld1q_u8(data + 16);
+            sumB = vaddq_u32(sumB, sumA);
+            sumA = vpadalq_u16(sumA, vpadalq_u8(vpaddlq_u8(bytes1), bytes2));
+            columns[0] = vaddw_u8(columns[0], vget_low_u8(bytes1));
+            columns[1] = vaddw_u8(columns[1], vget_high_u8(bytes1));
+            columns[2] = vaddw_u8(columns[2], vget_low_u8(bytes2));
+            columns[3] = vaddw_u8(columns[3], vget_high_u8(bytes2));
+            data += BlockSize;
+        } while (--n);
+
+        sumB = vshlq_n_u32(sumB, 5);
+        for (int i = 0; i < 4; ++i)
+        {
+            sumB = vmlal_u16(sumB, vget_low_u16(columns[i]),  vld1_u16(taps + 8 * i));
+            sumB = vmlal_u16(sumB, vget_high_u16(columns[i]), vld1_u16(taps + 8 * i + 4));
+        }
+
+        a = (a + vaddvq_u32(sumA)) % Adler32Modulus;
+        b = (b + vaddvq_u32(sumB)) % Adler32Modulus;
+    }
+
+    return consumed;
+}
+#endif
+
+} // detail namespace
+
+} // checksum namespace
+} // hashing namespace
+} // keeg namespace
+
+#endif // ADLER32ACCELERATED_HPP
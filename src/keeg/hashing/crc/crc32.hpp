@@ -28,23 +28,80 @@
 #ifndef CRC32_HPP
 #define CRC32_HPP
 
-#include <keeg/hashing/hashalgorithm.hpp>
+#include <keeg/hashing/integerhashalgorithm.hpp>
+#include <keeg/hashing/crc/crc32accelerated.hpp>
 #include <keeg/endian/conversion.hpp>
 #include <array>
-
-// zlib's CRC32 polynomial
-#define ZLIB_POLYNOMIAL UINT32_C(0xEDB88320)
+#include <map>
+#include <mutex>
 
 // If a polynomial isn't provided, default to zlib's.
 #ifndef DEFAULT_POLYNOMIAL32
     #define DEFAULT_POLYNOMIAL32 ZLIB_POLYNOMIAL
 #endif
 
-#define MAX_CRC32_SLICE UINT32_C(16)
-
 namespace keeg { namespace hashing { namespace crc {
 
-class Crc32 : public HashAlgorithm
+namespace detail {
+
+/// Lookup table shared by every Crc32 using the polynomial.
+/// The well known polynomials are generated at compile time.
+inline const Crc32LookupTable &crc32LookupTable(const uint32_t &polynomial)
+{
+    switch (polynomial) {
+    case ZLIB_POLYNOMIAL:
+        return CrcStaticTable<uint32_t, ZLIB_POLYNOMIAL>::value;
+    case CASTAGNOLI_POLYNOMIAL:
+        return CrcStaticTable<uint32_t, CASTAGNOLI_POLYNOMIAL>::value;
+    default:
+        return crcSharedTable<uint32_t>(polynomial);
+    }
+}
+
+/// Carry-less multiply fold constants shared by every Crc32 using the polynomial.
+/// The well known polynomials are computed once, others on first request.
+inline const Crc32FoldConstants &crc32FoldConstants(const uint32_t &polynomial)
+{
+    switch (polynomial) {
+    case ZLIB_POLYNOMIAL:
+    {
+        static const Crc32FoldConstants zlib = makeCrc32FoldConstants(ZLIB_POLYNOMIAL);
+        return zlib;
+    }
+    case CASTAGNOLI_POLYNOMIAL:
+    {
+        static const Crc32FoldConstants castagnoli = makeCrc32FoldConstants(CASTAGNOLI_POLYNOMIAL);
+        return castagnoli;
+    }
+    default:
+        break;
+    }
+
+    static std::mutex mutex;
+    static std::map<uint32_t, Crc32FoldConstants> shared;
+
+    std::lock_guard<std::mutex> lock(mutex);
+    auto found = shared.find(polynomial);
+    if (found == shared.end())
+        found = shared.emplace(polynomial, makeCrc32FoldConstants(polynomial)).first;
+
+    return found->second;
+}
+
+} // detail namespace
+
+/// Crc32 of length characters of text, usable at compile time. Same value as Crc32(Polynomial, seed).
+template<uint32_t Polynomial = DEFAULT_POLYNOMIAL32>
+constexpr uint32_t crc32Hash(const char *text, const std::size_t &length, const uint32_t &seed = UINT32_C(0))
+{
+    uint32_t crc = ~seed;
+    for (std::size_t i = 0; i < length; ++i)
+        crc = (crc >> 8) ^ CrcStaticTable<uint32_t, Polynomial>::value[0][(crc ^ static_cast<uint8_t>(text[i])) & 0xFF];
+
+    return ~crc;
+}
+
+class Crc32 : public IntegerHashAlgorithm<uint32_t>
 {
 public:
     Crc32(const uint32_t &polynomial = DEFAULT_POLYNOMIAL32, const uint32_t &seed = UINT32_C(0));
@@ -52,35 +109,58 @@ public:
     // HashAlgorithm interface
 public:
     virtual std::size_t hashSize() override;
+    virtual std::unique_ptr<HashAlgorithm> copy() const override;
     virtual void initialize() override;
+    /// The private register update below would hide these.
+    using IntegerHashAlgorithm<uint32_t>::update;
+
+    /// Implementation selected for this polynomial on the running cpu.
+    Crc32Backend backend() const { return m_backend; }
+
+    /// Crc of two blocks joined together, crcB must be computed with a zero seed.
+    uint32_t combine(const uint32_t &crcA, const uint32_t &crcB, const uint64_t &lengthB) const;
+
+    /// compute the crc of a memory block split across threads, 0 uses every hardware thread.
+    std::vector<uint8_t> computeHashParallel(const void *data, const std::size_t &dataLength,
+                                             const std::size_t &threadCount = 0);
 
 protected:
-    /// compute CRC32 (Slicing-by-16 algorithm)
+    /// compute CRC32 using the selected backend
     virtual void hashCore(const void *data, const std::size_t &dataLength, const std::size_t &startIndex) override;
 
-    virtual std::vector<uint8_t> hashFinal() override;
+    virtual uint32_t hashFinalValue() override;
 
 private:
-    static const std::size_t MaxSlice   = MAX_CRC32_SLICE;
     static const std::size_t m_hashSize = std::numeric_limits<uint32_t>::digits;
 
     /// CRC32 polynomial
     uint32_t m_polynomial;
     uint32_t m_seed;
     uint32_t m_hash;
-    std::array<std::array<uint32_t, 256>, MaxSlice> m_lookupTable;
+    const Crc32LookupTable *m_lookupTable;
+    Crc32Backend m_backend;
+    /// Only set for the folding backends.
+    const Crc32FoldConstants *m_foldConstants;
+
+    /// update the raw crc register with the selected backend
+    uint32_t update(uint32_t crc, const uint8_t *data, const std::size_t &dataLength) const;
 
-    void initializeTable();
+    /// compute CRC32 (Slicing-by-16 algorithm)
+    uint32_t hashSlicing16(uint32_t crc, const uint8_t *data, const std::size_t &dataLength) const;
 
     static_assert(std::is_same<uint8_t, unsigned char>::value,
                   "uint8_t is required to be implemented as unsigned char!");
 };
 
 Crc32::Crc32(const uint32_t &polynomial, const uint32_t &seed) :
-    HashAlgorithm(), m_polynomial(polynomial), m_seed(seed)
+    IntegerHashAlgorithm<uint32_t>(), m_polynomial(polynomial), m_seed(seed),
+    m_lookupTable(&detail::crc32LookupTable(polynomial)),
+    m_backend(detail::crc32Backend(polynomial)), m_foldConstants(nullptr)
 {
     initialize();
-    initializeTable();
+
+    if (m_backend == Crc32Backend::Pclmul || m_backend == Crc32Backend::ArmPmull)
+        m_foldConstants = &detail::crc32FoldConstants(m_polynomial);
 }
 
 std::size_t Crc32::hashSize()
@@ -88,17 +168,79 @@ std::size_t Crc32::hashSize()
     return m_hashSize;
 }
 
+std::unique_ptr<HashAlgorithm> Crc32::copy() const
+{
+    return std::unique_ptr<HashAlgorithm>(new Crc32(*this));
+}
+
 void Crc32::initialize()
 {
     m_hash = m_seed;
     m_hashValue.clear();
 }
 
+uint32_t Crc32::combine(const uint32_t &crcA, const uint32_t &crcB, const uint64_t &lengthB) const
+{
+    return crcCombine<uint32_t>(crcA, crcB, lengthB, m_polynomial);
+}
+
+std::vector<uint8_t> Crc32::computeHashParallel(const void *data, const std::size_t &dataLength,
+                                                const std::size_t &threadCount)
+{
+    initialize();
+    KEEG_INSTRUMENT_HASH_CORE(typeid(*this), dataLength);
+
+    const uint32_t crc = crcParallel<uint32_t>(static_cast<const uint8_t*>(data), dataLength, threadCount,
+                                               m_polynomial, [this](const uint8_t *block, const std::size_t &length)
+    {
+        return ~update(~UINT32_C(0), block, length);
+    });
+
+    m_hash = combine(m_hash, crc, dataLength);
+    m_hashValue = hashFinal();
+    return m_hashValue;
+}
+
 void Crc32::hashCore(const void *data, const std::size_t &dataLength, const std::size_t &startIndex)
 {
-    uint32_t crc = ~m_hash; // same as previousCrc32 ^ 0xFFFFFFFF
-    const uint8_t* currentByte = static_cast<const uint8_t*>(data) + startIndex;
-    const uint32_t* current = reinterpret_cast<const uint32_t*>(currentByte);
+    const uint8_t* current = static_cast<const uint8_t*>(data) + startIndex;
+    m_hash = ~update(~m_hash, current, dataLength); // same as previousCrc32 ^ 0xFFFFFFFF
+}
+
+uint32_t Crc32::update(uint32_t crc, const uint8_t *current, const std::size_t &dataLength) const
+{
+    switch (m_backend) {
+#if defined(ARCH_X86)
+    case Crc32Backend::Sse42:
+        crc = detail::crc32cSse42(crc, current, dataLength);
+        break;
+    case Crc32Backend::Pclmul:
+        crc = detail::crc32FoldPclmul(crc, current, dataLength, *m_foldConstants, *m_lookupTable);
+        break;
+#endif
+#if defined(CRC32_ARM_CRC32)
+    case Crc32Backend::ArmCrc32:
+        crc = detail::crc32Arm(crc, current, dataLength, m_polynomial == CASTAGNOLI_POLYNOMIAL);
+        break;
+#endif
+#if defined(CRC32_ARM_PMULL)
+    case Crc32Backend::ArmPmull:
+        crc = detail::crc32FoldPmull(crc, current, dataLength, *m_foldConstants, *m_lookupTable);
+        break;
+#endif
+    default:
+        crc = hashSlicing16(crc, current, dataLength);
+        break;
+    }
+
+    return crc;
+}
+
+uint32_t Crc32::hashSlicing16(uint32_t crc, const uint8_t *data, const std::size_t &dataLength) const
+{
+    const Crc32LookupTable &table = *m_lookupTable;
+    const uint8_t* currentByte = data;
+    const uint8_t* current = currentByte;
     std::size_t numBytes = dataLength;
 
     // enabling optimization (at least -O2) automatically unrolls the inner for-loop
@@ -111,47 +253,49 @@ void Crc32::hashCore(const void *data, const std::size_t &dataLength, const std:
       for (size_t unrolling = 0; unrolling < Unroll; unrolling++)
       {
   #if __BYTE_ORDER == __BIG_ENDIAN
-          uint32_t one   = *current++ ^ swap(crc);
-          uint32_t two   = *current++;
-          uint32_t three = *current++;
-          uint32_t four  = *current++;
-          crc  = m_lookupTable[ 0][ four         & 0xFF] ^
-                  m_lookupTable[ 1][(four  >>  8) & 0xFF] ^
-                  m_lookupTable[ 2][(four  >> 16) & 0xFF] ^
-                  m_lookupTable[ 3][(four  >> 24) & 0xFF] ^
-                  m_lookupTable[ 4][ three        & 0xFF] ^
-                  m_lookupTable[ 5][(three >>  8) & 0xFF] ^
-                  m_lookupTable[ 6][(three >> 16) & 0xFF] ^
-                  m_lookupTable[ 7][(three >> 24) & 0xFF] ^
-                  m_lookupTable[ 8][ two          & 0xFF] ^
-                  m_lookupTable[ 9][(two   >>  8) & 0xFF] ^
-                  m_lookupTable[10][(two   >> 16) & 0xFF] ^
-                  m_lookupTable[11][(two   >> 24) & 0xFF] ^
-                  m_lookupTable[12][ one          & 0xFF] ^
-                  m_lookupTable[13][(one   >>  8) & 0xFF] ^
-                  m_lookupTable[14][(one   >> 16) & 0xFF] ^
-                  m_lookupTable[15][(one   >> 24) & 0xFF];
+          uint32_t one   = endian::loadUnaligned<uint32_t>(current     ) ^ swap(crc);
+          uint32_t two   = endian::loadUnaligned<uint32_t>(current +  4);
+          uint32_t three = endian::loadUnaligned<uint32_t>(current +  8);
+          uint32_t four  = endian::loadUnaligned<uint32_t>(current + 12);
+          current += 16;
+          crc  = table[ 0][ four         & 0xFF] ^
+                  table[ 1][(four  >>  8) & 0xFF] ^
+                  table[ 2][(four  >> 16) & 0xFF] ^
+                  table[ 3][(four  >> 24) & 0xFF] ^
+                  table[ 4][ three        & 0xFF] ^
+                  table[ 5][(three >>  8) & 0xFF] ^
+                  table[ 6][(three >> 16) & 0xFF] ^
+                  table[ 7][(three >> 24) & 0xFF] ^
+                  table[ 8][ two          & 0xFF] ^
+                  table[ 9][(two   >>  8) & 0xFF] ^
+                  table[10][(two   >> 16) & 0xFF] ^
+                  table[11][(two   >> 24) & 0xFF] ^
+                  table[12][ one          & 0xFF] ^
+                  table[13][(one   >>  8) & 0xFF] ^
+                  table[14][(one   >> 16) & 0xFF] ^
+                  table[15][(one   >> 24) & 0xFF];
 #else
-          uint32_t one   = *current++ ^ crc;
-          uint32_t two   = *current++;
-          uint32_t three = *current++;
-          uint32_t four  = *current++;
-          crc  = m_lookupTable[ 0][(four  >> 24) & 0xFF] ^
-                  m_lookupTable[ 1][(four  >> 16) & 0xFF] ^
-                  m_lookupTable[ 2][(four  >>  8) & 0xFF] ^
-                  m_lookupTable[ 3][ four         & 0xFF] ^
-                  m_lookupTable[ 4][(three >> 24) & 0xFF] ^
-                  m_lookupTable[ 5][(three >> 16) & 0xFF] ^
-                  m_lookupTable[ 6][(three >>  8) & 0xFF] ^
-                  m_lookupTable[ 7][ three        & 0xFF] ^
-                  m_lookupTable[ 8][(two   >> 24) & 0xFF] ^
-                  m_lookupTable[ 9][(two   >> 16) & 0xFF] ^
-                  m_lookupTable[10][(two   >>  8) & 0xFF] ^
-                  m_lookupTable[11][ two          & 0xFF] ^
-                  m_lookupTable[12][(one   >> 24) & 0xFF] ^
-                  m_lookupTable[13][(one   >> 16) & 0xFF] ^
-                  m_lookupTable[14][(one   >>  8) & 0xFF] ^
-                  m_lookupTable[15][ one          & 0xFF];
+          uint32_t one   = endian::loadUnaligned<uint32_t>(current     ) ^ crc;
+          uint32_t two   = endian::loadUnaligned<uint32_t>(current +  4);
+          uint32_t three = endian::loadUnaligned<uint32_t>(current +  8);
+          uint32_t four  = endian::loadUnaligned<uint32_t>(current + 12);
+          current += 16;
+          crc  = table[ 0][(four  >> 24) & 0xFF] ^
+                  table[ 1][(four  >> 16) & 0xFF] ^
+                  table[ 2][(four  >>  8) & 0xFF] ^
+                  table[ 3][ four         & 0xFF] ^
+                  table[ 4][(three >> 24) & 0xFF] ^
+                  table[ 5][(three >> 16) & 0xFF] ^
+                  table[ 6][(three >>  8) & 0xFF] ^
+                  table[ 7][ three        & 0xFF] ^
+                  table[ 8][(two   >> 24) & 0xFF] ^
+                  table[ 9][(two   >> 16) & 0xFF] ^
+                  table[10][(two   >>  8) & 0xFF] ^
+                  table[11][ two          & 0xFF] ^
+                  table[12][(one   >> 24) & 0xFF] ^
+                  table[13][(one   >> 16) & 0xFF] ^
+                  table[14][(one   >>  8) & 0xFF] ^
+                  table[15][ one          & 0xFF];
 #endif
       }
 
@@ -161,55 +305,14 @@ void Crc32::hashCore(const void *data, const std::size_t &dataLength, const std:
 
     // remaining 1 to 63 bytes (standard algorithm)
     while (numBytes-- != 0)
-        crc = (crc >> 8) ^ m_lookupTable[0][(crc & 0xFF) ^ *currentByte++];
+        crc = (crc >> 8) ^ table[0][(crc & 0xFF) ^ *currentByte++];
 
-    m_hash = ~crc;
+    return crc;
 }
 
-std::vector<uint8_t> Crc32::hashFinal()
+uint32_t Crc32::hashFinalValue()
 {
-    uint32_t data = endian::native_to_big(m_hash);
-    std::vector<uint8_t> v(reinterpret_cast<uint8_t*>(&data),
-                           reinterpret_cast<uint8_t*>(&data) + sizeof(uint32_t));
-    return std::move(v);
-}
-
-void Crc32::initializeTable()
-{
-    uint32_t entry;
-    for (uint32_t i = 0; i < 256; ++i)
-    {
-        entry = i;
-        for (auto j = 0; j < 8; ++j)
-        {
-            entry = (entry >> 1) ^ ((entry & 1) * m_polynomial);
-        }
-
-        m_lookupTable[0][i] = entry;
-    }
-
-    for (auto i = 0; i < 256; ++i)
-    {
-        for (std::size_t slice = 1; slice < MaxSlice; ++slice)
-        {
-            m_lookupTable[slice][i] =
-                    (m_lookupTable[slice - 1][i] >> 8) ^ m_lookupTable[0][m_lookupTable[slice - 1][i] & 0xFF];
-        }
-    }
-    // slicing-by-8 algorithm (from Intel):
-    // http://www.intel.com/technology/comms/perfnet/download/CRC_generators.pdf
-    // http://sourceforge.net/projects/slicing-by-8/
-//    for (auto i = 0; i <= 256; ++i)
-//    {
-//        m_lookupTable[1][i] = (m_lookupTable[0][i] >> 8) ^ m_lookupTable[0][m_lookupTable[0][i] & 0xFF];
-//        m_lookupTable[2][i] = (m_lookupTable[1][i] >> 8) ^ m_lookupTable[0][m_lookupTable[1][i] & 0xFF];
-//        m_lookupTable[3][i] = (m_lookupTable[2][i] >> 8) ^ m_lookupTable[0][m_lookupTable[2][i] & 0xFF];
-
-//        m_lookupTable[4][i] = (m_lookupTable[3][i] >> 8) ^ m_lookupTable[0][m_lookupTable[3][i] & 0xFF];
-//        m_lookupTable[5][i] = (m_lookupTable[4][i] >> 8) ^ m_lookupTable[0][m_lookupTable[4][i] & 0xFF];
-//        m_lookupTable[6][i] = (m_lookupTable[5][i] >> 8) ^ m_lookupTable[0][m_lookupTable[5][i] & 0xFF];
-//        m_lookupTable[7][i] = (m_lookupTable[6][i] >> 8) ^ m_lookupTable[0][m_lookupTable[6][i] & 0xFF];
-//    }
+    return m_hash;
 }
 
 } // crc namespace
@@ -0,0 +1,356 @@
+/*
+ * Copyright (C) 2017 Larry Lopez
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to
+ * deal in the Software without restriction, including without limitation the
+ * rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+ * sell copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ */
+
+/*
+ * Folding with carry-less multiplication follows Intel's white paper
+ * "Fast CRC Computation for Generic Polynomials Using PCLMULQDQ Instruction".
+ */
+
+#ifndef CRC32ACCELERATED_HPP
+#define CRC32ACCELERATED_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <keeg/common/backendregistry.hpp>
+#include <keeg/common/cpufeatures.hpp>
+#include <keeg/common/macrohelpers.hpp>
+#include <keeg/hashing/crc/crccombine.hpp>
+#include <keeg/hashing/crc/crctables.hpp>
+
+#if defined(ARCH_ARM64) && defined(__ARM_FEATURE_CRC32)
+    #include <arm_acle.h>
+    #define CRC32_ARM_CRC32 1
+#endif
+
+#if defined(ARCH_ARM64) && (defined(__ARM_FEATURE_CRYPTO) || defined(__ARM_FEATURE_AES))
+    #include <arm_neon.h>
+    #define CRC32_ARM_PMULL 1
+#endif
+
+// zlib's CRC32 polynomial
+#define ZLIB_POLYNOMIAL UINT32_C(0xEDB88320)
+
+// Castagnoli's CRC32C polynomial, used by iSCSI, ext4 and the SSE4.2 crc32 instruction.
+#define CASTAGNOLI_POLYNOMIAL UINT32_C(0x82F63B78)
+
+namespace keeg { namespace hashing { namespace crc {
+
+/// Implementation used to update the crc, picked when a Crc32 is constructed.
+enum class Crc32Backend
+{
+    Table,     ///< portable slicing-by-16
+    Sse42,     ///< x86 crc32 instruction, Castagnoli polynomial only
+    Pclmul,    ///< x86 carry-less multiplication folding, any polynomial
+    ArmCrc32,  ///< ARMv8 crc32 instructions, zlib and Castagnoli polynomials only
+    ArmPmull   ///< ARMv8 carry-less multiplication folding, any polynomial
+};
+
+using Crc32LookupTable = CrcSliceTable<uint32_t>;
+
+/// Constants used to fold 128 bit blocks, stored bit reflected and shifted by one.
+struct Crc32FoldConstants
+{
+    uint64_t fold4Low  = 0; ///< x^(4*128+32) mod P, fold across four blocks
+    uint64_t fold4High = 0; ///< x^(4*128-32) mod P
+    uint64_t fold1Low  = 0; ///< x^(128+32) mod P, fold into the next block
+    uint64_t fold1High = 0; ///< x^(128-32) mod P
+};
+
+namespace detail {
+
+/// x^exponent modulo the reflected polynomial, in reflected form (x^0 is the top bit).
+inline uint32_t crc32XPowerMod(const uint32_t &exponent, const uint32_t &polynomial)
+{
+    return crcXPowerMod<uint32_t>(exponent, polynomial);
+}
+
+inline Crc32FoldConstants makeCrc32FoldConstants(const uint32_t &polynomial)
+{
+    Crc32FoldConstants constants;
+    constants.fold4Low  = static_cast<uint64_t>(crc32XPowerMod(4 * 128 + 32, polynomial)) << 1;
+    constants.fold4High = static_cast<uint64_t>(crc32XPowerMod(4 * 128 - 32, polynomial)) << 1;
+    constants.fold1Low  = static_cast<uint64_t>(crc32XPowerMod(128 + 32, polynomial)) << 1;
+    constants.fold1High = static_cast<uint64_t>(crc32XPowerMod(128 - 32, polynomial)) << 1;
+    return constants;
+}
+
+/// Crc of the 16 folded bytes starting from a zero crc, one table lookup per byte.
+inline uint32_t crc32FoldedBlock(const uint8_t (&folded)[16], const Crc32LookupTable &table)
+{
+    uint32_t crc = 0;
+    for (std::size_t i = 0; i < 16; ++i)
+        crc ^= table[15 - i][folded[i]];
+
+    return crc;
+}
+
+/// Standard byte at a time algorithm, used for the bytes left over by the wide kernels.
+inline uint32_t crc32Bytewise(uint32_t crc, const uint8_t *data, std::size_t length, const Crc32LookupTable &table)
+{
+    while (length-- != 0)
+        crc = (crc >> 8) ^ table[0][(crc & 0xFF) ^ *data++];
+
+    return crc;
+}
+
+/// Picks the fastest backend the cpu supports for the polynomial, "crc32" in the BackendRegistry.
+inline Crc32Backend selectCrc32Backend(const uint32_t &polynomial)
+{
+    const common::CpuFeatures &features = common::cpuFeatures();
+    bool sse42 = false, pclmul = false, armCrc32 = false, armPmull = false;
+
+#if defined(ARCH_X86)
+    sse42  = polynomial == CASTAGNOLI_POLYNOMIAL && features.sse42;
+    pclmul = features.pclmul;
+#endif
+#if defined(CRC32_ARM_CRC32)
+    armCrc32 = (polynomial == ZLIB_POLYNOMIAL || polynomial == CASTAGNOLI_POLYNOMIAL) && features.armCrc32;
+#endif
+#if defined(CRC32_ARM_PMULL)
+    armPmull = features.armPmull;
+#endif
+
+    (void)features;
+    (void)polynomial;
+    const common::BackendOption<Crc32Backend> options[] =
+    {
+        { Crc32Backend::Sse42,    "sse42",    sse42 },
+        { Crc32Backend::Pclmul,   "pclmul",   pclmul },
+        { Crc32Backend::ArmCrc32, "armcrc32", armCrc32 },
+        { Crc32Backend::ArmPmull, "armpmull", armPmull },
+        { Crc32Backend::Table,    "table",    true }
+    };
+    return common::selectBackend("crc32", options);
+}
+
+/// Backend picked once for the process per kind of polynomial. The crc instructions only
+/// know Castagnoli's polynomial, and zlib's on arm, every other polynomial gets the same.
+inline Crc32Backend crc32Backend(const uint32_t &polynomial)
+{
+    switch (polynomial) {
+    case ZLIB_POLYNOMIAL:
+    {
+        static const Crc32Backend zlib = selectCrc32Backend(ZLIB_POLYNOMIAL);
+        return zlib;
+    }
+    case CASTAGNOLI_POLYNOMIAL:
+    {
+        static const Crc32Backend castagnoli = selectCrc32Backend(CASTAGNOLI_POLYNOMIAL);
+        return castagnoli;
+    }
+    default:
+    {
+        static const Crc32Backend other = selectCrc32Backend(polynomial);
+        return other;
+    }
+    }
+}
+
+#if defined(ARCH_X86)
+
+TARGET_ATTRIBUTE("sse4.2")
+inline uint32_t crc32cSse42(uint32_t crc, const uint8_t *data, std::size_t length)
+{
+#if defined(ARCH_X86_64)
+    uint64_t crc64 = crc;
+    while (length >= sizeof(uint64_t))
+    {
+        uint64_t value;
+        std::memcpy(&value, data, sizeof(uint64_t));
+        crc64 = _mm_crc32_u64(crc64, value);
+        data   += sizeof(uint64_t);
+        length -= sizeof(uint64_t);
+    }
+    crc = static_cast<uint32_t>(crc64);
+#endif
+
+    while (length >= sizeof(uint32_t))
+    {
+        uint32_t value;
+        std::memcpy(&value, data, sizeof(uint32_t));
+        crc = _mm_crc32_u32(crc, value);
+        data   += sizeof(uint32_t);
+        length -= sizeof(uint32_t);
+    }
+
+    while (length-- != 0)
+        crc = _mm_crc32_u8(crc, *data++);
+
+    return crc;
+}
+
+/// Multiplies both halves of x by their fold constant and adds the next block.
+TARGET_ATTRIBUTE("sse2,pclmul")
+inline __m128i crc32FoldPclmul128(const __m128i &x, const __m128i &constants, const __m128i &next)
+{
+    const __m128i low  = _mm_clmulepi64_si128(x, constants, 0x00);
+    const __m128i high = _mm_clmulepi64_si128(x, constants, 0x11);
+    return _mm_xor_si128(_mm_xor_si128(low, high), next);
+}
+
+TARGET_ATTRIBUTE("sse2,pclmul")
+inline uint32_t crc32FoldPclmul(uint32_t crc, const uint8_t *data, std::size_t length,
+                                const Crc32FoldConstants &constants, const Crc32LookupTable &table)
+{
+    if (length >= 64)
+    {
+        const __m128i fold4 = _mm_set_epi64x(static_cast<long long>(constants.fold4High),
+                                             static_cast<long long>(constants.fold4Low));
+        const __m128i fold1 = _mm_set_epi64x(static_cast<long long>(constants.fold1High),
+                                             static_cast<long long>(constants.fold1Low));
+
+        __m128i x0 = _mm_loadu_si128(reinterpret_cast<const __m128i*>(data));
+        __m128i x1 = _mm_loadu_si128(reinterpret_cast<const __m128i*>(data + 16));
+        __m128i x2 = _mm_loadu_si128(reinterpret_cast<const __m128i*>(data + 32));
+        __m128i x3 = _mm_loadu_si128(reinterpret_cast<const __m128i*>(data + 48));
+        x0 = _mm_xor_si128(x0, _mm_cvtsi32_si128(static_cast<int>(crc)));
+        data   += 64;
+        length -= 64;
+
+        // four independent streams hide the latency of the multiplier
+        while (length >= 64)
+        {
+            x0 = crc32FoldPclmul128(x0, fold4, _mm_loadu_si128(reinterpret_cast<const __m128i*>(data)));
+            x1 = crc32FoldPclmul128(x1, fold4, _mm_loadu_si128(reinterpret_cast<const __m128i*>(data + 16)));
+            x2 = crc32FoldPclmul128(x2, fold4, _mm_loadu_si128(reinterpret_cast<const __m128i*>(data + 32)));
+            x3 = crc32FoldPclmul128(x3, fold4, _mm_loadu_si128(reinterpret_cast<const __m128i*>(data + 48)));
+            data   += 64;
+            length -= 64;
+        }
+
+        // fold the four streams into one
+        x1 = crc32FoldPclmul128(x0, fold1, x1);
+        x2 = crc32FoldPclmul128(x1, fold1, x2);
+        x3 = crc32FoldPclmul128(x2, fold1, x3);
+
+        while (length >= 16)
+        {
+            x3 = crc32FoldPclmul128(x3, fold1, _mm_loadu_si128(reinterpret_cast<const __m128i*>(data)));
+            data   += 16;
+            length -= 16;
+        }
+
+        uint8_t folded[16];
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(folded), x3);
+        crc = crc32FoldedBlock(folded, table);
+    }
+
+    return crc32Bytewise(crc, data, length, table);
+}
+
+#endif // ARCH_X86
+
+#if defined(CRC32_ARM_CRC32)
+
+inline uint32_t crc32Arm(uint32_t crc, const uint8_t *data, std::size_t length, const bool &castagnoli)
+{
+    while (length >= sizeof(uint64_t))
+    {
+        uint64_t value;
+        std::memcpy(&value, data, sizeof(uint64_t));
+        crc = castagnoli ? __crc32cd(crc, value) : __crc32d(crc, value);
+        data   += sizeof(uint64_t);
+        length -= sizeof(uint64_t);
+    }
+
+    while (length-- != 0)
+    {
+        crc = castagnoli ? __crc32cb(crc, *data) : __crc32b(crc, *data);
+        ++data;
+    }
+
+    return crc;
+}
+
+#endif // CRC32_ARM_CRC32
+
+#if defined(CRC32_ARM_PMULL)
+
+inline uint64x2_t crc32FoldPmull128(const uint64x2_t &x, const uint64x2_t &constants, const uint64x2_t &next)
+{
+    const poly64x2_t px = vreinterpretq_p64_u64(x);
+    const poly64x2_t pk = vreinterpretq_p64_u64(constants);
+    const uint64x2_t low  = vreinterpretq_u64_p128(vmull_p64(vgetq_lane_p64(px, 0), vgetq_lane_p64(pk, 0)));
+    const uint64x2_t high = vreinterpretq_u64_p128(vmull_high_p64(px, pk));
+    return veorq_u64(veorq_u64(low, high), next);
+}
+
+inline uint64x2_t crc32LoadPmull128(const uint8_t *data)
+{
+    return vreinterpretq_u64_u8(vld1q_u8(data));
+}
+
+inline uint32_t crc32FoldPmull(uint32_t crc, const uint8_t *data, std::size_t length,
+                               const Crc32FoldConstants &constants, const Crc32LookupTable &table)
+{
+    if (length >= 64)
+    {
+        const uint64x2_t fold4 = vcombine_u64(vcreate_u64(constants.fold4Low), vcreate_u64(constants.fold4High));
+        const uint64x2_t fold1 = vcombine_u64(vcreate_u64(constants.fold1Low), vcreate_u64(constants.fold1High));
+
+        uint64x2_t x0 = crc32LoadPmull128(data);
+        uint64x2_t x1 = crc32LoadPmull128(data + 16);
+        uint64x2_t x2 = crc32LoadPmull128(data + 32);
+        uint64x2_t x3 = crc32LoadPmull128(data + 48);
+        x0 = veorq_u64(x0, vcombine_u64(vcreate_u64(crc), vcreate_u64(0)));
+        data   += 64;
+        length -= 64;
+
+        while (length >= 64)
+        {
+            x0 = crc32FoldPmull128(x0, fold4, crc32LoadPmull128(data));
+            x1 = crc32FoldPmull128(x1, fold4, crc32LoadPmull128(data + 16));
+            x2 = crc32FoldPmull128(x2, fold4, crc32LoadPmull128(data + 32));
+            x3 = crc32FoldPmull128(x3, fold4, crc32LoadPmull128(data + 48));
+            data   += 64;
+            length -= 64;
+        }
+
+        x1 = crc32FoldPmull128(x0, fold1, x1);
+        x2 = crc32FoldPmull128(x1, fold1, x2);
+        x3 = crc32FoldPmull128(x2, fold1, x3);
+
+        while (length >= 16)
+        {
+            x3 = crc32FoldPmull128(x3, fold1, crc32LoadPmull128(data));
+            data   += 16;
+            length -= 16;
+        }
+
+        uint8_t folded[16];
+        vst1q_u8(folded, vreinterpretq_u8_u64(x3));
+        crc = crc32FoldedBlock(folded, table);
+    }
+
+    return crc32Bytewise(crc, data, length, table);
+}
+
+#endif // CRC32_ARM_PMULL
+
+} // detail namespace
+
+} // crc namespace
+} // hashing namespace
+} // keeg namespace
+
+#endif // CRC32ACCELERATED_HPP
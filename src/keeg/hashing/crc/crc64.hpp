@@ -28,9 +28,10 @@
 #ifndef CRC64_HPP
 #define CRC64_HPP
 
-#include <keeg/hashing/hashalgorithm.hpp>
+#include <keeg/hashing/integerhashalgorithm.hpp>
+#include <keeg/hashing/crc/crccombine.hpp>
+#include <keeg/hashing/crc/crctables.hpp>
 #include <keeg/endian/conversion.hpp>
-#include <array>
 
 /// The CRC 64 ISO polynomial, defined in ISO 3309 and used in HDLC.
 #define CRC_64_ISO_POLYNOMIAL UINT64_C(0xD800000000000000)
@@ -45,11 +46,31 @@
     #define DEFAULT_POLYNOMIAL64 ECMA_182_POLYNOMIAL
 #endif
 
-#define MAX_CRC64_SLICE UINT64_C(16)
-
 namespace keeg { namespace hashing { namespace crc {
 
-class Crc64 : public HashAlgorithm
+using Crc64LookupTable = CrcSliceTable<uint64_t>;
+
+namespace detail {
+
+/// Lookup table shared by every Crc64 using the polynomial.
+/// The well known polynomials are generated at compile time.
+inline const Crc64LookupTable &crc64LookupTable(const uint64_t &polynomial)
+{
+    switch (polynomial) {
+    case ECMA_182_POLYNOMIAL:
+        return CrcStaticTable<uint64_t, ECMA_182_POLYNOMIAL>::value;
+    case CRC_64_ISO_POLYNOMIAL:
+        return CrcStaticTable<uint64_t, CRC_64_ISO_POLYNOMIAL>::value;
+    case JONES_POLYNOMIAL:
+        return CrcStaticTable<uint64_t, JONES_POLYNOMIAL>::value;
+    default:
+        return crcSharedTable<uint64_t>(polynomial);
+    }
+}
+
+} // detail namespace
+
+class Crc64 : public IntegerHashAlgorithm<uint64_t>
 {
 public:
     Crc64(const uint64_t &polynomial = DEFAULT_POLYNOMIAL64, const uint64_t &seed = UINT64_C(0));
@@ -57,32 +78,40 @@ public:
     // HashAlgorithm interface
 public:
     virtual std::size_t hashSize() override;
+    virtual std::unique_ptr<HashAlgorithm> copy() const override;
     virtual void initialize() override;
+    /// The private register update below would hide these.
+    using IntegerHashAlgorithm<uint64_t>::update;
+
+    /// Crc of two blocks joined together, crcB must be computed with a zero seed.
+    uint64_t combine(const uint64_t &crcA, const uint64_t &crcB, const uint64_t &lengthB) const;
+
+    /// compute the crc of a memory block split across threads, 0 uses every hardware thread.
+    std::vector<uint8_t> computeHashParallel(const void *data, const std::size_t &dataLength,
+                                             const std::size_t &threadCount = 0);
 
 protected:
-    /// compute CRC64 (Slicing-by-16 algorithm)
     virtual void hashCore(const void *data, const std::size_t &dataLength, const std::size_t &startIndex) override;
-    virtual std::vector<uint8_t> hashFinal() override;
+    virtual uint64_t hashFinalValue() override;
 
 private:
-    static const std::size_t MaxSlice   = MAX_CRC64_SLICE;
     static const std::size_t m_hashSize = std::numeric_limits<uint64_t>::digits;
 
     /// CRC64 Polynomial
     uint64_t m_polynomial;
     uint64_t m_seed;
     uint64_t m_hash;
-//    uint64_t m_lookupTable[MaxSlice][256] = {{0}};
-    std::array<std::array<uint64_t, 256>, MaxSlice> m_lookupTable;
+    const Crc64LookupTable *m_lookupTable;
 
-    void initializeTable();
+    /// compute CRC64 (Slicing-by-16 algorithm) on the raw crc register
+    uint64_t update(uint64_t crc, const uint8_t *data, const std::size_t &dataLength) const;
 };
 
 Crc64::Crc64(const uint64_t &polynomial, const uint64_t &seed) :
-    HashAlgorithm(), m_polynomial(polynomial), m_seed(seed)
+    IntegerHashAlgorithm<uint64_t>(), m_polynomial(polynomial), m_seed(seed),
+    m_lookupTable(&detail::crc64LookupTable(polynomial))
 {
     initialize();
-    initializeTable();
 }
 
 std::size_t Crc64::hashSize()
@@ -90,17 +119,50 @@ std::size_t Crc64::hashSize()
     return m_hashSize;
 }
 
+std::unique_ptr<HashAlgorithm> Crc64::copy() const
+{
+    return std::unique_ptr<HashAlgorithm>(new Crc64(*this));
+}
+
 void Crc64::initialize()
 {
     m_hash = m_seed;
     m_hashValue.clear();
 }
 
+uint64_t Crc64::combine(const uint64_t &crcA, const uint64_t &crcB, const uint64_t &lengthB) const
+{
+    return crcCombine<uint64_t>(crcA, crcB, lengthB, m_polynomial);
+}
+
+std::vector<uint8_t> Crc64::computeHashParallel(const void *data, const std::size_t &dataLength,
+                                                const std::size_t &threadCount)
+{
+    initialize();
+    KEEG_INSTRUMENT_HASH_CORE(typeid(*this), dataLength);
+
+    const uint64_t crc = crcParallel<uint64_t>(static_cast<const uint8_t*>(data), dataLength, threadCount,
+                                               m_polynomial, [this](const uint8_t *block, const std::size_t &length)
+    {
+        return ~update(~UINT64_C(0), block, length);
+    });
+
+    m_hash = combine(m_hash, crc, dataLength);
+    m_hashValue = hashFinal();
+    return m_hashValue;
+}
+
 void Crc64::hashCore(const void *data, const size_t &dataLength, const size_t &startIndex)
 {
-    uint64_t crc = ~m_hash; /// same as previousCrc64 ^ 0xFFFFFFFFFFFFFFFF
-    const uint8_t* currentByte = static_cast<const uint8_t*>(data) + startIndex;
-    const uint64_t* current = reinterpret_cast<const uint64_t*>(currentByte);
+    const uint8_t* current = static_cast<const uint8_t*>(data) + startIndex;
+    m_hash = ~update(~m_hash, current, dataLength); /// same as previousCrc64 ^ 0xFFFFFFFFFFFFFFFF
+}
+
+uint64_t Crc64::update(uint64_t crc, const uint8_t *data, const std::size_t &dataLength) const
+{
+    const Crc64LookupTable &table = *m_lookupTable;
+    const uint8_t* currentByte = data;
+    const uint8_t* current = currentByte;
     std::size_t numBytes = dataLength;
 
     /// enabling optimization (at least -O2) automatically unrolls the inner for-loop
@@ -113,44 +175,46 @@ void Crc64::hashCore(const void *data, const size_t &dataLength, const size_t &s
       for (std::size_t unrolling = 0; unrolling < Unroll; unrolling++)
       {
   #if __BYTE_ORDER == __BIG_ENDIAN
-          uint64_t one   = *current++ ^ swap(crc);
-          uint64_t two   = *current++;
-          crc  = m_lookupTable[ 0][ two          & 0xFF] ^
-                  m_lookupTable[ 1][(two   >>  8) & 0xFF] ^
-                  m_lookupTable[ 2][(two   >> 16) & 0xFF] ^
-                  m_lookupTable[ 3][(two   >> 24) & 0xFF] ^
-                  m_lookupTable[ 4][(two   >> 32) & 0xFF] ^
-                  m_lookupTable[ 5][(two   >> 40) & 0xFF] ^
-                  m_lookupTable[ 6][(two   >> 48) & 0xFF] ^
-                  m_lookupTable[ 7][(two   >> 56) & 0xFF] ^
-                  m_lookupTable[ 8][ one          & 0xFF] ^
-                  m_lookupTable[ 9][(one   >>  8) & 0xFF] ^
-                  m_lookupTable[10][(one   >> 16) & 0xFF] ^
-                  m_lookupTable[11][(one   >> 24) & 0xFF] ^
-                  m_lookupTable[12][(one   >> 32  & 0xFF] ^
-                                     m_lookupTable[13][(one   >> 40) & 0xFF] ^
-                  m_lookupTable[14][(one   >> 48) & 0xFF] ^
-                  m_lookupTable[15][(one   >> 56) & 0xFF];
+          uint64_t one   = endian::loadUnaligned<uint64_t>(current     ) ^ swap(crc);
+          uint64_t two   = endian::loadUnaligned<uint64_t>(current +  8);
+          current += 16;
+          crc  = table[ 0][ two          & 0xFF] ^
+                  table[ 1][(two   >>  8) & 0xFF] ^
+                  table[ 2][(two   >> 16) & 0xFF] ^
+                  table[ 3][(two   >> 24) & 0xFF] ^
+                  table[ 4][(two   >> 32) & 0xFF] ^
+                  table[ 5][(two   >> 40) & 0xFF] ^
+                  table[ 6][(two   >> 48) & 0xFF] ^
+                  table[ 7][(two   >> 56) & 0xFF] ^
+                  table[ 8][ one          & 0xFF] ^
+                  table[ 9][(one   >>  8) & 0xFF] ^
+                  table[10][(one   >> 16) & 0xFF] ^
+                  table[11][(one   >> 24) & 0xFF] ^
+                  table[12][(one   >> 32) & 0xFF] ^
+                  table[13][(one   >> 40) & 0xFF] ^
+                  table[14][(one   >> 48) & 0xFF] ^
+                  table[15][(one   >> 56) & 0xFF];
 #else
-          uint64_t one   = *current++ ^ crc;
-          uint64_t two   = *current++;
-
-          crc  = m_lookupTable[ 0][(two   >> 56) & 0xFF] ^
-                  m_lookupTable[ 1][(two   >> 48) & 0xFF] ^
-                  m_lookupTable[ 2][(two   >> 40) & 0xFF] ^
-                  m_lookupTable[ 3][(two   >> 32) & 0xFF] ^
-                  m_lookupTable[ 4][(two   >> 24) & 0xFF] ^
-                  m_lookupTable[ 5][(two   >> 16) & 0xFF] ^
-                  m_lookupTable[ 6][(two   >>  8) & 0xFF] ^
-                  m_lookupTable[ 7][ two          & 0xFF] ^
-                  m_lookupTable[ 8][(one   >> 56) & 0xFF] ^
-                  m_lookupTable[ 9][(one   >> 48) & 0xFF] ^
-                  m_lookupTable[10][(one   >> 40) & 0xFF] ^
-                  m_lookupTable[11][(one   >> 32) & 0xFF] ^
-                  m_lookupTable[12][(one   >> 24) & 0xFF] ^
-                  m_lookupTable[13][(one   >> 16) & 0xFF] ^
-                  m_lookupTable[14][(one   >>  8) & 0xFF] ^
-                  m_lookupTable[15][ one          & 0xFF];
+          uint64_t one   = endian::loadUnaligned<uint64_t>(current     ) ^ crc;
+          uint64_t two   = endian::loadUnaligned<uint64_t>(current +  8);
+          current += 16;
+
+          crc  = table[ 0][(two   >> 56) & 0xFF] ^
+                  table[ 1][(two   >> 48) & 0xFF] ^
+                  table[ 2][(two   >> 40) & 0xFF] ^
+                  table[ 3][(two   >> 32) & 0xFF] ^
+                  table[ 4][(two   >> 24) & 0xFF] ^
+                  table[ 5][(two   >> 16) & 0xFF] ^
+                  table[ 6][(two   >>  8) & 0xFF] ^
+                  table[ 7][ two          & 0xFF] ^
+                  table[ 8][(one   >> 56) & 0xFF] ^
+                  table[ 9][(one   >> 48) & 0xFF] ^
+                  table[10][(one   >> 40) & 0xFF] ^
+                  table[11][(one   >> 32) & 0xFF] ^
+                  table[12][(one   >> 24) & 0xFF] ^
+                  table[13][(one   >> 16) & 0xFF] ^
+                  table[14][(one   >>  8) & 0xFF] ^
+                  table[15][ one          & 0xFF];
 #endif
       }
 
@@ -160,56 +224,14 @@ void Crc64::hashCore(const void *data, const size_t &dataLength, const size_t &s
 
     /// remaining 1 to 63 bytes (standard algorithm)
     while (numBytes-- != 0)
-        crc = (crc >> 8) ^ m_lookupTable[0][(crc & 0xFF) ^ *currentByte++];
-
-    m_hash = ~crc;
-}
+        crc = (crc >> 8) ^ table[0][(crc & 0xFF) ^ *currentByte++];
 
-std::vector<uint8_t> Crc64::hashFinal()
-{
-    uint64_t data = endian::native_to_big(m_hash);
-    std::vector<uint8_t> v(reinterpret_cast<uint8_t*>(&data),
-                           reinterpret_cast<uint8_t*>(&data) + sizeof(uint64_t));
-    return std::move(v);
+    return crc;
 }
 
-void Crc64::initializeTable()
+uint64_t Crc64::hashFinalValue()
 {
-    uint64_t entry;
-    for (uint64_t i = 0; i < 256; ++i)
-    {
-        entry = i;
-        for (auto j = 0; j < 8; ++j)
-        {
-            entry = (entry >> 1) ^ ((entry & 1) * m_polynomial);
-        }
-
-        m_lookupTable[0][i] = entry;
-    }
-
-    for (auto i = 0; i < 256; ++i)
-    {
-        for (std::size_t slice = 1; slice < MaxSlice; ++slice)
-        {
-            m_lookupTable[slice][i] =
-                    (m_lookupTable[slice - 1][i] >> 8) ^ m_lookupTable[0][m_lookupTable[slice - 1][i] & 0xFF];
-        }
-    }
-
-    // slicing-by-8 algorithm (from Intel):
-    // http://www.intel.com/technology/comms/perfnet/download/CRC_generators.pdf
-    // http://sourceforge.net/projects/slicing-by-8/
-//    for (auto i = 0; i <= 256; ++i)
-//    {
-//        m_lookupTable[1][i] = (m_lookupTable[0][i] >> 8) ^ m_lookupTable[0][m_lookupTable[0][i] & 0xFF];
-//        m_lookupTable[2][i] = (m_lookupTable[1][i] >> 8) ^ m_lookupTable[0][m_lookupTable[1][i] & 0xFF];
-//        m_lookupTable[3][i] = (m_lookupTable[2][i] >> 8) ^ m_lookupTable[0][m_lookupTable[2][i] & 0xFF];
-
-//        m_lookupTable[4][i] = (m_lookupTable[3][i] >> 8) ^ m_lookupTable[0][m_lookupTable[3][i] & 0xFF];
-//        m_lookupTable[5][i] = (m_lookupTable[4][i] >> 8) ^ m_lookupTable[0][m_lookupTable[4][i] & 0xFF];
-//        m_lookupTable[6][i] = (m_lookupTable[5][i] >> 8) ^ m_lookupTable[0][m_lookupTable[5][i] & 0xFF];
-//        m_lookupTable[7][i] = (m_lookupTable[6][i] >> 8) ^ m_lookupTable[0][m_lookupTable[6][i] & 0xFF];
-//    }
+    return m_hash;
 }
 
 } // crc namespace
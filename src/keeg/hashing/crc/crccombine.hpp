@@ -0,0 +1,153 @@
+/*
+ * Copyright (C) 2017 Larry Lopez
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to
+ * deal in the Software without restriction, including without limitation the
+ * rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+ * sell copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ */
+
+/*
+ * Polynomial arithmetic is adapted from zlib's crc32_combine by Mark Adler.
+ */
+
+#ifndef CRCCOMBINE_HPP
+#define CRCCOMBINE_HPP
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <thread>
+#include <type_traits>
+#include <vector>
+#include <keeg/common/threadgroup.hpp>
+
+#ifndef CRC_PARALLEL_MIN_BLOCK_SIZE
+    // Smallest block handed to a thread, below this starting a thread costs more than it saves.
+    #define CRC_PARALLEL_MIN_BLOCK_SIZE UINT64_C(1048576) // 1 MByte
+#endif
+
+namespace keeg { namespace hashing { namespace crc {
+
+/// Multiplies a and b modulo the reflected polynomial. Both are in reflected form,
+/// where the top bit is x^0.
+template<typename T>
+T crcMultiplyMod(T a, T b, const T &polynomial)
+{
+    static_assert(std::is_integral<T>::value && std::is_unsigned<T>::value, "T must be an unsigned integer type!");
+
+    T mask = static_cast<T>(T(1) << (std::numeric_limits<T>::digits - 1));
+    T product = 0;
+
+    while (mask != 0 && a != 0)
+    {
+        if (a & mask)
+        {
+            product ^= b;
+            a ^= mask;
+        }
+
+        mask >>= 1;
+        b = (b >> 1) ^ ((b & 1) * polynomial);
+    }
+
+    return product;
+}
+
+/// x^exponent modulo the reflected polynomial, in reflected form.
+template<typename T>
+T crcXPowerMod(uint64_t exponent, const T &polynomial)
+{
+    const int Digits = std::numeric_limits<T>::digits;
+
+    // square to get x^(2^k) as we walk the bits of the exponent
+    T power  = static_cast<T>(T(1) << (Digits - 2)); // x^1
+    T result = static_cast<T>(T(1) << (Digits - 1)); // x^0
+
+    while (exponent != 0)
+    {
+        if (exponent & 1)
+            result = crcMultiplyMod<T>(power, result, polynomial);
+
+        exponent >>= 1;
+        if (exponent != 0)
+            power = crcMultiplyMod<T>(power, power, polynomial);
+    }
+
+    return result;
+}
+
+/// Crc of two blocks joined together, computed from the crc of each block, like zlib's crc32_combine.
+/// crcB must have been computed with a zero seed, lengthB is the size of the second block in bytes.
+template<typename T>
+T crcCombine(const T &crcA, const T &crcB, const uint64_t &lengthB, const T &polynomial)
+{
+    return crcMultiplyMod<T>(crcXPowerMod<T>(lengthB * 8, polynomial), crcA, polynomial) ^ crcB;
+}
+
+/// Splits data into up to threadCount blocks, computes the crc of each block on its own thread
+/// and combines the results. blockCrc(data, length) must return the crc of a block from a zero
+/// seed and be safe to call concurrently. A threadCount of 0 uses every hardware thread.
+template<typename T, typename BlockCrc>
+T crcParallel(const uint8_t *data, const std::size_t &dataLength, std::size_t threadCount,
+              const T &polynomial, BlockCrc blockCrc)
+{
+    if (threadCount == 0)
+        threadCount = std::max<std::size_t>(1, std::thread::hardware_concurrency());
+
+    threadCount = std::min<std::size_t>(threadCount,
+                                        std::max<std::size_t>(1, dataLength / CRC_PARALLEL_MIN_BLOCK_SIZE));
+
+    if (threadCount <= 1)
+        return blockCrc(data, dataLength);
+
+    const std::size_t blockSize = dataLength / threadCount;
+    std::vector<T> crcs(threadCount, 0);
+    // Joined before crcs goes away however this returns, a throwing blockCrc is rethrown here.
+    common::ThreadGroup workers;
+    workers.reserve(threadCount - 1);
+
+    for (std::size_t i = 1; i < threadCount; ++i)
+    {
+        const std::size_t begin  = i * blockSize;
+        const std::size_t length = (i + 1 == threadCount) ? dataLength - begin : blockSize;
+        workers.run([&crcs, &blockCrc, data, i, begin, length]()
+        {
+            crcs[i] = blockCrc(data + begin, length);
+        });
+    }
+
+    // the calling thread takes the first block
+    crcs[0] = blockCrc(data, blockSize);
+
+    workers.join();
+
+    T crc = crcs[0];
+    for (std::size_t i = 1; i < threadCount; ++i)
+    {
+        const std::size_t length = (i + 1 == threadCount) ? dataLength - i * blockSize : blockSize;
+        crc = crcCombine<T>(crc, crcs[i], length, polynomial);
+    }
+
+    return crc;
+}
+
+} // crc namespace
+} // hashing namespace
+} // keeg namespace
+
+#endif // CRCCOMBINE_HPP
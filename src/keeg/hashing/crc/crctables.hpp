@@ -0,0 +1,108 @@
+/*
+ * Copyright (C) 2017 Larry Lopez
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to
+ * deal in the Software without restriction, including without limitation the
+ * rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+ * sell copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ */
+#ifndef CRCTABLES_HPP
+#define CRCTABLES_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <type_traits>
+
+#define MAX_CRC_SLICE 16
+
+namespace keeg { namespace hashing { namespace crc {
+
+/// Slicing-by-16 lookup table for a reflected crc polynomial.
+/// A plain array so it can be generated by a constexpr function in C++14.
+template<typename T>
+struct CrcSliceTable
+{
+    static_assert(std::is_integral<T>::value && std::is_unsigned<T>::value, "T must be an unsigned integer type!");
+
+    T values[MAX_CRC_SLICE][256];
+
+    constexpr const T *operator[](const std::size_t &slice) const { return values[slice]; }
+};
+
+/// Builds the slicing-by-16 table for the polynomial. Usable in a constant expression.
+template<typename T>
+constexpr CrcSliceTable<T> makeCrcSliceTable(const T polynomial)
+{
+    CrcSliceTable<T> table{};
+
+    for (std::size_t i = 0; i < 256; ++i)
+    {
+        T entry = static_cast<T>(i);
+        for (std::size_t j = 0; j < 8; ++j)
+            entry = (entry >> 1) ^ ((entry & 1) * polynomial);
+
+        table.values[0][i] = entry;
+    }
+
+    for (std::size_t i = 0; i < 256; ++i)
+    {
+        for (std::size_t slice = 1; slice < MAX_CRC_SLICE; ++slice)
+        {
+            table.values[slice][i] =
+                    (table.values[slice - 1][i] >> 8) ^ table.values[0][table.values[slice - 1][i] & 0xFF];
+        }
+    }
+
+    return table;
+}
+
+/// Table generated by the compiler, for polynomials known at compile time.
+template<typename T, T Polynomial>
+struct CrcStaticTable
+{
+    static constexpr CrcSliceTable<T> value = makeCrcSliceTable<T>(Polynomial);
+};
+
+template<typename T, T Polynomial>
+constexpr CrcSliceTable<T> CrcStaticTable<T, Polynomial>::value;
+
+/// Table for a polynomial only known at runtime. Built on first request and
+/// shared by every caller asking for the same polynomial until the program exits.
+template<typename T>
+const CrcSliceTable<T> &crcSharedTable(const T &polynomial)
+{
+    static std::mutex mutex;
+    static std::map<T, std::unique_ptr<const CrcSliceTable<T>>> tables;
+
+    std::lock_guard<std::mutex> lock(mutex);
+    auto found = tables.find(polynomial);
+    if (found == tables.end())
+    {
+        std::unique_ptr<const CrcSliceTable<T>> table(new CrcSliceTable<T>(makeCrcSliceTable<T>(polynomial)));
+        found = tables.emplace(polynomial, std::move(table)).first;
+    }
+
+    return *found->second;
+}
+
+} // crc namespace
+} // hashing namespace
+} // keeg namespace
+
+#endif // CRCTABLES_HPP
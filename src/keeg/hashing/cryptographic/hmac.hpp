@@ -0,0 +1,267 @@
+/*
+ * Copyright (C) 2017 Larry Lopez
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to
+ * deal in the Software without restriction, including without limitation the
+ * rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+ * sell copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ */
+#ifndef HMAC_HPP
+#define HMAC_HPP
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <memory>
+#include <vector>
+#include <keeg/hashing/keyedhashalgorithm.hpp>
+#include <keeg/hashing/cryptographic/hashmessage.hpp>
+#include <keeg/hashing/cryptographic/md5.hpp>
+#include <keeg/hashing/cryptographic/sha1.hpp>
+#include <keeg/hashing/cryptographic/sha256.hpp>
+#include <keeg/hashing/cryptographic/sha3.hpp>
+
+namespace keeg { namespace hashing { namespace cryptographic {
+
+namespace detail {
+
+/// Compares length bytes in time independent of where they differ.
+inline bool constantTimeEqual(const uint8_t *a, const uint8_t *b, const std::size_t &length)
+{
+    uint8_t difference = 0;
+    for (std::size_t i = 0; i < length; ++i)
+        difference |= a[i] ^ b[i];
+
+    return difference == 0;
+}
+
+} // detail namespace
+
+/// HMAC (RFC 2104) over Md5, Sha1, Sha256 or Sha3. The inner and outer key pads are
+/// hashed once when the key is set, each MAC then starts from a copy of those midstates
+/// and only pays for its own message blocks plus one outer block.
+template<typename Algorithm>
+class Hmac : public KeyedHashAlgorithm
+{
+public:
+    /// Largest digest of the supported algorithms, Sha3 512.
+    static const std::size_t MaxDigestSize = 64;
+
+    /// Keyed with an empty key until setKey.
+    Hmac();
+    /// Uses a configured algorithm, such as Sha3(Sha3Bits::Bits512).
+    explicit Hmac(const Algorithm &hash);
+    Hmac(const Algorithm &hash, const std::vector<uint8_t> &key);
+    virtual ~Hmac();
+
+    /// Size of the MAC in bytes.
+    std::size_t macSize();
+
+    /// Recomputes the MAC of data and compares it with the first macSize bytes of mac in
+    /// constant time. A mac shorter than macSize() checks a truncated MAC, 0 never matches.
+    bool verify(const void *data, const std::size_t &dataLength, const uint8_t *mac, const std::size_t &macSize);
+    /// Checks count messages against this key, macs holds macSize bytes for each one after
+    /// the other. results, when given, is set per message. Returns how many matched.
+    std::size_t verifyBatch(const HashMessage *messages, const std::size_t &count, const uint8_t *macs,
+                            const std::size_t &macSize, bool *results = nullptr);
+    /// Same for vectors, one expected MAC per message. Returns per message results.
+    std::vector<bool> verifyBatch(const std::vector<HashMessage> &messages,
+                                  const std::vector<std::vector<uint8_t>> &macs);
+
+    // HashAlgorithm interface
+public:
+    virtual std::size_t hashSize() override;
+    virtual std::size_t blockSize() override;
+    virtual std::unique_ptr<HashAlgorithm> copy() const override;
+    virtual void initialize() override;
+
+protected:
+    virtual void hashCore(const void *data, const std::size_t &dataLength, const std::size_t &startIndex) override;
+    virtual std::vector<uint8_t> hashFinal() override;
+    virtual void hashFinalTo(uint8_t *digest) override;
+
+    // KeyedHashAlgorithm interface
+    virtual void keyChanged() override;
+
+private:
+    /// State after the key xor ipad block.
+    Algorithm m_inner;
+    /// State after the key xor opad block.
+    Algorithm m_outer;
+    /// Running inner hash of the current message.
+    Algorithm m_hash;
+
+    static_assert(std::is_base_of<HashAlgorithm, Algorithm>::value, "Algorithm must be a HashAlgorithm!");
+};
+
+using HmacMd5 = Hmac<Md5>;
+using HmacSha1 = Hmac<Sha1>;
+using HmacSha256 = Hmac<Sha256>;
+using HmacSha3 = Hmac<Sha3>;
+
+template<typename Algorithm>
+Hmac<Algorithm>::Hmac() : Hmac(Algorithm())
+{ }
+
+template<typename Algorithm>
+Hmac<Algorithm>::Hmac(const Algorithm &hash) : KeyedHashAlgorithm(), m_inner(hash), m_outer(hash), m_hash(hash)
+{
+    keyChanged();
+}
+
+template<typename Algorithm>
+Hmac<Algorithm>::Hmac(const Algorithm &hash, const std::vector<uint8_t> &key) : Hmac(hash)
+{
+    setKey(key);
+}
+
+template<typename Algorithm>
+Hmac<Algorithm>::~Hmac()
+{ }
+
+template<typename Algorithm>
+std::size_t Hmac<Algorithm>::macSize()
+{
+    return hashSize() / std::numeric_limits<uint8_t>::digits;
+}
+
+template<typename Algorithm>
+bool Hmac<Algorithm>::verify(const void *data, const std::size_t &dataLength, const uint8_t *mac,
+                             const std::size_t &macSize)
+{
+    uint8_t expected[MaxDigestSize];
+    const std::size_t size = computeHash(data, dataLength, expected, sizeof(expected));
+    if (macSize == 0 || macSize > size)
+        return false;
+
+    return detail::constantTimeEqual(expected, mac, macSize);
+}
+
+template<typename Algorithm>
+std::size_t Hmac<Algorithm>::verifyBatch(const HashMessage *messages, const std::size_t &count, const uint8_t *macs,
+                                         const std::size_t &macSize, bool *results)
+{
+    std::size_t matched = 0;
+    for (std::size_t i = 0; i < count; ++i)
+    {
+        const bool match = verify(messages[i].data, messages[i].length, macs + i * macSize, macSize);
+        if (results != nullptr)
+            results[i] = match;
+        matched += match ? 1 : 0;
+    }
+
+    return matched;
+}
+
+template<typename Algorithm>
+std::vector<bool> Hmac<Algorithm>::verifyBatch(const std::vector<HashMessage> &messages,
+                                               const std::vector<std::vector<uint8_t>> &macs)
+{
+    std::vector<bool> results(messages.size(), false);
+    for (std::size_t i = 0; i < messages.size() && i < macs.size(); ++i)
+        results[i] = verify(messages[i].data, messages[i].length, macs[i].data(), macs[i].size());
+
+    return results;
+}
+
+template<typename Algorithm>
+std::size_t Hmac<Algorithm>::hashSize()
+{
+    return m_hash.hashSize();
+}
+
+template<typename Algorithm>
+std::size_t Hmac<Algorithm>::blockSize()
+{
+    return m_hash.blockSize();
+}
+
+template<typename Algorithm>
+std::unique_ptr<HashAlgorithm> Hmac<Algorithm>::copy() const
+{
+    return std::unique_ptr<HashAlgorithm>(new Hmac<Algorithm>(*this));
+}
+
+template<typename Algorithm>
+void Hmac<Algorithm>::initialize()
+{
+    m_hash = m_inner;
+    m_hashValue.clear();
+}
+
+template<typename Algorithm>
+void Hmac<Algorithm>::hashCore(const void *data, const std::size_t &dataLength, const std::size_t &startIndex)
+{
+    m_hash.update(static_cast<const uint8_t*>(data) + startIndex, dataLength);
+}
+
+template<typename Algorithm>
+std::vector<uint8_t> Hmac<Algorithm>::hashFinal()
+{
+    std::vector<uint8_t> v(macSize());
+    hashFinalTo(v.data());
+    return v;
+}
+
+template<typename Algorithm>
+void Hmac<Algorithm>::hashFinalTo(uint8_t *digest)
+{
+    uint8_t inner[MaxDigestSize];
+    const std::size_t size = m_hash.finalize(inner, sizeof(inner));
+
+    Algorithm outer(m_outer);
+    outer.update(inner, size);
+    outer.finalize(digest, size);
+}
+
+template<typename Algorithm>
+void Hmac<Algorithm>::keyChanged()
+{
+    const std::size_t padSize = m_inner.blockSize();
+    std::vector<uint8_t> pad(padSize, 0);
+
+    // Keys longer than a block are hashed down first.
+    if (m_key.size() > padSize)
+    {
+        m_inner.initialize();
+        m_inner.update(m_key.data(), m_key.size());
+        m_inner.finalize(pad.data(), pad.size());
+    }
+    else
+    {
+        std::copy(m_key.begin(), m_key.end(), pad.begin());
+    }
+
+    for (uint8_t &byte : pad)
+        byte ^= 0x36;
+    m_inner.initialize();
+    m_inner.update(pad.data(), pad.size());
+
+    for (uint8_t &byte : pad)
+        byte ^= 0x36 ^ 0x5C;
+    m_outer.initialize();
+    m_outer.update(pad.data(), pad.size());
+
+    std::fill(pad.begin(), pad.end(), 0);
+    initialize();
+}
+
+} // cryptographic namespace
+} // hashing namespace
+} // keeg namespace
+
+#endif // HMAC_HPP
@@ -0,0 +1,516 @@
+/*
+ * Copyright (C) 2017 Larry Lopez
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to
+ * deal in the Software without restriction, including without limitation the
+ * rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+ * sell copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ */
+#ifndef KECCAK_HPP
+#define KECCAK_HPP
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <keeg/common/backendregistry.hpp>
+#include <keeg/common/cpufeatures.hpp>
+#include <keeg/common/macrohelpers.hpp>
+#include <keeg/endian/conversion.hpp>
+#include <keeg/hashing/cryptographic/hashmessage.hpp>
+
+// The batch kernels are written with the GCC/Clang vector extensions.
+#if defined(ARCH_X86) && (defined(__GNUC__) || defined(__clang__))
+    #define KECCAK_VECTOR_LANES 1
+#endif
+
+namespace keeg { namespace hashing { namespace cryptographic {
+
+/// Implementation of Keccak-f[1600], one state or several states side by side.
+enum class KeccakBackend
+{
+    Scalar,     ///< portable C++
+    Bmi2,       ///< same code using x86 andn and rorx
+    Sse2x2,     ///< two states in SSE2 registers
+    Avx2x4,     ///< four states in AVX2 registers
+    Avx512x8    ///< eight states in AVX-512 registers
+};
+
+namespace detail {
+
+const std::size_t KeccakStateWords = 25;
+const std::size_t KeccakRounds = 24;
+
+const uint64_t KeccakRoundConstants[KeccakRounds] =
+{
+    UINT64_C(0x0000000000000001), UINT64_C(0x0000000000008082), UINT64_C(0x800000000000808a),
+    UINT64_C(0x8000000080008000), UINT64_C(0x000000000000808b), UINT64_C(0x0000000080000001),
+    UINT64_C(0x8000000080008081), UINT64_C(0x8000000000008009), UINT64_C(0x000000000000008a),
+    UINT64_C(0x0000000000000088), UINT64_C(0x0000000080008009), UINT64_C(0x000000008000000a),
+    UINT64_C(0x000000008000808b), UINT64_C(0x800000000000008b), UINT64_C(0x8000000000008089),
+    UINT64_C(0x8000000000008003), UINT64_C(0x8000000000008002), UINT64_C(0x8000000000000080),
+    UINT64_C(0x000000000000800a), UINT64_C(0x800000008000000a), UINT64_C(0x8000000080008081),
+    UINT64_C(0x8000000000008080), UINT64_C(0x0000000080000001), UINT64_C(0x8000000080008008)
+};
+
+/// Lane is uint64_t or a vector of them, every operation is plain C++ so the same code
+/// compiles to andn/rorx, SSE2, AVX2 or AVX-512 depending on the caller's target.
+template<int N, typename Lane>
+FORCE_INLINE void keccakRotate(Lane &x)
+{
+    x = (x << N) | (x >> (64 - N));
+}
+
+/// Chi on one plane of five lanes, written to out.
+template<typename Lane>
+FORCE_INLINE void keccakChi(Lane *out, const Lane &b0, const Lane &b1, const Lane &b2, const Lane &b3, const Lane &b4)
+{
+    out[0] = b0 ^ (~b1 & b2);
+    out[1] = b1 ^ (~b2 & b3);
+    out[2] = b2 ^ (~b3 & b4);
+    out[3] = b3 ^ (~b4 & b0);
+    out[4] = b4 ^ (~b0 & b1);
+}
+
+/// One round from in to out, lane x + 5y of the state at index x + 5 * y.
+/// Rho and pi are folded into the loads, each output plane gathers its five lanes directly.
+template<typename Lane>
+FORCE_INLINE void keccakRound(const Lane *in, Lane *out, const uint64_t &roundConstant)
+{
+    const Lane c0 = in[0] ^ in[5] ^ in[10] ^ in[15] ^ in[20];
+    const Lane c1 = in[1] ^ in[6] ^ in[11] ^ in[16] ^ in[21];
+    const Lane c2 = in[2] ^ in[7] ^ in[12] ^ in[17] ^ in[22];
+    const Lane c3 = in[3] ^ in[8] ^ in[13] ^ in[18] ^ in[23];
+    const Lane c4 = in[4] ^ in[9] ^ in[14] ^ in[19] ^ in[24];
+
+    Lane d0 = c1, d1 = c2, d2 = c3, d3 = c4, d4 = c0;
+    keccakRotate<1>(d0); keccakRotate<1>(d1); keccakRotate<1>(d2); keccakRotate<1>(d3); keccakRotate<1>(d4);
+    d0 = d0 ^ c4; d1 = d1 ^ c0; d2 = d2 ^ c1; d3 = d3 ^ c2; d4 = d4 ^ c3;
+
+    Lane b0, b1, b2, b3, b4;
+
+    b0 = in[ 0] ^ d0;
+    b1 = in[ 6] ^ d1; keccakRotate<44>(b1);
+    b2 = in[12] ^ d2; keccakRotate<43>(b2);
+    b3 = in[18] ^ d3; keccakRotate<21>(b3);
+    b4 = in[24] ^ d4; keccakRotate<14>(b4);
+    keccakChi(out, b0, b1, b2, b3, b4);
+    out[0] = out[0] ^ roundConstant;
+
+    b0 = in[ 3] ^ d3; keccakRotate<28>(b0);
+    b1 = in[ 9] ^ d4; keccakRotate<20>(b1);
+    b2 = in[10] ^ d0; keccakRotate< 3>(b2);
+    b3 = in[16] ^ d1; keccakRotate<45>(b3);
+    b4 = in[22] ^ d2; keccakRotate<61>(b4);
+    keccakChi(out + 5, b0, b1, b2, b3, b4);
+
+    b0 = in[ 1] ^ d1; keccakRotate< 1>(b0);
+    b1 = in[ 7] ^ d2; keccakRotate< 6>(b1);
+    b2 = in[13] ^ d3; keccakRotate<25>(b2);
+    b3 = in[19] ^ d4; keccakRotate< 8>(b3);
+    b4 = in[20] ^ d0; keccakRotate<18>(b4);
+    keccakChi(out + 10, b0, b1, b2, b3, b4);
+
+    b0 = in[ 4] ^ d4; keccakRotate<27>(b0);
+    b1 = in[ 5] ^ d0; keccakRotate<36>(b1);
+    b2 = in[11] ^ d1; keccakRotate<10>(b2);
+    b3 = in[17] ^ d2; keccakRotate<15>(b3);
+    b4 = in[23] ^ d3; keccakRotate<56>(b4);
+    keccakChi(out + 15, b0, b1, b2, b3, b4);
+
+    b0 = in[ 2] ^ d2; keccakRotate<62>(b0);
+    b1 = in[ 8] ^ d3; keccakRotate<55>(b1);
+    b2 = in[14] ^ d4; keccakRotate<39>(b2);
+    b3 = in[15] ^ d0; keccakRotate<41>(b3);
+    b4 = in[21] ^ d1; keccakRotate< 2>(b4);
+    keccakChi(out + 20, b0, b1, b2, b3, b4);
+}
+
+/// All 24 rounds, two at a time so the state ping-pongs between two arrays without copies.
+template<typename Lane>
+FORCE_INLINE void keccakPermute(Lane *state)
+{
+    Lane temporary[KeccakStateWords];
+    for (std::size_t round = 0; round < KeccakRounds; round += 2)
+    {
+        keccakRound(state, temporary, KeccakRoundConstants[round]);
+        keccakRound(temporary, state, KeccakRoundConstants[round + 1]);
+    }
+}
+
+inline void keccakF1600Scalar(uint64_t *state)
+{
+    keccakPermute(state);
+}
+
+#if defined(ARCH_X86)
+TARGET_ATTRIBUTE("bmi,bmi2")
+inline void keccakF1600Bmi2(uint64_t *state)
+{
+    keccakPermute(state);
+}
+#endif
+
+#if defined(KECCAK_VECTOR_LANES)
+typedef uint64_t KeccakLanes2 __attribute__((vector_size(16)));
+typedef uint64_t KeccakLanes4 __attribute__((vector_size(32)));
+typedef uint64_t KeccakLanes8 __attribute__((vector_size(64)));
+
+/// Permutes Lanes interleaved states, word i of state l at states[i * Lanes + l].
+template<typename Vector, std::size_t Lanes>
+FORCE_INLINE void keccakPermuteInterleaved(uint64_t *states)
+{
+    Vector state[KeccakStateWords];
+    std::memcpy(state, states, sizeof(state));
+    keccakPermute(state);
+    std::memcpy(states, state, sizeof(state));
+}
+
+TARGET_ATTRIBUTE("sse2")
+inline void keccakF1600x2Sse2(uint64_t *states)
+{
+    keccakPermuteInterleaved<KeccakLanes2, 2>(states);
+}
+
+TARGET_ATTRIBUTE("avx2")
+inline void keccakF1600x4Avx2(uint64_t *states)
+{
+    keccakPermuteInterleaved<KeccakLanes4, 4>(states);
+}
+
+TARGET_ATTRIBUTE("avx512f")
+inline void keccakF1600x8Avx512(uint64_t *states)
+{
+    keccakPermuteInterleaved<KeccakLanes8, 8>(states);
+}
+#endif
+
+/// Fastest single state backend the cpu supports, "keccak" in the BackendRegistry.
+inline KeccakBackend selectKeccakBackend()
+{
+    const common::CpuFeatures &features = common::cpuFeatures();
+    bool bmi2 = false;
+#if defined(ARCH_X86)
+    bmi2 = features.bmi1 && features.bmi2;
+#endif
+
+    (void)features;
+    const common::BackendOption<KeccakBackend> options[] =
+    {
+        { KeccakBackend::Bmi2,   "bmi2",   bmi2 },
+        { KeccakBackend::Scalar, "scalar", true }
+    };
+    return common::selectBackend("keccak", options);
+}
+
+/// Single state backend picked once for the process.
+inline KeccakBackend keccakBackend()
+{
+    static const KeccakBackend backend = selectKeccakBackend();
+    return backend;
+}
+
+/// Widest batch backend the cpu supports, "keccak-batch" in the BackendRegistry.
+/// Without vector lanes messages go one at a time through the single state backend.
+inline KeccakBackend selectKeccakBatchBackend()
+{
+    const common::CpuFeatures &features = common::cpuFeatures();
+    bool vectors = false, sse2 = false;
+#if defined(KECCAK_VECTOR_LANES)
+    vectors = true;
+  #if defined(ARCH_X86_64) || defined(__SSE2__)
+    sse2 = true;
+  #endif
+#endif
+
+    const common::BackendOption<KeccakBackend> options[] =
+    {
+        { KeccakBackend::Avx512x8, "avx512x8", vectors && features.avx512f },
+        { KeccakBackend::Avx2x4,   "avx2x4",   vectors && features.avx2 },
+        { KeccakBackend::Sse2x2,   "sse2x2",   sse2 },
+        { KeccakBackend::Scalar,   "single",   true }
+    };
+    return common::selectBackend("keccak-batch", options);
+}
+
+inline void keccakF1600(uint64_t *state, const KeccakBackend &backend)
+{
+#if defined(ARCH_X86)
+    if (backend == KeccakBackend::Bmi2)
+    {
+        keccakF1600Bmi2(state);
+        return;
+    }
+#endif
+
+    (void)backend;
+    keccakF1600Scalar(state);
+}
+
+inline uint64_t keccakLoadWord(const uint8_t *data)
+{
+    uint64_t word;
+    std::memcpy(&word, data, sizeof(word));
+    return endian::little_to_native(word);
+}
+
+/// Keccak sponge with byte granular absorb and squeeze, shared by Sha3 and Shake.
+/// domain holds the suffix bits and the first padding bit, 0x06 for SHA3 and 0x1F for SHAKE.
+class KeccakSponge
+{
+public:
+    KeccakSponge(const std::size_t &rate, uint8_t domain);
+
+    std::size_t rate() const { return m_rate; }
+    KeccakBackend backend() const { return m_backend; }
+
+    void reset();
+    void absorb(const uint8_t *data, std::size_t length);
+    /// The first call pads the input, after that only squeeze may be called until reset.
+    void squeeze(uint8_t *output, std::size_t length);
+
+private:
+    uint64_t m_state[KeccakStateWords];
+    std::size_t m_rate;
+    std::size_t m_position;
+    uint8_t m_domain;
+    bool m_squeezing;
+    KeccakBackend m_backend;
+
+    void xorByte(const std::size_t &index, const uint8_t &value);
+    uint8_t stateByte(const std::size_t &index) const;
+    void permute();
+};
+
+KeccakSponge::KeccakSponge(const std::size_t &rate, uint8_t domain) :
+    m_rate(rate), m_domain(domain), m_backend(keccakBackend())
+{
+    reset();
+}
+
+void KeccakSponge::reset()
+{
+    std::fill(std::begin(m_state), std::end(m_state), 0);
+    m_position = 0;
+    m_squeezing = false;
+}
+
+void KeccakSponge::absorb(const uint8_t *data, std::size_t length)
+{
+    while (length > 0 && m_position != 0)
+    {
+        xorByte(m_position++, *data++);
+        --length;
+        if (m_position == m_rate)
+        {
+            permute();
+            m_position = 0;
+        }
+    }
+
+    // Whole blocks straight from the input.
+    const std::size_t words = m_rate / 8;
+    while (length >= m_rate)
+    {
+        for (std::size_t i = 0; i < words; ++i)
+            m_state[i] ^= keccakLoadWord(data + 8 * i);
+        permute();
+        data += m_rate;
+        length -= m_rate;
+    }
+
+    while (length-- > 0)
+        xorByte(m_position++, *data++);
+}
+
+void KeccakSponge::squeeze(uint8_t *output, std::size_t length)
+{
+    if (!m_squeezing)
+    {
+        xorByte(m_position, m_domain);
+        xorByte(m_rate - 1, 0x80);
+        permute();
+        m_position = 0;
+        m_squeezing = true;
+    }
+
+    while (length-- > 0)
+    {
+        if (m_position == m_rate)
+        {
+            permute();
+            m_position = 0;
+        }
+        *output++ = stateByte(m_position++);
+    }
+}
+
+void KeccakSponge::xorByte(const std::size_t &index, const uint8_t &value)
+{
+    m_state[index / 8] ^= static_cast<uint64_t>(value) << (8 * (index % 8));
+}
+
+uint8_t KeccakSponge::stateByte(const std::size_t &index) const
+{
+    return static_cast<uint8_t>(m_state[index / 8] >> (8 * (index % 8)));
+}
+
+void KeccakSponge::permute()
+{
+    keccakF1600(m_state, m_backend);
+}
+
+/// Hashes count messages Lanes at a time with one interleaved permutation. A lane whose
+/// message is done takes the next one, so different lengths keep every lane busy.
+/// Digests are written digestSize bytes apart.
+template<std::size_t Lanes>
+class KeccakLanes
+{
+public:
+    using Permutation = void (*)(uint64_t *states);
+
+    static void run(const HashMessage *messages, const std::size_t &count, uint8_t *digests,
+                    const std::size_t &digestSize, const std::size_t &rate, uint8_t domain,
+                    const Permutation &permutation)
+    {
+        alignas(64) uint64_t states[KeccakStateWords * Lanes];
+        Lane lanes[Lanes];
+        std::size_t nextMessage = 0;
+        std::size_t active = 0;
+
+        for (std::size_t l = 0; l < Lanes; ++l)
+        {
+            if (start(lanes[l], states, l, messages, count, nextMessage))
+                ++active;
+        }
+
+        const std::size_t words = rate / 8;
+        while (active > 0)
+        {
+            for (std::size_t l = 0; l < Lanes; ++l)
+            {
+                Lane &lane = lanes[l];
+                if (lane.message == nullptr)
+                    continue;
+
+                // Next block, the last one padded in the lane's buffer.
+                const uint8_t *block = lane.message + lane.offset;
+                if (lane.remaining() < rate)
+                {
+                    std::memset(lane.padded, 0, rate);
+                    std::memcpy(lane.padded, block, lane.remaining());
+                    lane.padded[lane.remaining()] ^= domain;
+                    lane.padded[rate - 1] ^= 0x80;
+                    block = lane.padded;
+                    lane.final = true;
+                }
+
+                for (std::size_t i = 0; i < words; ++i)
+                    states[i * Lanes + l] ^= keccakLoadWord(block + 8 * i);
+                lane.offset += rate;
+            }
+
+            permutation(states);
+
+            for (std::size_t l = 0; l < Lanes; ++l)
+            {
+                Lane &lane = lanes[l];
+                if (lane.message == nullptr || !lane.final)
+                    continue;
+
+                // Every digest size of SHA3 fits in one block of output.
+                uint8_t *digest = digests + lane.index * digestSize;
+                for (std::size_t i = 0; i < digestSize; ++i)
+                    digest[i] = static_cast<uint8_t>(states[(i / 8) * Lanes + l] >> (8 * (i % 8)));
+
+                if (!start(lane, states, l, messages, count, nextMessage))
+                    --active;
+            }
+        }
+    }
+
+private:
+    struct Lane
+    {
+        const uint8_t *message = nullptr;
+        std::size_t length = 0;
+        std::size_t offset = 0;
+        std::size_t index = 0;
+        bool final = false;
+        uint8_t padded[200];
+
+        std::size_t remaining() const { return length - offset; }
+    };
+
+    static bool start(Lane &lane, uint64_t *states, const std::size_t &l, const HashMessage *messages,
+                      const std::size_t &count, std::size_t &nextMessage)
+    {
+        for (std::size_t i = 0; i < KeccakStateWords; ++i)
+            states[i * Lanes + l] = 0;
+
+        if (nextMessage >= count)
+        {
+            lane.message = nullptr;
+            return false;
+        }
+
+        lane.message = static_cast<const uint8_t*>(messages[nextMessage].data);
+        lane.length = messages[nextMessage].length;
+        lane.offset = 0;
+        lane.index = nextMessage++;
+        lane.final = false;
+        return true;
+    }
+};
+
+/// Fixed length hash of many messages with the batch backend, digestSize no larger than rate.
+inline void keccakHashBatch(const HashMessage *messages, const std::size_t &count, uint8_t *digests,
+                            const std::size_t &digestSize, const std::size_t &rate, uint8_t domain,
+                            const KeccakBackend &backend)
+{
+    switch (backend)
+    {
+#if defined(KECCAK_VECTOR_LANES)
+    case KeccakBackend::Avx512x8:
+        KeccakLanes<8>::run(messages, count, digests, digestSize, rate, domain, keccakF1600x8Avx512);
+        return;
+    case KeccakBackend::Avx2x4:
+        KeccakLanes<4>::run(messages, count, digests, digestSize, rate, domain, keccakF1600x4Avx2);
+        return;
+    case KeccakBackend::Sse2x2:
+        KeccakLanes<2>::run(messages, count, digests, digestSize, rate, domain, keccakF1600x2Sse2);
+        return;
+#endif
+    default:
+        break;
+    }
+
+    KeccakSponge sponge(rate, domain);
+    for (std::size_t i = 0; i < count; ++i)
+    {
+        sponge.reset();
+        sponge.absorb(static_cast<const uint8_t*>(messages[i].data), messages[i].length);
+        sponge.squeeze(digests + i * digestSize, digestSize);
+    }
+}
+
+} // detail namespace
+
+} // cryptographic namespace
+} // hashing namespace
+} // keeg namespace
+
+#endif // KECCAK_HPP
@@ -38,17 +38,24 @@ namespace keeg { namespace hashing { namespace cryptographic {
 class Md5 : public HashAlgorithm
 {
 public:
+    /// Size of the hash in bytes.
+    static const std::size_t DigestSize = 16;
+    using Digest = HashDigest<DigestSize>;
+
     Md5();
 
     // HashAlgorithm interface
 public:
     virtual std::size_t hashSize() override;
+    virtual std::size_t blockSize() override;
+    virtual std::unique_ptr<HashAlgorithm> copy() const override;
     virtual void initialize() override;
 
 protected:
     virtual void hashCore(const void *data, const std::size_t &dataLength, const std::size_t &startIndex) override;
 
     virtual std::vector<uint8_t> hashFinal() override;
+    virtual void hashFinalTo(uint8_t *digest) override;
 
 private:
     static const std::size_t m_hashSize = std::numeric_limits<uint8_t>::digits * 16;
@@ -98,6 +105,16 @@ std::size_t Md5::hashSize()
     return m_hashSize;
 }
 
+std::size_t Md5::blockSize()
+{
+    return BLOCK_SIZE;
+}
+
+std::unique_ptr<HashAlgorithm> Md5::copy() const
+{
+    return std::unique_ptr<HashAlgorithm>(new Md5(*this));
+}
+
 void Md5::initialize()
 {
     m_hashValue.clear();
@@ -156,29 +173,31 @@ void Md5::hashCore(const void *data, const std::size_t &dataLength, const std::s
 }
 
 std::vector<uint8_t> Md5::hashFinal()
+{
+    std::vector<uint8_t> v(DigestSize);
+    hashFinalTo(v.data());
+    return v;
+}
+
+void Md5::hashFinalTo(uint8_t *digest)
 {
     // save old hash if buffer is partially filled
-    //uint32_t oldHash[NUM_HASH_VALUES];
     std::array<uint32_t, NUM_HASH_VALUES> oldHash{m_hash};
-//    for (uint32_t i = 0; i < NUM_HASH_VALUES; i++)
-//        oldHash[i] = m_hash[i];
 
     // process remaining bytes
     processBuffer();
 
-    const uint8_t* bytes = reinterpret_cast<const uint8_t*>(&m_hash[0]);
-
-    std::vector<uint8_t> v(bytes, bytes + (m_hashSize/std::numeric_limits<uint8_t>::digits));
+    // MD5 is little endian
+    for (uint32_t i = 0; i < NUM_HASH_VALUES; i++)
+    {
+        *digest++ = static_cast<uint8_t>( m_hash[i]        & 0xFF);
+        *digest++ = static_cast<uint8_t>((m_hash[i] >>  8) & 0xFF);
+        *digest++ = static_cast<uint8_t>((m_hash[i] >> 16) & 0xFF);
+        *digest++ = static_cast<uint8_t>((m_hash[i] >> 24) & 0xFF);
+    }
 
-//    for (uint32_t i = 0; i < NUM_HASH_VALUES; ++i)
-//    {
-//        // restore old hash
-//        m_hash[i] = oldHash[i];
-//    }
     // restore old hash
     m_hash = oldHash;
-
-    return std::move(v);
 }
 
 void Md5::processBlock(const void *data)
@@ -190,50 +209,44 @@ void Md5::processBlock(const void *data)
     uint32_t d = m_hash[3];
 
     // data represented as 16x 32-bit words
-    const uint32_t* words = static_cast<const uint32_t*>(data);
-
-    // computations are little endian, swap data if necessary
-    #if defined(__BYTE_ORDER) && (__BYTE_ORDER != 0) && (__BYTE_ORDER == __BIG_ENDIAN)
-        #define LITTLEENDIAN(x) endian::swap(x)
-    #else
-        #define LITTLEENDIAN(x) (x)
-    #endif
+    // the block may be unaligned, loadLE32 reads it in any case
+    const uint8_t* words = static_cast<const uint8_t*>(data);
 
     // first round
-    uint32_t word0  = LITTLEENDIAN(words[ 0]);
+    uint32_t word0  = endian::loadLE32(words +  0 * 4);
     a = rotateLeft(a + f1(b,c,d) + word0  + 0xd76aa478,  7) + b;
-    uint32_t word1  = LITTLEENDIAN(words[ 1]);
+    uint32_t word1  = endian::loadLE32(words +  1 * 4);
     d = rotateLeft(d + f1(a,b,c) + word1  + 0xe8c7b756, 12) + a;
-    uint32_t word2  = LITTLEENDIAN(words[ 2]);
+    uint32_t word2  = endian::loadLE32(words +  2 * 4);
     c = rotateLeft(c + f1(d,a,b) + word2  + 0x242070db, 17) + d;
-    uint32_t word3  = LITTLEENDIAN(words[ 3]);
+    uint32_t word3  = endian::loadLE32(words +  3 * 4);
     b = rotateLeft(b + f1(c,d,a) + word3  + 0xc1bdceee, 22) + c;
 
-    uint32_t word4  = LITTLEENDIAN(words[ 4]);
+    uint32_t word4  = endian::loadLE32(words +  4 * 4);
     a = rotateLeft(a + f1(b,c,d) + word4  + 0xf57c0faf,  7) + b;
-    uint32_t word5  = LITTLEENDIAN(words[ 5]);
+    uint32_t word5  = endian::loadLE32(words +  5 * 4);
     d = rotateLeft(d + f1(a,b,c) + word5  + 0x4787c62a, 12) + a;
-    uint32_t word6  = LITTLEENDIAN(words[ 6]);
+    uint32_t word6  = endian::loadLE32(words +  6 * 4);
     c = rotateLeft(c + f1(d,a,b) + word6  + 0xa8304613, 17) + d;
-    uint32_t word7  = LITTLEENDIAN(words[ 7]);
+    uint32_t word7  = endian::loadLE32(words +  7 * 4);
     b = rotateLeft(b + f1(c,d,a) + word7  + 0xfd469501, 22) + c;
 
-    uint32_t word8  = LITTLEENDIAN(words[ 8]);
+    uint32_t word8  = endian::loadLE32(words +  8 * 4);
     a = rotateLeft(a + f1(b,c,d) + word8  + 0x698098d8,  7) + b;
-    uint32_t word9  = LITTLEENDIAN(words[ 9]);
+    uint32_t word9  = endian::loadLE32(words +  9 * 4);
     d = rotateLeft(d + f1(a,b,c) + word9  + 0x8b44f7af, 12) + a;
-    uint32_t word10 = LITTLEENDIAN(words[10]);
+    uint32_t word10 = endian::loadLE32(words + 10 * 4);
     c = rotateLeft(c + f1(d,a,b) + word10 + 0xffff5bb1, 17) + d;
-    uint32_t word11 = LITTLEENDIAN(words[11]);
+    uint32_t word11 = endian::loadLE32(words + 11 * 4);
     b = rotateLeft(b + f1(c,d,a) + word11 + 0x895cd7be, 22) + c;
 
-    uint32_t word12 = LITTLEENDIAN(words[12]);
+    uint32_t word12 = endian::loadLE32(words + 12 * 4);
     a = rotateLeft(a + f1(b,c,d) + word12 + 0x6b901122,  7) + b;
-    uint32_t word13 = LITTLEENDIAN(words[13]);
+    uint32_t word13 = endian::loadLE32(words + 13 * 4);
     d = rotateLeft(d + f1(a,b,c) + word13 + 0xfd987193, 12) + a;
-    uint32_t word14 = LITTLEENDIAN(words[14]);
+    uint32_t word14 = endian::loadLE32(words + 14 * 4);
     c = rotateLeft(c + f1(d,a,b) + word14 + 0xa679438e, 17) + d;
-    uint32_t word15 = LITTLEENDIAN(words[15]);
+    uint32_t word15 = endian::loadLE32(words + 15 * 4);
     b = rotateLeft(b + f1(c,d,a) + word15 + 0x49b40821, 22) + c;
 
     // second round
@@ -38,16 +38,23 @@ namespace keeg { namespace hashing { namespace cryptographic {
 class Sha1 : public HashAlgorithm
 {
 public:
+    /// Size of the hash in bytes.
+    static const std::size_t DigestSize = 20;
+    using Digest = HashDigest<DigestSize>;
+
     Sha1();
 
     // HashAlgorithm interface
 public:
     virtual std::size_t hashSize() override;
+    virtual std::size_t blockSize() override;
+    virtual std::unique_ptr<HashAlgorithm> copy() const override;
     virtual void initialize() override;
 
 protected:
     virtual void hashCore(const void *data, const std::size_t &dataLength, const std::size_t &startIndex) override;
     virtual std::vector<uint8_t> hashFinal() override;
+    virtual void hashFinalTo(uint8_t *digest) override;
 
 private:
     static const std::size_t m_hashSize = std::numeric_limits<uint8_t>::digits * 20;
@@ -98,6 +105,16 @@ std::size_t Sha1::hashSize()
     return m_hashSize;
 }
 
+std::size_t Sha1::blockSize()
+{
+    return BLOCK_SIZE;
+}
+
+std::unique_ptr<HashAlgorithm> Sha1::copy() const
+{
+    return std::unique_ptr<HashAlgorithm>(new Sha1(*this));
+}
+
 void Sha1::initialize()
 {
     m_hashValue.clear();
@@ -157,6 +174,13 @@ void Sha1::hashCore(const void *data, const std::size_t &dataLength, const std::
 }
 
 std::vector<uint8_t> Sha1::hashFinal()
+{
+    std::vector<uint8_t> v(DigestSize);
+    hashFinalTo(v.data());
+    return v;
+}
+
+void Sha1::hashFinalTo(uint8_t *digest)
 {
     // save old hash if buffer is partially filled
     std::array<uint32_t, NUM_HASH_VALUES> oldHash{m_hash};
@@ -164,20 +188,16 @@ std::vector<uint8_t> Sha1::hashFinal()
     // process remaining bytes
     processBuffer();
 
-    std::vector<uint8_t> v;
-    v.reserve(m_hashSize/std::numeric_limits<uint8_t>::digits);
     for (uint32_t i = 0; i < NUM_HASH_VALUES; i++)
     {
-        v.insert(v.end(), (m_hash[i] >> 24) & 0xFF);
-        v.insert(v.end(), (m_hash[i] >> 16) & 0xFF);
-        v.insert(v.end(), (m_hash[i] >>  8) & 0xFF);
-        v.insert(v.end(),  m_hash[i]        & 0xFF);
+        *digest++ = static_cast<uint8_t>((m_hash[i] >> 24) & 0xFF);
+        *digest++ = static_cast<uint8_t>((m_hash[i] >> 16) & 0xFF);
+        *digest++ = static_cast<uint8_t>((m_hash[i] >>  8) & 0xFF);
+        *digest++ = static_cast<uint8_t>( m_hash[i]        & 0xFF);
     }
 
     // restore old hash
     m_hash = oldHash;
-
-    return std::move(v);
 }
 
 void Sha1::processBlock(const void *data)
@@ -190,16 +210,12 @@ void Sha1::processBlock(const void *data)
     uint32_t e = m_hash[4];
 
     // data represented as 16x 32-bit words
-    const uint32_t* input = static_cast<const uint32_t*>(data);
+    const uint8_t* input = static_cast<const uint8_t*>(data);
 
+    // convert to big endian, the block may be unaligned
     std::array<uint32_t, 80> words;
-#if defined(__BYTE_ORDER) && (__BYTE_ORDER != 0) && (__BYTE_ORDER == __BIG_ENDIAN)
-    std::copy(input, input + 16, std::begin(words));
-#else
-    // convert to big endian
-    std::transform(input, input + 16, std::begin(words),
-                   [](const uint32_t &b) -> uint32_t { return endian::swap(b); });
-#endif
+    for (int i = 0; i < 16; i++)
+        words[i] = endian::loadBE32(input + i * 4);
 
     // extend to 80 words
     for (int i = 16; i < 80; i++)
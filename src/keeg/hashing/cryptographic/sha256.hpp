@@ -29,25 +29,47 @@
 #define SHA256_HPP
 
 #include <keeg/hashing/hashalgorithm.hpp>
+#include <keeg/hashing/cryptographic/sha256accelerated.hpp>
 #include <keeg/endian/conversion.hpp>
 #include <algorithm>
 #include <array>
 
 namespace keeg { namespace hashing { namespace cryptographic {
 
+using Sha256Digest = HashDigest<32>;
+
 class Sha256 : public HashAlgorithm
 {
 public:
+    /// Size of the hash in bytes.
+    static const std::size_t DigestSize = 32;
+    using Digest = Sha256Digest;
+
     Sha256();
 
+    /// Implementation used by processBlock on this cpu.
+    Sha256Backend backend() const;
+
+    /// Hashes count independent messages into digests, several at a time across SIMD lanes
+    /// when the cpu supports it. Much faster than hashing one after the other when there are
+    /// many small to medium messages.
+    static void computeHashBatch(const HashMessage *messages, const std::size_t &count, Sha256Digest *digests);
+    /// Hashes independent messages, returning one digest per message in the same order.
+    static std::vector<Sha256Digest> computeHashBatch(const std::vector<HashMessage> &messages);
+    /// Implementation used by computeHashBatch on this cpu.
+    static Sha256Backend batchBackend();
+
     // HashAlgorithm interface
 public:
     virtual std::size_t hashSize() override;
+    virtual std::size_t blockSize() override;
+    virtual std::unique_ptr<HashAlgorithm> copy() const override;
     virtual void initialize() override;
 
 protected:
     virtual void hashCore(const void *data, const std::size_t &dataLength, const std::size_t &startIndex) override;
     virtual std::vector<uint8_t> hashFinal() override;
+    virtual void hashFinalTo(uint8_t *digest) override;
 
 private:
     static const std::size_t m_hashSize = std::numeric_limits<uint8_t>::digits * 32;
@@ -64,8 +86,12 @@ private:
     std::array<uint8_t, BLOCK_SIZE> m_buffer;
     /// hash, stored as integers
     std::array<uint32_t, NUM_HASH_VALUES> m_hash;
+    /// picked on construction from the cpu features
+    Sha256Backend m_backend;
 
-    /// process 64 bytes
+    /// process numBlocks consecutive 64 byte blocks with the selected backend
+    void processBlocks(const void *data, const std::size_t &numBlocks);
+    /// process 64 bytes, portable version
     void processBlock(const void *data);
 
     /// process everything left in the internal buffer
@@ -88,16 +114,76 @@ namespace
 
 } // anonymous namespace
 
-Sha256::Sha256() : HashAlgorithm()
+Sha256::Sha256() : HashAlgorithm(),
+    m_backend(detail::sha256Backend())
 {
     initialize();
 }
 
+Sha256Backend Sha256::backend() const
+{
+    return m_backend;
+}
+
+void Sha256::computeHashBatch(const HashMessage *messages, const std::size_t &count, Sha256Digest *digests)
+{
+    if (count == 0)
+        return;
+
+    uint8_t (*output)[32] = reinterpret_cast<uint8_t (*)[32]>(digests);
+    static_assert(sizeof(Sha256Digest) == 32, "Sha256Digest must be a plain 32 byte array!");
+
+    switch (batchBackend())
+    {
+#if defined(ARCH_X86)
+    case Sha256Backend::Avx512x16:
+        detail::Sha256Lanes<16>::run(messages, count, output, detail::sha256CompressAvx512x16);
+        return;
+    case Sha256Backend::Avx2x8:
+        detail::Sha256Lanes<8>::run(messages, count, output, detail::sha256CompressAvx2x8);
+        return;
+    case Sha256Backend::Sse2x4:
+        detail::Sha256Lanes<4>::run(messages, count, output, detail::sha256CompressSse2x4);
+        return;
+#endif
+    default:
+        break;
+    }
+
+    // one at a time, the single stream backend still applies
+    Sha256 sha256;
+    for (std::size_t i = 0; i < count; ++i)
+        sha256.computeHash(messages[i].data, messages[i].length, digests[i]);
+}
+
+std::vector<Sha256Digest> Sha256::computeHashBatch(const std::vector<HashMessage> &messages)
+{
+    std::vector<Sha256Digest> digests(messages.size());
+    computeHashBatch(messages.data(), messages.size(), digests.data());
+    return digests;
+}
+
+Sha256Backend Sha256::batchBackend()
+{
+    static const Sha256Backend backend = detail::selectSha256BatchBackend();
+    return backend;
+}
+
 std::size_t Sha256::hashSize()
 {
     return m_hashSize;
 }
 
+std::size_t Sha256::blockSize()
+{
+    return BLOCK_SIZE;
+}
+
+std::unique_ptr<HashAlgorithm> Sha256::copy() const
+{
+    return std::unique_ptr<HashAlgorithm>(new Sha256(*this));
+}
+
 void Sha256::initialize()
 {
     m_hashValue.clear();
@@ -133,7 +219,7 @@ void Sha256::hashCore(const void *data, const std::size_t &dataLength, const std
     // full buffer
     if (m_bufferSize == BLOCK_SIZE)
     {
-        processBlock(m_buffer.data());
+        processBlocks(m_buffer.data(), 1);
         m_numBytes  += BLOCK_SIZE;
         m_bufferSize = 0;
     }
@@ -143,12 +229,13 @@ void Sha256::hashCore(const void *data, const std::size_t &dataLength, const std
         return;
 
     // process full blocks
-    while (numBytes >= BLOCK_SIZE)
+    if (numBytes >= BLOCK_SIZE)
     {
-        processBlock(current);
-        current    += BLOCK_SIZE;
-        m_numBytes += BLOCK_SIZE;
-        numBytes   -= BLOCK_SIZE;
+        const std::size_t numBlocks = numBytes / BLOCK_SIZE;
+        processBlocks(current, numBlocks);
+        current    += numBlocks * BLOCK_SIZE;
+        m_numBytes += numBlocks * BLOCK_SIZE;
+        numBytes   -= numBlocks * BLOCK_SIZE;
     }
 
     // keep remaining bytes in buffer
@@ -160,6 +247,13 @@ void Sha256::hashCore(const void *data, const std::size_t &dataLength, const std
 }
 
 std::vector<uint8_t> Sha256::hashFinal()
+{
+    std::vector<uint8_t> v(DigestSize);
+    hashFinalTo(v.data());
+    return v;
+}
+
+void Sha256::hashFinalTo(uint8_t *digest)
 {
     // save old hash if buffer is partially filled
     uint32_t oldHash[NUM_HASH_VALUES];
@@ -169,20 +263,31 @@ std::vector<uint8_t> Sha256::hashFinal()
     // process remaining bytes
     processBuffer();
 
-    std::vector<uint8_t> v;
-    v.reserve(m_hashSize/std::numeric_limits<uint8_t>::digits);
     for (uint32_t i = 0; i < NUM_HASH_VALUES; i++)
     {
-        v.insert(v.end(), (m_hash[i] >> 24) & 0xFF);
-        v.insert(v.end(), (m_hash[i] >> 16) & 0xFF);
-        v.insert(v.end(), (m_hash[i] >>  8) & 0xFF);
-        v.insert(v.end(),  m_hash[i]        & 0xFF);
+        *digest++ = static_cast<uint8_t>((m_hash[i] >> 24) & 0xFF);
+        *digest++ = static_cast<uint8_t>((m_hash[i] >> 16) & 0xFF);
+        *digest++ = static_cast<uint8_t>((m_hash[i] >>  8) & 0xFF);
+        *digest++ = static_cast<uint8_t>( m_hash[i]        & 0xFF);
 
         // restore old hash
         m_hash[i] = oldHash[i];
     }
+}
 
-    return std::move(v);
+void Sha256::processBlocks(const void *data, const std::size_t &numBlocks)
+{
+#if defined(ARCH_X86)
+    if (m_backend == Sha256Backend::ShaNi)
+    {
+        detail::sha256CompressShaNi(m_hash.data(), static_cast<const uint8_t*>(data), numBlocks);
+        return;
+    }
+#endif
+
+    const uint8_t *current = static_cast<const uint8_t*>(data);
+    for (std::size_t i = 0; i < numBlocks; ++i, current += BLOCK_SIZE)
+        processBlock(current);
 }
 
 void Sha256::processBlock(const void *data)
@@ -198,17 +303,12 @@ void Sha256::processBlock(const void *data)
     uint32_t h = m_hash[7];
 
     // data represented as 16x 32-bit words
-    const uint32_t* input = static_cast<const uint32_t*>(data);
+    const uint8_t* input = static_cast<const uint8_t*>(data);
 
-    // convert to big endian
+    // convert to big endian, the block may be unaligned
     std::array<uint32_t, 64> words;
-#if defined(__BYTE_ORDER) && (__BYTE_ORDER != 0) && (__BYTE_ORDER == __BIG_ENDIAN)
-    std::copy(input, input + 16, std::begin(words));
-#else
-    // convert to big endian
-    std::transform(input, input + 16, std::begin(words),
-                   [](const uint32_t &b) -> uint32_t { return endian::swap(b); });
-#endif
+    for (int i = 0; i < 16; i++)
+        words[i] = endian::loadBE32(input + i * 4);
 
     uint32_t x,y; // temporaries
 
@@ -405,11 +505,11 @@ void Sha256::processBuffer()
     *addLength   = static_cast<uint8_t>( msgBits        & 0xFF);
 
     // process blocks
-    processBlock(m_buffer.data());
+    processBlocks(m_buffer.data(), 1);
 
     // flowed over into a second block ?
     if (paddedLength > BLOCK_SIZE)
-        processBlock(extra.data());
+        processBlocks(extra.data(), 1);
 }
 
 uint32_t Sha256::f1(uint32_t e, uint32_t f, uint32_t g)
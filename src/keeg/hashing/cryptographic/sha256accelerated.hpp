@@ -0,0 +1,534 @@
+/*
+ * Copyright (C) 2017 Larry Lopez
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to
+ * deal in the Software without restriction, including without limitation the
+ * rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+ * sell copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ */
+
+/*
+ * The SHA extensions kernel follows Intel's "Intel SHA Extensions" white paper
+ * and the public domain sha256-x86 sample by Jeffrey Walton.
+ */
+
+#ifndef SHA256ACCELERATED_HPP
+#define SHA256ACCELERATED_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <keeg/common/backendregistry.hpp>
+#include <keeg/common/cpufeatures.hpp>
+#include <keeg/common/macrohelpers.hpp>
+#include <keeg/hashing/cryptographic/hashmessage.hpp>
+
+namespace keeg { namespace hashing { namespace cryptographic {
+
+/// Implementation used to compress blocks, single stream or several messages at once.
+enum class Sha256Backend
+{
+    Scalar,     ///< portable C++
+    ShaNi,      ///< x86 SHA extensions, one message
+    Sse2x4,     ///< four messages side by side in SSE2 registers
+    Avx2x8,     ///< eight messages side by side in AVX2 registers
+    Avx512x16   ///< sixteen messages side by side in AVX-512 registers
+};
+
+namespace detail {
+
+/// Round constants, also used by the vector kernels.
+alignas(64) const uint32_t Sha256RoundConstants[64] =
+{
+    0x428a2f98, 0x71374491, 0xb5c0fbcf, 0xe9b5dba5, 0x3956c25b, 0x59f111f1, 0x923f82a4, 0xab1c5ed5,
+    0xd807aa98, 0x12835b01, 0x243185be, 0x550c7dc3, 0x72be5d74, 0x80deb1fe, 0x9bdc06a7, 0xc19bf174,
+    0xe49b69c1, 0xefbe4786, 0x0fc19dc6, 0x240ca1cc, 0x2de92c6f, 0x4a7484aa, 0x5cb0a9dc, 0x76f988da,
+    0x983e5152, 0xa831c66d, 0xb00327c8, 0xbf597fc7, 0xc6e00bf3, 0xd5a79147, 0x06ca6351, 0x14292967,
+    0x27b70a85, 0x2e1b2138, 0x4d2c6dfc, 0x53380d13, 0x650a7354, 0x766a0abb, 0x81c2c92e, 0x92722c85,
+    0xa2bfe8a1, 0xa81a664b, 0xc24b8b70, 0xc76c51a3, 0xd192e819, 0xd6990624, 0xf40e3585, 0x106aa070,
+    0x19a4c116, 0x1e376c08, 0x2748774c, 0x34b0bcb5, 0x391c0cb3, 0x4ed8aa4a, 0x5b9cca4f, 0x682e6ff3,
+    0x748f82ee, 0x78a5636f, 0x84c87814, 0x8cc70208, 0x90befffa, 0xa4506ceb, 0xbef9a3f7, 0xc67178f2
+};
+
+/// Initial hash values.
+const uint32_t Sha256InitialHash[8] =
+{
+    0x6a09e667, 0xbb67ae85, 0x3c6ef372, 0xa54ff53a, 0x510e527f, 0x9b05688c, 0x1f83d9ab, 0x5be0cd19
+};
+
+/// Fastest single stream backend the cpu supports, "sha256" in the BackendRegistry.
+inline Sha256Backend selectSha256Backend()
+{
+    const common::CpuFeatures &features = common::cpuFeatures();
+    bool shaNi = false;
+#if defined(ARCH_X86)
+    shaNi = features.sha && features.sse41 && features.ssse3;
+#endif
+
+    (void)features;
+    const common::BackendOption<Sha256Backend> options[] =
+    {
+        { Sha256Backend::ShaNi,  "shani",  shaNi },
+        { Sha256Backend::Scalar, "scalar", true }
+    };
+    return common::selectBackend("sha256", options);
+}
+
+/// Single stream backend picked once for the process.
+inline Sha256Backend sha256Backend()
+{
+    static const Sha256Backend backend = selectSha256Backend();
+    return backend;
+}
+
+/// Fastest backend for hashing many messages, "sha256-batch" in the BackendRegistry.
+/// Sixteen AVX-512 lanes outrun the SHA extensions, eight AVX2 lanes do not, so the
+/// extensions go in between.
+inline Sha256Backend selectSha256BatchBackend()
+{
+    const common::CpuFeatures &features = common::cpuFeatures();
+    bool x86 = false, sse2 = false;
+#if defined(ARCH_X86)
+    x86 = true;
+  #if defined(ARCH_X86_64) || defined(__SSE2__)
+    sse2 = true;
+  #endif
+#endif
+
+    const common::BackendOption<Sha256Backend> options[] =
+    {
+        { Sha256Backend::Avx512x16, "avx512x16", x86 && features.avx512f },
+        { Sha256Backend::ShaNi,     "shani",     x86 && features.sha && features.sse41 && features.ssse3 },
+        { Sha256Backend::Avx2x8,    "avx2x8",    x86 && features.avx2 },
+        { Sha256Backend::Sse2x4,    "sse2x4",    sse2 },
+        { Sha256Backend::Scalar,    "scalar",    true }
+    };
+    return common::selectBackend("sha256-batch", options);
+}
+
+/// Big endian 32 bit load from a possibly unaligned address.
+inline uint32_t sha256LoadWord(const uint8_t *data)
+{
+    return (static_cast<uint32_t>(data[0]) << 24) | (static_cast<uint32_t>(data[1]) << 16) |
+           (static_cast<uint32_t>(data[2]) <<  8) |  static_cast<uint32_t>(data[3]);
+}
+
+#if defined(ARCH_X86)
+/// Four rounds with the SHA extensions, msg holds the next four schedule words.
+TARGET_ATTRIBUTE("sha,sse4.1,ssse3")
+inline void sha256NiRounds(__m128i &state0, __m128i &state1, const __m128i &msg, const std::size_t &round)
+{
+    __m128i sum = _mm_add_epi32(msg, _mm_load_si128(reinterpret_cast<const __m128i*>(Sha256RoundConstants + round)));
+    state1 = _mm_sha256rnds2_epu32(state1, state0, sum);
+    sum = _mm_shuffle_epi32(sum, 0x0E);
+    state0 = _mm_sha256rnds2_epu32(state0, state1, sum);
+}
+
+/// Finishes schedule words next from the two groups before it.
+TARGET_ATTRIBUTE("sha,sse4.1,ssse3")
+inline void sha256NiSchedule(__m128i &next, const __m128i &current, const __m128i &previous)
+{
+    next = _mm_add_epi32(next, _mm_alignr_epi8(current, previous, 4));
+    next = _mm_sha256msg2_epu32(next, current);
+}
+
+/// Compresses numBlocks consecutive 64 byte blocks into state with the SHA extensions.
+TARGET_ATTRIBUTE("sha,sse4.1,ssse3")
+inline void sha256CompressShaNi(uint32_t *state, const uint8_t *data, std::size_t numBlocks)
+{
+    const __m128i byteSwap = _mm_set_epi64x(0x0c0d0e0f08090a0bULL, 0x0405060700010203ULL);
+
+    // the instructions want the state as ABEF and CDGH
+    __m128i temp   = _mm_loadu_si128(reinterpret_cast<const __m128i*>(state));
+    __m128i state1 = _mm_loadu_si128(reinterpret_cast<const __m128i*>(state + 4));
+    temp   = _mm_shuffle_epi32(temp, 0xB1);
+    state1 = _mm_shuffle_epi32(state1, 0x1B);
+    __m128i state0 = _mm_alignr_epi8(temp, state1, 8);
+    state1 = _mm_blend_epi16(state1, temp, 0xF0);
+
+    while (numBlocks-- != 0)
+    {
+        const __m128i saved0 = state0;
+        const __m128i saved1 = state1;
+
+        __m128i msg0 = _mm_shuffle_epi8(_mm_loadu_si128(reinterpret_cast<const __m128i*>(data)), byteSwap);
+        __m128i msg1 = _mm_shuffle_epi8(_mm_loadu_si128(reinterpret_cast<const __m128i*>(data + 16)), byteSwap);
+        __m128i msg2 = _mm_shuffle_epi8(_mm_loadu_si128(reinterpret_cast<const __m128i*>(data + 32)), byteSwap);
+        __m128i msg3 = _mm_shuffle_epi8(_mm_loadu_si128(reinterpret_cast<const __m128i*>(data + 48)), byteSwap);
+
+        sha256NiRounds(state0, state1, msg0, 0);
+        sha256NiRounds(state0, state1, msg1, 4);
+        msg0 = _mm_sha256msg1_epu32(msg0, msg1);
+        sha256NiRounds(state0, state1, msg2, 8);
+        msg1 = _mm_sha256msg1_epu32(msg1, msg2);
+
+        // from here on every group of four rounds also extends the schedule
+        for (std::size_t round = 12; round < 48; round += 16)
+        {
+            sha256NiRounds(state0, state1, msg3, round);
+            sha256NiSchedule(msg0, msg3, msg2);
+            msg2 = _mm_sha256msg1_epu32(msg2, msg3);
+
+            sha256NiRounds(state0, state1, msg0, round + 4);
+            sha256NiSchedule(msg1, msg0, msg3);
+            msg3 = _mm_sha256msg1_epu32(msg3, msg0);
+
+            sha256NiRounds(state0, state1, msg1, round + 8);
+            sha256NiSchedule(msg2, msg1, msg0);
+            msg0 = _mm_sha256msg1_epu32(msg0, msg1);
+
+            sha256NiRounds(state0, state1, msg2, round + 12);
+            sha256NiSchedule(msg3, msg2, msg1);
+            msg1 = _mm_sha256msg1_epu32(msg1, msg2);
+        }
+
+        sha256NiRounds(state0, state1, msg3, 60);
+
+        state0 = _mm_add_epi32(state0, saved0);
+        state1 = _mm_add_epi32(state1, saved1);
+        data += 64;
+    }
+
+    // back to ABCD and EFGH
+    temp   = _mm_shuffle_epi32(state0, 0x1B);
+    state1 = _mm_shuffle_epi32(state1, 0xB1);
+    state0 = _mm_blend_epi16(temp, state1, 0xF0);
+    state1 = _mm_alignr_epi8(state1, temp, 8);
+
+    _mm_storeu_si128(reinterpret_cast<__m128i*>(state), state0);
+    _mm_storeu_si128(reinterpret_cast<__m128i*>(state + 4), state1);
+}
+#endif
+
+/*
+ * Multi buffer kernels. Lane i of every vector belongs to message i, so the state is kept
+ * transposed: state[word][lane]. The schedule words arrive transposed and already converted
+ * from big endian, see Sha256Lanes::stage().
+ */
+
+#if defined(ARCH_X86)
+
+template<int N>
+TARGET_ATTRIBUTE("sse2")
+inline __m128i sha256RotateRightSse2(const __m128i &x)
+{
+    return _mm_or_si128(_mm_srli_epi32(x, N), _mm_slli_epi32(x, 32 - N));
+}
+
+TARGET_ATTRIBUTE("sse2")
+inline void sha256CompressSse2x4(uint32_t (&state)[8][4], const uint32_t (&words)[16][4])
+{
+    __m128i w[16];
+    for (std::size_t t = 0; t < 16; ++t)
+        w[t] = _mm_loadu_si128(reinterpret_cast<const __m128i*>(words[t]));
+
+    __m128i v[8];
+    for (std::size_t i = 0; i < 8; ++i)
+        v[i] = _mm_loadu_si128(reinterpret_cast<const __m128i*>(state[i]));
+
+    __m128i a = v[0], b = v[1], c = v[2], d = v[3], e = v[4], f = v[5], g = v[6], h = v[7];
+
+    for (std::size_t t = 0; t < 64; ++t)
+    {
+        if (t >= 16)
+        {
+            const __m128i w15 = w[(t - 15) & 15];
+            const __m128i w2  = w[(t - 2) & 15];
+            const __m128i s0 = _mm_xor_si128(_mm_xor_si128(sha256RotateRightSse2<7>(w15),
+                                                           sha256RotateRightSse2<18>(w15)),
+                                             _mm_srli_epi32(w15, 3));
+            const __m128i s1 = _mm_xor_si128(_mm_xor_si128(sha256RotateRightSse2<17>(w2),
+                                                           sha256RotateRightSse2<19>(w2)),
+                                             _mm_srli_epi32(w2, 10));
+            w[t & 15] = _mm_add_epi32(_mm_add_epi32(w[t & 15], s0), _mm_add_epi32(w[(t - 7) & 15], s1));
+        }
+
+        const __m128i sum1 = _mm_xor_si128(_mm_xor_si128(sha256RotateRightSse2<6>(e), sha256RotateRightSse2<11>(e)),
+                                           sha256RotateRightSse2<25>(e));
+        const __m128i choose = _mm_xor_si128(_mm_and_si128(e, f), _mm_andnot_si128(e, g));
+        const __m128i x = _mm_add_epi32(_mm_add_epi32(_mm_add_epi32(h, sum1), _mm_add_epi32(choose, w[t & 15])),
+                                        _mm_set1_epi32(static_cast<int>(Sha256RoundConstants[t])));
+        const __m128i sum0 = _mm_xor_si128(_mm_xor_si128(sha256RotateRightSse2<2>(a), sha256RotateRightSse2<13>(a)),
+                                           sha256RotateRightSse2<22>(a));
+        const __m128i majority = _mm_or_si128(_mm_and_si128(a, b), _mm_and_si128(c, _mm_or_si128(a, b)));
+
+        h = g; g = f; f = e;
+        e = _mm_add_epi32(d, x);
+        d = c; c = b; b = a;
+        a = _mm_add_epi32(x, _mm_add_epi32(sum0, majority));
+    }
+
+    const __m128i result[8] = { a, b, c, d, e, f, g, h };
+    for (std::size_t i = 0; i < 8; ++i)
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(state[i]), _mm_add_epi32(v[i], result[i]));
+}
+
+template<int N>
+TARGET_ATTRIBUTE("avx2")
+inline __m256i sha256RotateRightAvx2(const __m256i &x)
+{
+    return _mm256_or_si256(_mm256_srli_epi32(x, N), _mm256_slli_epi32(x, 32 - N));
+}
+
+TARGET_ATTRIBUTE("avx2")
+inline void sha256CompressAvx2x8(uint32_t (&state)[8][8], const uint32_t (&words)[16][8])
+{
+    __m256i w[16];
+    for (std::size_t t = 0; t < 16; ++t)
+        w[t] = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(words[t]));
+
+    __m256i v[8];
+    for (std::size_t i = 0; i < 8; ++i)
+        v[i] = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(state[i]));
+
+    __m256i a = v[0], b = v[1], c = v[2], d = v[3], e = v[4], f = v[5], g = v[6], h = v[7];
+
+    for (std::size_t t = 0; t < 64; ++t)
+    {
+        if (t >= 16)
+        {
+            const __m256i w15 = w[(t - 15) & 15];
+            const __m256i w2  = w[(t - 2) & 15];
+            const __m256i s0 = _mm256_xor_si256(_mm256_xor_si256(sha256RotateRightAvx2<7>(w15),
+                                                                 sha256RotateRightAvx2<18>(w15)),
+                                                _mm256_srli_epi32(w15, 3));
+            const __m256i s1 = _mm256_xor_si256(_mm256_xor_si256(sha256RotateRightAvx2<17>(w2),
+                                                                 sha256RotateRightAvx2<19>(w2)),
+                                                _mm256_srli_epi32(w2, 10));
+            w[t & 15] = _mm256_add_epi32(_mm256_add_epi32(w[t & 15], s0), _mm256_add_epi32(w[(t - 7) & 15], s1));
+        }
+
+        const __m256i sum1 = _mm256_xor_si256(_mm256_xor_si256(sha256RotateRightAvx2<6>(e),
+                                                               sha256RotateRightAvx2<11>(e)),
+                                              sha256RotateRightAvx2<25>(e));
+        const __m256i choose = _mm256_xor_si256(_mm256_and_si256(e, f), _mm256_andnot_si256(e, g));
+        const __m256i x = _mm256_add_epi32(_mm256_add_epi32(_mm256_add_epi32(h, sum1),
+                                                            _mm256_add_epi32(choose, w[t & 15])),
+                                           _mm256_set1_epi32(static_cast<int>(Sha256RoundConstants[t])));
+        const __m256i sum0 = _mm256_xor_si256(_mm256_xor_si256(sha256RotateRightAvx2<2>(a),
+                                                               sha256RotateRightAvx2<13>(a)),
+                                              sha256RotateRightAvx2<22>(a));
+        const __m256i majority = _mm256_or_si256(_mm256_and_si256(a, b), _mm256_and_si256(c, _mm256_or_si256(a, b)));
+
+        h = g; g = f; f = e;
+        e = _mm256_add_epi32(d, x);
+        d = c; c = b; b = a;
+        a = _mm256_add_epi32(x, _mm256_add_epi32(sum0, majority));
+    }
+
+    const __m256i result[8] = { a, b, c, d, e, f, g, h };
+    for (std::size_t i = 0; i < 8; ++i)
+        _mm256_storeu_si256(reinterpret_cast<__m256i*>(state[i]), _mm256_add_epi32(v[i], result[i]));
+}
+
+// The zero masking forms keep GCC from warning about the undefined
+// source operand of the plain intrinsics, the instructions are the same.
+template<int N>
+TARGET_ATTRIBUTE("avx512f")
+inline __m512i sha256RotateRightAvx512(const __m512i &x)
+{
+    return _mm512_maskz_ror_epi32(0xFFFF, x, N);
+}
+
+template<int N>
+TARGET_ATTRIBUTE("avx512f")
+inline __m512i sha256ShiftRightAvx512(const __m512i &x)
+{
+    return _mm512_maskz_srli_epi32(0xFFFF, x, N);
+}
+
+TARGET_ATTRIBUTE("avx512f")
+inline void sha256CompressAvx512x16(uint32_t (&state)[8][16], const uint32_t (&words)[16][16])
+{
+    __m512i w[16];
+    for (std::size_t t = 0; t < 16; ++t)
+        w[t] = _mm512_loadu_si512(words[t]);
+
+    __m512i v[8];
+    for (std::size_t i = 0; i < 8; ++i)
+        v[i] = _mm512_loadu_si512(state[i]);
+
+    __m512i a = v[0], b = v[1], c = v[2], d = v[3], e = v[4], f = v[5], g = v[6], h = v[7];
+
+    for (std::size_t t = 0; t < 64; ++t)
+    {
+        if (t >= 16)
+        {
+            const __m512i w15 = w[(t - 15) & 15];
+            const __m512i w2  = w[(t - 2) & 15];
+            // 0x96 is a three way xor
+            const __m512i s0 = _mm512_ternarylogic_epi32(sha256RotateRightAvx512<7>(w15),
+                                                         sha256RotateRightAvx512<18>(w15),
+                                                         sha256ShiftRightAvx512<3>(w15), 0x96);
+            const __m512i s1 = _mm512_ternarylogic_epi32(sha256RotateRightAvx512<17>(w2),
+                                                         sha256RotateRightAvx512<19>(w2),
+                                                         sha256ShiftRightAvx512<10>(w2), 0x96);
+            w[t & 15] = _mm512_add_epi32(_mm512_add_epi32(w[t & 15], s0), _mm512_add_epi32(w[(t - 7) & 15], s1));
+        }
+
+        const __m512i sum1 = _mm512_ternarylogic_epi32(sha256RotateRightAvx512<6>(e),
+                                                       sha256RotateRightAvx512<11>(e),
+                                                       sha256RotateRightAvx512<25>(e), 0x96);
+        // 0xCA selects f where e is set and g elsewhere
+        const __m512i choose = _mm512_ternarylogic_epi32(e, f, g, 0xCA);
+        const __m512i x = _mm512_add_epi32(_mm512_add_epi32(_mm512_add_epi32(h, sum1),
+                                                            _mm512_add_epi32(choose, w[t & 15])),
+                                           _mm512_set1_epi32(static_cast<int>(Sha256RoundConstants[t])));
+        const __m512i sum0 = _mm512_ternarylogic_epi32(sha256RotateRightAvx512<2>(a),
+                                                       sha256RotateRightAvx512<13>(a),
+                                                       sha256RotateRightAvx512<22>(a), 0x96);
+        // 0xE8 is the bitwise majority
+        const __m512i majority = _mm512_ternarylogic_epi32(a, b, c, 0xE8);
+
+        h = g; g = f; f = e;
+        e = _mm512_add_epi32(d, x);
+        d = c; c = b; b = a;
+        a = _mm512_add_epi32(x, _mm512_add_epi32(sum0, majority));
+    }
+
+    const __m512i result[8] = { a, b, c, d, e, f, g, h };
+    for (std::size_t i = 0; i < 8; ++i)
+        _mm512_storeu_si512(state[i], _mm512_add_epi32(v[i], result[i]));
+}
+#endif
+
+/// Schedules messages onto Lanes side by side SHA-256 computations. A lane that finishes its
+/// message writes the digest and takes the next message right away, so messages of mixed
+/// lengths keep every lane busy until the queue runs dry.
+template<std::size_t Lanes>
+class Sha256Lanes
+{
+public:
+    using State = uint32_t[8][Lanes];
+    using Words = uint32_t[16][Lanes];
+
+    /// Hashes every message, kernel(state, words) must compress one block in each lane.
+    template<typename Kernel>
+    static void run(const HashMessage *messages, const std::size_t &count, uint8_t (*digests)[32], Kernel kernel)
+    {
+        alignas(64) State state;
+        alignas(64) Words words;
+        Lane lanes[Lanes];
+
+        std::size_t next = 0;
+        std::size_t active = 0;
+        for (std::size_t lane = 0; lane < Lanes; ++lane)
+        {
+            if (assign(lanes[lane], state, lane, messages, count, next))
+                ++active;
+        }
+
+        while (active != 0)
+        {
+            for (std::size_t lane = 0; lane < Lanes; ++lane)
+                stage(words, lane, lanes[lane]);
+
+            kernel(state, words);
+
+            for (std::size_t lane = 0; lane < Lanes; ++lane)
+            {
+                Lane &current = lanes[lane];
+                if (!current.active || ++current.block != current.numBlocks)
+                    continue;
+
+                uint8_t *digest = digests[current.message];
+                for (std::size_t i = 0; i < 8; ++i)
+                {
+                    digest[i * 4]     = static_cast<uint8_t>(state[i][lane] >> 24);
+                    digest[i * 4 + 1] = static_cast<uint8_t>(state[i][lane] >> 16);
+                    digest[i * 4 + 2] = static_cast<uint8_t>(state[i][lane] >>  8);
+                    digest[i * 4 + 3] = static_cast<uint8_t>(state[i][lane]);
+                }
+
+                if (!assign(current, state, lane, messages, count, next))
+                    --active;
+            }
+        }
+    }
+
+private:
+    struct Lane
+    {
+        bool active = false;
+        std::size_t message = 0;
+        const uint8_t *data = nullptr;
+        /// blocks that can be read straight from the message
+        std::size_t fullBlocks = 0;
+        /// fullBlocks plus the one or two padding blocks
+        std::size_t numBlocks = 0;
+        std::size_t block = 0;
+        /// last partial block with the padding and bit length appended
+        uint8_t tail[128];
+    };
+
+    static bool assign(Lane &lane, State &state, const std::size_t &index,
+                       const HashMessage *messages, const std::size_t &count, std::size_t &next)
+    {
+        lane.active = next < count;
+        if (!lane.active)
+            return false;
+
+        const HashMessage &message = messages[next];
+        const std::size_t remainder = message.length % 64;
+
+        lane.message    = next++;
+        lane.data       = static_cast<const uint8_t*>(message.data);
+        lane.fullBlocks = message.length / 64;
+        lane.numBlocks  = lane.fullBlocks + (remainder < 56 ? 1 : 2);
+        lane.block      = 0;
+
+        const std::size_t tailSize = (lane.numBlocks - lane.fullBlocks) * 64;
+        std::memset(lane.tail, 0, tailSize);
+        if (remainder != 0)
+            std::memcpy(lane.tail, lane.data + lane.fullBlocks * 64, remainder);
+        lane.tail[remainder] = 0x80;
+
+        const uint64_t numBits = static_cast<uint64_t>(message.length) * 8;
+        for (std::size_t i = 0; i < 8; ++i)
+            lane.tail[tailSize - 1 - i] = static_cast<uint8_t>(numBits >> (i * 8));
+
+        for (std::size_t i = 0; i < 8; ++i)
+            state[i][index] = Sha256InitialHash[i];
+
+        return true;
+    }
+
+    static void stage(Words &words, const std::size_t &index, const Lane &lane)
+    {
+        if (!lane.active)
+        {
+            // idle lane, computes garbage that is never read
+            for (std::size_t t = 0; t < 16; ++t)
+                words[t][index] = 0;
+            return;
+        }
+
+        const uint8_t *block = lane.block < lane.fullBlocks
+                ? lane.data + lane.block * 64
+                : lane.tail + (lane.block - lane.fullBlocks) * 64;
+
+        for (std::size_t t = 0; t < 16; ++t)
+            words[t][index] = sha256LoadWord(block + t * 4);
+    }
+};
+
+} // detail namespace
+
+} // cryptographic namespace
+} // hashing namespace
+} // keeg namespace
+
+#endif // SHA256ACCELERATED_HPP
@@ -0,0 +1,148 @@
+/*
+ * Copyright (C) 2017 Larry Lopez
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to
+ * deal in the Software without restriction, including without limitation the
+ * rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+ * sell copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ */
+#ifndef SHAKE_HPP
+#define SHAKE_HPP
+
+#include <keeg/hashing/hashalgorithm.hpp>
+#include <keeg/hashing/cryptographic/keccak.hpp>
+#include <keeg/common/enums.hpp>
+
+namespace keeg { namespace hashing { namespace cryptographic {
+
+enum class ShakeBits : uint16_t
+{
+    Bits128 = 128,
+    Bits256 = 256
+};
+
+/// SHAKE128 and SHAKE256 extendable output functions from FIPS 202.
+/// Computing a hash returns outputLength bytes, squeeze reads any amount after finishing.
+class Shake : public HashAlgorithm
+{
+public:
+    /// outputLength defaults to twice the security level, 32 bytes for SHAKE128 and 64 for SHAKE256.
+    Shake(const ShakeBits &bits = ShakeBits::Bits128, const std::size_t &outputLength = 0);
+
+    /// Implementation of the permutation used on this cpu.
+    KeccakBackend backend() const;
+
+    /// Bytes returned when finishing a hash.
+    std::size_t outputLength() const;
+    void setOutputLength(const std::size_t &outputLength);
+
+    /// Reads the next length bytes of output. The first call ends the input, call initialize
+    /// before hashing new data. Follows on from the output returned by computeHash.
+    void squeeze(uint8_t *output, const std::size_t &length);
+    std::vector<uint8_t> squeeze(const std::size_t &length);
+
+    // HashAlgorithm interface
+public:
+    virtual std::size_t hashSize() override;
+    virtual std::unique_ptr<HashAlgorithm> copy() const override;
+    virtual void initialize() override;
+
+protected:
+    virtual void hashCore(const void *data, const std::size_t &dataLength, const std::size_t &startIndex) override;
+    virtual std::vector<uint8_t> hashFinal() override;
+    virtual void hashFinalTo(uint8_t *digest) override;
+
+private:
+    /// SHAKE suffix bits 1111 followed by the first padding bit.
+    static const uint8_t Domain = 0x1F;
+
+    detail::KeccakSponge m_sponge;
+    std::size_t m_outputLength;
+    ShakeBits   m_bits;
+};
+
+Shake::Shake(const ShakeBits &bits, const std::size_t &outputLength) :
+    HashAlgorithm(), m_sponge(200 - 2 * (common::enumToIntegral(bits) / 8), Domain),
+    m_outputLength(outputLength == 0 ? common::enumToIntegral(bits) / 4 : outputLength), m_bits(bits)
+{
+    initialize();
+}
+
+KeccakBackend Shake::backend() const
+{
+    return m_sponge.backend();
+}
+
+std::size_t Shake::outputLength() const
+{
+    return m_outputLength;
+}
+
+void Shake::setOutputLength(const std::size_t &outputLength)
+{
+    m_outputLength = outputLength;
+}
+
+void Shake::squeeze(uint8_t *output, const std::size_t &length)
+{
+    m_sponge.squeeze(output, length);
+}
+
+std::vector<uint8_t> Shake::squeeze(const std::size_t &length)
+{
+    std::vector<uint8_t> v(length);
+    squeeze(v.data(), length);
+    return v;
+}
+
+std::size_t Shake::hashSize()
+{
+    return m_outputLength * std::numeric_limits<uint8_t>::digits;
+}
+
+std::unique_ptr<HashAlgorithm> Shake::copy() const
+{
+    return std::unique_ptr<HashAlgorithm>(new Shake(*this));
+}
+
+void Shake::initialize()
+{
+    m_sponge.reset();
+    m_hashValue.clear();
+}
+
+void Shake::hashCore(const void *data, const std::size_t &dataLength, const std::size_t &startIndex)
+{
+    m_sponge.absorb(static_cast<const uint8_t*>(data) + startIndex, dataLength);
+}
+
+std::vector<uint8_t> Shake::hashFinal()
+{
+    std::vector<uint8_t> v(m_outputLength);
+    hashFinalTo(v.data());
+    return v;
+}
+
+void Shake::hashFinalTo(uint8_t *digest)
+{
+    m_sponge.squeeze(digest, m_outputLength);
+}
+
+} // cryptographic namespace
+} // hashing namespace
+} // keeg namespace
+
+#endif // SHAKE_HPP
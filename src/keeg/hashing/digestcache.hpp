@@ -0,0 +1,748 @@
+/*
+ * Copyright (C) 2017 Larry Lopez
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to
+ * deal in the Software without restriction, including without limitation the
+ * rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+ * sell copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ */
+#ifndef DIGESTCACHE_HPP
+#define DIGESTCACHE_HPP
+
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <deque>
+#include <mutex>
+#include <string>
+#include <typeinfo>
+#include <unordered_map>
+#include <vector>
+#include <keeg/hashing/hashalgorithm.hpp>
+#include <keeg/hashing/noncryptographic/fnv.hpp>
+#include <keeg/io/mappedfile.hpp>
+
+#if defined(_WIN32)
+    #ifndef NOMINMAX
+        #define NOMINMAX
+    #endif
+    #include <windows.h>
+#else
+    #include <climits>
+    #include <fcntl.h>
+    #include <sys/file.h>
+    #include <sys/stat.h>
+    #include <unistd.h>
+#endif
+
+#ifndef DIGEST_CACHE_RACY_SECONDS
+    // A file modified this recently isn't cached, a change within the same timestamp tick
+    // after hashing would go unnoticed.
+    #define DIGEST_CACHE_RACY_SECONDS 2
+#endif
+
+namespace keeg { namespace hashing {
+
+/// What identifies the contents of a file without reading it.
+struct FileIdentity
+{
+    uint64_t device = 0;
+    uint64_t inode = 0;
+    uint64_t size = 0;
+    /// Last write, nanoseconds since the Unix epoch.
+    int64_t modified = 0;
+
+    bool operator==(const FileIdentity &other) const
+    {
+        return device == other.device && inode == other.inode && size == other.size && modified == other.modified;
+    }
+    bool operator!=(const FileIdentity &other) const { return !(*this == other); }
+};
+
+/// Identity of the regular file at path, false if it can't be read.
+inline bool fileIdentity(const std::string &path, FileIdentity &identity)
+{
+#if defined(_WIN32)
+    HANDLE file = CreateFileA(path.c_str(), FILE_READ_ATTRIBUTES, FILE_SHARE_READ | FILE_SHARE_WRITE | FILE_SHARE_DELETE,
+                              nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+    if (file == INVALID_HANDLE_VALUE)
+        return false;
+
+    BY_HANDLE_FILE_INFORMATION info;
+    const bool ok = GetFileInformationByHandle(file, &info) != 0 &&
+                    (info.dwFileAttributes & FILE_ATTRIBUTE_DIRECTORY) == 0;
+    CloseHandle(file);
+    if (!ok)
+        return false;
+
+    // FILETIME counts 100ns ticks since 1601.
+    const uint64_t ticks = (static_cast<uint64_t>(info.ftLastWriteTime.dwHighDateTime) << 32) | info.ftLastWriteTime.dwLowDateTime;
+    identity.device = info.dwVolumeSerialNumber;
+    identity.inode = (static_cast<uint64_t>(info.nFileIndexHigh) << 32) | info.nFileIndexLow;
+    identity.size = (static_cast<uint64_t>(info.nFileSizeHigh) << 32) | info.nFileSizeLow;
+    identity.modified = (static_cast<int64_t>(ticks) - INT64_C(116444736000000000)) * 100;
+#else
+    struct stat status;
+    if (stat(path.c_str(), &status) != 0 || !S_ISREG(status.st_mode))
+        return false;
+
+    identity.device = static_cast<uint64_t>(status.st_dev);
+    identity.inode = static_cast<uint64_t>(status.st_ino);
+    identity.size = static_cast<uint64_t>(status.st_size);
+    #if defined(__APPLE__)
+        identity.modified = static_cast<int64_t>(status.st_mtimespec.tv_sec) * INT64_C(1000000000) + status.st_mtimespec.tv_nsec;
+    #else
+        identity.modified = static_cast<int64_t>(status.st_mtim.tv_sec) * INT64_C(1000000000) + status.st_mtim.tv_nsec;
+    #endif
+#endif
+
+    return true;
+}
+
+namespace detail {
+
+#if defined(_WIN32)
+    using DigestCacheFile = HANDLE;
+    static const DigestCacheFile InvalidDigestCacheFile = INVALID_HANDLE_VALUE;
+#else
+    using DigestCacheFile = int;
+    static const DigestCacheFile InvalidDigestCacheFile = -1;
+#endif
+
+/// Advisory lock on the cache's lock file, held while in scope. Appends take it shared,
+/// a compaction exclusive. Without a lock file nothing is locked.
+class DigestCacheLock
+{
+public:
+    DigestCacheLock(const DigestCacheFile &file, const bool &exclusive);
+    DigestCacheLock(const DigestCacheLock&) = delete;
+    DigestCacheLock &operator=(const DigestCacheLock&) = delete;
+    ~DigestCacheLock();
+
+private:
+    DigestCacheFile m_file;
+    bool m_locked;
+};
+
+DigestCacheLock::DigestCacheLock(const DigestCacheFile &file, const bool &exclusive) :
+    m_file(file),
+    m_locked(false)
+{
+    if (m_file == InvalidDigestCacheFile)
+        return;
+
+#if defined(_WIN32)
+    OVERLAPPED overlapped = {};
+    m_locked = LockFileEx(m_file, exclusive ? LOCKFILE_EXCLUSIVE_LOCK : 0, 0, 1, 0, &overlapped) != 0;
+#else
+    m_locked = flock(m_file, exclusive ? LOCK_EX : LOCK_SH) == 0;
+#endif
+}
+
+DigestCacheLock::~DigestCacheLock()
+{
+    if (!m_locked)
+        return;
+
+#if defined(_WIN32)
+    OVERLAPPED overlapped = {};
+    UnlockFileEx(m_file, 0, 1, 0, &overlapped);
+#else
+    flock(m_file, LOCK_UN);
+#endif
+}
+
+/// One cache entry as stored on disk, in native byte order. Files written on a machine
+/// of the other byte order fail the magic check and are ignored.
+struct DigestCacheRecord
+{
+    static const uint32_t Magic = UINT32_C(0x3143444B); // "KDC1"
+    static const std::size_t MaxDigestSize = 64;
+
+    uint32_t magic;
+    uint8_t digestSize;
+    uint8_t reserved[3];
+    uint64_t pathHash;
+    uint64_t algorithmHash;
+    uint64_t device;
+    uint64_t inode;
+    uint64_t size;
+    int64_t modified;
+    uint8_t digest[MaxDigestSize];
+    /// FNV-1a of everything before it, a torn write fails it.
+    uint64_t checksum;
+
+    uint64_t computeChecksum() const
+    {
+        return noncryptographic::fnv1aHash64(reinterpret_cast<const char*>(this), offsetof(DigestCacheRecord, checksum));
+    }
+};
+
+static_assert(sizeof(DigestCacheRecord) == 128, "DigestCacheRecord must be packed to 128 bytes!");
+
+struct DigestCacheKey
+{
+    uint64_t pathHash;
+    uint64_t algorithmHash;
+
+    bool operator==(const DigestCacheKey &other) const
+    {
+        return pathHash == other.pathHash && algorithmHash == other.algorithmHash;
+    }
+};
+
+struct DigestCacheKeyHash
+{
+    std::size_t operator()(const DigestCacheKey &key) const
+    {
+        return static_cast<std::size_t>(key.pathHash ^ (key.algorithmHash * UINT64_C(0x9E3779B97F4A7C15)));
+    }
+};
+
+/// Absolute form of path so the same file is found from any working directory,
+/// path itself if it can't be resolved.
+inline std::string absolutePath(const std::string &path)
+{
+#if defined(_WIN32)
+    char buffer[MAX_PATH];
+    const DWORD length = GetFullPathNameA(path.c_str(), MAX_PATH, buffer, nullptr);
+    if (length == 0 || length >= MAX_PATH)
+        return path;
+    return std::string(buffer, length);
+#else
+    char *resolved = realpath(path.c_str(), nullptr);
+    if (resolved == nullptr)
+        return path;
+    std::string result(resolved);
+    std::free(resolved);
+    return result;
+#endif
+}
+
+} // detail namespace
+
+/// Persistent cache of file digests, so unchanged files aren't read again.
+///
+///   DigestCache cache(".digests");
+///   cryptographic::Sha256 sha;
+///   std::vector<uint8_t> digest = cache.computeHashFile(sha, path);
+///
+/// Entries are keyed by the file's absolute path and the algorithm, and hold the file's
+/// device, inode, size and modification time when it was hashed. A hit needs all four to
+/// still match, anything else hashes the file again and replaces the entry.
+///
+/// The file is a log of fixed 128 byte records, memory mapped on open. New entries are
+/// appended with one write each, so processes sharing a cache file don't corrupt it, and a
+/// record torn by a crash fails its checksum and is skipped. Appends from other processes
+/// are picked up by refresh(), compact() rewrites the log with only the latest entries.
+/// A compaction holds an exclusive lock on the path + ".lock" file from reading the log
+/// to renaming the new one over it, and appends hold it shared, so no process's records
+/// are lost to another's compaction. A cache that can't be written to still works in
+/// memory, and refresh() or compact() retry writing what couldn't be appended. Thread safe.
+///
+/// The algorithm name defaults to the algorithm's type and hash size, pass a name that
+/// includes any seed, key or polynomial when those differ between runs.
+class DigestCache
+{
+public:
+    DigestCache() = default;
+    explicit DigestCache(const std::string &path);
+    DigestCache(const DigestCache&) = delete;
+    DigestCache &operator=(const DigestCache&) = delete;
+    ~DigestCache();
+
+    /// Opens or creates the cache file and loads its entries, false if it can't be read.
+    bool open(const std::string &path);
+    void close();
+    bool isOpen() const;
+    /// Entries in the cache, one per path and algorithm.
+    std::size_t size() const;
+    std::size_t hits() const;
+    std::size_t misses() const;
+
+    /// Digest of the file at path, from the cache when the file hasn't changed, otherwise
+    /// computed with algorithm and stored. Empty if the file can't be read.
+    std::vector<uint8_t> computeHashFile(HashAlgorithm &algorithm, const std::string &path,
+                                         const std::string &algorithmName = std::string());
+
+    /// Cached digest of the file at path if its identity still matches.
+    bool lookup(const std::string &path, const std::string &algorithmName, std::vector<uint8_t> &digest);
+    /// Stores a digest computed by the caller for the file as it was at identity.
+    /// false if the digest is larger than 64 bytes.
+    bool store(const std::string &path, const std::string &algorithmName, const FileIdentity &identity,
+               const std::vector<uint8_t> &digest);
+
+    /// Reloads the file to pick up entries other processes added.
+    bool refresh();
+    /// Rewrites the file with one record per entry, dropping the replaced ones.
+    bool compact();
+
+    /// Name used for algorithm when none is given.
+    static std::string defaultAlgorithmName(HashAlgorithm &algorithm);
+
+private:
+    using Index = std::unordered_map<detail::DigestCacheKey, const detail::DigestCacheRecord*, detail::DigestCacheKeyHash>;
+
+    mutable std::mutex m_mutex;
+    std::string m_path;
+    bool m_open = false;
+    /// Records from the file that passed their checksum, aligned copies.
+    std::vector<detail::DigestCacheRecord> m_loaded;
+    /// Records added since the file was loaded, a deque so pointers into it stay valid.
+    std::deque<detail::DigestCacheRecord> m_added;
+    /// Records that couldn't be appended, put back into the index by every reload.
+    std::vector<detail::DigestCacheRecord> m_unsaved;
+    Index m_index;
+    std::size_t m_hits = 0;
+    std::size_t m_misses = 0;
+
+    detail::DigestCacheFile m_appendFile = detail::InvalidDigestCacheFile;
+    /// Identity of the file m_appendFile points to, to notice a compaction by another process.
+    FileIdentity m_appendIdentity;
+    detail::DigestCacheFile m_lockFile = detail::InvalidDigestCacheFile;
+
+    bool load();
+    bool openAppend();
+    void closeAppend();
+    void openLock();
+    void closeLock();
+    bool append(const detail::DigestCacheRecord &record);
+    bool find(const detail::DigestCacheKey &key, const FileIdentity &identity, std::vector<uint8_t> &digest) const;
+    void insert(const detail::DigestCacheRecord &record);
+    void add(const detail::DigestCacheRecord &record);
+    static detail::DigestCacheKey makeKey(const std::string &absolutePath, const std::string &algorithmName);
+    static detail::DigestCacheRecord makeRecord(const detail::DigestCacheKey &key, const FileIdentity &identity,
+                                                const std::vector<uint8_t> &digest);
+};
+
+DigestCache::DigestCache(const std::string &path)
+{
+    open(path);
+}
+
+DigestCache::~DigestCache()
+{
+    close();
+}
+
+bool DigestCache::open(const std::string &path)
+{
+    close();
+
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_path = path;
+    // The cache still works without write access, entries just aren't kept.
+    openLock();
+    openAppend();
+    m_open = load();
+    if (!m_open)
+    {
+        closeAppend();
+        closeLock();
+    }
+    return m_open;
+}
+
+void DigestCache::close()
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    closeAppend();
+    closeLock();
+    m_index.clear();
+    m_added.clear();
+    m_unsaved.clear();
+    m_loaded.clear();
+    m_loaded.shrink_to_fit();
+    m_open = false;
+}
+
+bool DigestCache::isOpen() const
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return m_open;
+}
+
+std::size_t DigestCache::size() const
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return m_index.size();
+}
+
+std::size_t DigestCache::hits() const
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return m_hits;
+}
+
+std::size_t DigestCache::misses() const
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return m_misses;
+}
+
+std::string DigestCache::defaultAlgorithmName(HashAlgorithm &algorithm)
+{
+    return std::string(typeid(algorithm).name()) + '/' + std::to_string(algorithm.hashSize());
+}
+
+std::vector<uint8_t> DigestCache::computeHashFile(HashAlgorithm &algorithm, const std::string &path,
+                                                  const std::string &algorithmName)
+{
+    const std::string name = algorithmName.empty() ? defaultAlgorithmName(algorithm) : algorithmName;
+
+    FileIdentity before;
+    if (!fileIdentity(path, before))
+        return std::vector<uint8_t>();
+
+    const detail::DigestCacheKey key = makeKey(detail::absolutePath(path), name);
+    std::vector<uint8_t> digest;
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        if (find(key, before, digest))
+        {
+            ++m_hits;
+            return digest;
+        }
+        ++m_misses;
+    }
+
+    digest = algorithm.computeHashFile(path);
+    if (digest.empty() || digest.size() > detail::DigestCacheRecord::MaxDigestSize)
+        return digest;
+
+    // Only cache what is known to be the digest of that identity: unchanged while it was
+    // read, and old enough that a later write can't keep the same timestamp. procfs and
+    // sysfs files report a size of 0 whatever they hold, so empty files aren't cached.
+    FileIdentity after;
+    const int64_t now = std::chrono::duration_cast<std::chrono::nanoseconds>(
+                            std::chrono::system_clock::now().time_since_epoch()).count();
+    if (before.size == 0 || !fileIdentity(path, after) || after != before ||
+        now - before.modified < INT64_C(1000000000) * DIGEST_CACHE_RACY_SECONDS)
+        return digest;
+
+    const detail::DigestCacheRecord record = makeRecord(key, before, digest);
+    std::lock_guard<std::mutex> lock(m_mutex);
+    add(record);
+    return digest;
+}
+
+bool DigestCache::lookup(const std::string &path, const std::string &algorithmName, std::vector<uint8_t> &digest)
+{
+    FileIdentity identity;
+    if (!fileIdentity(path, identity))
+        return false;
+
+    const detail::DigestCacheKey key = makeKey(detail::absolutePath(path), algorithmName);
+    std::lock_guard<std::mutex> lock(m_mutex);
+    const bool found = find(key, identity, digest);
+    ++(found ? m_hits : m_misses);
+    return found;
+}
+
+bool DigestCache::store(const std::string &path, const std::string &algorithmName, const FileIdentity &identity,
+                        const std::vector<uint8_t> &digest)
+{
+    if (digest.empty() || digest.size() > detail::DigestCacheRecord::MaxDigestSize)
+        return false;
+
+    const detail::DigestCacheKey key = makeKey(detail::absolutePath(path), algorithmName);
+
+    const detail::DigestCacheRecord record = makeRecord(key, identity, digest);
+    std::lock_guard<std::mutex> lock(m_mutex);
+    add(record);
+    return true;
+}
+
+bool DigestCache::refresh()
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    if (!m_open)
+        return false;
+
+    // Another process may have compacted the file, appends must follow it.
+    closeAppend();
+    openAppend();
+    if (!load())
+        return false;
+
+    std::vector<detail::DigestCacheRecord> unsaved;
+    unsaved.swap(m_unsaved);
+    for (const detail::DigestCacheRecord &record : unsaved)
+    {
+        if (!append(record))
+            m_unsaved.push_back(record);
+    }
+    return true;
+}
+
+bool DigestCache::compact()
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    if (!m_open)
+        return false;
+
+    // No process appends until the new file is in place, and reloading first keeps the
+    // records they appended since this one last loaded.
+    detail::DigestCacheLock fileLock(m_lockFile, true);
+    if (!load())
+        return false;
+
+    // Written next to the cache and renamed over it, readers see the old or the new file.
+#if defined(_WIN32)
+    const std::string temporary = m_path + ".tmp" + std::to_string(GetCurrentProcessId());
+#else
+    const std::string temporary = m_path + ".tmp" + std::to_string(getpid());
+#endif
+    std::FILE *file = std::fopen(temporary.c_str(), "wb");
+    if (file == nullptr)
+        return false;
+
+    bool ok = true;
+    for (const auto &entry : m_index)
+        ok = ok && std::fwrite(entry.second, sizeof(detail::DigestCacheRecord), 1, file) == 1;
+    ok = (std::fclose(file) == 0) && ok;
+
+#if defined(_WIN32)
+    ok = ok && MoveFileExA(temporary.c_str(), m_path.c_str(), MOVEFILE_REPLACE_EXISTING) != 0;
+#else
+    ok = ok && std::rename(temporary.c_str(), m_path.c_str()) == 0;
+#endif
+    if (!ok)
+    {
+        std::remove(temporary.c_str());
+        return false;
+    }
+
+    // Every entry is in the new file, the unsaved ones included.
+    m_unsaved.clear();
+    closeAppend();
+    openAppend();
+    return load();
+}
+
+bool DigestCache::load()
+{
+    m_index.clear();
+    m_added.clear();
+    m_loaded.clear();
+
+    io::MappedFile mapped;
+    if (!mapped.open(m_path))
+    {
+        // A new cache file is empty and isn't mapped.
+        FileIdentity identity;
+        if (!fileIdentity(m_path, identity) || identity.size != 0)
+            return false;
+    }
+
+    const uint8_t *data = mapped.data();
+    const std::size_t size = mapped.size();
+    m_loaded.reserve(size / sizeof(detail::DigestCacheRecord));
+
+    std::size_t offset = 0;
+    while (offset + sizeof(detail::DigestCacheRecord) <= size)
+    {
+        uint32_t magic;
+        std::memcpy(&magic, data + offset, sizeof(magic));
+        if (magic == detail::DigestCacheRecord::Magic)
+        {
+            detail::DigestCacheRecord record;
+            std::memcpy(&record, data + offset, sizeof(record));
+            if (record.checksum == record.computeChecksum() &&
+                record.digestSize <= detail::DigestCacheRecord::MaxDigestSize)
+            {
+                m_loaded.push_back(record);
+                offset += sizeof(record);
+                continue;
+            }
+        }
+
+        // A torn record shifts everything after it, find the next one byte by byte.
+        ++offset;
+    }
+
+    // Later records replace earlier ones for the same key, and what this process couldn't
+    // write is newer than anything it read.
+    m_index.reserve(m_loaded.size() + m_unsaved.size());
+    for (const detail::DigestCacheRecord &record : m_loaded)
+        m_index[detail::DigestCacheKey{ record.pathHash, record.algorithmHash }] = &record;
+    for (const detail::DigestCacheRecord &record : m_unsaved)
+        insert(record);
+
+    // The records were copied out so another process truncating the file can't fault a
+    // lookup, the mapping isn't kept past loading.
+    return true;
+}
+
+bool DigestCache::openAppend()
+{
+#if defined(_WIN32)
+    m_appendFile = CreateFileA(m_path.c_str(), FILE_APPEND_DATA | FILE_READ_ATTRIBUTES,
+                               FILE_SHARE_READ | FILE_SHARE_WRITE | FILE_SHARE_DELETE,
+                               nullptr, OPEN_ALWAYS, FILE_ATTRIBUTE_NORMAL, nullptr);
+    if (m_appendFile == INVALID_HANDLE_VALUE)
+        return false;
+
+    BY_HANDLE_FILE_INFORMATION info;
+    if (GetFileInformationByHandle(m_appendFile, &info) != 0)
+    {
+        m_appendIdentity.device = info.dwVolumeSerialNumber;
+        m_appendIdentity.inode = (static_cast<uint64_t>(info.nFileIndexHigh) << 32) | info.nFileIndexLow;
+    }
+    return true;
+#else
+    m_appendFile = ::open(m_path.c_str(), O_WRONLY | O_APPEND | O_CREAT, 0644);
+    if (m_appendFile < 0)
+        return false;
+
+    struct stat status;
+    if (fstat(m_appendFile, &status) == 0)
+    {
+        m_appendIdentity.device = static_cast<uint64_t>(status.st_dev);
+        m_appendIdentity.inode = static_cast<uint64_t>(status.st_ino);
+    }
+    return true;
+#endif
+}
+
+void DigestCache::closeAppend()
+{
+#if defined(_WIN32)
+    if (m_appendFile != INVALID_HANDLE_VALUE)
+        CloseHandle(m_appendFile);
+    m_appendFile = INVALID_HANDLE_VALUE;
+#else
+    if (m_appendFile >= 0)
+        ::close(m_appendFile);
+    m_appendFile = -1;
+#endif
+}
+
+void DigestCache::openLock()
+{
+    const std::string path = m_path + ".lock";
+#if defined(_WIN32)
+    m_lockFile = CreateFileA(path.c_str(), GENERIC_READ | GENERIC_WRITE, FILE_SHARE_READ | FILE_SHARE_WRITE | FILE_SHARE_DELETE,
+                             nullptr, OPEN_ALWAYS, FILE_ATTRIBUTE_NORMAL, nullptr);
+    // Another user's cache can still be locked by reading its lock file.
+    if (m_lockFile == INVALID_HANDLE_VALUE)
+        m_lockFile = CreateFileA(path.c_str(), GENERIC_READ, FILE_SHARE_READ | FILE_SHARE_WRITE | FILE_SHARE_DELETE,
+                                 nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+#else
+    m_lockFile = ::open(path.c_str(), O_RDWR | O_CREAT, 0644);
+    // Another user's cache can still be locked by reading its lock file.
+    if (m_lockFile < 0)
+        m_lockFile = ::open(path.c_str(), O_RDONLY);
+#endif
+}
+
+void DigestCache::closeLock()
+{
+#if defined(_WIN32)
+    if (m_lockFile != INVALID_HANDLE_VALUE)
+        CloseHandle(m_lockFile);
+    m_lockFile = INVALID_HANDLE_VALUE;
+#else
+    if (m_lockFile >= 0)
+        ::close(m_lockFile);
+    m_lockFile = -1;
+#endif
+}
+
+bool DigestCache::append(const detail::DigestCacheRecord &record)
+{
+    // A compaction by another process renames a new file over the one held open,
+    // appends to the old one would be lost. None can start while the lock is held.
+    detail::DigestCacheLock fileLock(m_lockFile, false);
+    FileIdentity current;
+    if (!fileIdentity(m_path, current) || current.device != m_appendIdentity.device ||
+        current.inode != m_appendIdentity.inode)
+    {
+        closeAppend();
+        openAppend();
+    }
+
+    if (m_appendFile == detail::InvalidDigestCacheFile)
+        return false;
+
+#if defined(_WIN32)
+    DWORD written = 0;
+    return WriteFile(m_appendFile, &record, sizeof(record), &written, nullptr) != 0 && written == sizeof(record);
+#else
+    // One write per record, O_APPEND places it after anything other processes wrote.
+    return ::write(m_appendFile, &record, sizeof(record)) == static_cast<ssize_t>(sizeof(record));
+#endif
+}
+
+bool DigestCache::find(const detail::DigestCacheKey &key, const FileIdentity &identity, std::vector<uint8_t> &digest) const
+{
+    const auto found = m_index.find(key);
+    if (found == m_index.end())
+        return false;
+
+    const detail::DigestCacheRecord &record = *found->second;
+    if (record.device != identity.device || record.inode != identity.inode ||
+        record.size != identity.size || record.modified != identity.modified)
+        return false;
+
+    digest.assign(record.digest, record.digest + record.digestSize);
+    return true;
+}
+
+void DigestCache::insert(const detail::DigestCacheRecord &record)
+{
+    m_added.push_back(record);
+    m_index[detail::DigestCacheKey{ record.pathHash, record.algorithmHash }] = &m_added.back();
+}
+
+void DigestCache::add(const detail::DigestCacheRecord &record)
+{
+    insert(record);
+    if (!append(record))
+        m_unsaved.push_back(record);
+}
+
+detail::DigestCacheKey DigestCache::makeKey(const std::string &absolutePath, const std::string &algorithmName)
+{
+    return detail::DigestCacheKey{ noncryptographic::fnv1aHash64(absolutePath.data(), absolutePath.size()),
+                                   noncryptographic::fnv1aHash64(algorithmName.data(), algorithmName.size()) };
+}
+
+detail::DigestCacheRecord DigestCache::makeRecord(const detail::DigestCacheKey &key, const FileIdentity &identity,
+                                                  const std::vector<uint8_t> &digest)
+{
+    detail::DigestCacheRecord record;
+    std::memset(&record, 0, sizeof(record));
+    record.magic = detail::DigestCacheRecord::Magic;
+    record.digestSize = static_cast<uint8_t>(digest.size());
+    record.pathHash = key.pathHash;
+    record.algorithmHash = key.algorithmHash;
+    record.device = identity.device;
+    record.inode = identity.inode;
+    record.size = identity.size;
+    record.modified = identity.modified;
+    std::memcpy(record.digest, digest.data(), digest.size());
+    record.checksum = record.computeChecksum();
+    return record;
+}
+
+} // hashing namespace
+} // keeg namespace
+
+#endif // DIGESTCACHE_HPP
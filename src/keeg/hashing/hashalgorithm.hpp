@@ -22,15 +22,23 @@
 #ifndef HASHALGORITHM_HPP
 #define HASHALGORITHM_HPP
 
+#include <algorithm>
+#include <array>
 #include <cstddef>
 #include <cstdint>
+#include <cstdio>
 #include <istream>
 #include <limits>
 #include <memory>
 #include <string>
+#include <thread>
 #include <type_traits>
 #include <vector>
+#include <keeg/common/instrumentation.hpp>
 #include <keeg/common/stringutils.hpp>
+#include <keeg/common/threadgroup.hpp>
+#include <keeg/hashing/blockqueue.hpp>
+#include <keeg/io/mappedfile.hpp>
 
 #ifndef HASH_BLOCK_BUFFER_SIZE
     // Block of bytes to process per file read.
@@ -38,15 +46,30 @@
     #define HASH_BLOCK_BUFFER_SIZE UINT64_C(1032192) // 144 * 7 * 1024
 #endif
 
+#ifndef HASH_FILE_BUFFER_SIZE
+    // Bytes per read when computeHashFile can't map the file, bypassing the stdio buffer.
+    #define HASH_FILE_BUFFER_SIZE (HASH_BLOCK_BUFFER_SIZE * 4)
+#endif
+
 namespace keeg { namespace hashing {
 
+class MultiHash;
+class MerkleTree;
+
+/// Hash value of a fixed size algorithm, in the same byte order as hashValue().
+template<std::size_t N>
+using HashDigest = std::array<uint8_t, N>;
+
 class HashAlgorithm
 {
 public:
     /// Size of the return hash in bits.
     virtual std::size_t hashSize() = 0;
+    /// Bytes consumed per compression, 1 for algorithms that take a byte at a time.
+    /// Sizes the key pads of Hmac.
+    virtual std::size_t blockSize();
     /// Get the hash value as vector byte array.
-    std::vector<uint8_t> hashValue();
+    const std::vector<uint8_t> &hashValue() const;
 
     /// Virtual destructor
     virtual ~HashAlgorithm();
@@ -57,6 +80,19 @@ public:
     std::vector<uint8_t> computeHash(const void* data, const std::size_t &dataLength);
     /// Comput Hash of a stream
     std::vector<uint8_t> computeHash(std::istream &instream);
+    /// Comput Hash of a stream while a second thread reads ahead into bufferCount rotating buffers,
+    /// so reading and hashing overlap.
+    std::vector<uint8_t> computeHashAsync(std::istream &instream, const std::size_t &bufferCount = 2,
+                                          const std::size_t &bufferSize = HASH_BLOCK_BUFFER_SIZE);
+    /// Compute Hash of a file, memory mapped and hashed in place when possible, read in large blocks otherwise.
+    /// Returns an empty vector if the file can't be read.
+    std::vector<uint8_t> computeHashFile(const std::string &path);
+    /// compute Hash of a memory block into digest, which must hold hashSize() / 8 bytes.
+    /// Nothing is allocated and hashValue() is not set. Returns the bytes written, 0 if digest is too small.
+    std::size_t computeHash(const void* data, const std::size_t &dataLength, uint8_t *digest, const std::size_t &digestSize);
+    /// compute Hash of a memory block into a fixed size array, see above.
+    template<std::size_t N>
+    std::size_t computeHash(const void* data, const std::size_t &dataLength, HashDigest<N> &digest);
 
     /// Get the hash value as a hex string.
     std::string hashValueString(const bool &useUpperCase = true, const bool &insertSpaces = false);
@@ -64,6 +100,23 @@ public:
     /// Make sure everything is setup, or reset.
     virtual void initialize() = 0;
 
+    /// Adds a piece of the message to the running hash, for data that arrives in parts.
+    /// A message starts at construction or initialize(), call initialize() again after
+    /// finalize() to hash the next one. The result matches a single computeHash() of the
+    /// whole message, except for SuperFastHash32 which is seeded with the first length.
+    void update(const void* data, const std::size_t &dataLength);
+    /// Adds the text to the running hash, excluding final zero.
+    void update(const std::string &text);
+    /// Hash of everything passed to update(), also kept in hashValue().
+    std::vector<uint8_t> finalize();
+    /// Finalize into digest, which must hold hashSize() / 8 bytes. Nothing is allocated and
+    /// hashValue() is not set. Returns the bytes written, 0 if digest is too small.
+    std::size_t finalize(uint8_t *digest, const std::size_t &digestSize);
+
+    /// Independent copy of the algorithm including its running state, so a shared prefix
+    /// such as a key pad or a common header is hashed once and each copy continues from it.
+    virtual std::unique_ptr<HashAlgorithm> copy() const = 0;
+
     /// compute Hash of a memory block returning the hash as a hex string.
     std::string operator()(const void* data, const std::size_t &dataLength, const std::size_t &index);
     /// compute Hash of a memory block returning the hash as a hex string.
@@ -72,6 +125,9 @@ public:
     std::string operator()(const std::string &text);
 
 protected:
+    friend class MultiHash;
+    friend class MerkleTree;
+
     /// Computed hash value stored as a vector of bytes in Big endian order.
     /// Makes it human readable for testing.
     std::vector<uint8_t> m_hashValue;
@@ -91,21 +147,43 @@ protected:
 
     /// This is called to finalize the hash computation.
     virtual std::vector<uint8_t> hashFinal() = 0;
+    /// Finalize into digest, hashSize() / 8 bytes. Override to avoid the vector hashFinal() allocates.
+    virtual void hashFinalTo(uint8_t *digest);
+
+    /// hashCore, hashFinal and hashFinalTo through the instrumentation hooks,
+    /// the public entry points call these instead of the virtuals directly.
+    void runHashCore(const void* data, const std::size_t &dataLength, const std::size_t &startIndex);
+    std::vector<uint8_t> runHashFinal();
+    void runHashFinalTo(uint8_t *digest);
 
 private:
-    const std::size_t m_blockSizeBuffer = HASH_BLOCK_BUFFER_SIZE;
+    std::size_t m_blockSizeBuffer = HASH_BLOCK_BUFFER_SIZE;
 
     static_assert(std::is_same<uint8_t, unsigned char>::value,
                   "uint8_t is required to be implemented as unsigned char!");
 };
 
-std::vector<uint8_t> HashAlgorithm::hashValue()
+/// Hashes a memory block into an array sized for the algorithm, which must declare DigestSize.
+template<typename Algorithm>
+HashDigest<Algorithm::DigestSize> computeDigest(Algorithm &algorithm, const void* data, const std::size_t &dataLength)
+{
+    HashDigest<Algorithm::DigestSize> digest;
+    algorithm.computeHash(data, dataLength, digest.data(), digest.size());
+    return digest;
+}
+
+const std::vector<uint8_t> &HashAlgorithm::hashValue() const
 {
     return m_hashValue;
 }
 
 HashAlgorithm::~HashAlgorithm() { }
 
+std::size_t HashAlgorithm::blockSize()
+{
+    return 1;
+}
+
 std::vector<uint8_t> HashAlgorithm::computeHash(const void *data, const std::size_t &dataLength, const std::size_t &index)
 {
     computeHashInternal(data, dataLength, index);
@@ -136,20 +214,121 @@ std::vector<uint8_t> HashAlgorithm::computeHash(std::istream &instream)
         std::size_t numBytesRead = 0;
         while (*input)
         {
-            input->read(buffer.get(), m_blockSizeBuffer);
+            {
+                KEEG_INSTRUMENT_STREAM_STALL(typeid(*this));
+                input->read(buffer.get(), m_blockSizeBuffer);
+            }
             numBytesRead = static_cast<std::size_t>(input->gcount());
-            hashCore(buffer.get(), numBytesRead, 0);
+            runHashCore(buffer.get(), numBytesRead, 0);
         }
 
-        m_hashValue = hashFinal();
+        m_hashValue = runHashFinal();
         return m_hashValue;
     }
 }
 
+std::vector<uint8_t> HashAlgorithm::computeHashAsync(std::istream &instream, const std::size_t &bufferCount,
+                                                     const std::size_t &bufferSize)
+{
+    if (!instream)
+        return std::vector<uint8_t>();
+
+    BlockQueue queue(bufferCount, bufferSize, 1);
+    initialize();
+    instream.seekg(0, std::ios::beg);
+
+    bool readOk = true;
+    common::ThreadGroup reader;
+    // The reader waits on this thread, it can't run in its place. Nothing was read yet.
+    if (!reader.tryRun([&] { readOk = readIntoQueue(instream, queue); }))
+        return computeHash(instream);
+
+    try
+    {
+        for (;;)
+        {
+            const BlockQueue::Block *block;
+            {
+                KEEG_INSTRUMENT_STREAM_STALL(typeid(*this));
+                block = queue.next(0);
+            }
+            if (block == nullptr)
+                break;
+
+            runHashCore(block->data.get(), block->length, 0);
+            queue.release(0);
+        }
+    }
+    catch (...)
+    {
+        // Stops the reader waiting for a free buffer, leaving reader joins it.
+        queue.cancel();
+        throw;
+    }
+
+    reader.join();
+    if (!readOk)
+        return std::vector<uint8_t>();
+
+    m_hashValue = runHashFinal();
+    return m_hashValue;
+}
+
+std::vector<uint8_t> HashAlgorithm::computeHashFile(const std::string &path)
+{
+    io::MappedFile mapped;
+    if (mapped.open(path))
+    {
+        initialize();
+        runHashCore(mapped.data(), mapped.size(), 0);
+        m_hashValue = runHashFinal();
+        return m_hashValue;
+    }
+
+    // Pipes, devices, or a file too large for the address space.
+    std::FILE *file = std::fopen(path.c_str(), "rb");
+    if (file == nullptr)
+        return std::vector<uint8_t>();
+
+    std::setvbuf(file, nullptr, _IONBF, 0);
+    std::unique_ptr<uint8_t[]> buffer = std::make_unique<uint8_t[]>(HASH_FILE_BUFFER_SIZE);
+
+    initialize();
+    std::size_t numBytesRead = 0;
+    while ((numBytesRead = std::fread(buffer.get(), 1, HASH_FILE_BUFFER_SIZE, file)) > 0)
+        runHashCore(buffer.get(), numBytesRead, 0);
+
+    const bool failed = std::ferror(file) != 0;
+    std::fclose(file);
+    if (failed)
+        return std::vector<uint8_t>();
+
+    m_hashValue = runHashFinal();
+    return m_hashValue;
+}
+
+std::size_t HashAlgorithm::computeHash(const void *data, const std::size_t &dataLength,
+                                       uint8_t *digest, const std::size_t &digestSize)
+{
+    const std::size_t byteSize = hashSize() / std::numeric_limits<uint8_t>::digits;
+    if (digestSize < byteSize)
+        return 0;
+
+    initialize();
+    runHashCore(data, dataLength, 0);
+    runHashFinalTo(digest);
+    return byteSize;
+}
+
+template<std::size_t N>
+std::size_t HashAlgorithm::computeHash(const void *data, const std::size_t &dataLength, HashDigest<N> &digest)
+{
+    return computeHash(data, dataLength, digest.data(), N);
+}
+
 std::string HashAlgorithm::hashValueString(const bool &useUpperCase, const bool &insertSpaces)
 {
-    return common::make_hex_string(std::begin(m_hashValue),
-                                   std::end(m_hashValue), useUpperCase, insertSpaces);
+    return common::hexString(m_hashValue.data(), m_hashValue.size(), useUpperCase, insertSpaces);
 }
 
 std::string HashAlgorithm::operator()(const void *data, const std::size_t &dataLength, const std::size_t &index)
@@ -175,11 +354,37 @@ HashAlgorithm::HashAlgorithm()/* :
     m_hashSizeBits(std::numeric_limits<uint8_t>::digits * hashSize)*/
 { }
 
+void HashAlgorithm::update(const void *data, const std::size_t &dataLength)
+{
+    runHashCore(data, dataLength, 0);
+}
+
+void HashAlgorithm::update(const std::string &text)
+{
+    runHashCore(text.data(), text.size(), 0);
+}
+
+std::vector<uint8_t> HashAlgorithm::finalize()
+{
+    m_hashValue = runHashFinal();
+    return m_hashValue;
+}
+
+std::size_t HashAlgorithm::finalize(uint8_t *digest, const std::size_t &digestSize)
+{
+    const std::size_t byteSize = hashSize() / std::numeric_limits<uint8_t>::digits;
+    if (digestSize < byteSize)
+        return 0;
+
+    runHashFinalTo(digest);
+    return byteSize;
+}
+
 void HashAlgorithm::computeHashInternal(const void *data, const std::size_t &dataLength, const std::size_t &startIndex)
 {
     initialize();
-    hashCore(data, dataLength, startIndex);
-    m_hashValue = hashFinal();
+    runHashCore(data, dataLength, startIndex);
+    m_hashValue = runHashFinal();
 }
 
 void HashAlgorithm::computeHashInternal(const void *data, const std::size_t &dataLength)
@@ -192,6 +397,30 @@ void HashAlgorithm::hashCore(const void *data, const std::size_t &dataLength)
     hashCore(data, dataLength, 0);
 }
 
+void HashAlgorithm::hashFinalTo(uint8_t *digest)
+{
+    const std::vector<uint8_t> v = hashFinal();
+    std::copy(v.begin(), v.end(), digest);
+}
+
+void HashAlgorithm::runHashCore(const void *data, const std::size_t &dataLength, const std::size_t &startIndex)
+{
+    KEEG_INSTRUMENT_HASH_CORE(typeid(*this), dataLength);
+    hashCore(data, dataLength, startIndex);
+}
+
+std::vector<uint8_t> HashAlgorithm::runHashFinal()
+{
+    KEEG_INSTRUMENT_HASH_FINAL(typeid(*this));
+    return hashFinal();
+}
+
+void HashAlgorithm::runHashFinalTo(uint8_t *digest)
+{
+    KEEG_INSTRUMENT_HASH_FINAL(typeid(*this));
+    hashFinalTo(digest);
+}
+
 } // hashing namespace
 } // keeg namespace
 
@@ -0,0 +1,307 @@
+/*
+ * Copyright (C) 2017 Larry Lopez
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to
+ * deal in the Software without restriction, including without limitation the
+ * rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+ * sell copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ */
+#ifndef HASHERPOOL_HPP
+#define HASHERPOOL_HPP
+
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <tuple>
+#include <utility>
+#include <vector>
+
+#ifndef HASHER_POOL_MAX_IDLE
+    // Instances a pool keeps for reuse, beyond that returned ones are destroyed.
+    #define HASHER_POOL_MAX_IDLE 64
+#endif
+
+namespace keeg { namespace hashing {
+
+namespace detail {
+
+template<typename Algorithm, typename Tuple, std::size_t... Index>
+std::unique_ptr<Algorithm> makeFromTuple(const Tuple &args, std::index_sequence<Index...>)
+{
+    return std::unique_ptr<Algorithm>(new Algorithm(std::get<Index>(args)...));
+}
+
+} // detail namespace
+
+/// Thread safe pool of ready to use algorithms of a single configuration, so a service
+/// doesn't construct one per request. acquire() hands out an initialized instance, first
+/// from a one slot cache of the calling thread, then from the shared idle list under a
+/// lock, and only then from the factory. When the handle goes away the instance is reset
+/// with initialize() and goes back, the thread slot first.
+///   HasherPool<Crc32> &pool = hasherPool<Crc32>(CASTAGNOLI_POLYNOMIAL);
+///   uint32_t crc = pool.acquire()->computeHashValue(data, length);
+template<typename Algorithm>
+class HasherPool
+{
+public:
+    using Factory = std::function<std::unique_ptr<Algorithm>()>;
+
+    /// Instance on loan from the pool, returned when the handle is destroyed.
+    class Handle
+    {
+    public:
+        Handle() = default;
+        Handle(Handle &&other) = default;
+        Handle &operator=(Handle &&other);
+        ~Handle();
+
+        Algorithm *get() const { return m_algorithm.get(); }
+        Algorithm *operator->() const { return m_algorithm.get(); }
+        Algorithm &operator*() const { return *m_algorithm; }
+        explicit operator bool() const { return m_algorithm != nullptr; }
+
+        /// Gives the instance back early.
+        void release();
+
+    private:
+        friend class HasherPool;
+
+        HasherPool *m_pool = nullptr;
+        std::unique_ptr<Algorithm> m_algorithm;
+
+        Handle(HasherPool *pool, std::unique_ptr<Algorithm> algorithm);
+    };
+
+    /// Default constructed instances.
+    HasherPool();
+    /// Instances made by factory, which must return the same configuration every time.
+    explicit HasherPool(Factory factory, const std::size_t &maxIdle = HASHER_POOL_MAX_IDLE);
+    HasherPool(const HasherPool&) = delete;
+    HasherPool &operator=(const HasherPool&) = delete;
+
+    /// Initialized instance, safe to call from any thread. The pool must outlive the handle.
+    Handle acquire();
+
+    /// Instances waiting in the shared list, not counting thread slots.
+    std::size_t idle() const;
+    /// Instances the factory made so far.
+    std::size_t created() const;
+
+private:
+    /// The slot one thread keeps for one pool. Pools are told apart by an id that is never
+    /// reused, so a slot can't be handed to a later pool at the same address. pool expires
+    /// with the pool, the thread then drops the slot the next time it looks through them.
+    /// The pool never touches the slots itself when destroyed, the process wide pools of
+    /// hasherPool() outlive the main thread's slots.
+    struct ThreadSlot
+    {
+        uint64_t poolId;
+        std::weak_ptr<void> pool;
+        std::unique_ptr<Algorithm> algorithm;
+    };
+
+    Factory m_factory;
+    std::size_t m_maxIdle;
+    uint64_t m_id;
+    std::shared_ptr<void> m_lifetime;
+    std::vector<std::unique_ptr<Algorithm>> m_idle;
+    std::atomic<std::size_t> m_created;
+    mutable std::mutex m_mutex;
+
+    static uint64_t nextId();
+    static std::vector<ThreadSlot> &threadSlots();
+    /// This pool's slot of the calling thread, nullptr if it has none. Slots of destroyed
+    /// pools met on the way are erased.
+    ThreadSlot *findThreadSlot();
+
+    void giveBack(std::unique_ptr<Algorithm> algorithm);
+};
+
+/// Process wide pool for Algorithm constructed with args, one per distinct configuration,
+/// for example hasherPool<Crc32>(polynomial, seed) or hasherPool<Sha3>(Sha3Bits::Bits512).
+/// The arguments must be copyable and ordered by operator<.
+template<typename Algorithm, typename... Args>
+HasherPool<Algorithm> &hasherPool(const Args&... args);
+
+template<typename Algorithm>
+typename HasherPool<Algorithm>::Handle &HasherPool<Algorithm>::Handle::operator=(Handle &&other)
+{
+    if (this != &other)
+    {
+        release();
+        m_pool = other.m_pool;
+        m_algorithm = std::move(other.m_algorithm);
+        other.m_pool = nullptr;
+    }
+
+    return *this;
+}
+
+template<typename Algorithm>
+HasherPool<Algorithm>::Handle::~Handle()
+{
+    release();
+}
+
+template<typename Algorithm>
+void HasherPool<Algorithm>::Handle::release()
+{
+    if (m_pool != nullptr && m_algorithm != nullptr)
+        m_pool->giveBack(std::move(m_algorithm));
+
+    m_pool = nullptr;
+    m_algorithm.reset();
+}
+
+template<typename Algorithm>
+HasherPool<Algorithm>::Handle::Handle(HasherPool *pool, std::unique_ptr<Algorithm> algorithm) :
+    m_pool(pool), m_algorithm(std::move(algorithm))
+{ }
+
+template<typename Algorithm>
+HasherPool<Algorithm>::HasherPool() :
+    HasherPool([] { return std::unique_ptr<Algorithm>(new Algorithm()); })
+{ }
+
+template<typename Algorithm>
+HasherPool<Algorithm>::HasherPool(Factory factory, const std::size_t &maxIdle) :
+    m_factory(std::move(factory)), m_maxIdle(maxIdle), m_id(nextId()),
+    m_lifetime(std::make_shared<uint64_t>(m_id)), m_created(0)
+{ }
+
+template<typename Algorithm>
+typename HasherPool<Algorithm>::Handle HasherPool<Algorithm>::acquire()
+{
+    ThreadSlot *slot = findThreadSlot();
+    if (slot != nullptr && slot->algorithm != nullptr)
+        return Handle(this, std::move(slot->algorithm));
+
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        if (!m_idle.empty())
+        {
+            std::unique_ptr<Algorithm> algorithm = std::move(m_idle.back());
+            m_idle.pop_back();
+            return Handle(this, std::move(algorithm));
+        }
+    }
+
+    ++m_created;
+    return Handle(this, m_factory());
+}
+
+template<typename Algorithm>
+std::size_t HasherPool<Algorithm>::idle() const
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return m_idle.size();
+}
+
+template<typename Algorithm>
+std::size_t HasherPool<Algorithm>::created() const
+{
+    return m_created.load();
+}
+
+template<typename Algorithm>
+uint64_t HasherPool<Algorithm>::nextId()
+{
+    static std::atomic<uint64_t> counter(0);
+    return ++counter;
+}
+
+template<typename Algorithm>
+std::vector<typename HasherPool<Algorithm>::ThreadSlot> &HasherPool<Algorithm>::threadSlots()
+{
+    thread_local std::vector<ThreadSlot> slots;
+    return slots;
+}
+
+template<typename Algorithm>
+typename HasherPool<Algorithm>::ThreadSlot *HasherPool<Algorithm>::findThreadSlot()
+{
+    std::vector<ThreadSlot> &slots = threadSlots();
+    ThreadSlot *found = nullptr;
+    for (std::size_t i = 0; i < slots.size();)
+    {
+        if (slots[i].pool.expired())
+        {
+            // Order doesn't matter, move the last slot into the hole.
+            if (i + 1 != slots.size())
+                slots[i] = std::move(slots.back());
+            slots.pop_back();
+            continue;
+        }
+
+        if (slots[i].poolId == m_id)
+            found = &slots[i];
+        ++i;
+    }
+
+    // Holes are only filled past the slot found, its address stays valid.
+    return found;
+}
+
+template<typename Algorithm>
+void HasherPool<Algorithm>::giveBack(std::unique_ptr<Algorithm> algorithm)
+{
+    // O(1) for every algorithm, the running state is a fixed size and m_hashValue keeps its capacity.
+    algorithm->initialize();
+
+    ThreadSlot *slot = findThreadSlot();
+    if (slot == nullptr)
+    {
+        threadSlots().push_back(ThreadSlot{ m_id, m_lifetime, std::move(algorithm) });
+        return;
+    }
+    if (slot->algorithm == nullptr)
+    {
+        slot->algorithm = std::move(algorithm);
+        return;
+    }
+
+    std::lock_guard<std::mutex> lock(m_mutex);
+    if (m_idle.size() < m_maxIdle)
+        m_idle.push_back(std::move(algorithm));
+}
+
+template<typename Algorithm, typename... Args>
+HasherPool<Algorithm> &hasherPool(const Args&... args)
+{
+    using Key = std::tuple<Args...>;
+    static std::mutex mutex;
+    static std::map<Key, std::unique_ptr<HasherPool<Algorithm>>> pools;
+
+    std::lock_guard<std::mutex> lock(mutex);
+    std::unique_ptr<HasherPool<Algorithm>> &pool = pools[Key(args...)];
+    if (pool == nullptr)
+    {
+        const Key key(args...);
+        pool.reset(new HasherPool<Algorithm>([key] { return detail::makeFromTuple<Algorithm>(key, std::index_sequence_for<Args...>()); }));
+    }
+
+    return *pool;
+}
+
+} // hashing namespace
+} // keeg namespace
+
+#endif // HASHERPOOL_HPP
@@ -0,0 +1,86 @@
+/*
+ * Copyright (C) 2017 Larry Lopez
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to
+ * deal in the Software without restriction, including without limitation the
+ * rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+ * sell copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ */
+#ifndef HASHLITERALS_HPP
+#define HASHLITERALS_HPP
+
+#include <keeg/hashing/crc/crc32.hpp>
+#include <keeg/hashing/noncryptographic/djb2hash32.hpp>
+#include <keeg/hashing/noncryptographic/fnv.hpp>
+#include <keeg/hashing/noncryptographic/sdbmhash32.hpp>
+
+/*
+ * Hash literals, evaluated by the compiler so they can be used as case labels:
+ *
+ *   using namespace keeg::hashing::literals;
+ *   switch (noncryptographic::StaticFnv1aHash64().hash(name))
+ *   {
+ *   case "config"_fnv1a64: ...
+ *   }
+ */
+
+namespace keeg { namespace hashing { namespace literals {
+
+constexpr uint32_t operator"" _fnv1_32(const char *text, std::size_t length)
+{
+    return noncryptographic::fnv1Hash32(text, length);
+}
+
+constexpr uint64_t operator"" _fnv1_64(const char *text, std::size_t length)
+{
+    return noncryptographic::fnv1Hash64(text, length);
+}
+
+constexpr uint32_t operator"" _fnv1a32(const char *text, std::size_t length)
+{
+    return noncryptographic::fnv1aHash32(text, length);
+}
+
+constexpr uint64_t operator"" _fnv1a64(const char *text, std::size_t length)
+{
+    return noncryptographic::fnv1aHash64(text, length);
+}
+
+constexpr uint32_t operator"" _djb2(const char *text, std::size_t length)
+{
+    return noncryptographic::djb2Hash32(text, length);
+}
+
+constexpr uint32_t operator"" _sdbm(const char *text, std::size_t length)
+{
+    return noncryptographic::sdbmHash32(text, length);
+}
+
+constexpr uint32_t operator"" _crc32(const char *text, std::size_t length)
+{
+    return crc::crc32Hash<ZLIB_POLYNOMIAL>(text, length);
+}
+
+constexpr uint32_t operator"" _crc32c(const char *text, std::size_t length)
+{
+    return crc::crc32Hash<CASTAGNOLI_POLYNOMIAL>(text, length);
+}
+
+} // literals namespace
+} // hashing namespace
+} // keeg namespace
+
+#endif // HASHLITERALS_HPP
@@ -0,0 +1,105 @@
+/*
+ * Copyright (C) 2017 Larry Lopez
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to
+ * deal in the Software without restriction, including without limitation the
+ * rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+ * sell copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ */
+#ifndef INTEGERHASHALGORITHM_HPP
+#define INTEGERHASHALGORITHM_HPP
+
+#include <keeg/hashing/hashalgorithm.hpp>
+
+namespace keeg { namespace hashing {
+
+/// Base for the algorithms whose hash is a single unsigned integer. The derived class only
+/// produces the final integer, the byte conversions live here and none of them allocate.
+template<typename T>
+class IntegerHashAlgorithm : public HashAlgorithm
+{
+public:
+    static_assert(std::is_integral<T>::value && std::is_unsigned<T>::value, "T must be an unsigned integer type!");
+
+    /// Size of the hash in bytes.
+    static const std::size_t DigestSize = sizeof(T);
+    using Digest = HashDigest<DigestSize>;
+
+    /// compute Hash of a memory block returning the hash as an integer.
+    T computeHashValue(const void* data, const std::size_t &dataLength);
+    /// compute Hash of a string returning the hash as an integer, excluding final zero.
+    T computeHashValue(const std::string &text);
+    /// Hash of everything passed to update() as an integer, nothing is allocated.
+    T finalizeValue();
+
+protected:
+    IntegerHashAlgorithm();
+
+    /// Final hash value, must not change the running state.
+    virtual T hashFinalValue() = 0;
+
+    // HashAlgorithm interface
+    virtual std::vector<uint8_t> hashFinal() override;
+    virtual void hashFinalTo(uint8_t *digest) override;
+};
+
+template<typename T>
+IntegerHashAlgorithm<T>::IntegerHashAlgorithm() : HashAlgorithm()
+{ }
+
+template<typename T>
+T IntegerHashAlgorithm<T>::computeHashValue(const void *data, const std::size_t &dataLength)
+{
+    initialize();
+    runHashCore(data, dataLength, 0);
+    KEEG_INSTRUMENT_HASH_FINAL(typeid(*this));
+    return hashFinalValue();
+}
+
+template<typename T>
+T IntegerHashAlgorithm<T>::computeHashValue(const std::string &text)
+{
+    return computeHashValue(text.data(), text.size());
+}
+
+template<typename T>
+T IntegerHashAlgorithm<T>::finalizeValue()
+{
+    KEEG_INSTRUMENT_HASH_FINAL(typeid(*this));
+    return hashFinalValue();
+}
+
+template<typename T>
+std::vector<uint8_t> IntegerHashAlgorithm<T>::hashFinal()
+{
+    std::vector<uint8_t> v(DigestSize);
+    hashFinalTo(v.data());
+    return v;
+}
+
+template<typename T>
+void IntegerHashAlgorithm<T>::hashFinalTo(uint8_t *digest)
+{
+    // Big-Endian, most significant byte first.
+    const T value = hashFinalValue();
+    for (std::size_t i = 0; i < DigestSize; ++i)
+        digest[i] = static_cast<uint8_t>(value >> ((DigestSize - 1 - i) * 8));
+}
+
+} // hashing namespace
+} // keeg namespace
+
+#endif // INTEGERHASHALGORITHM_HPP
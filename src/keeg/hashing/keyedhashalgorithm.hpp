@@ -41,6 +41,9 @@ protected:
 
     KeyedHashAlgorithm();
     virtual ~KeyedHashAlgorithm();
+
+    /// Called after every setKey, derived classes prepare their keyed state here.
+    virtual void keyChanged();
 };
 
 void KeyedHashAlgorithm::setKey(const std::vector<uint8_t> &key)
@@ -58,11 +61,15 @@ void KeyedHashAlgorithm::setKey(const void *key, const std::size_t &length, cons
     const uint8_t *bytes = reinterpret_cast<const uint8_t*>(key) + index;
     m_key.clear();
     std::copy(bytes, bytes+length, std::back_inserter(m_key));
+    keyChanged();
 }
 
 KeyedHashAlgorithm::KeyedHashAlgorithm()
 { }
 
+void KeyedHashAlgorithm::keyChanged()
+{ }
+
 KeyedHashAlgorithm::~KeyedHashAlgorithm()
 {
     /// Make sure to zero out the key in memory for security.
@@ -0,0 +1,361 @@
+/*
+ * Copyright (C) 2017 Larry Lopez
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to
+ * deal in the Software without restriction, including without limitation the
+ * rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+ * sell copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ */
+#ifndef MERKLETREE_HPP
+#define MERKLETREE_HPP
+
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <functional>
+#include <limits>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+#include <keeg/common/threadgroup.hpp>
+#include <keeg/hashing/hashalgorithm.hpp>
+#include <keeg/io/mappedfile.hpp>
+
+#ifndef MERKLE_DEFAULT_LEAF_SIZE
+    // Bytes per leaf, large enough that the per leaf overhead doesn't show.
+    #define MERKLE_DEFAULT_LEAF_SIZE (UINT64_C(1) << 20)
+#endif
+
+#ifndef MERKLE_PARALLEL_MIN_SIZE
+    // Fewer dirty bytes than this per thread are hashed on the calling thread.
+    #define MERKLE_PARALLEL_MIN_SIZE (UINT64_C(4) << 20)
+#endif
+
+namespace keeg { namespace hashing {
+
+/// Tree hash over any HashAlgorithm, so large objects hash on all cores.
+/// The input is split into leafSize() byte leaves hashed in parallel, then pairs are combined
+/// up to the root as in RFC 6962: leaf = H(0x00 || data), node = H(0x01 || left || right),
+/// an odd node is carried up unchanged. Empty input hashes to H().
+/// The root differs from the plain hash of the data, both sides have to use the same leaf size.
+///
+///   MerkleTree tree = MerkleTree::create<cryptographic::Sha256>();
+///   tree.computeHash(data, size);
+///   ... data[n] changes ...
+///   tree.updateRange(data, size, n, 1);   // rehashes one leaf and its path to the root
+///
+/// Every level of the tree is kept, so an update costs the changed leaves plus about
+/// log2(leafCount()) node hashes for each of them.
+class MerkleTree
+{
+public:
+    using AlgorithmFactory = std::function<std::unique_ptr<HashAlgorithm>()>;
+
+    /// factory makes one algorithm per worker, threadCount 0 uses every hardware thread.
+    explicit MerkleTree(const AlgorithmFactory &factory, const std::size_t &leafSize = MERKLE_DEFAULT_LEAF_SIZE,
+                        const std::size_t &threadCount = 0);
+
+    /// Tree of a default constructible algorithm.
+    template<typename Algorithm>
+    static MerkleTree create(const std::size_t &leafSize = MERKLE_DEFAULT_LEAF_SIZE, const std::size_t &threadCount = 0);
+
+    std::size_t leafSize() const;
+    std::size_t leafCount() const;
+    /// Hash of each leaf from the last computation, in order.
+    const std::vector<std::vector<uint8_t>> &leafHashes() const;
+    const std::vector<uint8_t> &rootHash() const;
+
+    /// Hashes every leaf of a memory block and returns the root.
+    const std::vector<uint8_t> &computeHash(const void *data, const std::size_t &dataLength);
+    /// Tree hash of a file, memory mapped when it can be and read in parallel sized chunks
+    /// otherwise. Returns an empty root if it can't be read.
+    const std::vector<uint8_t> &computeHashFile(const std::string &path);
+    /// Rehashes only the leaves overlapping [offset, offset + length) of data, which must be the
+    /// same size as in the last computation, and returns the new root.
+    const std::vector<uint8_t> &updateRange(const void *data, const std::size_t &dataLength,
+                                            const std::size_t &offset, const std::size_t &length);
+    /// Leaves that differ from other, e.g. a stored leafHashes(). Leaves past the end of either count as changed.
+    std::vector<std::size_t> changedLeaves(const std::vector<std::vector<uint8_t>> &other) const;
+
+private:
+    AlgorithmFactory m_factory;
+    std::size_t m_leafSize;
+    std::size_t m_threadCount;
+    std::size_t m_dataLength = 0;
+    std::vector<std::vector<uint8_t>> m_leafHashes;
+    /// Interior levels from the leaves' parents up to the root, m_levels.back() has one node.
+    std::vector<std::vector<std::vector<uint8_t>>> m_levels;
+    std::vector<uint8_t> m_root;
+
+    void clear();
+    /// Hashes the leaves in data, dataLength bytes starting at leaf firstLeaf.
+    void hashLeaves(const uint8_t *data, const std::size_t &dataLength, const std::size_t &firstLeaf);
+    /// Builds every interior level from the leaf hashes.
+    void buildLevels();
+    /// Rehashes the nodes above leaves [first, last).
+    void updateLevels(const std::size_t &first, const std::size_t &last);
+    /// Node index of level, 1 is the leaves' parents, from its two children.
+    void hashNode(HashAlgorithm &algorithm, const std::size_t &level, const std::size_t &index);
+    void updateRoot();
+};
+
+MerkleTree::MerkleTree(const AlgorithmFactory &factory, const std::size_t &leafSize, const std::size_t &threadCount) :
+    m_factory(factory),
+    m_leafSize(std::max<std::size_t>(leafSize, 1)),
+    m_threadCount(threadCount)
+{
+    if (m_threadCount == 0)
+        m_threadCount = std::max<std::size_t>(std::thread::hardware_concurrency(), 1);
+}
+
+template<typename Algorithm>
+MerkleTree MerkleTree::create(const std::size_t &leafSize, const std::size_t &threadCount)
+{
+    return MerkleTree([] { return std::unique_ptr<HashAlgorithm>(new Algorithm()); }, leafSize, threadCount);
+}
+
+std::size_t MerkleTree::leafSize() const
+{
+    return m_leafSize;
+}
+
+std::size_t MerkleTree::leafCount() const
+{
+    return m_leafHashes.size();
+}
+
+const std::vector<std::vector<uint8_t>> &MerkleTree::leafHashes() const
+{
+    return m_leafHashes;
+}
+
+const std::vector<uint8_t> &MerkleTree::rootHash() const
+{
+    return m_root;
+}
+
+const std::vector<uint8_t> &MerkleTree::computeHash(const void *data, const std::size_t &dataLength)
+{
+    m_dataLength = dataLength;
+    m_leafHashes.assign((dataLength + m_leafSize - 1) / m_leafSize, std::vector<uint8_t>());
+    hashLeaves(static_cast<const uint8_t*>(data), dataLength, 0);
+    buildLevels();
+    return m_root;
+}
+
+const std::vector<uint8_t> &MerkleTree::computeHashFile(const std::string &path)
+{
+    io::MappedFile mapped;
+    if (mapped.open(path))
+        return computeHash(mapped.data(), mapped.size());
+
+    // Pipes, procfs files, or a file too large for the address space: read enough leaves
+    // at a time to keep every thread busy.
+    clear();
+    std::FILE *file = std::fopen(path.c_str(), "rb");
+    if (file == nullptr)
+        return m_root;
+
+    std::setvbuf(file, nullptr, _IONBF, 0);
+    const std::size_t chunkSize = m_leafSize * m_threadCount;
+    std::unique_ptr<uint8_t[]> buffer(new uint8_t[chunkSize]);
+
+    bool failed = false;
+    for (;;)
+    {
+        std::size_t filled = 0;
+        while (filled < chunkSize)
+        {
+            const std::size_t numBytesRead = std::fread(buffer.get() + filled, 1, chunkSize - filled, file);
+            if (numBytesRead == 0)
+                break;
+            filled += numBytesRead;
+        }
+
+        if (std::ferror(file) != 0)
+        {
+            failed = true;
+            break;
+        }
+        if (filled == 0)
+            break;
+
+        const std::size_t firstLeaf = m_leafHashes.size();
+        m_leafHashes.resize(firstLeaf + (filled + m_leafSize - 1) / m_leafSize);
+        m_dataLength += filled;
+        hashLeaves(buffer.get(), filled, firstLeaf);
+
+        if (filled < chunkSize)
+            break;
+    }
+
+    std::fclose(file);
+    if (failed)
+    {
+        clear();
+        return m_root;
+    }
+
+    buildLevels();
+    return m_root;
+}
+
+const std::vector<uint8_t> &MerkleTree::updateRange(const void *data, const std::size_t &dataLength,
+                                                    const std::size_t &offset, const std::size_t &length)
+{
+    if (dataLength != m_dataLength || m_root.empty())
+        return computeHash(data, dataLength);
+
+    if (length == 0 || offset >= dataLength)
+        return m_root;
+
+    const std::size_t end = offset + std::min(length, dataLength - offset);
+    const std::size_t first = offset / m_leafSize;
+    const std::size_t last = (end + m_leafSize - 1) / m_leafSize;
+    const std::size_t begin = first * m_leafSize;
+
+    hashLeaves(static_cast<const uint8_t*>(data) + begin, std::min(last * m_leafSize, dataLength) - begin, first);
+    updateLevels(first, last);
+    return m_root;
+}
+
+std::vector<std::size_t> MerkleTree::changedLeaves(const std::vector<std::vector<uint8_t>> &other) const
+{
+    std::vector<std::size_t> changed;
+    const std::size_t count = std::max(m_leafHashes.size(), other.size());
+    for (std::size_t i = 0; i < count; ++i)
+    {
+        if (i >= m_leafHashes.size() || i >= other.size() || m_leafHashes[i] != other[i])
+            changed.push_back(i);
+    }
+
+    return changed;
+}
+
+void MerkleTree::clear()
+{
+    m_dataLength = 0;
+    m_leafHashes.clear();
+    m_levels.clear();
+    m_root.clear();
+}
+
+void MerkleTree::hashLeaves(const uint8_t *data, const std::size_t &dataLength, const std::size_t &firstLeaf)
+{
+    static const uint8_t leafPrefix = 0x00;
+    const std::size_t leafCount = (dataLength + m_leafSize - 1) / m_leafSize;
+    std::atomic<std::size_t> nextLeaf(0);
+
+    auto worker = [&] {
+        std::unique_ptr<HashAlgorithm> algorithm = m_factory();
+        const std::size_t digestSize = algorithm->hashSize() / std::numeric_limits<uint8_t>::digits;
+        std::size_t leaf;
+        while ((leaf = nextLeaf.fetch_add(1)) < leafCount)
+        {
+            const std::size_t offset = leaf * m_leafSize;
+            std::vector<uint8_t> &hash = m_leafHashes[firstLeaf + leaf];
+            algorithm->initialize();
+            algorithm->runHashCore(&leafPrefix, 1, 0);
+            algorithm->runHashCore(data + offset, std::min(m_leafSize, dataLength - offset), 0);
+            hash.resize(digestSize);
+            algorithm->runHashFinalTo(hash.data());
+        }
+    };
+
+    // Threads only pay off with enough to hash, a small edit stays on this thread.
+    const std::size_t threadCount = std::min(std::min(m_threadCount, leafCount),
+                                             std::max<std::size_t>(dataLength / MERKLE_PARALLEL_MIN_SIZE, 1));
+    common::ThreadGroup threads;
+    for (std::size_t i = 1; i < threadCount; ++i)
+        threads.run(worker);
+
+    worker();
+    threads.join();
+}
+
+void MerkleTree::buildLevels()
+{
+    m_levels.clear();
+    std::unique_ptr<HashAlgorithm> algorithm = m_factory();
+
+    if (m_leafHashes.empty())
+    {
+        m_root = algorithm->computeHash(nullptr, 0);
+        return;
+    }
+
+    std::size_t count = m_leafHashes.size();
+    while (count > 1)
+    {
+        count = (count + 1) / 2;
+        m_levels.emplace_back(count);
+        for (std::size_t i = 0; i < count; ++i)
+            hashNode(*algorithm, m_levels.size(), i);
+    }
+
+    updateRoot();
+}
+
+void MerkleTree::updateLevels(const std::size_t &first, const std::size_t &last)
+{
+    std::unique_ptr<HashAlgorithm> algorithm = m_factory();
+    std::size_t low = first;
+    std::size_t high = last;
+    for (std::size_t level = 1; level <= m_levels.size(); ++level)
+    {
+        low /= 2;
+        high = (high + 1) / 2;
+        for (std::size_t i = low; i < high; ++i)
+            hashNode(*algorithm, level, i);
+    }
+
+    updateRoot();
+}
+
+void MerkleTree::hashNode(HashAlgorithm &algorithm, const std::size_t &level, const std::size_t &index)
+{
+    static const uint8_t nodePrefix = 0x01;
+    const std::vector<std::vector<uint8_t>> &children = level == 1 ? m_leafHashes : m_levels[level - 2];
+    std::vector<uint8_t> &node = m_levels[level - 1][index];
+    const std::size_t left = index * 2;
+
+    // An odd node is carried up unchanged.
+    if (left + 1 >= children.size())
+    {
+        node = children[left];
+        return;
+    }
+
+    algorithm.initialize();
+    algorithm.runHashCore(&nodePrefix, 1, 0);
+    algorithm.runHashCore(children[left].data(), children[left].size(), 0);
+    algorithm.runHashCore(children[left + 1].data(), children[left + 1].size(), 0);
+    node.resize(algorithm.hashSize() / std::numeric_limits<uint8_t>::digits);
+    algorithm.runHashFinalTo(node.data());
+}
+
+void MerkleTree::updateRoot()
+{
+    m_root = m_levels.empty() ? m_leafHashes.front() : m_levels.back().front();
+}
+
+} // hashing namespace
+} // keeg namespace
+
+#endif // MERKLETREE_HPP
@@ -0,0 +1,214 @@
+/*
+ * Copyright (C) 2017 Larry Lopez
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to
+ * deal in the Software without restriction, including without limitation the
+ * rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+ * sell copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ */
+#ifndef MULTIHASH_HPP
+#define MULTIHASH_HPP
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <fstream>
+#include <istream>
+#include <string>
+#include <thread>
+#include <vector>
+#include <keeg/common/threadgroup.hpp>
+#include <keeg/hashing/blockqueue.hpp>
+#include <keeg/hashing/hashalgorithm.hpp>
+#include <keeg/io/mappedfile.hpp>
+
+namespace keeg { namespace hashing {
+
+/// Feeds the same data to several algorithms, reading it only once.
+/// Results are left in each algorithm's hashValue().
+///
+///   crc::Crc32 crc; cryptographic::Md5 md5; cryptographic::Sha256 sha;
+///   MultiHash multi({&crc, &md5, &sha}, true);
+///   multi.computeHashFile(path);
+///
+/// With useThreads every algorithm runs on its own thread, taking blocks from a bounded
+/// queue of queueDepth buffers, so the total time is that of the slowest algorithm.
+class MultiHash
+{
+public:
+    explicit MultiHash(const std::vector<HashAlgorithm*> &algorithms, const bool &useThreads = false,
+                       const std::size_t &queueDepth = 4, const std::size_t &blockSize = HASH_BLOCK_BUFFER_SIZE);
+
+    const std::vector<HashAlgorithm*> &algorithms() const;
+
+    /// Hashes a memory block with every algorithm.
+    void computeHash(const void *data, const std::size_t &dataLength);
+    /// Hashes a stream from the start with every algorithm. Returns false if the stream is bad.
+    bool computeHash(std::istream &instream);
+    /// Hashes a file with every algorithm, memory mapped when possible. Returns false if it can't be read.
+    bool computeHashFile(const std::string &path);
+
+private:
+    std::vector<HashAlgorithm*> m_algorithms;
+    bool m_useThreads;
+    std::size_t m_queueDepth;
+    std::size_t m_blockSize;
+
+    bool threaded() const;
+    void initializeAll();
+    void finalizeAll();
+};
+
+MultiHash::MultiHash(const std::vector<HashAlgorithm*> &algorithms, const bool &useThreads,
+                     const std::size_t &queueDepth, const std::size_t &blockSize) :
+    m_algorithms(algorithms),
+    m_useThreads(useThreads),
+    m_queueDepth(std::max<std::size_t>(queueDepth, 1)),
+    m_blockSize(std::max<std::size_t>(blockSize, 1))
+{
+    m_algorithms.erase(std::remove(m_algorithms.begin(), m_algorithms.end(), nullptr), m_algorithms.end());
+}
+
+const std::vector<HashAlgorithm*> &MultiHash::algorithms() const
+{
+    return m_algorithms;
+}
+
+void MultiHash::computeHash(const void *data, const std::size_t &dataLength)
+{
+    initializeAll();
+    const uint8_t *bytes = static_cast<const uint8_t*>(data);
+
+    if (threaded())
+    {
+        // Nothing to read, each thread walks the whole block on its own.
+        common::ThreadGroup workers;
+        workers.reserve(m_algorithms.size());
+        for (HashAlgorithm *algorithm : m_algorithms)
+            workers.run([=] { algorithm->runHashCore(bytes, dataLength, 0); });
+        workers.join();
+    }
+    else
+    {
+        // Block by block, so every algorithm after the first finds the data in cache.
+        for (std::size_t offset = 0; offset < dataLength; offset += m_blockSize)
+        {
+            const std::size_t length = std::min(m_blockSize, dataLength - offset);
+            for (HashAlgorithm *algorithm : m_algorithms)
+                algorithm->runHashCore(bytes + offset, length, 0);
+        }
+    }
+
+    finalizeAll();
+}
+
+bool MultiHash::computeHash(std::istream &instream)
+{
+    if (!instream)
+        return false;
+
+    initializeAll();
+    instream.seekg(0, std::ios::beg);
+
+    bool started = false;
+    if (threaded())
+    {
+        BlockQueue queue(m_queueDepth, m_blockSize, m_algorithms.size());
+        common::ThreadGroup workers;
+        workers.reserve(m_algorithms.size());
+        for (std::size_t i = 0; i < m_algorithms.size(); ++i)
+        {
+            // The workers wait on the reader below, they can't run on this thread.
+            started = workers.tryRun([&queue, this, i] {
+                try
+                {
+                    while (const BlockQueue::Block *block = queue.next(i))
+                    {
+                        m_algorithms[i]->runHashCore(block->data.get(), block->length, 0);
+                        queue.release(i);
+                    }
+                }
+                catch (...)
+                {
+                    // The reader and the other workers would wait on this one forever.
+                    queue.cancel();
+                    throw;
+                }
+            });
+            if (!started)
+                break;
+        }
+
+        // Out of threads, nothing was read yet and the loop below hashes everything.
+        if (!started)
+            queue.cancel();
+
+        const bool readOk = started && readIntoQueue(instream, queue);
+        workers.join();
+        if (started && !readOk)
+            return false;
+    }
+
+    if (!started)
+    {
+        std::unique_ptr<char[]> buffer = std::make_unique<char[]>(m_blockSize);
+        while (instream)
+        {
+            instream.read(buffer.get(), static_cast<std::streamsize>(m_blockSize));
+            const std::size_t numBytesRead = static_cast<std::size_t>(instream.gcount());
+            for (HashAlgorithm *algorithm : m_algorithms)
+                algorithm->runHashCore(buffer.get(), numBytesRead, 0);
+        }
+    }
+
+    finalizeAll();
+    return true;
+}
+
+bool MultiHash::computeHashFile(const std::string &path)
+{
+    io::MappedFile mapped;
+    if (mapped.open(path))
+    {
+        computeHash(mapped.data(), mapped.size());
+        return true;
+    }
+
+    std::ifstream file(path, std::ios::binary);
+    return computeHash(file);
+}
+
+bool MultiHash::threaded() const
+{
+    return m_useThreads && m_algorithms.size() > 1;
+}
+
+void MultiHash::initializeAll()
+{
+    for (HashAlgorithm *algorithm : m_algorithms)
+        algorithm->initialize();
+}
+
+void MultiHash::finalizeAll()
+{
+    for (HashAlgorithm *algorithm : m_algorithms)
+        algorithm->m_hashValue = algorithm->runHashFinal();
+}
+
+} // hashing namespace
+} // keeg namespace
+
+#endif // MULTIHASH_HPP
@@ -22,13 +22,43 @@
 #ifndef APHASH32_HPP
 #define APHASH32_HPP
 
-#include <keeg/hashing/hashalgorithm.hpp>
+#include <keeg/hashing/integerhashalgorithm.hpp>
+#include <keeg/hashing/statichash.hpp>
+#include <keeg/hashing/noncryptographic/stringhashkernels.hpp>
 #include <keeg/endian/conversion.hpp>
 
 namespace keeg { namespace hashing { namespace noncryptographic {
 
+/// Arash Partow's hash as a policy for StaticHash, also used by APHash32.
+/// Odd and even bytes are mixed differently, counted from the start of each update.
+struct APHash32Policy
+{
+    using result_type = uint32_t;
+
+    uint32_t initial() const { return UINT32_C(0xAAAAAAAA); }
+
+    static uint32_t mix(const uint32_t &h, const uint8_t &byte, const bool &even)
+    {
+        return h ^ (even ? (  (h <<  7) ^ byte ^ (h >> 3)) :
+                           (~((h << 11) ^ byte ^ (h >> 5))));
+    }
+
+    uint32_t update(uint32_t hash, const uint8_t *data, const std::size_t &dataLength) const
+    {
+        // Unrolled the parity of each byte is known, so the choice folds away.
+        return detail::unrolledByteHash(hash, data, dataLength, [](const uint32_t &h, const uint8_t &byte, const bool &even)
+        {
+            return mix(h, byte, even);
+        });
+    }
+
+    uint32_t finalize(const uint32_t &hash) const { return hash; }
+};
+
+using StaticAPHash32 = StaticHash<APHash32Policy>;
+
 /// Hashing algorithm by Arash Partow
-class APHash32 : public HashAlgorithm
+class APHash32 : public IntegerHashAlgorithm<uint32_t>
 {
 public:
     APHash32();
@@ -36,22 +66,25 @@ public:
     // HashAlgorithm interface
 public:
     virtual std::size_t hashSize() override;
+    virtual std::unique_ptr<HashAlgorithm> copy() const override;
     virtual void initialize() override;
 
 protected:
     virtual void hashCore(const void *data, const std::size_t &dataLength, const std::size_t &startIndex) override;
-    virtual std::vector<uint8_t> hashFinal() override;
+    virtual uint32_t hashFinalValue() override;
 
 private:
     static const std::size_t m_hashSize = std::numeric_limits<uint32_t>::digits;
-    const uint32_t m_seed = UINT32_C(0xAAAAAAAA);
+    APHash32Policy m_policy;
     uint32_t m_hash;
+    /// An odd number of bytes were hashed so far, the next update starts on an odd byte.
+    bool m_odd;
 
     static_assert(std::is_same<uint8_t, unsigned char>::value,
                   "uint8_t is required to be implemented as unsigned char!");
 };
 
-APHash32::APHash32() : HashAlgorithm()
+APHash32::APHash32() : IntegerHashAlgorithm<uint32_t>()
 {
     initialize();
 }
@@ -61,32 +94,36 @@ std::size_t APHash32::hashSize()
     return m_hashSize;
 }
 
+std::unique_ptr<HashAlgorithm> APHash32::copy() const
+{
+    return std::unique_ptr<HashAlgorithm>(new APHash32(*this));
+}
+
 void APHash32::initialize()
 {
-    m_hash = m_seed;
+    m_hash = m_policy.initial();
+    m_odd = false;
     m_hashValue.clear();
 }
 
 void APHash32::hashCore(const void *data, const std::size_t &dataLength, const std::size_t &startIndex)
 {
-    const uint8_t *current = static_cast<const uint8_t*>(data) + startIndex;
+    const uint8_t *bytes = static_cast<const uint8_t*>(data) + startIndex;
+    if (dataLength == 0)
+        return;
 
-    for(std::size_t i = 0; i < dataLength; ++current, ++i)
-    {
-       m_hash ^= ((i & 0x01) == 0) ? (  (m_hash <<  7) ^ *current ^ (m_hash >> 3)) :
-                                     (~((m_hash << 11) ^ *current ^ (m_hash >> 5)));
-    }
+    // Keep the parity of the whole message across updates.
+    std::size_t first = 0;
+    if (m_odd)
+        m_hash = APHash32Policy::mix(m_hash, bytes[first++], false);
+
+    m_hash = m_policy.update(m_hash, bytes + first, dataLength - first);
+    m_odd = m_odd != ((dataLength & 1) != 0);
 }
 
-std::vector<uint8_t> APHash32::hashFinal()
+uint32_t APHash32::hashFinalValue()
 {
-    /// Make sure the hash is Big-Endian.
-    uint32_t data = endian::native_to_big(m_hash);
-
-    /// Convert the hash to a vector of bytes.
-    std::vector<uint8_t> v(reinterpret_cast<uint8_t*>(&data),
-                           reinterpret_cast<uint8_t*>(&data) + sizeof(uint32_t));
-    return std::move(v);
+    return m_policy.finalize(m_hash);
 }
 
 } // noncryptographic namespace
@@ -22,36 +22,67 @@
 #ifndef BKDRHASH32_HPP
 #define BKDRHASH32_HPP
 
-#include <keeg/hashing/hashalgorithm.hpp>
+#include <keeg/hashing/integerhashalgorithm.hpp>
+#include <keeg/hashing/statichash.hpp>
+#include <keeg/hashing/noncryptographic/stringhashkernels.hpp>
 #include <keeg/endian/conversion.hpp>
 
+#define BKDR_DEFAULT_SEED UINT32_C(131)
+
 namespace keeg { namespace hashing { namespace noncryptographic {
 
+/// Kernighan and Ritchie's hash as a policy for StaticHash, also used by BKDRHash32.
+struct BKDRHash32Policy
+{
+    using result_type = uint32_t;
+
+    /// multiplier, 31 131 1313 13131 131313 etc..
+    uint32_t seed;
+    /// powers of seed for update, computed once here
+    detail::MultiplyAddPowers powers;
+
+    explicit BKDRHash32Policy(const uint32_t &multiplier = BKDR_DEFAULT_SEED) :
+        seed(multiplier), powers(detail::multiplyAddPowers(multiplier)) { }
+
+    uint32_t initial() const { return 0; }
+
+    /// hash * seed + byte for each byte, eight bytes per step.
+    uint32_t update(uint32_t hash, const uint8_t *data, const std::size_t &dataLength) const
+    {
+        return detail::multiplyAddHash(hash, data, dataLength, powers);
+    }
+
+    uint32_t finalize(const uint32_t &hash) const { return hash; }
+};
+
+using StaticBKDRHash32 = StaticHash<BKDRHash32Policy>;
+
 /// Brian Kernighan and Dennis Ritchie
-class BKDRHash32 : public HashAlgorithm
+class BKDRHash32 : public IntegerHashAlgorithm<uint32_t>
 {
 public:
-    BKDRHash32(const uint32_t &seed = UINT32_C(131));
+    BKDRHash32(const uint32_t &seed = BKDR_DEFAULT_SEED);
 
     // HashAlgorithm interface
 public:
     virtual std::size_t hashSize() override;
+    virtual std::unique_ptr<HashAlgorithm> copy() const override;
     virtual void initialize() override;
 
 protected:
     virtual void hashCore(const void *data, const std::size_t &dataLength, const std::size_t &startIndex) override;
-    virtual std::vector<uint8_t> hashFinal() override;
+    virtual uint32_t hashFinalValue() override;
 
 private:
     static const std::size_t m_hashSize = std::numeric_limits<uint32_t>::digits;
-    uint32_t m_seed;
+    BKDRHash32Policy m_policy;
     uint32_t m_hash;
 
     static_assert(std::is_same<uint8_t, unsigned char>::value,
                   "uint8_t is required to be implemented as unsigned char!");
 };
 
-BKDRHash32::BKDRHash32(const uint32_t &seed) : HashAlgorithm(), m_seed(seed)
+BKDRHash32::BKDRHash32(const uint32_t &seed) : IntegerHashAlgorithm<uint32_t>(), m_policy(seed)
 {
     initialize();
 }
@@ -61,31 +92,25 @@ std::size_t BKDRHash32::hashSize()
     return m_hashSize;
 }
 
+std::unique_ptr<HashAlgorithm> BKDRHash32::copy() const
+{
+    return std::unique_ptr<HashAlgorithm>(new BKDRHash32(*this));
+}
+
 void BKDRHash32::initialize()
 {
-    m_hash = 0;
+    m_hash = m_policy.initial();
     m_hashValue.clear();
 }
 
 void BKDRHash32::hashCore(const void *data, const std::size_t &dataLength, const std::size_t &startIndex)
 {
-    const uint8_t *current = static_cast<const uint8_t*>(data) + startIndex;
-
-    for (uint32_t i = 0; i < dataLength; ++current, ++i)
-    {
-        m_hash = (m_hash * m_seed) + *current;
-    }
+    m_hash = m_policy.update(m_hash, static_cast<const uint8_t*>(data) + startIndex, dataLength);
 }
 
-std::vector<uint8_t> BKDRHash32::hashFinal()
+uint32_t BKDRHash32::hashFinalValue()
 {
-    /// Make sure the hash is Big-Endian.
-    uint32_t data = endian::native_to_big(m_hash);
-
-    /// Convert the hash to a vector of bytes.
-    std::vector<uint8_t> v(reinterpret_cast<uint8_t*>(&data),
-                           reinterpret_cast<uint8_t*>(&data) + sizeof(uint32_t));
-    return std::move(v);
+    return m_policy.finalize(m_hash);
 }
 
 } // noncryptographic namespace
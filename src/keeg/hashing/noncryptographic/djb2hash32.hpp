@@ -22,14 +22,55 @@
 #ifndef DJB2HASH32_HPP
 #define DJB2HASH32_HPP
 
-#include <keeg/hashing/hashalgorithm.hpp>
+#include <keeg/hashing/integerhashalgorithm.hpp>
+#include <keeg/hashing/statichash.hpp>
+#include <keeg/hashing/noncryptographic/stringhashkernels.hpp>
 #include <keeg/endian/conversion.hpp>
 
 #define DJB2_DEFAULT_SEED UINT32_C(5381)
 
 namespace keeg { namespace hashing { namespace noncryptographic {
 
-class Djb2Hash32 : public HashAlgorithm
+/// Dan Bernstein's djb2 as a policy for StaticHash, also used by Djb2Hash32.
+struct Djb2Hash32Policy
+{
+    using result_type = uint32_t;
+
+    uint32_t seed;
+
+    constexpr explicit Djb2Hash32Policy(const uint32_t &defaultSeed = DJB2_DEFAULT_SEED) : seed(defaultSeed) { }
+
+    constexpr uint32_t initial() const { return seed; }
+
+    /// Byte is uint8_t, or char in constant expressions.
+    template<typename Byte>
+    constexpr uint32_t update(uint32_t hash, const Byte *data, const std::size_t &dataLength) const
+    {
+        for (std::size_t i = 0; i < dataLength; ++i)
+            hash = ((hash << 5) + hash) + static_cast<uint8_t>(data[i]); /* hash * 33 + c */
+
+        return hash;
+    }
+
+    /// Runtime data, eight bytes per step with the powers of 33.
+    uint32_t update(uint32_t hash, const uint8_t *data, const std::size_t &dataLength) const
+    {
+        constexpr detail::MultiplyAddPowers powers = detail::multiplyAddPowers(33);
+        return detail::multiplyAddHash(hash, data, dataLength, powers);
+    }
+
+    constexpr uint32_t finalize(const uint32_t &hash) const { return hash; }
+};
+
+/// djb2 of length characters of text, usable at compile time. Same value as Djb2Hash32.
+constexpr uint32_t djb2Hash32(const char *text, const std::size_t &length, const uint32_t &seed = DJB2_DEFAULT_SEED)
+{
+    return constexprHash(Djb2Hash32Policy(seed), text, length);
+}
+
+using StaticDjb2Hash32 = StaticHash<Djb2Hash32Policy>;
+
+class Djb2Hash32 : public IntegerHashAlgorithm<uint32_t>
 {
 public:
     Djb2Hash32(const uint32_t &defaultSeed = DJB2_DEFAULT_SEED);
@@ -37,22 +78,23 @@ public:
     // HashAlgorithm interface
 public:
     virtual std::size_t hashSize() override;
+    virtual std::unique_ptr<HashAlgorithm> copy() const override;
     virtual void initialize() override;
 
 protected:
     virtual void hashCore(const void *data, const std::size_t &dataLength, const std::size_t &startIndex) override;
-    virtual std::vector<uint8_t> hashFinal() override;
+    virtual uint32_t hashFinalValue() override;
 
 private:
     static const std::size_t m_hashSize = std::numeric_limits<uint32_t>::digits;
-    uint32_t m_defaultSeed;
+    Djb2Hash32Policy m_policy;
     uint32_t m_hash;
 
     static_assert(std::is_same<uint8_t, unsigned char>::value,
                   "uint8_t is required to be implemented as unsigned char!");
 };
 
-Djb2Hash32::Djb2Hash32(const uint32_t &defaultSeed) : HashAlgorithm(), m_defaultSeed(defaultSeed)
+Djb2Hash32::Djb2Hash32(const uint32_t &defaultSeed) : IntegerHashAlgorithm<uint32_t>(), m_policy(defaultSeed)
 {
     initialize();
 }
@@ -62,31 +104,25 @@ std::size_t Djb2Hash32::hashSize()
     return m_hashSize;
 }
 
+std::unique_ptr<HashAlgorithm> Djb2Hash32::copy() const
+{
+    return std::unique_ptr<HashAlgorithm>(new Djb2Hash32(*this));
+}
+
 void Djb2Hash32::initialize()
 {
-    m_hash = m_defaultSeed;
+    m_hash = m_policy.initial();
     m_hashValue.clear();
 }
 
 void Djb2Hash32::hashCore(const void *data, const std::size_t &dataLength, const std::size_t &startIndex)
 {
-    const uint8_t *current = static_cast<const uint8_t*>(data) + startIndex;
-
-    for (std::size_t i = 0; i < dataLength; ++current, ++i)
-    {
-        m_hash = ((m_hash << 5) + m_hash) + *current; /* hash * 33 + c */
-    }
+    m_hash = m_policy.update(m_hash, static_cast<const uint8_t*>(data) + startIndex, dataLength);
 }
 
-std::vector<uint8_t> Djb2Hash32::hashFinal()
+uint32_t Djb2Hash32::hashFinalValue()
 {
-    /// Make sure the hash is Big-Endian.
-    uint32_t data = endian::native_to_big(m_hash);
-
-    /// Convert the hash to a vector of bytes.
-    std::vector<uint8_t> v(reinterpret_cast<uint8_t*>(&data),
-                           reinterpret_cast<uint8_t*>(&data) + sizeof(uint32_t));
-    return std::move(v);
+    return m_policy.finalize(m_hash);
 }
 
 } // noncryptographic namespace
@@ -22,13 +22,38 @@
 #ifndef ELFHASH32_HPP
 #define ELFHASH32_HPP
 
-#include <keeg/hashing/hashalgorithm.hpp>
+#include <keeg/hashing/integerhashalgorithm.hpp>
+#include <keeg/hashing/statichash.hpp>
+#include <keeg/hashing/noncryptographic/stringhashkernels.hpp>
 #include <keeg/endian/conversion.hpp>
 
 namespace keeg { namespace hashing { namespace noncryptographic {
 
+/// Unix ELF object file hash as a policy for StaticHash, also used by ELFHash32.
+struct ELFHash32Policy
+{
+    using result_type = uint32_t;
+
+    uint32_t initial() const { return 0; }
+
+    /// Without the branch on the top nibble, xor with zero changes nothing.
+    uint32_t update(uint32_t hash, const uint8_t *data, const std::size_t &dataLength) const
+    {
+        return detail::unrolledByteHash(hash, data, dataLength, [](uint32_t h, const uint8_t &byte, bool)
+        {
+            h = (h << 4) + byte;
+            const uint32_t x = h & UINT32_C(0xF0000000);
+            return (h ^ (x >> 24)) & ~x;
+        });
+    }
+
+    uint32_t finalize(const uint32_t &hash) const { return hash; }
+};
+
+using StaticELFHash32 = StaticHash<ELFHash32Policy>;
+
 /// Similar to the Peter J. Weinberger hashing function but tweaked for 32-bit processors.
-class ELFHash32 : public HashAlgorithm
+class ELFHash32 : public IntegerHashAlgorithm<uint32_t>
 {
 public:
     ELFHash32();
@@ -36,21 +61,23 @@ public:
     // HashAlgorithm interface
 public:
     virtual std::size_t hashSize() override;
+    virtual std::unique_ptr<HashAlgorithm> copy() const override;
     virtual void initialize() override;
 
 protected:
     virtual void hashCore(const void *data, const std::size_t &dataLength, const std::size_t &startIndex) override;
-    virtual std::vector<uint8_t> hashFinal() override;
+    virtual uint32_t hashFinalValue() override;
 
 private:
     static const std::size_t m_hashSize = std::numeric_limits<uint32_t>::digits;
+    ELFHash32Policy m_policy;
     uint32_t m_hash;
 
     static_assert(std::is_same<uint8_t, unsigned char>::value,
                   "uint8_t is required to be implemented as unsigned char!");
 };
 
-ELFHash32::ELFHash32() : HashAlgorithm()
+ELFHash32::ELFHash32() : IntegerHashAlgorithm<uint32_t>()
 {
     initialize();
 }
@@ -60,38 +87,25 @@ size_t ELFHash32::hashSize()
     return m_hashSize;
 }
 
+std::unique_ptr<HashAlgorithm> ELFHash32::copy() const
+{
+    return std::unique_ptr<HashAlgorithm>(new ELFHash32(*this));
+}
+
 void ELFHash32::initialize()
 {
-    m_hash = 0;
+    m_hash = m_policy.initial();
     m_hashValue.clear();
 }
 
 void ELFHash32::hashCore(const void *data, const size_t &dataLength, const size_t &startIndex)
 {
-    const uint8_t *current = static_cast<const uint8_t*>(data) + startIndex;
-
-    uint32_t x = 0;
-    for (std::size_t i = 0; i < dataLength; ++current, ++i)
-    {
-        m_hash = (m_hash << 4) + *current;
-        if ((x = m_hash & INT32_C(0xF0000000)) != 0)
-        {
-            m_hash ^= (x >> 24);
-        }
-
-        m_hash &= ~x;
-    }
+    m_hash = m_policy.update(m_hash, static_cast<const uint8_t*>(data) + startIndex, dataLength);
 }
 
-std::vector<uint8_t> ELFHash32::hashFinal()
+uint32_t ELFHash32::hashFinalValue()
 {
-    /// Make sure the hash is Big-Endian.
-    uint32_t data = endian::native_to_big(m_hash);
-
-    /// Convert the hash to a vector of bytes.
-    std::vector<uint8_t> v(reinterpret_cast<uint8_t*>(&data),
-                           reinterpret_cast<uint8_t*>(&data) + sizeof(uint32_t));
-    return std::move(v);
+    return m_policy.finalize(m_hash);
 }
 
 } // noncryptographic namespace
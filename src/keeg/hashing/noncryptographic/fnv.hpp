@@ -23,21 +23,14 @@
 #define FNV_HPP
 
 #include <keeg/hashing/hashalgorithm.hpp>
+#include <keeg/hashing/statichash.hpp>
 #include <keeg/common/enums.hpp>
 #include <keeg/endian/conversion.hpp>
 #include <algorithm>
 #include <iterator>
 
-#ifndef FNV_USE_BOOST
-    #define FNV_USE_BOOST 0
-#endif
-
-#if FNV_USE_BOOST == 1
-    #include <boost/multiprecision/cpp_int.hpp>
-#endif
-
-#if FNV_USE_BOOST == 1
-    namespace bm = boost::multiprecision;
+#if defined(_MSC_VER) && defined(_M_X64)
+    #include <intrin.h>
 #endif
 
 namespace keeg { namespace hashing { namespace noncryptographic {
@@ -72,15 +65,254 @@ void calcFnv1aHash(const void* data, std::size_t dataLength, const std::size_t &
     }
 }
 
+/// Prime and offset basis of the FNV sizes that fit in a native integer.
+template<typename T>
+struct FnvParameters;
+
+template<>
+struct FnvParameters<uint32_t>
+{
+    static const uint32_t prime       = UINT32_C(16777619);
+    static const uint32_t offsetBasis = UINT32_C(2166136261);
+};
+
+template<>
+struct FnvParameters<uint64_t>
+{
+    static const uint64_t prime       = UINT64_C(1099511628211);
+    static const uint64_t offsetBasis = UINT64_C(14695981039346656037);
+};
+
+/// Unsigned integer of Bits bits with only what FNV needs, least significant limb first.
+template<std::size_t Bits>
+struct FnvUint
+{
+    static const std::size_t Limbs = Bits / 64;
+    uint64_t limbs[Limbs];
+};
+
+using FnvUint128 = FnvUint<128>;
+using FnvUint256 = FnvUint<256>;
+using FnvUint512 = FnvUint<512>;
+
+/// The primes above 64 bits are 2^primeShift + primeLow, a shift and a small multiply.
+template<>
+struct FnvParameters<FnvUint128>
+{
+    static const std::size_t primeShift = 88;
+    static const uint64_t primeLow = 0x13B;
+    /// Same value as the prime, kept so existing 128 bit hashes stay the same.
+    static FnvUint128 offsetBasis()
+    {
+        return {{ UINT64_C(0x000000000000013B), UINT64_C(0x0000000001000000) }};
+    }
+};
+
+template<>
+struct FnvParameters<FnvUint256>
+{
+    static const std::size_t primeShift = 168;
+    static const uint64_t primeLow = 0x163;
+    static FnvUint256 offsetBasis()
+    {
+        return {{ UINT64_C(0x1023B4C8CAEE0535), UINT64_C(0xC8B1536847B6BBB3),
+                  UINT64_C(0x2D98C384C4E576CC), UINT64_C(0xDD268DBCAAC55036) }};
+    }
+};
+
+template<>
+struct FnvParameters<FnvUint512>
+{
+    static const std::size_t primeShift = 344;
+    static const uint64_t primeLow = 0x157;
+    static FnvUint512 offsetBasis()
+    {
+        return {{ UINT64_C(0xAC982AAC4AFE9FD9), UINT64_C(0x182036415F56E34B),
+                  UINT64_C(0x2EA79BC942DBE7CE), UINT64_C(0xE948F68A34C192F6),
+                  UINT64_C(0x0000000000000D21), UINT64_C(0xAC87D059C9000000),
+                  UINT64_C(0xDCA1E50F309990AC), UINT64_C(0xB86DB0B1171F4416) }};
+    }
+};
+
+namespace detail {
+
+/// Low 64 bits of a * b + carry, the high 64 bits are left in carry. b is below 2^32.
+inline uint64_t fnvMultiplyAdd(const uint64_t &a, const uint64_t &b, uint64_t &carry)
+{
+#if defined(__SIZEOF_INT128__)
+    const unsigned __int128 product = static_cast<unsigned __int128>(a) * b + carry;
+    carry = static_cast<uint64_t>(product >> 64);
+    return static_cast<uint64_t>(product);
+#elif defined(_MSC_VER) && defined(_M_X64)
+    uint64_t high;
+    uint64_t low = _umul128(a, b, &high);
+    low  += carry;
+    high += (low < carry) ? 1 : 0;
+    carry = high;
+    return low;
+#else
+    const uint64_t low  = (a & UINT64_C(0xFFFFFFFF)) * b + carry;
+    const uint64_t high = (a >> 32) * b + (low >> 32);
+    carry = high >> 32;
+    return (high << 32) | (low & UINT64_C(0xFFFFFFFF));
+#endif
+}
+
+/// hash *= prime modulo 2^Bits, as hash * primeLow + (hash << primeShift).
+/// The shifted term only reaches the limbs from primeShift up.
+template<std::size_t Bits>
+inline void fnvMultiplyPrime(FnvUint<Bits> &hash)
+{
+    using Parameters = FnvParameters<FnvUint<Bits>>;
+    const std::size_t Limbs = FnvUint<Bits>::Limbs;
+    const std::size_t limbShift = Parameters::primeShift / 64;
+    const unsigned bitShift = Parameters::primeShift % 64;
+    const uint64_t primeLow = Parameters::primeLow;
+    static_assert(Parameters::primeShift % 64 != 0, "The shift is assumed to cross a limb boundary!");
+
+    FnvUint<Bits> product;
+    uint64_t carry = 0;
+    for (std::size_t i = 0; i < Limbs; ++i)
+        product.limbs[i] = fnvMultiplyAdd(hash.limbs[i], primeLow, carry);
+
+    carry = 0;
+    for (std::size_t i = limbShift; i < Limbs; ++i)
+    {
+        uint64_t shifted = hash.limbs[i - limbShift] << bitShift;
+        if (i > limbShift)
+            shifted |= hash.limbs[i - limbShift - 1] >> (64 - bitShift);
+
+        const uint64_t sum = product.limbs[i] + shifted;
+        const uint64_t overflow = (sum < shifted) ? 1 : 0;
+        product.limbs[i] = sum + carry;
+        carry = overflow | ((product.limbs[i] < sum) ? 1 : 0);
+    }
+
+    hash = product;
+}
+
+/// Big endian bytes of hash, Bits / 8 of them.
+template<std::size_t Bits>
+inline void fnvToBytes(const FnvUint<Bits> &hash, uint8_t *digest)
+{
+    for (std::size_t i = 0; i < Bits / 8; ++i)
+        digest[i] = static_cast<uint8_t>(hash.limbs[FnvUint<Bits>::Limbs - 1 - i / 8] >> (56 - 8 * (i % 8)));
+}
+
+} // detail namespace
+
+template<std::size_t Bits>
+void calcFnv1Hash(const void* data, std::size_t dataLength, const std::size_t &startIndex,
+                  FnvUint<Bits> &hashValue)
+{
+    const uint8_t *current = static_cast<const uint8_t*>(data) + startIndex;
+
+    // Work on a copy so the limbs can stay in registers.
+    FnvUint<Bits> hash = hashValue;
+    for (std::size_t i = 0; i < dataLength; ++current, ++i)
+    {
+        detail::fnvMultiplyPrime(hash);
+        hash.limbs[0] ^= *current;
+    }
+    hashValue = hash;
+}
+
+template<std::size_t Bits>
+void calcFnv1aHash(const void* data, std::size_t dataLength, const std::size_t &startIndex,
+                   FnvUint<Bits> &hashValue)
+{
+    const uint8_t *current = static_cast<const uint8_t*>(data) + startIndex;
+
+    FnvUint<Bits> hash = hashValue;
+    for (std::size_t i = 0; i < dataLength; ++current, ++i)
+    {
+        hash.limbs[0] ^= *current;
+        detail::fnvMultiplyPrime(hash);
+    }
+    hashValue = hash;
+}
+
+/// FNV-1 as a policy for StaticHash, T is uint32_t or uint64_t.
+template<typename T>
+struct Fnv1Policy
+{
+    using result_type = T;
+
+    constexpr T initial() const { return FnvParameters<T>::offsetBasis; }
+
+    /// Byte is uint8_t, or char in constant expressions.
+    template<typename Byte>
+    constexpr T update(T hash, const Byte *data, const std::size_t &dataLength) const
+    {
+        for (std::size_t i = 0; i < dataLength; ++i)
+            hash = (FnvParameters<T>::prime * hash) ^ static_cast<uint8_t>(data[i]);
+
+        return hash;
+    }
+
+    constexpr T finalize(const T &hash) const { return hash; }
+};
+
+/// FNV-1a as a policy for StaticHash, T is uint32_t or uint64_t.
+template<typename T>
+struct Fnv1aPolicy
+{
+    using result_type = T;
+
+    constexpr T initial() const { return FnvParameters<T>::offsetBasis; }
+
+    /// Byte is uint8_t, or char in constant expressions.
+    template<typename Byte>
+    constexpr T update(T hash, const Byte *data, const std::size_t &dataLength) const
+    {
+        for (std::size_t i = 0; i < dataLength; ++i)
+            hash = (static_cast<uint8_t>(data[i]) ^ hash) * FnvParameters<T>::prime;
+
+        return hash;
+    }
+
+    constexpr T finalize(const T &hash) const { return hash; }
+};
+
+using Fnv1Hash32Policy  = Fnv1Policy<uint32_t>;
+using Fnv1Hash64Policy  = Fnv1Policy<uint64_t>;
+using Fnv1aHash32Policy = Fnv1aPolicy<uint32_t>;
+using Fnv1aHash64Policy = Fnv1aPolicy<uint64_t>;
+
+using StaticFnv1Hash32  = StaticHash<Fnv1Hash32Policy>;
+using StaticFnv1Hash64  = StaticHash<Fnv1Hash64Policy>;
+using StaticFnv1aHash32 = StaticHash<Fnv1aHash32Policy>;
+using StaticFnv1aHash64 = StaticHash<Fnv1aHash64Policy>;
+
+/// FNV of length characters of text, usable at compile time. Same values as Fnv1Hash
+/// and Fnv1aHash with the matching FnvBits.
+constexpr uint32_t fnv1Hash32(const char *text, const std::size_t &length)
+{
+    return constexprHash(Fnv1Hash32Policy(), text, length);
+}
+
+constexpr uint64_t fnv1Hash64(const char *text, const std::size_t &length)
+{
+    return constexprHash(Fnv1Hash64Policy(), text, length);
+}
+
+constexpr uint32_t fnv1aHash32(const char *text, const std::size_t &length)
+{
+    return constexprHash(Fnv1aHash32Policy(), text, length);
+}
+
+constexpr uint64_t fnv1aHash64(const char *text, const std::size_t &length)
+{
+    return constexprHash(Fnv1aHash64Policy(), text, length);
+}
+
 enum class FnvBits : uint16_t
 {
     Bits32  =  32,
     Bits64  =  64,
-#if FNV_USE_BOOST == 1
     Bits128 = 128,
     Bits256 = 256,
     Bits512 = 512
-#endif
 };
 
 class FnvBase : public HashAlgorithm
@@ -90,14 +322,6 @@ public:
     static const uint32_t offsetBasis32 = UINT32_C(2166136261);
     static const uint64_t fnvPrime64 = UINT64_C(1099511628211);
     static const uint64_t offsetBasis64 = UINT64_C(14695981039346656037);
-#if FNV_USE_BOOST == 1
-    const bm::uint128_t fnvPrime128 = bm::uint128_t("0x1000000000000000000013B");
-    const bm::uint128_t offsetBasis128 = bm::uint128_t("0x1000000000000000000013B");
-    const bm::uint256_t fnvPrime256 = bm::uint256_t("0x1000000000000000000000000000000000000000163");
-    const bm::uint256_t offsetBasis256 = bm::uint256_t("0xDD268DBCAAC550362D98C384C4E576CCC8B1536847B6BBB31023B4C8CAEE0535");
-    const bm::uint512_t fnvPrime512 = bm::uint512_t("0x100000000000000000000000000000000000000000000000000000000000000000000000000000000000157");
-    const bm::uint512_t offsetBasis512 = bm::uint512_t("0xB86DB0B1171F4416DCA1E50F309990ACAC87D059C90000000000000000000D21E948F68A34C192F62EA79BC942DBE7CE182036415F56E34BAC982AAC4AFE9FD9");
-#endif
 
     FnvBase(const FnvBits &bits = FnvBits::Bits32);
 
@@ -107,20 +331,25 @@ public:
 
     virtual void initialize() override;
 
+    /// compute Hash of a memory block returning the hash as an integer, nothing is allocated.
+    /// Sizes over 64 bits return their lowest 64 bits.
+    uint64_t computeHashValue(const void* data, const std::size_t &dataLength);
+    /// compute Hash of a string returning the hash as an integer, excluding final zero.
+    uint64_t computeHashValue(const std::string &text);
+
 protected:
     virtual void hashCore(const void *data, const std::size_t &dataLength, const std::size_t &startIndex) = 0;
 
     virtual std::vector<uint8_t> hashFinal() override;
+    virtual void hashFinalTo(uint8_t *digest) override;
 
 protected:
     FnvBits m_bits;
     uint32_t m_hash32;
     uint64_t m_hash64;
-#if FNV_USE_BOOST == 1
-    bm::uint128_t m_hash128;
-    bm::uint256_t m_hash256;
-    bm::uint512_t m_hash512;
-#endif
+    FnvUint128 m_hash128;
+    FnvUint256 m_hash256;
+    FnvUint512 m_hash512;
 };
 
 FnvBase::FnvBase(const FnvBits &bits) : HashAlgorithm(), m_bits(bits)
@@ -144,58 +373,77 @@ void FnvBase::initialize()
     case FnvBits::Bits64:
         m_hash64 = offsetBasis64;
         break;
-#if FNV_USE_BOOST == 1
     case FnvBits::Bits128:
-        m_hash128 = offsetBasis128;
+        m_hash128 = FnvParameters<FnvUint128>::offsetBasis();
         break;
     case FnvBits::Bits256:
-        m_hash256 = offsetBasis256;
+        m_hash256 = FnvParameters<FnvUint256>::offsetBasis();
         break;
     case FnvBits::Bits512:
-        m_hash512 = offsetBasis512;
+        m_hash512 = FnvParameters<FnvUint512>::offsetBasis();
         break;
-#endif
     default:
         break;
     }
 }
 
-std::vector<uint8_t> FnvBase::hashFinal()
+uint64_t FnvBase::computeHashValue(const void *data, const std::size_t &dataLength)
 {
-    const std::size_t byteSize = hashSize() / std::numeric_limits<uint8_t>::digits;
-    std::vector<uint8_t> v(byteSize);
+    initialize();
+    runHashCore(data, dataLength, 0);
+    KEEG_INSTRUMENT_HASH_FINAL(typeid(*this));
 
     switch (m_bits) {
     case FnvBits::Bits32:
-    {
-        uint32_t data32 = endian::native_to_big(m_hash32);
-        std::copy(reinterpret_cast<uint8_t*>(&data32),
-                  reinterpret_cast<uint8_t*>(&data32) + byteSize, std::begin(v));
+        return m_hash32;
+    case FnvBits::Bits64:
+        return m_hash64;
+    case FnvBits::Bits128:
+        return m_hash128.limbs[0];
+    case FnvBits::Bits256:
+        return m_hash256.limbs[0];
+    case FnvBits::Bits512:
+        return m_hash512.limbs[0];
+    default:
+        return 0;
     }
+}
+
+uint64_t FnvBase::computeHashValue(const std::string &text)
+{
+    return computeHashValue(text.data(), text.size());
+}
+
+std::vector<uint8_t> FnvBase::hashFinal()
+{
+    std::vector<uint8_t> v(hashSize() / std::numeric_limits<uint8_t>::digits);
+    hashFinalTo(v.data());
+    return v;
+}
+
+void FnvBase::hashFinalTo(uint8_t *digest)
+{
+    switch (m_bits) {
+    case FnvBits::Bits32:
+        for (std::size_t i = 0; i < sizeof(uint32_t); ++i)
+            digest[i] = static_cast<uint8_t>(m_hash32 >> ((sizeof(uint32_t) - 1 - i) * 8));
         break;
     case FnvBits::Bits64:
-    {
-        uint64_t data64 = endian::native_to_big(m_hash64);
-        std::copy(reinterpret_cast<uint8_t*>(&data64),
-                  reinterpret_cast<uint8_t*>(&data64) + byteSize, std::begin(v));
-    }
+        for (std::size_t i = 0; i < sizeof(uint64_t); ++i)
+            digest[i] = static_cast<uint8_t>(m_hash64 >> ((sizeof(uint64_t) - 1 - i) * 8));
         break;
-#if FNV_USE_BOOST == 1
     case FnvBits::Bits128:
-        bm::export_bits(m_hash128, &v[0], 8, true);
+        detail::fnvToBytes(m_hash128, digest);
         break;
     case FnvBits::Bits256:
-        bm::export_bits(m_hash256, &v[0], 8, true);
+        detail::fnvToBytes(m_hash256, digest);
         break;
     case FnvBits::Bits512:
-        bm::export_bits(m_hash512, &v[0], 8, true);
+        detail::fnvToBytes(m_hash512, digest);
         break;
-#endif
     default:
         break;
     }
-
-    return std::move(v);
 }
 
 } // noncryptographic namespace
@@ -32,6 +32,9 @@ public:
     Fnv1Hash(const FnvBits &bits = FnvBits::Bits32);
 
     // HashAlgorithm interface
+public:
+    virtual std::unique_ptr<HashAlgorithm> copy() const override;
+
 protected:
     virtual void hashCore(const void *data, const std::size_t &dataLength, const std::size_t &startIndex) override;
 };
@@ -39,6 +42,11 @@ protected:
 Fnv1Hash::Fnv1Hash(const FnvBits &bits) : FnvBase(bits)
 { }
 
+std::unique_ptr<HashAlgorithm> Fnv1Hash::copy() const
+{
+    return std::unique_ptr<HashAlgorithm>(new Fnv1Hash(*this));
+}
+
 void Fnv1Hash::hashCore(const void *data, const size_t &dataLength, const size_t &startIndex)
 {
     switch (m_bits) {
@@ -48,17 +56,15 @@ void Fnv1Hash::hashCore(const void *data, const size_t &dataLength, const size_t
     case FnvBits::Bits64:
         calcFnv1Hash<uint64_t>(data, dataLength, startIndex, fnvPrime64, m_hash64);
         break;
-#if FNV_USE_BOOST == 1
     case FnvBits::Bits128:
-        calcFnv1Hash<bm::uint128_t>(data, dataLength, startIndex, fnvPrime128, m_hash128);
+        calcFnv1Hash(data, dataLength, startIndex, m_hash128);
         break;
     case FnvBits::Bits256:
-        calcFnv1Hash<bm::uint256_t>(data, dataLength, startIndex, fnvPrime256, m_hash256);
+        calcFnv1Hash(data, dataLength, startIndex, m_hash256);
         break;
     case FnvBits::Bits512:
-        calcFnv1Hash<bm::uint512_t>(data, dataLength, startIndex, fnvPrime512, m_hash512);
+        calcFnv1Hash(data, dataLength, startIndex, m_hash512);
         break;
-#endif
     default:
         break;
     }
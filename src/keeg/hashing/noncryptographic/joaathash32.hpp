@@ -22,13 +22,43 @@
 #ifndef JOAATHASH32_HPP
 #define JOAATHASH32_HPP
 
-#include <keeg/hashing/hashalgorithm.hpp>
+#include <keeg/hashing/integerhashalgorithm.hpp>
+#include <keeg/hashing/statichash.hpp>
+#include <keeg/hashing/noncryptographic/stringhashkernels.hpp>
 #include <keeg/endian/conversion.hpp>
 
 namespace keeg { namespace hashing { namespace noncryptographic {
 
+/// Bob Jenkins One-at-a-Time hash as a policy for StaticHash, also used by JOAATHash32.
+struct JOAATHash32Policy
+{
+    using result_type = uint32_t;
+
+    uint32_t initial() const { return 0; }
+
+    uint32_t update(uint32_t hash, const uint8_t *data, const std::size_t &dataLength) const
+    {
+        return detail::unrolledByteHash(hash, data, dataLength, [](uint32_t h, const uint8_t &byte, bool)
+        {
+            h += byte;
+            h += (h << 10);
+            return h ^ (h >> 6);
+        });
+    }
+
+    uint32_t finalize(uint32_t hash) const
+    {
+        hash += (hash << 3);
+        hash ^= (hash >> 11);
+        hash += (hash << 15);
+        return hash;
+    }
+};
+
+using StaticJOAATHash32 = StaticHash<JOAATHash32Policy>;
+
 /// Bob Jenkins One-at-a-Time hash
-class JOAATHash32 : public HashAlgorithm
+class JOAATHash32 : public IntegerHashAlgorithm<uint32_t>
 {
 public:
     JOAATHash32();
@@ -36,21 +66,23 @@ public:
     // HashAlgorithm interface
 public:
     virtual std::size_t hashSize() override;
+    virtual std::unique_ptr<HashAlgorithm> copy() const override;
     virtual void initialize() override;
 
 protected:
     virtual void hashCore(const void *data, const std::size_t &dataLength, const std::size_t &startIndex) override;
-    virtual std::vector<uint8_t> hashFinal() override;
+    virtual uint32_t hashFinalValue() override;
 
 private:
     static const std::size_t m_hashSize = std::numeric_limits<uint32_t>::digits;
+    JOAATHash32Policy m_policy;
     uint32_t m_hash;
 
     static_assert(std::is_same<uint8_t, unsigned char>::value,
                   "uint8_t is required to be implemented as unsigned char!");
 };
 
-JOAATHash32::JOAATHash32() : HashAlgorithm()
+JOAATHash32::JOAATHash32() : IntegerHashAlgorithm<uint32_t>()
 {
     initialize();
 }
@@ -60,37 +92,25 @@ size_t JOAATHash32::hashSize()
     return m_hashSize;
 }
 
+std::unique_ptr<HashAlgorithm> JOAATHash32::copy() const
+{
+    return std::unique_ptr<HashAlgorithm>(new JOAATHash32(*this));
+}
+
 void JOAATHash32::initialize()
 {
-    m_hash = 0;
+    m_hash = m_policy.initial();
     m_hashValue.clear();
 }
 
 void JOAATHash32::hashCore(const void *data, const std::size_t &dataLength, const std::size_t &startIndex)
 {
-    const uint8_t *current = static_cast<const uint8_t*>(data) + startIndex;
-
-    for (std::size_t i = 0; i < dataLength; ++current, ++i)
-    {
-        m_hash += *current;
-        m_hash += (m_hash << 10);
-        m_hash ^= (m_hash >> 6);
-    }
+    m_hash = m_policy.update(m_hash, static_cast<const uint8_t*>(data) + startIndex, dataLength);
 }
 
-std::vector<uint8_t> JOAATHash32::hashFinal()
+uint32_t JOAATHash32::hashFinalValue()
 {
-    m_hash += (m_hash << 3);
-    m_hash ^= (m_hash >> 11);
-    m_hash += (m_hash << 15);
-
-    /// Make sure the hash is Big-Endian.
-    uint32_t data = endian::native_to_big(m_hash);
-
-    /// Convert the hash to a vector of bytes.
-    std::vector<uint8_t> v(reinterpret_cast<uint8_t*>(&data),
-                           reinterpret_cast<uint8_t*>(&data) + sizeof(uint32_t));
-    return std::move(v);
+    return m_policy.finalize(m_hash);
 }
 
 } // noncryptographic namespace
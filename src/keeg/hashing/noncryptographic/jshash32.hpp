@@ -22,13 +22,35 @@
 #ifndef JSHASH32_HPP
 #define JSHASH32_HPP
 
-#include <keeg/hashing/hashalgorithm.hpp>
+#include <keeg/hashing/integerhashalgorithm.hpp>
+#include <keeg/hashing/statichash.hpp>
+#include <keeg/hashing/noncryptographic/stringhashkernels.hpp>
 #include <keeg/endian/conversion.hpp>
 
 namespace keeg { namespace hashing { namespace noncryptographic {
 
+/// Justin Sobel's hash as a policy for StaticHash, also used by JSHash32.
+struct JSHash32Policy
+{
+    using result_type = uint32_t;
+
+    uint32_t initial() const { return UINT32_C(1315423911); }
+
+    uint32_t update(uint32_t hash, const uint8_t *data, const std::size_t &dataLength) const
+    {
+        return detail::unrolledByteHash(hash, data, dataLength, [](const uint32_t &h, const uint8_t &byte, bool)
+        {
+            return h ^ ((h << 5) + byte + (h >> 2));
+        });
+    }
+
+    uint32_t finalize(const uint32_t &hash) const { return hash; }
+};
+
+using StaticJSHash32 = StaticHash<JSHash32Policy>;
+
 /// Justin Sobel Hash
-class JSHash32 : public HashAlgorithm
+class JSHash32 : public IntegerHashAlgorithm<uint32_t>
 {
 public:
     JSHash32();
@@ -36,22 +58,23 @@ public:
     // HashAlgorithm interface
 public:
     virtual std::size_t hashSize() override;
+    virtual std::unique_ptr<HashAlgorithm> copy() const override;
     virtual void initialize() override;
 
 protected:
     virtual void hashCore(const void *data, const std::size_t &dataLength, const std::size_t &startIndex) override;
-    virtual std::vector<uint8_t> hashFinal() override;
+    virtual uint32_t hashFinalValue() override;
 
 private:
     static const std::size_t m_hashSize = std::numeric_limits<uint32_t>::digits;
-    const uint32_t m_seed = UINT32_C(1315423911);
+    JSHash32Policy m_policy;
     uint32_t m_hash;
 
     static_assert(std::is_same<uint8_t, unsigned char>::value,
                   "uint8_t is required to be implemented as unsigned char!");
 };
 
-JSHash32::JSHash32() : HashAlgorithm()
+JSHash32::JSHash32() : IntegerHashAlgorithm<uint32_t>()
 {
     initialize();
 }
@@ -61,31 +84,25 @@ size_t JSHash32::hashSize()
     return m_hashSize;
 }
 
+std::unique_ptr<HashAlgorithm> JSHash32::copy() const
+{
+    return std::unique_ptr<HashAlgorithm>(new JSHash32(*this));
+}
+
 void JSHash32::initialize()
 {
-    m_hash = m_seed;
+    m_hash = m_policy.initial();
     m_hashValue.clear();
 }
 
 void JSHash32::hashCore(const void *data, const std::size_t &dataLength, const std::size_t &startIndex)
 {
-    const uint8_t *current = static_cast<const uint8_t*>(data) + startIndex;
-
-    for (std::size_t i = 0; i < dataLength; ++current, ++i)
-    {
-        m_hash ^= ((m_hash << 5) + *current + (m_hash >> 2));
-    }
+    m_hash = m_policy.update(m_hash, static_cast<const uint8_t*>(data) + startIndex, dataLength);
 }
 
-std::vector<uint8_t> JSHash32::hashFinal()
+uint32_t JSHash32::hashFinalValue()
 {
-    /// Make sure the hash is Big-Endian.
-    uint32_t data = endian::native_to_big(m_hash);
-
-    /// Convert the hash to a vector of bytes.
-    std::vector<uint8_t> v(reinterpret_cast<uint8_t*>(&data),
-                           reinterpret_cast<uint8_t*>(&data) + sizeof(uint32_t));
-    return std::move(v);
+    return m_policy.finalize(m_hash);
 }
 
 } // noncryptographic namespace
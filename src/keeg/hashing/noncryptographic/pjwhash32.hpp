@@ -22,14 +22,44 @@
 #ifndef PJWHASH32_HPP
 #define PJWHASH32_HPP
 
-#include <keeg/hashing/hashalgorithm.hpp>
+#include <keeg/hashing/integerhashalgorithm.hpp>
+#include <keeg/hashing/statichash.hpp>
+#include <keeg/hashing/noncryptographic/stringhashkernels.hpp>
 #include <keeg/endian/conversion.hpp>
 #include <keeg/common/macrohelpers.hpp>
 
 namespace keeg { namespace hashing { namespace noncryptographic {
 
+/// Peter J. Weinberger's hash as a policy for StaticHash, also used by PJWHash32.
+struct PJWHash32Policy
+{
+    using result_type = uint32_t;
+
+    static const uint32_t BitsInUnsignedInt = UINT32CAST(std::numeric_limits<uint32_t>::digits);
+    static const uint32_t ThreeQuarters     = UINT32CAST((BitsInUnsignedInt  * 3) / 4);
+    static const uint32_t OneEighth         = UINT32CAST(BitsInUnsignedInt / 8);
+    static const uint32_t HighBits          = UINT32CONST(0xFFFFFFFF) << (BitsInUnsignedInt - OneEighth);
+
+    uint32_t initial() const { return 0; }
+
+    /// Branch free, when test is zero the xor does nothing and the high bits are already clear.
+    uint32_t update(uint32_t hash, const uint8_t *data, const std::size_t &dataLength) const
+    {
+        return detail::unrolledByteHash(hash, data, dataLength, [](uint32_t h, const uint8_t &byte, bool)
+        {
+            h = (h << OneEighth) + byte;
+            const uint32_t test = h & HighBits;
+            return (h ^ (test >> ThreeQuarters)) & (~HighBits);
+        });
+    }
+
+    uint32_t finalize(const uint32_t &hash) const { return hash; }
+};
+
+using StaticPJWHash32 = StaticHash<PJWHash32Policy>;
+
 /// Peter J. Weinberger
-class PJWHash32 : public HashAlgorithm
+class PJWHash32 : public IntegerHashAlgorithm<uint32_t>
 {
 public:
     PJWHash32();
@@ -37,26 +67,24 @@ public:
     // HashAlgorithm interface
 public:
     virtual std::size_t hashSize() override;
+    virtual std::unique_ptr<HashAlgorithm> copy() const override;
     virtual void initialize() override;
 
 protected:
     virtual void hashCore(const void *data, const std::size_t &dataLength, const std::size_t &startIndex) override;
-    virtual std::vector<uint8_t> hashFinal() override;
+    virtual uint32_t hashFinalValue() override;
 
 private:
     static const std::size_t m_hashSize = std::numeric_limits<uint32_t>::digits;
-    const uint32_t BitsInUnsignedInt = UINT32CAST(m_hashSize);
-    const uint32_t ThreeQuarters     = UINT32CAST((BitsInUnsignedInt  * 3) / 4);
-    const uint32_t OneEighth         = UINT32CAST(BitsInUnsignedInt / 8);
-    const uint32_t HighBits          = UINT32CONST(0xFFFFFFFF) << (BitsInUnsignedInt - OneEighth);
 
+    PJWHash32Policy m_policy;
     uint32_t m_hash;
 
     static_assert(std::is_same<uint8_t, unsigned char>::value,
                   "uint8_t is required to be implemented as unsigned char!");
 };
 
-PJWHash32::PJWHash32() : HashAlgorithm()
+PJWHash32::PJWHash32() : IntegerHashAlgorithm<uint32_t>()
 {
     initialize();
 }
@@ -66,37 +94,25 @@ std::size_t PJWHash32::hashSize()
     return m_hashSize;
 }
 
+std::unique_ptr<HashAlgorithm> PJWHash32::copy() const
+{
+    return std::unique_ptr<HashAlgorithm>(new PJWHash32(*this));
+}
+
 void PJWHash32::initialize()
 {
-    m_hash = 0;
+    m_hash = m_policy.initial();
     m_hashValue.clear();
 }
 
 void PJWHash32::hashCore(const void *data, const std::size_t &dataLength, const std::size_t &startIndex)
 {
-    const uint8_t *current = static_cast<const uint8_t*>(data) + startIndex;
-    uint32_t test = 0;
-
-    for(std::size_t i = 0; i < dataLength; ++current, ++i)
-    {
-        m_hash = (m_hash << OneEighth) + *current;
-
-        if((test = m_hash & HighBits) != 0)
-        {
-            m_hash = ((m_hash ^ (test >> ThreeQuarters)) & (~HighBits));
-        }
-    }
+    m_hash = m_policy.update(m_hash, static_cast<const uint8_t*>(data) + startIndex, dataLength);
 }
 
-std::vector<uint8_t> PJWHash32::hashFinal()
+uint32_t PJWHash32::hashFinalValue()
 {
-    /// Make sure the hash is Big-Endian.
-    uint32_t data = endian::native_to_big(m_hash);
-
-    /// Convert the hash to a vector of bytes.
-    std::vector<uint8_t> v(reinterpret_cast<uint8_t*>(&data),
-                           reinterpret_cast<uint8_t*>(&data) + sizeof(uint32_t));
-    return std::move(v);
+    return m_policy.finalize(m_hash);
 }
 
 } // noncryptographic namespace
@@ -22,12 +22,49 @@
 #ifndef SDBMHASH32_HPP
 #define SDBMHASH32_HPP
 
-#include <keeg/hashing/hashalgorithm.hpp>
+#include <keeg/hashing/integerhashalgorithm.hpp>
+#include <keeg/hashing/statichash.hpp>
+#include <keeg/hashing/noncryptographic/stringhashkernels.hpp>
 #include <keeg/endian/conversion.hpp>
 
 namespace keeg { namespace hashing { namespace noncryptographic {
 
-class SDBMHash32 : public HashAlgorithm
+/// SDBM hash as a policy for StaticHash, also used by SDBMHash32.
+struct SDBMHash32Policy
+{
+    using result_type = uint32_t;
+
+    constexpr uint32_t initial() const { return 0; }
+
+    /// Byte is uint8_t, or char in constant expressions.
+    template<typename Byte>
+    constexpr uint32_t update(uint32_t hash, const Byte *data, const std::size_t &dataLength) const
+    {
+        for (std::size_t i = 0; i < dataLength; ++i)
+            hash = static_cast<uint8_t>(data[i]) + (hash << 6) + (hash << 16) - hash;
+
+        return hash;
+    }
+
+    /// Runtime data, the update is hash * 65599 + byte so eight bytes go per step.
+    uint32_t update(uint32_t hash, const uint8_t *data, const std::size_t &dataLength) const
+    {
+        constexpr detail::MultiplyAddPowers powers = detail::multiplyAddPowers(65599);
+        return detail::multiplyAddHash(hash, data, dataLength, powers);
+    }
+
+    constexpr uint32_t finalize(const uint32_t &hash) const { return hash; }
+};
+
+/// SDBM of length characters of text, usable at compile time. Same value as SDBMHash32.
+constexpr uint32_t sdbmHash32(const char *text, const std::size_t &length)
+{
+    return constexprHash(SDBMHash32Policy(), text, length);
+}
+
+using StaticSDBMHash32 = StaticHash<SDBMHash32Policy>;
+
+class SDBMHash32 : public IntegerHashAlgorithm<uint32_t>
 {
 public:
     SDBMHash32();
@@ -35,21 +72,23 @@ public:
     // HashAlgorithm interface
 public:
     virtual std::size_t hashSize() override;
+    virtual std::unique_ptr<HashAlgorithm> copy() const override;
     virtual void initialize() override;
 
 protected:
     virtual void hashCore(const void *data, const std::size_t &dataLength, const std::size_t &startIndex) override;
-    virtual std::vector<uint8_t> hashFinal() override;
+    virtual uint32_t hashFinalValue() override;
 
 private:
     static const std::size_t m_hashSize = std::numeric_limits<uint32_t>::digits;
+    SDBMHash32Policy m_policy;
     uint32_t m_hash;
 
     static_assert(std::is_same<uint8_t, unsigned char>::value,
                   "uint8_t is required to be implemented as unsigned char!");
 };
 
-SDBMHash32::SDBMHash32() : HashAlgorithm()
+SDBMHash32::SDBMHash32() : IntegerHashAlgorithm<uint32_t>()
 {
     initialize();
 }
@@ -59,31 +98,25 @@ size_t SDBMHash32::hashSize()
     return m_hashSize;
 }
 
+std::unique_ptr<HashAlgorithm> SDBMHash32::copy() const
+{
+    return std::unique_ptr<HashAlgorithm>(new SDBMHash32(*this));
+}
+
 void SDBMHash32::initialize()
 {
-    m_hash = 0;
+    m_hash = m_policy.initial();
     m_hashValue.clear();
 }
 
 void SDBMHash32::hashCore(const void *data, const std::size_t &dataLength, const std::size_t &startIndex)
 {
-    const uint8_t *current = static_cast<const uint8_t*>(data) + startIndex;
-
-    for (std::size_t i = 0; i < dataLength; ++current, ++i)
-    {
-        m_hash = *current + (m_hash << 6) + (m_hash << 16) - m_hash;
-    }
+    m_hash = m_policy.update(m_hash, static_cast<const uint8_t*>(data) + startIndex, dataLength);
 }
 
-std::vector<uint8_t> SDBMHash32::hashFinal()
+uint32_t SDBMHash32::hashFinalValue()
 {
-    /// Make sure the hash is Big-Endian.
-    uint32_t data = endian::native_to_big(m_hash);
-
-    /// Convert the hash to a vector of bytes.
-    std::vector<uint8_t> v(reinterpret_cast<uint8_t*>(&data),
-                           reinterpret_cast<uint8_t*>(&data) + sizeof(uint32_t));
-    return std::move(v);
+    return m_policy.finalize(m_hash);
 }
 
 } // noncryptographic namespace
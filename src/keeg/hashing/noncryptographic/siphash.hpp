@@ -0,0 +1,377 @@
+/*
+ * Copyright (C) 2017 Larry Lopez
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to
+ * deal in the Software without restriction, including without limitation the
+ * rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+ * sell copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ */
+#ifndef SIPHASH_HPP
+#define SIPHASH_HPP
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <limits>
+#include <memory>
+#include <vector>
+#include <keeg/hashing/keyedhashalgorithm.hpp>
+#include <keeg/hashing/statichash.hpp>
+#include <keeg/endian/conversion.hpp>
+
+namespace keeg { namespace hashing { namespace noncryptographic {
+
+namespace detail {
+
+/// Rotations of a SipRound, SipHash works on 64 bit words and HalfSipHash on 32 bit.
+template<typename Word>
+struct SipRoundRotations;
+
+template<>
+struct SipRoundRotations<uint64_t>
+{
+    static const int A = 13, B = 32, C = 16, D = 21, E = 17, F = 32;
+};
+
+template<>
+struct SipRoundRotations<uint32_t>
+{
+    static const int A = 5, B = 16, C = 8, D = 7, E = 13, F = 16;
+};
+
+template<typename Word, int Bits>
+FORCE_INLINE Word sipRotate(const Word &x)
+{
+    return static_cast<Word>((x << Bits) | (x >> (std::numeric_limits<Word>::digits - Bits)));
+}
+
+template<typename Word>
+FORCE_INLINE void sipRound(Word (&v)[4])
+{
+    using R = SipRoundRotations<Word>;
+    v[0] += v[1]; v[1] = sipRotate<Word, R::A>(v[1]); v[1] ^= v[0]; v[0] = sipRotate<Word, R::B>(v[0]);
+    v[2] += v[3]; v[3] = sipRotate<Word, R::C>(v[3]); v[3] ^= v[2];
+    v[0] += v[3]; v[3] = sipRotate<Word, R::D>(v[3]); v[3] ^= v[0];
+    v[2] += v[1]; v[1] = sipRotate<Word, R::E>(v[1]); v[1] ^= v[2]; v[2] = sipRotate<Word, R::F>(v[2]);
+}
+
+template<typename Word>
+FORCE_INLINE Word sipLoad(const uint8_t *data)
+{
+    return endian::little_to_native(endian::loadUnaligned<Word>(data));
+}
+
+/// Little endian read of the last length bytes, fewer than a word.
+template<typename Word>
+FORCE_INLINE Word sipLoadPartial(const uint8_t *data, const std::size_t &length)
+{
+    uint64_t value = 0;
+    switch (length)
+    {
+    case 7: value |= static_cast<uint64_t>(data[6]) << 48; // fallthrough
+    case 6: value |= static_cast<uint64_t>(data[5]) << 40; // fallthrough
+    case 5: value |= static_cast<uint64_t>(data[4]) << 32; // fallthrough
+    case 4: value |= static_cast<uint64_t>(data[3]) << 24; // fallthrough
+    case 3: value |= static_cast<uint64_t>(data[2]) << 16; // fallthrough
+    case 2: value |= static_cast<uint64_t>(data[1]) <<  8; // fallthrough
+    case 1: value |= static_cast<uint64_t>(data[0]);
+    default: break;
+    }
+
+    return static_cast<Word>(value);
+}
+
+/// Initial state offsets, "somepseudorandomlygeneratedbytes".
+inline void sipInitialize(uint64_t (&v)[4], const uint64_t &k0, const uint64_t &k1)
+{
+    v[0] = k0 ^ UINT64_C(0x736f6d6570736575);
+    v[1] = k1 ^ UINT64_C(0x646f72616e646f6d);
+    v[2] = k0 ^ UINT64_C(0x6c7967656e657261);
+    v[3] = k1 ^ UINT64_C(0x7465646279746573);
+}
+
+inline void sipInitialize(uint32_t (&v)[4], const uint32_t &k0, const uint32_t &k1)
+{
+    v[0] = k0;
+    v[1] = k1;
+    v[2] = k0 ^ UINT32_C(0x6c796765);
+    v[3] = k1 ^ UINT32_C(0x74656462);
+}
+
+/// Result of the finalized state, 64 bits for SipHash and 32 for HalfSipHash.
+inline uint64_t sipResult(const uint64_t (&v)[4]) { return v[0] ^ v[1] ^ v[2] ^ v[3]; }
+inline uint32_t sipResult(const uint32_t (&v)[4]) { return v[1] ^ v[3]; }
+
+} // detail namespace
+
+/// SipHash-c-d with Word uint64_t, or HalfSipHash-c-d with Word uint32_t, as a policy for
+/// StaticHash; also used by SipHash. The key is two words, read little endian from
+/// 2 * sizeof(Word) key bytes. Keyed so table keys from untrusted input can't be chosen
+/// to collide, the state is carried across updates.
+template<typename Word, int CRounds, int DRounds>
+struct SipHashPolicy
+{
+    using result_type = Word;
+
+    /// Bytes of key and of each compressed block.
+    static const std::size_t KeySize = 2 * sizeof(Word);
+    static const std::size_t BlockSize = sizeof(Word);
+
+    struct State
+    {
+        Word v[4];
+        /// Bytes of a block not complete yet, in the low tailSize bytes.
+        Word tail;
+        std::size_t tailSize;
+        /// Only the low byte goes into the hash.
+        std::size_t length;
+    };
+
+    Word k0 = 0;
+    Word k1 = 0;
+
+    SipHashPolicy() = default;
+    SipHashPolicy(const Word &key0, const Word &key1) : k0(key0), k1(key1) { }
+    /// Reads KeySize key bytes.
+    explicit SipHashPolicy(const void *key) :
+        k0(detail::sipLoad<Word>(static_cast<const uint8_t*>(key))),
+        k1(detail::sipLoad<Word>(static_cast<const uint8_t*>(key) + sizeof(Word)))
+    { }
+
+    State initial() const
+    {
+        State state;
+        detail::sipInitialize(state.v, k0, k1);
+        state.tail = 0;
+        state.tailSize = 0;
+        state.length = 0;
+        return state;
+    }
+
+    State update(State state, const uint8_t *data, const std::size_t &dataLength) const
+    {
+        std::size_t i = 0;
+        state.length += dataLength;
+
+        // Finish a block started by the previous update.
+        if (state.tailSize > 0)
+        {
+            for (; i < dataLength && state.tailSize < BlockSize; ++i)
+                state.tail |= static_cast<Word>(data[i]) << (8 * state.tailSize++);
+
+            if (state.tailSize < BlockSize)
+                return state;
+
+            compress(state.v, state.tail);
+            state.tail = 0;
+            state.tailSize = 0;
+        }
+
+        for (; i + BlockSize <= dataLength; i += BlockSize)
+            compress(state.v, detail::sipLoad<Word>(data + i));
+
+        state.tailSize = dataLength - i;
+        state.tail = detail::sipLoadPartial<Word>(data + i, state.tailSize);
+        return state;
+    }
+
+    result_type finalize(State state) const
+    {
+        const int lengthShift = std::numeric_limits<Word>::digits - 8;
+        compress(state.v, state.tail | (static_cast<Word>(state.length & 0xFF) << lengthShift));
+
+        state.v[2] ^= 0xFF;
+        for (int r = 0; r < DRounds; ++r)
+            detail::sipRound(state.v);
+
+        return detail::sipResult(state.v);
+    }
+
+private:
+    static FORCE_INLINE void compress(Word (&v)[4], const Word &block)
+    {
+        v[3] ^= block;
+        for (int r = 0; r < CRounds; ++r)
+            detail::sipRound(v);
+        v[0] ^= block;
+    }
+};
+
+using SipHash24Policy = SipHashPolicy<uint64_t, 2, 4>;
+using SipHash13Policy = SipHashPolicy<uint64_t, 1, 3>;
+using HalfSipHash24Policy = SipHashPolicy<uint32_t, 2, 4>;
+
+/// Devirtualized forms for std::unordered_map, keyed through the policy:
+///   std::unordered_map<std::string, int, StaticSipHash13> table(64, StaticSipHash13(SipHash13Policy(k0, k1)));
+using StaticSipHash24 = StaticHash<SipHash24Policy>;
+using StaticSipHash13 = StaticHash<SipHash13Policy>;
+using StaticHalfSipHash24 = StaticHash<HalfSipHash24Policy>;
+
+/// SipHash by Jean-Philippe Aumasson and Daniel J. Bernstein, a keyed hash for short
+/// inputs. The key is KeySize bytes, a shorter key is zero padded and a longer one
+/// truncated. Hash bytes are the integer result, most significant byte first as
+/// IntegerHashAlgorithm.
+template<typename Word, int CRounds, int DRounds>
+class SipHash : public KeyedHashAlgorithm
+{
+public:
+    using Policy = SipHashPolicy<Word, CRounds, DRounds>;
+
+    static const std::size_t KeySize = Policy::KeySize;
+    /// Size of the hash in bytes.
+    static const std::size_t DigestSize = sizeof(Word);
+    using Digest = HashDigest<DigestSize>;
+
+    /// Keyed with zeros until setKey.
+    SipHash();
+    explicit SipHash(const std::vector<uint8_t> &key);
+
+    /// compute Hash of a memory block returning the hash as an integer, nothing is allocated.
+    Word computeHashValue(const void* data, const std::size_t &dataLength);
+    /// compute Hash of a string returning the hash as an integer, excluding final zero.
+    Word computeHashValue(const std::string &text);
+    /// Hash of everything passed to update() as an integer.
+    Word finalizeValue();
+
+    /// Policy with the current key, for a StaticHash over the same key.
+    const Policy &policy() const;
+
+    // HashAlgorithm interface
+public:
+    virtual std::size_t hashSize() override;
+    virtual std::size_t blockSize() override;
+    virtual std::unique_ptr<HashAlgorithm> copy() const override;
+    virtual void initialize() override;
+
+protected:
+    virtual void hashCore(const void *data, const std::size_t &dataLength, const std::size_t &startIndex) override;
+    virtual std::vector<uint8_t> hashFinal() override;
+    virtual void hashFinalTo(uint8_t *digest) override;
+
+    // KeyedHashAlgorithm interface
+    virtual void keyChanged() override;
+
+private:
+    Policy m_policy;
+    typename Policy::State m_state;
+};
+
+using SipHash24 = SipHash<uint64_t, 2, 4>;
+using SipHash13 = SipHash<uint64_t, 1, 3>;
+using HalfSipHash24 = SipHash<uint32_t, 2, 4>;
+
+template<typename Word, int CRounds, int DRounds>
+SipHash<Word, CRounds, DRounds>::SipHash() : KeyedHashAlgorithm()
+{
+    initialize();
+}
+
+template<typename Word, int CRounds, int DRounds>
+SipHash<Word, CRounds, DRounds>::SipHash(const std::vector<uint8_t> &key) : KeyedHashAlgorithm()
+{
+    setKey(key);
+}
+
+template<typename Word, int CRounds, int DRounds>
+Word SipHash<Word, CRounds, DRounds>::computeHashValue(const void *data, const std::size_t &dataLength)
+{
+    return m_policy.finalize(m_policy.update(m_policy.initial(), static_cast<const uint8_t*>(data), dataLength));
+}
+
+template<typename Word, int CRounds, int DRounds>
+Word SipHash<Word, CRounds, DRounds>::computeHashValue(const std::string &text)
+{
+    return computeHashValue(text.data(), text.size());
+}
+
+template<typename Word, int CRounds, int DRounds>
+Word SipHash<Word, CRounds, DRounds>::finalizeValue()
+{
+    return m_policy.finalize(m_state);
+}
+
+template<typename Word, int CRounds, int DRounds>
+const typename SipHash<Word, CRounds, DRounds>::Policy &SipHash<Word, CRounds, DRounds>::policy() const
+{
+    return m_policy;
+}
+
+template<typename Word, int CRounds, int DRounds>
+std::size_t SipHash<Word, CRounds, DRounds>::hashSize()
+{
+    return std::numeric_limits<Word>::digits;
+}
+
+template<typename Word, int CRounds, int DRounds>
+std::size_t SipHash<Word, CRounds, DRounds>::blockSize()
+{
+    return Policy::BlockSize;
+}
+
+template<typename Word, int CRounds, int DRounds>
+std::unique_ptr<HashAlgorithm> SipHash<Word, CRounds, DRounds>::copy() const
+{
+    return std::unique_ptr<HashAlgorithm>(new SipHash<Word, CRounds, DRounds>(*this));
+}
+
+template<typename Word, int CRounds, int DRounds>
+void SipHash<Word, CRounds, DRounds>::initialize()
+{
+    m_state = m_policy.initial();
+    m_hashValue.clear();
+}
+
+template<typename Word, int CRounds, int DRounds>
+void SipHash<Word, CRounds, DRounds>::hashCore(const void *data, const std::size_t &dataLength,
+                                               const std::size_t &startIndex)
+{
+    m_state = m_policy.update(m_state, static_cast<const uint8_t*>(data) + startIndex, dataLength);
+}
+
+template<typename Word, int CRounds, int DRounds>
+std::vector<uint8_t> SipHash<Word, CRounds, DRounds>::hashFinal()
+{
+    std::vector<uint8_t> v(DigestSize);
+    hashFinalTo(v.data());
+    return v;
+}
+
+template<typename Word, int CRounds, int DRounds>
+void SipHash<Word, CRounds, DRounds>::hashFinalTo(uint8_t *digest)
+{
+    // Big-Endian, most significant byte first.
+    const Word value = finalizeValue();
+    for (std::size_t i = 0; i < DigestSize; ++i)
+        digest[i] = static_cast<uint8_t>(value >> ((DigestSize - 1 - i) * 8));
+}
+
+template<typename Word, int CRounds, int DRounds>
+void SipHash<Word, CRounds, DRounds>::keyChanged()
+{
+    uint8_t key[KeySize] = {0};
+    if (!m_key.empty())
+        std::memcpy(key, m_key.data(), std::min<std::size_t>(m_key.size(), KeySize));
+    m_policy = Policy(key);
+    std::fill(std::begin(key), std::end(key), 0);
+    initialize();
+}
+
+} // noncryptographic namespace
+} // hashing namespace
+} // keeg namespace
+
+#endif // SIPHASH_HPP
@@ -0,0 +1,117 @@
+/*
+ * Copyright (C) 2017 Larry Lopez
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to
+ * deal in the Software without restriction, including without limitation the
+ * rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+ * sell copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ */
+#ifndef STRINGHASHKERNELS_HPP
+#define STRINGHASHKERNELS_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <keeg/common/macrohelpers.hpp>
+#include <keeg/endian/conversion.hpp>
+
+namespace keeg { namespace hashing { namespace noncryptographic {
+
+namespace detail {
+
+/// Eight bytes of data as a little endian word, byte i of the data in bits 8i to 8i+7.
+inline uint64_t stringHashLoad64(const uint8_t *data)
+{
+    uint64_t word;
+    std::memcpy(&word, data, sizeof(word));
+    return endian::little_to_native(word);
+}
+
+/// multiplier^0 to multiplier^8 modulo 2^32.
+struct MultiplyAddPowers
+{
+    uint32_t power[9];
+};
+
+constexpr MultiplyAddPowers multiplyAddPowers(const uint32_t &multiplier)
+{
+    MultiplyAddPowers powers{};
+    powers.power[0] = 1;
+    for (std::size_t i = 1; i < 9; ++i)
+        powers.power[i] = powers.power[i - 1] * multiplier;
+
+    return powers;
+}
+
+/// hash = hash * multiplier + byte for every byte, the multiply-add hashes (BKDR, djb2, SDBM).
+/// Eight steps expand to hash * m^8 + b0 * m^7 + ... + b7, so each word costs independent
+/// multiplies instead of a chain of eight dependent ones.
+inline uint32_t multiplyAddHash(uint32_t hash, const uint8_t *data, const std::size_t &dataLength,
+                                const MultiplyAddPowers &powers)
+{
+    const uint32_t *p = powers.power;
+
+    std::size_t i = 0;
+    for (; i + 8 <= dataLength; i += 8)
+    {
+        const uint64_t word = stringHashLoad64(data + i);
+        const uint32_t high = static_cast<uint8_t>(word      ) * p[7] + static_cast<uint8_t>(word >>  8) * p[6]
+                            + static_cast<uint8_t>(word >> 16) * p[5] + static_cast<uint8_t>(word >> 24) * p[4];
+        const uint32_t low  = static_cast<uint8_t>(word >> 32) * p[3] + static_cast<uint8_t>(word >> 40) * p[2]
+                            + static_cast<uint8_t>(word >> 48) * p[1] + static_cast<uint8_t>(word >> 56);
+        hash = hash * p[8] + high + low;
+    }
+
+    for (; i < dataLength; ++i)
+        hash = hash * p[1] + data[i];
+
+    return hash;
+}
+
+/// Runs step(hash, byte) over every byte for the hashes whose steps depend on each other.
+/// Loads eight bytes at a time and unrolls the steps, step(hash, byte, even) also gets
+/// whether the byte is at an even offset in data.
+template<typename Step>
+FORCE_INLINE uint32_t unrolledByteHash(uint32_t hash, const uint8_t *data, const std::size_t &dataLength,
+                                       const Step &step)
+{
+    std::size_t i = 0;
+    for (; i + 8 <= dataLength; i += 8)
+    {
+        const uint64_t word = stringHashLoad64(data + i);
+        hash = step(hash, static_cast<uint8_t>(word      ), true);
+        hash = step(hash, static_cast<uint8_t>(word >>  8), false);
+        hash = step(hash, static_cast<uint8_t>(word >> 16), true);
+        hash = step(hash, static_cast<uint8_t>(word >> 24), false);
+        hash = step(hash, static_cast<uint8_t>(word >> 32), true);
+        hash = step(hash, static_cast<uint8_t>(word >> 40), false);
+        hash = step(hash, static_cast<uint8_t>(word >> 48), true);
+        hash = step(hash, static_cast<uint8_t>(word >> 56), false);
+    }
+
+    for (; i < dataLength; ++i)
+        hash = step(hash, data[i], (i & 0x01) == 0);
+
+    return hash;
+}
+
+} // detail namespace
+
+} // noncryptographic namespace
+} // hashing namespace
+} // keeg namespace
+
+#endif // STRINGHASHKERNELS_HPP
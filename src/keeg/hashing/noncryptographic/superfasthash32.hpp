@@ -22,14 +22,81 @@
 #ifndef SUPERFASTHASH32_HPP
 #define SUPERFASTHASH32_HPP
 
-#include <keeg/hashing/hashalgorithm.hpp>
+#include <keeg/hashing/integerhashalgorithm.hpp>
+#include <keeg/hashing/statichash.hpp>
 #include <keeg/endian/conversion.hpp>
 #include <keeg/common/macrohelpers.hpp>
 
 namespace keeg { namespace hashing { namespace noncryptographic {
 
+/// Paul Hsieh's SuperFastHash as a policy for StaticHash, also used by SuperFastHash32.
+/// The length of the first update seeds the hash.
+struct SuperFastHash32Policy
+{
+    using result_type = uint32_t;
+
+    uint32_t initial() const { return 0; }
+
+    uint32_t update(uint32_t hash, const uint8_t *data, const std::size_t &dataLength) const
+    {
+        const uint8_t *current = data;
+        std::size_t length = dataLength;
+        uint32_t temp;
+        int32_t rem = length & 3;
+
+        if (hash == 0)
+            hash = static_cast<uint32_t>(length);
+
+        length >>= 2;
+
+        for (; length > 0; length--)
+        {
+            hash    += GET16BITS(current);
+            temp     = (GET16BITS(current+2) << 11) ^ hash;
+            hash     = (hash << 16) ^ temp;
+            current += 2 * sizeof(uint16_t);
+            hash    += hash >> 11;
+        }
+
+        // Handle end cases
+        switch (rem)
+        {
+            case 3: hash += GET16BITS(current);
+                    hash ^= hash << 16;
+                    hash ^= static_cast<int8_t>(current[sizeof(uint16_t)]) << 18;
+                    hash += hash >> 11;
+                    break;
+            case 2: hash += GET16BITS(current);
+                    hash ^= hash << 11;
+                    hash += hash >> 17;
+                    break;
+            case 1: hash += *reinterpret_cast<const int8_t*>(current);
+                    hash ^= hash << 10;
+                    hash += hash >> 1;
+        }
+
+        return hash;
+    }
+
+    uint32_t finalize(uint32_t hash) const
+    {
+        /// Force "avalanching" of final 127 bits
+        hash ^= hash << 3;
+        hash += hash >> 5;
+        hash ^= hash << 4;
+        hash += hash >> 17;
+        hash ^= hash << 25;
+        hash += hash >> 6;
+        return hash;
+    }
+};
+
+using StaticSuperFastHash32 = StaticHash<SuperFastHash32Policy>;
+
 /// Algorithm by Paul Hsieh
-class SuperFastHash32 : public HashAlgorithm
+/// The hash is seeded with the length of the first update, so a message fed to update()
+/// in several pieces hashes differently than in one piece.
+class SuperFastHash32 : public IntegerHashAlgorithm<uint32_t>
 {
 public:
     SuperFastHash32();
@@ -37,21 +104,23 @@ public:
     // HashAlgorithm interface
 public:
     virtual std::size_t hashSize() override;
+    virtual std::unique_ptr<HashAlgorithm> copy() const override;
     virtual void initialize() override;
 
 protected:
     virtual void hashCore(const void *data, const std::size_t &dataLength, const std::size_t &startIndex) override;
-    virtual std::vector<uint8_t> hashFinal() override;
+    virtual uint32_t hashFinalValue() override;
 
 private:
     static const std::size_t m_hashSize = std::numeric_limits<uint32_t>::digits;
+    SuperFastHash32Policy m_policy;
     uint32_t m_hash;
 
     static_assert(std::is_same<uint8_t, unsigned char>::value,
                   "uint8_t is required to be implemented as unsigned char!");
 };
 
-SuperFastHash32::SuperFastHash32() : HashAlgorithm()
+SuperFastHash32::SuperFastHash32() : IntegerHashAlgorithm<uint32_t>()
 {
     initialize();
 }
@@ -61,68 +130,25 @@ size_t SuperFastHash32::hashSize()
     return m_hashSize;
 }
 
+std::unique_ptr<HashAlgorithm> SuperFastHash32::copy() const
+{
+    return std::unique_ptr<HashAlgorithm>(new SuperFastHash32(*this));
+}
+
 void SuperFastHash32::initialize()
 {
-    m_hash = 0;
+    m_hash = m_policy.initial();
     m_hashValue.clear();
 }
 
 void SuperFastHash32::hashCore(const void *data, const size_t &dataLength, const size_t &startIndex)
 {
-    const uint8_t *current = static_cast<const uint8_t*>(data) + startIndex;
-    std::size_t length = dataLength;
-    uint32_t temp;
-    int32_t rem = length & 3;
-
-    if (m_hash == 0)
-        m_hash = static_cast<uint32_t>(length);
-
-    length >>= 2;
-
-    for (; length > 0; length--)
-    {
-        m_hash  += GET16BITS(current);
-        temp    = (GET16BITS(current+2) << 11) ^ m_hash;
-        m_hash  = (m_hash << 16) ^ temp;
-        current += 2 * sizeof(uint16_t);
-        m_hash  += m_hash >> 11;
-    }
-
-    // Handle end cases
-    switch (rem)
-    {
-        case 3: m_hash += GET16BITS(current);
-                m_hash ^= m_hash << 16;
-                m_hash ^= static_cast<int8_t>(current[sizeof(uint16_t)]) << 18;
-                m_hash += m_hash >> 11;
-                break;
-        case 2: m_hash += GET16BITS(current);
-                m_hash ^= m_hash << 11;
-                m_hash += m_hash >> 17;
-                break;
-        case 1: m_hash += *reinterpret_cast<const int8_t*>(current);
-                m_hash ^= m_hash << 10;
-                m_hash += m_hash >> 1;
-    }
+    m_hash = m_policy.update(m_hash, static_cast<const uint8_t*>(data) + startIndex, dataLength);
 }
 
-std::vector<uint8_t> SuperFastHash32::hashFinal()
+uint32_t SuperFastHash32::hashFinalValue()
 {
-    /// Force "avalanching" of final 127 bits
-    m_hash ^= m_hash << 3;
-    m_hash += m_hash >> 5;
-    m_hash ^= m_hash << 4;
-    m_hash += m_hash >> 17;
-    m_hash ^= m_hash << 25;
-    m_hash += m_hash >> 6;
-
-    /// Make sure the hash is Big-Endian.
-    uint32_t data = endian::native_to_big(m_hash);
-
-    /// Convert the hash to a vector of bytes.
-    std::vector<uint8_t> v(reinterpret_cast<uint8_t*>(&data),
-                           reinterpret_cast<uint8_t*>(&data) + sizeof(uint32_t));
-    return std::move(v);
+    return m_policy.finalize(m_hash);
 }
 
 } // noncryptographic namespace
@@ -0,0 +1,676 @@
+/*
+ * Copyright (C) 2017 Larry Lopez
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to
+ * deal in the Software without restriction, including without limitation the
+ * rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+ * sell copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ */
+/*
+ * XXH3 by Yann Collet, see https://github.com/Cyan4973/xxHash for the specification.
+ * Matches XXH3_64bits_withSeed and XXH3_128bits_withSeed of xxHash 0.8.
+ */
+
+#ifndef XXH3_HPP
+#define XXH3_HPP
+
+#include <keeg/hashing/integerhashalgorithm.hpp>
+#include <keeg/hashing/noncryptographic/xxh3accelerated.hpp>
+#include <keeg/endian/conversion.hpp>
+#include <algorithm>
+#include <cstring>
+
+namespace keeg { namespace hashing { namespace noncryptographic {
+
+/// 128 bit XXH3 hash, canonical byte order is high64 then low64, each big endian.
+struct Xxh3Value128
+{
+    uint64_t low64;
+    uint64_t high64;
+
+    bool operator==(const Xxh3Value128 &other) const { return low64 == other.low64 && high64 == other.high64; }
+    bool operator!=(const Xxh3Value128 &other) const { return !(*this == other); }
+};
+
+namespace detail {
+
+/// 64 x 64 -> 128 bit product.
+inline Xxh3Value128 xxh3Multiply64To128(const uint64_t &lhs, const uint64_t &rhs)
+{
+#if defined(__SIZEOF_INT128__)
+    const unsigned __int128 product = static_cast<unsigned __int128>(lhs) * rhs;
+    return Xxh3Value128{ static_cast<uint64_t>(product), static_cast<uint64_t>(product >> 64) };
+#elif defined(_MSC_VER) && defined(_M_X64)
+    Xxh3Value128 result;
+    result.low64 = _umul128(lhs, rhs, &result.high64);
+    return result;
+#else
+    const uint64_t loLo = (lhs & 0xFFFFFFFF) * (rhs & 0xFFFFFFFF);
+    const uint64_t hiLo = (lhs >> 32) * (rhs & 0xFFFFFFFF);
+    const uint64_t loHi = (lhs & 0xFFFFFFFF) * (rhs >> 32);
+    const uint64_t hiHi = (lhs >> 32) * (rhs >> 32);
+    const uint64_t cross = (loLo >> 32) + (hiLo & 0xFFFFFFFF) + loHi;
+    return Xxh3Value128{ (cross << 32) | (loLo & 0xFFFFFFFF), (hiLo >> 32) + (cross >> 32) + hiHi };
+#endif
+}
+
+inline uint64_t xxh3Multiply128Fold64(const uint64_t &lhs, const uint64_t &rhs)
+{
+    const Xxh3Value128 product = xxh3Multiply64To128(lhs, rhs);
+    return product.low64 ^ product.high64;
+}
+
+inline uint64_t xxh64Avalanche(uint64_t hash)
+{
+    hash ^= hash >> 33;
+    hash *= Xxh3Prime64_2;
+    hash ^= hash >> 29;
+    hash *= Xxh3Prime64_3;
+    return hash ^ (hash >> 32);
+}
+
+/// rotate left and wrap around to the right
+#ifndef rotateLeft
+    #define rotateLeft(x,y) keeg::endian::rotateLeft((x),(y))
+#endif
+
+inline uint64_t xxh3Avalanche(uint64_t hash)
+{
+    hash ^= hash >> 37;
+    hash *= Xxh3PrimeMx1;
+    return hash ^ (hash >> 32);
+}
+
+/// Stronger avalanche for the 4 to 8 byte inputs, which only get one multiply otherwise.
+inline uint64_t xxh3Rrmxmx(uint64_t hash, const uint64_t &length)
+{
+    hash ^= rotateLeft(hash, 49) ^ rotateLeft(hash, 24);
+    hash *= Xxh3PrimeMx2;
+    hash ^= (hash >> 35) + length;
+    hash *= Xxh3PrimeMx2;
+    return hash ^ (hash >> 28);
+}
+
+inline uint64_t xxh3Mix16(const uint8_t *input, const uint8_t *secret, const uint64_t &seed)
+{
+    return xxh3Multiply128Fold64(xxh3Read64(input)     ^ (xxh3Read64(secret)     + seed),
+                                 xxh3Read64(input + 8) ^ (xxh3Read64(secret + 8) - seed));
+}
+
+/// 32 bytes into both halves of a 128 bit accumulator.
+inline void xxh3Mix32(Xxh3Value128 &acc, const uint8_t *input1, const uint8_t *input2,
+                      const uint8_t *secret, const uint64_t &seed)
+{
+    acc.low64  += xxh3Mix16(input1, secret, seed);
+    acc.low64  ^= xxh3Read64(input2) + xxh3Read64(input2 + 8);
+    acc.high64 += xxh3Mix16(input2, secret + 16, seed);
+    acc.high64 ^= xxh3Read64(input1) + xxh3Read64(input1 + 8);
+}
+
+/// Inputs of at most 240 bytes, each size range with its own path.
+inline uint64_t xxh3Hash64Short(const uint8_t *input, const std::size_t &length, const uint8_t *secret, uint64_t seed)
+{
+    if (length == 0)
+        return xxh64Avalanche(seed ^ xxh3Read64(secret + 56) ^ xxh3Read64(secret + 64));
+
+    if (length <= 3)
+    {
+        const uint32_t combined = (static_cast<uint32_t>(input[0]) << 16) | (static_cast<uint32_t>(input[length >> 1]) << 24) |
+                                  static_cast<uint32_t>(input[length - 1]) | (static_cast<uint32_t>(length) << 8);
+        const uint64_t bitflip = (xxh3Read32(secret) ^ xxh3Read32(secret + 4)) + seed;
+        return xxh64Avalanche(combined ^ bitflip);
+    }
+
+    if (length <= 8)
+    {
+        seed ^= static_cast<uint64_t>(endian::swap(static_cast<uint32_t>(seed))) << 32;
+        const uint64_t input64 = xxh3Read32(input + length - 4) + (static_cast<uint64_t>(xxh3Read32(input)) << 32);
+        const uint64_t bitflip = (xxh3Read64(secret + 8) ^ xxh3Read64(secret + 16)) - seed;
+        return xxh3Rrmxmx(input64 ^ bitflip, length);
+    }
+
+    if (length <= 16)
+    {
+        const uint64_t low  = xxh3Read64(input) ^ ((xxh3Read64(secret + 24) ^ xxh3Read64(secret + 32)) + seed);
+        const uint64_t high = xxh3Read64(input + length - 8) ^ ((xxh3Read64(secret + 40) ^ xxh3Read64(secret + 48)) - seed);
+        return xxh3Avalanche(length + endian::swap(low) + high + xxh3Multiply128Fold64(low, high));
+    }
+
+    uint64_t acc = length * Xxh3Prime64_1;
+    if (length <= 128)
+    {
+        if (length > 32)
+        {
+            if (length > 64)
+            {
+                if (length > 96)
+                {
+                    acc += xxh3Mix16(input + 48, secret + 96, seed);
+                    acc += xxh3Mix16(input + length - 64, secret + 112, seed);
+                }
+                acc += xxh3Mix16(input + 32, secret + 64, seed);
+                acc += xxh3Mix16(input + length - 48, secret + 80, seed);
+            }
+            acc += xxh3Mix16(input + 16, secret + 32, seed);
+            acc += xxh3Mix16(input + length - 32, secret + 48, seed);
+        }
+        acc += xxh3Mix16(input, secret, seed);
+        acc += xxh3Mix16(input + length - 16, secret + 16, seed);
+        return xxh3Avalanche(acc);
+    }
+
+    // 129 to 240 bytes, the secret restarts after 128 input bytes at a 3 byte offset.
+    const std::size_t rounds = length / 16;
+    for (std::size_t i = 0; i < 8; ++i)
+        acc += xxh3Mix16(input + 16 * i, secret + 16 * i, seed);
+    acc = xxh3Avalanche(acc);
+    for (std::size_t i = 8; i < rounds; ++i)
+        acc += xxh3Mix16(input + 16 * i, secret + 16 * (i - 8) + 3, seed);
+    acc += xxh3Mix16(input + length - 16, secret + Xxh3SecretSizeMin - 17, seed);
+    return xxh3Avalanche(acc);
+}
+
+inline Xxh3Value128 xxh3Hash128Short(const uint8_t *input, const std::size_t &length, const uint8_t *secret, uint64_t seed)
+{
+    if (length == 0)
+    {
+        return Xxh3Value128{ xxh64Avalanche(seed ^ xxh3Read64(secret + 64) ^ xxh3Read64(secret + 72)),
+                             xxh64Avalanche(seed ^ xxh3Read64(secret + 80) ^ xxh3Read64(secret + 88)) };
+    }
+
+    if (length <= 3)
+    {
+        const uint32_t combinedLow = (static_cast<uint32_t>(input[0]) << 16) | (static_cast<uint32_t>(input[length >> 1]) << 24) |
+                                     static_cast<uint32_t>(input[length - 1]) | (static_cast<uint32_t>(length) << 8);
+        const uint32_t combinedHigh = rotateLeft(endian::swap(combinedLow), 13);
+        const uint64_t bitflipLow  = (xxh3Read32(secret) ^ xxh3Read32(secret + 4)) + seed;
+        const uint64_t bitflipHigh = (xxh3Read32(secret + 8) ^ xxh3Read32(secret + 12)) - seed;
+        return Xxh3Value128{ xxh64Avalanche(combinedLow ^ bitflipLow), xxh64Avalanche(combinedHigh ^ bitflipHigh) };
+    }
+
+    if (length <= 8)
+    {
+        seed ^= static_cast<uint64_t>(endian::swap(static_cast<uint32_t>(seed))) << 32;
+        const uint64_t input64 = xxh3Read32(input) + (static_cast<uint64_t>(xxh3Read32(input + length - 4)) << 32);
+        const uint64_t bitflip = (xxh3Read64(secret + 16) ^ xxh3Read64(secret + 24)) + seed;
+        Xxh3Value128 product = xxh3Multiply64To128(input64 ^ bitflip, Xxh3Prime64_1 + (length << 2));
+        product.high64 += product.low64 << 1;
+        product.low64  ^= product.high64 >> 3;
+        product.low64  ^= product.low64 >> 35;
+        product.low64  *= Xxh3PrimeMx2;
+        product.low64  ^= product.low64 >> 28;
+        product.high64  = xxh3Avalanche(product.high64);
+        return product;
+    }
+
+    if (length <= 16)
+    {
+        const uint64_t bitflipLow  = (xxh3Read64(secret + 32) ^ xxh3Read64(secret + 40)) - seed;
+        const uint64_t bitflipHigh = (xxh3Read64(secret + 48) ^ xxh3Read64(secret + 56)) + seed;
+        const uint64_t inputLow = xxh3Read64(input);
+        uint64_t inputHigh = xxh3Read64(input + length - 8);
+        Xxh3Value128 product = xxh3Multiply64To128(inputLow ^ inputHigh ^ bitflipLow, Xxh3Prime64_1);
+        product.low64 += static_cast<uint64_t>(length - 1) << 54;
+        inputHigh ^= bitflipHigh;
+        product.high64 += inputHigh + (inputHigh & 0xFFFFFFFF) * (Xxh3Prime32_2 - 1);
+        product.low64 ^= endian::swap(product.high64);
+        Xxh3Value128 hash = xxh3Multiply64To128(product.low64, Xxh3Prime64_2);
+        hash.high64 += product.high64 * Xxh3Prime64_2;
+        return Xxh3Value128{ xxh3Avalanche(hash.low64), xxh3Avalanche(hash.high64) };
+    }
+
+    Xxh3Value128 acc{ length * Xxh3Prime64_1, 0 };
+    if (length <= 128)
+    {
+        if (length > 32)
+        {
+            if (length > 64)
+            {
+                if (length > 96)
+                    xxh3Mix32(acc, input + 48, input + length - 64, secret + 96, seed);
+                xxh3Mix32(acc, input + 32, input + length - 48, secret + 64, seed);
+            }
+            xxh3Mix32(acc, input + 16, input + length - 32, secret + 32, seed);
+        }
+        xxh3Mix32(acc, input, input + length - 16, secret, seed);
+    }
+    else
+    {
+        const std::size_t rounds = length / 32;
+        for (std::size_t i = 0; i < 4; ++i)
+            xxh3Mix32(acc, input + 32 * i, input + 32 * i + 16, secret + 32 * i, seed);
+        acc.low64  = xxh3Avalanche(acc.low64);
+        acc.high64 = xxh3Avalanche(acc.high64);
+        for (std::size_t i = 4; i < rounds; ++i)
+            xxh3Mix32(acc, input + 32 * i, input + 32 * i + 16, secret + 32 * (i - 4) + 3, seed);
+        xxh3Mix32(acc, input + length - 16, input + length - 32, secret + Xxh3SecretSizeMin - 17 - 16, 0 - seed);
+    }
+
+    const uint64_t low  = acc.low64 + acc.high64;
+    const uint64_t high = (acc.low64 * Xxh3Prime64_1) + (acc.high64 * Xxh3Prime64_4) + ((length - seed) * Xxh3Prime64_2);
+    return Xxh3Value128{ xxh3Avalanche(low), 0 - xxh3Avalanche(high) };
+}
+
+/// Secret of a seeded long hash, the default one with the seed added and subtracted alternately.
+inline void xxh3InitSecret(uint8_t *secret, const uint64_t &seed)
+{
+    for (std::size_t i = 0; i < Xxh3SecretSize; i += 16)
+    {
+        xxh3Write64(secret + i,     xxh3Read64(Xxh3DefaultSecret + i)     + seed);
+        xxh3Write64(secret + i + 8, xxh3Read64(Xxh3DefaultSecret + i + 8) - seed);
+    }
+}
+
+inline void xxh3InitAccumulators(uint64_t *acc)
+{
+    acc[0] = Xxh3Prime32_3; acc[1] = Xxh3Prime64_1; acc[2] = Xxh3Prime64_2; acc[3] = Xxh3Prime64_3;
+    acc[4] = Xxh3Prime64_4; acc[5] = Xxh3Prime32_2; acc[6] = Xxh3Prime64_5; acc[7] = Xxh3Prime32_1;
+}
+
+/// Offsets into the secret of the last stripe and of the final merge.
+const std::size_t Xxh3LastStripeSecretOffset = Xxh3SecretSize - Xxh3StripeLength - 7;
+const std::size_t Xxh3MergeSecretOffset = 11;
+
+/// Main loop over inputs longer than 240 bytes.
+inline void xxh3HashLongLoop(uint64_t *acc, const uint8_t *input, const std::size_t &length, const uint8_t *secret)
+{
+    const Xxh3Kernels &kernels = xxh3Kernels();
+    const std::size_t blocks = (length - 1) / Xxh3BlockLength;
+    for (std::size_t n = 0; n < blocks; ++n)
+    {
+        kernels.accumulate(acc, input + n * Xxh3BlockLength, secret, Xxh3StripesPerBlock);
+        kernels.scramble(acc, secret + Xxh3SecretSize - Xxh3StripeLength);
+    }
+
+    // Partial last block, and the last stripe even if it overlaps what was already consumed.
+    const std::size_t stripes = ((length - 1) - Xxh3BlockLength * blocks) / Xxh3StripeLength;
+    kernels.accumulate(acc, input + blocks * Xxh3BlockLength, secret, stripes);
+    kernels.accumulate(acc, input + length - Xxh3StripeLength, secret + Xxh3LastStripeSecretOffset, 1);
+}
+
+inline uint64_t xxh3MergeAccumulators(const uint64_t *acc, const uint8_t *secret, uint64_t start)
+{
+    for (std::size_t i = 0; i < 4; ++i)
+        start += xxh3Multiply128Fold64(acc[2 * i] ^ xxh3Read64(secret + 16 * i), acc[2 * i + 1] ^ xxh3Read64(secret + 16 * i + 8));
+
+    return xxh3Avalanche(start);
+}
+
+inline uint64_t xxh3Merge64(const uint64_t *acc, const uint8_t *secret, const uint64_t &length)
+{
+    return xxh3MergeAccumulators(acc, secret + Xxh3MergeSecretOffset, length * Xxh3Prime64_1);
+}
+
+inline Xxh3Value128 xxh3Merge128(const uint64_t *acc, const uint8_t *secret, const uint64_t &length)
+{
+    return Xxh3Value128{ xxh3MergeAccumulators(acc, secret + Xxh3MergeSecretOffset, length * Xxh3Prime64_1),
+                         xxh3MergeAccumulators(acc, secret + Xxh3SecretSize - Xxh3StripeLength - Xxh3MergeSecretOffset,
+                                               ~(length * Xxh3Prime64_2)) };
+}
+
+/// Streaming state shared by Xxh3Hash64 and Xxh3Hash128. Input is buffered 256 bytes at a
+/// time so the final stripe can always be found, as the one shot functions expect.
+class Xxh3State
+{
+public:
+    explicit Xxh3State(const uint64_t &seed = 0);
+
+    void reset();
+    void update(const uint8_t *input, std::size_t length);
+    uint64_t digest64() const;
+    Xxh3Value128 digest128() const;
+
+private:
+    static const std::size_t BufferSize = 256;
+    static const std::size_t BufferStripes = BufferSize / Xxh3StripeLength;
+
+    // Not over-aligned, C++14 new can't honour it and the hash classes are heap allocated.
+    // The kernels only use unaligned loads.
+    uint64_t m_acc[Xxh3AccumulatorCount];
+    uint8_t m_secret[Xxh3SecretSize];
+    uint8_t m_buffer[BufferSize];
+    std::size_t m_bufferSize;
+    std::size_t m_stripesSoFar;
+    uint64_t m_totalLength;
+    uint64_t m_seed;
+
+    /// Accumulates stripes, scrambling whenever a block of the secret is used up.
+    void consumeStripes(uint64_t *acc, std::size_t &stripesSoFar, const uint8_t *input, std::size_t stripes) const;
+    /// Accumulators including the buffered tail, without changing the state.
+    void finalAccumulators(uint64_t *acc) const;
+};
+
+Xxh3State::Xxh3State(const uint64_t &seed) : m_seed(seed)
+{
+    if (m_seed == 0)
+        std::memcpy(m_secret, Xxh3DefaultSecret, Xxh3SecretSize);
+    else
+        xxh3InitSecret(m_secret, m_seed);
+
+    reset();
+}
+
+void Xxh3State::reset()
+{
+    xxh3InitAccumulators(m_acc);
+    m_bufferSize = 0;
+    m_stripesSoFar = 0;
+    m_totalLength = 0;
+}
+
+void Xxh3State::update(const uint8_t *input, std::size_t length)
+{
+    m_totalLength += length;
+    if (m_bufferSize + length <= BufferSize)
+    {
+        std::memcpy(m_buffer + m_bufferSize, input, length);
+        m_bufferSize += length;
+        return;
+    }
+
+    // More than the buffer holds, so there will be input left after consuming it.
+    if (m_bufferSize > 0)
+    {
+        const std::size_t fill = BufferSize - m_bufferSize;
+        std::memcpy(m_buffer + m_bufferSize, input, fill);
+        input += fill;
+        length -= fill;
+        consumeStripes(m_acc, m_stripesSoFar, m_buffer, BufferStripes);
+        m_bufferSize = 0;
+    }
+
+    if (length > BufferSize)
+    {
+        do
+        {
+            consumeStripes(m_acc, m_stripesSoFar, input, BufferStripes);
+            input += BufferSize;
+            length -= BufferSize;
+        } while (length > BufferSize);
+
+        // Keep the stripe before the tail, the digest needs it if fewer than 64 bytes follow.
+        std::memcpy(m_buffer + BufferSize - Xxh3StripeLength, input - Xxh3StripeLength, Xxh3StripeLength);
+    }
+
+    std::memcpy(m_buffer, input, length);
+    m_bufferSize = length;
+}
+
+uint64_t Xxh3State::digest64() const
+{
+    if (m_totalLength <= 240)
+        return xxh3Hash64Short(m_buffer, static_cast<std::size_t>(m_totalLength), Xxh3DefaultSecret, m_seed);
+
+    alignas(64) uint64_t acc[Xxh3AccumulatorCount];
+    finalAccumulators(acc);
+    return xxh3Merge64(acc, m_secret, m_totalLength);
+}
+
+Xxh3Value128 Xxh3State::digest128() const
+{
+    if (m_totalLength <= 240)
+        return xxh3Hash128Short(m_buffer, static_cast<std::size_t>(m_totalLength), Xxh3DefaultSecret, m_seed);
+
+    alignas(64) uint64_t acc[Xxh3AccumulatorCount];
+    finalAccumulators(acc);
+    return xxh3Merge128(acc, m_secret, m_totalLength);
+}
+
+void Xxh3State::consumeStripes(uint64_t *acc, std::size_t &stripesSoFar, const uint8_t *input, std::size_t stripes) const
+{
+    const Xxh3Kernels &kernels = xxh3Kernels();
+    if (Xxh3StripesPerBlock - stripesSoFar <= stripes)
+    {
+        const std::size_t toBlockEnd = Xxh3StripesPerBlock - stripesSoFar;
+        kernels.accumulate(acc, input, m_secret + stripesSoFar * Xxh3SecretConsumeRate, toBlockEnd);
+        kernels.scramble(acc, m_secret + Xxh3SecretSize - Xxh3StripeLength);
+        kernels.accumulate(acc, input + toBlockEnd * Xxh3StripeLength, m_secret, stripes - toBlockEnd);
+        stripesSoFar = stripes - toBlockEnd;
+    }
+    else
+    {
+        kernels.accumulate(acc, input, m_secret + stripesSoFar * Xxh3SecretConsumeRate, stripes);
+        stripesSoFar += stripes;
+    }
+}
+
+void Xxh3State::finalAccumulators(uint64_t *acc) const
+{
+    std::memcpy(acc, m_acc, sizeof(m_acc));
+    const Xxh3Kernels &kernels = xxh3Kernels();
+
+    if (m_bufferSize >= Xxh3StripeLength)
+    {
+        std::size_t stripesSoFar = m_stripesSoFar;
+        consumeStripes(acc, stripesSoFar, m_buffer, (m_bufferSize - 1) / Xxh3StripeLength);
+        kernels.accumulate(acc, m_buffer + m_bufferSize - Xxh3StripeLength, m_secret + Xxh3LastStripeSecretOffset, 1);
+    }
+    else
+    {
+        // The last stripe reaches back into the previous buffer contents.
+        uint8_t lastStripe[Xxh3StripeLength];
+        const std::size_t catchUp = Xxh3StripeLength - m_bufferSize;
+        std::memcpy(lastStripe, m_buffer + BufferSize - catchUp, catchUp);
+        std::memcpy(lastStripe + catchUp, m_buffer, m_bufferSize);
+        kernels.accumulate(acc, lastStripe, m_secret + Xxh3LastStripeSecretOffset, 1);
+    }
+}
+
+/// One shot long hashes, the seeded ones derive their secret on the stack.
+inline uint64_t xxh3Hash64Long(const uint8_t *input, const std::size_t &length, const uint64_t &seed)
+{
+    alignas(64) uint64_t acc[Xxh3AccumulatorCount];
+    alignas(64) uint8_t secret[Xxh3SecretSize];
+    const uint8_t *activeSecret = Xxh3DefaultSecret;
+    if (seed != 0)
+    {
+        xxh3InitSecret(secret, seed);
+        activeSecret = secret;
+    }
+
+    xxh3InitAccumulators(acc);
+    xxh3HashLongLoop(acc, input, length, activeSecret);
+    return xxh3Merge64(acc, activeSecret, length);
+}
+
+inline Xxh3Value128 xxh3Hash128Long(const uint8_t *input, const std::size_t &length, const uint64_t &seed)
+{
+    alignas(64) uint64_t acc[Xxh3AccumulatorCount];
+    alignas(64) uint8_t secret[Xxh3SecretSize];
+    const uint8_t *activeSecret = Xxh3DefaultSecret;
+    if (seed != 0)
+    {
+        xxh3InitSecret(secret, seed);
+        activeSecret = secret;
+    }
+
+    xxh3InitAccumulators(acc);
+    xxh3HashLongLoop(acc, input, length, activeSecret);
+    return xxh3Merge128(acc, activeSecret, length);
+}
+
+} // detail namespace
+
+/// XXH3 64 bit hash of a memory block, for hot loops that don't need the HashAlgorithm interface.
+inline uint64_t xxh3Hash64(const void *data, const std::size_t &dataLength, const uint64_t &seed = 0)
+{
+    const uint8_t *input = static_cast<const uint8_t*>(data);
+    if (dataLength <= 240)
+        return detail::xxh3Hash64Short(input, dataLength, detail::Xxh3DefaultSecret, seed);
+
+    return detail::xxh3Hash64Long(input, dataLength, seed);
+}
+
+/// XXH3 128 bit hash of a memory block.
+inline Xxh3Value128 xxh3Hash128(const void *data, const std::size_t &dataLength, const uint64_t &seed = 0)
+{
+    const uint8_t *input = static_cast<const uint8_t*>(data);
+    if (dataLength <= 240)
+        return detail::xxh3Hash128Short(input, dataLength, detail::Xxh3DefaultSecret, seed);
+
+    return detail::xxh3Hash128Long(input, dataLength, seed);
+}
+
+/// Implementation of the long input loop used on this cpu.
+inline Xxh3Backend xxh3Backend()
+{
+    return detail::xxh3Backend();
+}
+
+/// XXH3 64 bit as a streaming HashAlgorithm.
+class Xxh3Hash64 : public IntegerHashAlgorithm<uint64_t>
+{
+public:
+    Xxh3Hash64(const uint64_t &seed = 0);
+
+    // HashAlgorithm interface
+public:
+    virtual std::size_t hashSize() override;
+    virtual std::unique_ptr<HashAlgorithm> copy() const override;
+    virtual void initialize() override;
+
+protected:
+    virtual void hashCore(const void *data, const std::size_t &dataLength, const std::size_t &startIndex) override;
+    virtual uint64_t hashFinalValue() override;
+
+private:
+    static const std::size_t m_hashSize = std::numeric_limits<uint64_t>::digits;
+    detail::Xxh3State m_state;
+};
+
+Xxh3Hash64::Xxh3Hash64(const uint64_t &seed) : IntegerHashAlgorithm<uint64_t>(), m_state(seed)
+{
+    initialize();
+}
+
+std::size_t Xxh3Hash64::hashSize()
+{
+    return m_hashSize;
+}
+
+std::unique_ptr<HashAlgorithm> Xxh3Hash64::copy() const
+{
+    return std::unique_ptr<HashAlgorithm>(new Xxh3Hash64(*this));
+}
+
+void Xxh3Hash64::initialize()
+{
+    m_state.reset();
+    m_hashValue.clear();
+}
+
+void Xxh3Hash64::hashCore(const void *data, const std::size_t &dataLength, const std::size_t &startIndex)
+{
+    m_state.update(static_cast<const uint8_t*>(data) + startIndex, dataLength);
+}
+
+uint64_t Xxh3Hash64::hashFinalValue()
+{
+    return m_state.digest64();
+}
+
+/// XXH3 128 bit as a streaming HashAlgorithm, the hash bytes are in canonical order.
+class Xxh3Hash128 : public HashAlgorithm
+{
+public:
+    /// Size of the hash in bytes.
+    static const std::size_t DigestSize = 16;
+    using Digest = HashDigest<DigestSize>;
+
+    Xxh3Hash128(const uint64_t &seed = 0);
+
+    /// compute Hash of a memory block returning both halves.
+    Xxh3Value128 computeHashValue(const void *data, const std::size_t &dataLength);
+    /// compute Hash of a string returning both halves, excluding final zero.
+    Xxh3Value128 computeHashValue(const std::string &text);
+
+    // HashAlgorithm interface
+public:
+    virtual std::size_t hashSize() override;
+    virtual std::unique_ptr<HashAlgorithm> copy() const override;
+    virtual void initialize() override;
+
+protected:
+    virtual void hashCore(const void *data, const std::size_t &dataLength, const std::size_t &startIndex) override;
+    virtual std::vector<uint8_t> hashFinal() override;
+    virtual void hashFinalTo(uint8_t *digest) override;
+
+private:
+    static const std::size_t m_hashSize = std::numeric_limits<uint8_t>::digits * DigestSize;
+    detail::Xxh3State m_state;
+};
+
+Xxh3Hash128::Xxh3Hash128(const uint64_t &seed) : HashAlgorithm(), m_state(seed)
+{
+    initialize();
+}
+
+Xxh3Value128 Xxh3Hash128::computeHashValue(const void *data, const std::size_t &dataLength)
+{
+    initialize();
+    runHashCore(data, dataLength, 0);
+    KEEG_INSTRUMENT_HASH_FINAL(typeid(*this));
+    return m_state.digest128();
+}
+
+Xxh3Value128 Xxh3Hash128::computeHashValue(const std::string &text)
+{
+    return computeHashValue(text.data(), text.size());
+}
+
+std::size_t Xxh3Hash128::hashSize()
+{
+    return m_hashSize;
+}
+
+std::unique_ptr<HashAlgorithm> Xxh3Hash128::copy() const
+{
+    return std::unique_ptr<HashAlgorithm>(new Xxh3Hash128(*this));
+}
+
+void Xxh3Hash128::initialize()
+{
+    m_state.reset();
+    m_hashValue.clear();
+}
+
+void Xxh3Hash128::hashCore(const void *data, const std::size_t &dataLength, const std::size_t &startIndex)
+{
+    m_state.update(static_cast<const uint8_t*>(data) + startIndex, dataLength);
+}
+
+std::vector<uint8_t> Xxh3Hash128::hashFinal()
+{
+    std::vector<uint8_t> v(DigestSize);
+    hashFinalTo(v.data());
+    return v;
+}
+
+void Xxh3Hash128::hashFinalTo(uint8_t *digest)
+{
+    const Xxh3Value128 value = m_state.digest128();
+    for (std::size_t i = 0; i < 8; ++i)
+    {
+        digest[i]     = static_cast<uint8_t>(value.high64 >> ((7 - i) * 8));
+        digest[i + 8] = static_cast<uint8_t>(value.low64  >> ((7 - i) * 8));
+    }
+}
+
+} // noncryptographic namespace
+} // hashing namespace
+} // keeg namespace
+
+#endif // XXH3_HPP
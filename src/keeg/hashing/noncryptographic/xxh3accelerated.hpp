@@ -0,0 +1,390 @@
+/*
+ * Copyright (C) 2017 Larry Lopez
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to
+ * deal in the Software without restriction, including without limitation the
+ * rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+ * sell copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ */
+/*
+ * XXH3 by Yann Collet, see https://github.com/Cyan4973/xxHash for the specification.
+ * The accumulate and scramble kernels follow the reference implementation's vector paths.
+ */
+
+#ifndef XXH3ACCELERATED_HPP
+#define XXH3ACCELERATED_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <keeg/common/backendregistry.hpp>
+#include <keeg/common/cpufeatures.hpp>
+#include <keeg/common/macrohelpers.hpp>
+#include <keeg/endian/conversion.hpp>
+
+namespace keeg { namespace hashing { namespace noncryptographic {
+
+/// Implementation of the XXH3 long input loop.
+enum class Xxh3Backend
+{
+    Scalar,     ///< portable C++
+    Sse2,       ///< two accumulators per SSE2 register
+    Avx2,       ///< four accumulators per AVX2 register
+    Avx512,     ///< all eight accumulators in one AVX-512 register
+    Neon        ///< two accumulators per NEON register
+};
+
+namespace detail {
+
+const uint32_t Xxh3Prime32_1 = UINT32_C(0x9E3779B1);
+const uint32_t Xxh3Prime32_2 = UINT32_C(0x85EBCA77);
+const uint32_t Xxh3Prime32_3 = UINT32_C(0xC2B2AE3D);
+const uint64_t Xxh3Prime64_1 = UINT64_C(0x9E3779B185EBCA87);
+const uint64_t Xxh3Prime64_2 = UINT64_C(0xC2B2AE3D27D4EB4F);
+const uint64_t Xxh3Prime64_3 = UINT64_C(0x165667B19E3779F9);
+const uint64_t Xxh3Prime64_4 = UINT64_C(0x85EBCA77C2B2AE63);
+const uint64_t Xxh3Prime64_5 = UINT64_C(0x27D4EB2F165667C5);
+const uint64_t Xxh3PrimeMx1  = UINT64_C(0x165667919E3779F9);
+const uint64_t Xxh3PrimeMx2  = UINT64_C(0x9FB21C651E98DF25);
+
+/// Bytes consumed per accumulate step, and 8 accumulators of 64 bits.
+const std::size_t Xxh3StripeLength = 64;
+const std::size_t Xxh3AccumulatorCount = 8;
+/// The secret advances this many bytes per stripe.
+const std::size_t Xxh3SecretConsumeRate = 8;
+const std::size_t Xxh3SecretSize = 192;
+/// Smallest secret the specification allows, the mid size path is defined against it.
+const std::size_t Xxh3SecretSizeMin = 136;
+const std::size_t Xxh3StripesPerBlock = (Xxh3SecretSize - Xxh3StripeLength) / Xxh3SecretConsumeRate;
+const std::size_t Xxh3BlockLength = Xxh3StripeLength * Xxh3StripesPerBlock;
+
+/// Default secret of the specification.
+alignas(64) const uint8_t Xxh3DefaultSecret[Xxh3SecretSize] =
+{
+    0xb8, 0xfe, 0x6c, 0x39, 0x23, 0xa4, 0x4b, 0xbe, 0x7c, 0x01, 0x81, 0x2c, 0xf7, 0x21, 0xad, 0x1c,
+    0xde, 0xd4, 0x6d, 0xe9, 0x83, 0x90, 0x97, 0xdb, 0x72, 0x40, 0xa4, 0xa4, 0xb7, 0xb3, 0x67, 0x1f,
+    0xcb, 0x79, 0xe6, 0x4e, 0xcc, 0xc0, 0xe5, 0x78, 0x82, 0x5a, 0xd0, 0x7d, 0xcc, 0xff, 0x72, 0x21,
+    0xb8, 0x08, 0x46, 0x74, 0xf7, 0x43, 0x24, 0x8e, 0xe0, 0x35, 0x90, 0xe6, 0x81, 0x3a, 0x26, 0x4c,
+    0x3c, 0x28, 0x52, 0xbb, 0x91, 0xc3, 0x00, 0xcb, 0x88, 0xd0, 0x65, 0x8b, 0x1b, 0x53, 0x2e, 0xa3,
+    0x71, 0x64, 0x48, 0x97, 0xa2, 0x0d, 0xf9, 0x4e, 0x38, 0x19, 0xef, 0x46, 0xa9, 0xde, 0xac, 0xd8,
+    0xa8, 0xfa, 0x76, 0x3f, 0xe3, 0x9c, 0x34, 0x3f, 0xf9, 0xdc, 0xbb, 0xc7, 0xc7, 0x0b, 0x4f, 0x1d,
+    0x8a, 0x51, 0xe0, 0x4b, 0xcd, 0xb4, 0x59, 0x31, 0xc8, 0x9f, 0x7e, 0xc9, 0xd9, 0x78, 0x73, 0x64,
+    0xea, 0xc5, 0xac, 0x83, 0x34, 0xd3, 0xeb, 0xc3, 0xc5, 0x81, 0xa0, 0xff, 0xfa, 0x13, 0x63, 0xeb,
+    0x17, 0x0d, 0xdd, 0x51, 0xb7, 0xf0, 0xda, 0x49, 0xd3, 0x16, 0x55, 0x26, 0x29, 0xd4, 0x68, 0x9e,
+    0x2b, 0x16, 0xbe, 0x58, 0x7d, 0x47, 0xa1, 0xfc, 0x8f, 0xf8, 0xb8, 0xd1, 0x7a, 0xd0, 0x31, 0xce,
+    0x45, 0xcb, 0x3a, 0x8f, 0x95, 0x16, 0x04, 0x28, 0xaf, 0xd7, 0xfb, 0xca, 0xbb, 0x4b, 0x40, 0x7e
+};
+
+/// Little endian loads from possibly unaligned addresses.
+inline uint32_t xxh3Read32(const uint8_t *data)
+{
+    uint32_t value;
+    std::memcpy(&value, data, sizeof(value));
+    return endian::little_to_native(value);
+}
+
+inline uint64_t xxh3Read64(const uint8_t *data)
+{
+    uint64_t value;
+    std::memcpy(&value, data, sizeof(value));
+    return endian::little_to_native(value);
+}
+
+inline void xxh3Write64(uint8_t *data, const uint64_t &value)
+{
+    const uint64_t little = endian::native_to_little(value);
+    std::memcpy(data, &little, sizeof(little));
+}
+
+/// Accumulates nbStripes stripes of input, the secret moving 8 bytes per stripe.
+using Xxh3AccumulateFunction = void (*)(uint64_t *acc, const uint8_t *input, const uint8_t *secret, std::size_t nbStripes);
+/// Scrambles the accumulators at the end of a block.
+using Xxh3ScrambleFunction = void (*)(uint64_t *acc, const uint8_t *secret);
+
+inline void xxh3AccumulateScalar(uint64_t *acc, const uint8_t *input, const uint8_t *secret, std::size_t nbStripes)
+{
+    for (std::size_t n = 0; n < nbStripes; ++n)
+    {
+        const uint8_t *stripe = input + n * Xxh3StripeLength;
+        const uint8_t *key = secret + n * Xxh3SecretConsumeRate;
+        for (std::size_t i = 0; i < Xxh3AccumulatorCount; ++i)
+        {
+            const uint64_t dataValue = xxh3Read64(stripe + 8 * i);
+            const uint64_t dataKey = dataValue ^ xxh3Read64(key + 8 * i);
+            acc[i ^ 1] += dataValue;
+            acc[i] += (dataKey & UINT64_C(0xFFFFFFFF)) * (dataKey >> 32);
+        }
+    }
+}
+
+inline void xxh3ScrambleScalar(uint64_t *acc, const uint8_t *secret)
+{
+    for (std::size_t i = 0; i < Xxh3AccumulatorCount; ++i)
+    {
+        uint64_t value = acc[i];
+        value ^= value >> 47;
+        value ^= xxh3Read64(secret + 8 * i);
+        value *= Xxh3Prime32_1;
+        acc[i] = value;
+    }
+}
+
+#if defined(ARCH_X86)
+TARGET_ATTRIBUTE("sse2")
+inline void xxh3AccumulateSse2(uint64_t *acc, const uint8_t *input, const uint8_t *secret, std::size_t nbStripes)
+{
+    __m128i a[4];
+    for (int i = 0; i < 4; ++i)
+        a[i] = _mm_loadu_si128(reinterpret_cast<const __m128i*>(acc) + i);
+
+    for (std::size_t n = 0; n < nbStripes; ++n)
+    {
+        const __m128i *stripe = reinterpret_cast<const __m128i*>(input + n * Xxh3StripeLength);
+        const __m128i *key = reinterpret_cast<const __m128i*>(secret + n * Xxh3SecretConsumeRate);
+        for (int i = 0; i < 4; ++i)
+        {
+            const __m128i data = _mm_loadu_si128(stripe + i);
+            const __m128i dataKey = _mm_xor_si128(data, _mm_loadu_si128(key + i));
+            // 32 x 32 -> 64 bit product of the low and high half of each lane.
+            const __m128i product = _mm_mul_epu32(dataKey, _mm_shuffle_epi32(dataKey, _MM_SHUFFLE(0, 3, 0, 1)));
+            // Each lane also adds the input of its neighbour.
+            const __m128i swapped = _mm_shuffle_epi32(data, _MM_SHUFFLE(1, 0, 3, 2));
+            a[i] = _mm_add_epi64(a[i], _mm_add_epi64(product, swapped));
+        }
+    }
+
+    for (int i = 0; i < 4; ++i)
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(acc) + i, a[i]);
+}
+
+TARGET_ATTRIBUTE("sse2")
+inline void xxh3ScrambleSse2(uint64_t *acc, const uint8_t *secret)
+{
+    const __m128i prime = _mm_set1_epi32(static_cast<int>(Xxh3Prime32_1));
+    for (int i = 0; i < 4; ++i)
+    {
+        __m128i value = _mm_loadu_si128(reinterpret_cast<const __m128i*>(acc) + i);
+        value = _mm_xor_si128(value, _mm_srli_epi64(value, 47));
+        value = _mm_xor_si128(value, _mm_loadu_si128(reinterpret_cast<const __m128i*>(secret) + i));
+        // 64 x 32 bit multiply out of two 32 x 32 bit halves.
+        const __m128i productLow  = _mm_mul_epu32(value, prime);
+        const __m128i productHigh = _mm_mul_epu32(_mm_shuffle_epi32(value, _MM_SHUFFLE(0, 3, 0, 1)), prime);
+        value = _mm_add_epi64(productLow, _mm_slli_epi64(productHigh, 32));
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(acc) + i, value);
+    }
+}
+
+TARGET_ATTRIBUTE("avx2")
+inline void xxh3AccumulateAvx2(uint64_t *acc, const uint8_t *input, const uint8_t *secret, std::size_t nbStripes)
+{
+    __m256i a[2];
+    for (int i = 0; i < 2; ++i)
+        a[i] = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(acc) + i);
+
+    for (std::size_t n = 0; n < nbStripes; ++n)
+    {
+        const __m256i *stripe = reinterpret_cast<const __m256i*>(input + n * Xxh3StripeLength);
+        const __m256i *key = reinterpret_cast<const __m256i*>(secret + n * Xxh3SecretConsumeRate);
+        for (int i = 0; i < 2; ++i)
+        {
+            const __m256i data = _mm256_loadu_si256(stripe + i);
+            const __m256i dataKey = _mm256_xor_si256(data, _mm256_loadu_si256(key + i));
+            const __m256i product = _mm256_mul_epu32(dataKey, _mm256_shuffle_epi32(dataKey, _MM_SHUFFLE(0, 3, 0, 1)));
+            const __m256i swapped = _mm256_shuffle_epi32(data, _MM_SHUFFLE(1, 0, 3, 2));
+            a[i] = _mm256_add_epi64(a[i], _mm256_add_epi64(product, swapped));
+        }
+    }
+
+    for (int i = 0; i < 2; ++i)
+        _mm256_storeu_si256(reinterpret_cast<__m256i*>(acc) + i, a[i]);
+}
+
+TARGET_ATTRIBUTE("avx2")
+inline void xxh3ScrambleAvx2(uint64_t *acc, const uint8_t *secret)
+{
+    const __m256i prime = _mm256_set1_epi32(static_cast<int>(Xxh3Prime32_1));
+    for (int i = 0; i < 2; ++i)
+    {
+        __m256i value = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(acc) + i);
+        value = _mm256_xor_si256(value, _mm256_srli_epi64(value, 47));
+        value = _mm256_xor_si256(value, _mm256_loadu_si256(reinterpret_cast<const __m256i*>(secret) + i));
+        const __m256i productLow  = _mm256_mul_epu32(value, prime);
+        const __m256i productHigh = _mm256_mul_epu32(_mm256_shuffle_epi32(value, _MM_SHUFFLE(0, 3, 0, 1)), prime);
+        value = _mm256_add_epi64(productLow, _mm256_slli_epi64(productHigh, 32));
+        _mm256_storeu_si256(reinterpret_cast<__m256i*>(acc) + i, value);
+    }
+}
+
+// The zero masking forms keep GCC from warning about the undefined
+// source operand of the plain intrinsics, the instructions are the same.
+TARGET_ATTRIBUTE("avx512f")
+inline __m512i xxh3MultiplyAvx512(const __m512i &lhs, const __m512i &rhs)
+{
+    return _mm512_maskz_mul_epu32(0xFF, lhs, rhs);
+}
+
+TARGET_ATTRIBUTE("avx512f")
+inline __m512i xxh3SwapHalvesAvx512(const __m512i &x)
+{
+    return _mm512_maskz_shuffle_epi32(0xFFFF, x, static_cast<_MM_PERM_ENUM>(_MM_SHUFFLE(0, 3, 0, 1)));
+}
+
+TARGET_ATTRIBUTE("avx512f")
+inline __m512i xxh3SwapNeighboursAvx512(const __m512i &x)
+{
+    return _mm512_maskz_shuffle_epi32(0xFFFF, x, static_cast<_MM_PERM_ENUM>(_MM_SHUFFLE(1, 0, 3, 2)));
+}
+
+TARGET_ATTRIBUTE("avx512f")
+inline void xxh3AccumulateAvx512(uint64_t *acc, const uint8_t *input, const uint8_t *secret, std::size_t nbStripes)
+{
+    __m512i a = _mm512_loadu_si512(acc);
+    for (std::size_t n = 0; n < nbStripes; ++n)
+    {
+        const __m512i data = _mm512_loadu_si512(input + n * Xxh3StripeLength);
+        const __m512i dataKey = _mm512_xor_si512(data, _mm512_loadu_si512(secret + n * Xxh3SecretConsumeRate));
+        const __m512i product = xxh3MultiplyAvx512(dataKey, xxh3SwapHalvesAvx512(dataKey));
+        a = _mm512_add_epi64(a, _mm512_add_epi64(product, xxh3SwapNeighboursAvx512(data)));
+    }
+
+    _mm512_storeu_si512(acc, a);
+}
+
+TARGET_ATTRIBUTE("avx512f")
+inline void xxh3ScrambleAvx512(uint64_t *acc, const uint8_t *secret)
+{
+    const __m512i prime = _mm512_set1_epi32(static_cast<int>(Xxh3Prime32_1));
+    __m512i value = _mm512_loadu_si512(acc);
+    // value ^ (value >> 47) ^ secret in one instruction.
+    value = _mm512_ternarylogic_epi64(value, _mm512_maskz_srli_epi64(0xFF, value, 47), _mm512_loadu_si512(secret), 0x96);
+    const __m512i productLow  = xxh3MultiplyAvx512(value, prime);
+    const __m512i productHigh = xxh3MultiplyAvx512(_mm512_maskz_srli_epi64(0xFF, value, 32), prime);
+    _mm512_storeu_si512(acc, _mm512_add_epi64(productLow, _mm512_maskz_slli_epi64(0xFF, productHigh, 32)));
+}
+#endif
+
+#if defined(ARCH_ARM64)
+inline void xxh3AccumulateNeon(uint64_t *acc, const uint8_t *input, const uint8_t *secret, std::size_t nbStripes)
+{
+    uint64x2_t a[4];
+    for (int i = 0; i < 4; ++i)
+        a[i] = vld1q_u64(acc + 2 * i);
+
+    for (std::size_t n = 0; n < nbStripes; ++n)
+    {
+        const uint8_t *stripe = input + n * Xxh3StripeLength;
+        const uint8_t *key = secret + n * Xxh3SecretConsumeRate;
+        for (int i = 0; i < 4; ++i)
+        {
+            const uint64x2_t data = vreinterpretq_u64_u8(vld1q_u8(stripe + 16 * i));
+            const uint64x2_t dataKey = veorq_u64(data, vreinterpretq_u64_u8(vld1q_u8(key + 16 * i)));
+            a[i] = vaddq_u64(a[i], vextq_u64(data, data, 1));
+            a[i] = vmlal_u32(a[i], vmovn_u64(dataKey), vshrn_n_u64(dataKey, 32));
+        }
+    }
+
+    for (int i = 0; i < 4; ++i)
+        vst1q_u64(acc + 2 * i, a[i]);
+}
+
+inline void xxh3ScrambleNeon(uint64_t *acc, const uint8_t *secret)
+{
+    const uint32x2_t prime = vdup_n_u32(Xxh3Prime32_1);
+    for (int i = 0; i < 4; ++i)
+    {
+        uint64x2_t value = vld1q_u64(acc + 2 * i);
+        value = veorq_u64(value, vshrq_n_u64(value, 47));
+        value = veorq_u64(value, vreinterpretq_u64_u8(vld1q_u8(secret + 16 * i)));
+        const uint64x2_t productHigh = vshlq_n_u64(vmull_u32(vshrn_n_u64(value, 32), prime), 32);
+        vst1q_u64(acc + 2 * i, vmlal_u32(productHigh, vmovn_u64(value), prime));
+    }
+}
+#endif
+
+/// Kernels of one backend.
+struct Xxh3Kernels
+{
+    Xxh3AccumulateFunction accumulate;
+    Xxh3ScrambleFunction scramble;
+};
+
+/// Kernels for backend, the scalar ones if it isn't compiled in.
+inline Xxh3Kernels xxh3KernelsFor(const Xxh3Backend &backend)
+{
+    switch (backend)
+    {
+#if defined(ARCH_X86)
+    case Xxh3Backend::Avx512:
+        return Xxh3Kernels{ xxh3AccumulateAvx512, xxh3ScrambleAvx512 };
+    case Xxh3Backend::Avx2:
+        return Xxh3Kernels{ xxh3AccumulateAvx2, xxh3ScrambleAvx2 };
+    case Xxh3Backend::Sse2:
+        return Xxh3Kernels{ xxh3AccumulateSse2, xxh3ScrambleSse2 };
+#endif
+#if defined(ARCH_ARM64)
+    case Xxh3Backend::Neon:
+        return Xxh3Kernels{ xxh3AccumulateNeon, xxh3ScrambleNeon };
+#endif
+    default:
+        return Xxh3Kernels{ xxh3AccumulateScalar, xxh3ScrambleScalar };
+    }
+}
+
+/// Fastest backend the cpu supports, "xxh3" in the BackendRegistry.
+inline Xxh3Backend selectXxh3Backend()
+{
+    const common::CpuFeatures &features = common::cpuFeatures();
+    bool x86 = false, sse2 = false, arm64 = false;
+#if defined(ARCH_X86)
+    x86 = true;
+  #if defined(ARCH_X86_64) || defined(__SSE2__)
+    sse2 = true;
+  #endif
+#elif defined(ARCH_ARM64)
+    arm64 = true;
+#endif
+
+    const common::BackendOption<Xxh3Backend> options[] =
+    {
+        { Xxh3Backend::Avx512, "avx512", x86 && features.avx512f },
+        { Xxh3Backend::Avx2,   "avx2",   x86 && features.avx2 },
+        { Xxh3Backend::Sse2,   "sse2",   sse2 },
+        { Xxh3Backend::Neon,   "neon",   arm64 && features.neon },
+        { Xxh3Backend::Scalar, "scalar", true }
+    };
+    return common::selectBackend("xxh3", options);
+}
+
+/// Backend picked once for the process.
+inline Xxh3Backend xxh3Backend()
+{
+    static const Xxh3Backend backend = selectXxh3Backend();
+    return backend;
+}
+
+inline const Xxh3Kernels &xxh3Kernels()
+{
+    static const Xxh3Kernels kernels = xxh3KernelsFor(xxh3Backend());
+    return kernels;
+}
+
+} // detail namespace
+
+} // noncryptographic namespace
+} // hashing namespace
+} // keeg namespace
+
+#endif // XXH3ACCELERATED_HPP
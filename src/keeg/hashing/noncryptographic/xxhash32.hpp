@@ -22,14 +22,14 @@
 #ifndef XXHASH32_HPP
 #define XXHASH32_HPP
 
-#include <keeg/hashing/hashalgorithm.hpp>
+#include <keeg/hashing/integerhashalgorithm.hpp>
 #include <keeg/endian/conversion.hpp>
 #include <algorithm>
 #include <array>
 
 namespace keeg { namespace hashing { namespace noncryptographic {
 
-class XxHash32 : public HashAlgorithm
+class XxHash32 : public IntegerHashAlgorithm<uint32_t>
 {
 public:
     XxHash32(const uint32_t &seed = 0);
@@ -37,11 +37,12 @@ public:
     // HashAlgorithm interface
 public:
     virtual std::size_t hashSize() override;
+    virtual std::unique_ptr<HashAlgorithm> copy() const override;
     virtual void initialize() override;
 
 protected:
     virtual void hashCore(const void *data, const std::size_t &dataLength, const std::size_t &startIndex) override;
-    virtual std::vector<uint8_t> hashFinal() override;
+    virtual uint32_t hashFinalValue() override;
 
 private:
     static const std::size_t m_hashSize = std::numeric_limits<uint32_t>::digits;
@@ -72,7 +73,7 @@ private:
 
 #define rotateLeft(x,y) keeg::endian::rotateLeft((x),(y))
 
-XxHash32::XxHash32(const uint32_t &seed) : HashAlgorithm(), m_seed(seed)
+XxHash32::XxHash32(const uint32_t &seed) : IntegerHashAlgorithm<uint32_t>(), m_seed(seed)
 {
     initialize();
 }
@@ -82,6 +83,11 @@ size_t XxHash32::hashSize()
     return m_hashSize;
 }
 
+std::unique_ptr<HashAlgorithm> XxHash32::copy() const
+{
+    return std::unique_ptr<HashAlgorithm>(new XxHash32(*this));
+}
+
 void XxHash32::initialize()
 {
     m_state[0] = m_seed + Prime1 + Prime2;
@@ -147,7 +153,7 @@ void XxHash32::hashCore(const void *data, const size_t &dataLength, const size_t
     }
 }
 
-std::vector<uint8_t> XxHash32::hashFinal()
+uint32_t XxHash32::hashFinalValue()
 {
     uint32_t result = static_cast<uint32_t>(m_totalLength);
 
@@ -185,20 +191,17 @@ std::vector<uint8_t> XxHash32::hashFinal()
      result *= Prime3;
      result ^= result >> 16;
 
-     result = endian::native_to_big(result);
-
-     return std::move(std::vector<uint8_t>(reinterpret_cast<uint8_t*>(&result),
-                                           reinterpret_cast<uint8_t*>(&result) + sizeof(uint32_t)));
+     return result;
 }
 
 void XxHash32::process(const void *data, uint32_t &state0, uint32_t &state1, uint32_t &state2, uint32_t &state3)
 {
-    const uint32_t* block = static_cast<const uint32_t*>(data);
+    const uint8_t* block = static_cast<const uint8_t*>(data);
 
-    state0 = rotateLeft(state0 + block[0] * Prime2, 13) * Prime1;
-    state1 = rotateLeft(state1 + block[1] * Prime2, 13) * Prime1;
-    state2 = rotateLeft(state2 + block[2] * Prime2, 13) * Prime1;
-    state3 = rotateLeft(state3 + block[3] * Prime2, 13) * Prime1;
+    state0 = rotateLeft(state0 + GET32BITS(block + 0) * Prime2, 13) * Prime1;
+    state1 = rotateLeft(state1 + GET32BITS(block + 4) * Prime2, 13) * Prime1;
+    state2 = rotateLeft(state2 + GET32BITS(block + 8) * Prime2, 13) * Prime1;
+    state3 = rotateLeft(state3 + GET32BITS(block + 12) * Prime2, 13) * Prime1;
 }
 
 } // noncryptographic namespace
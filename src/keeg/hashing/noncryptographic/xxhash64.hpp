@@ -22,14 +22,14 @@
 #ifndef XXHASH64_HPP
 #define XXHASH64_HPP
 
-#include <keeg/hashing/hashalgorithm.hpp>
+#include <keeg/hashing/integerhashalgorithm.hpp>
 #include <keeg/endian/conversion.hpp>
 #include <algorithm>
 #include <array>
 
 namespace keeg { namespace hashing { namespace noncryptographic {
 
-class XxHash64 : public HashAlgorithm
+class XxHash64 : public IntegerHashAlgorithm<uint64_t>
 {
 public:
     XxHash64(const uint64_t &seed = 0);
@@ -37,14 +37,15 @@ public:
     // HashAlgorithm interface
 public:
     virtual std::size_t hashSize() override;
+    virtual std::unique_ptr<HashAlgorithm> copy() const override;
     virtual void initialize() override;
 
 protected:
     virtual void hashCore(const void *data, const size_t &dataLength, const size_t &startIndex) override;
-    virtual std::vector<uint8_t> hashFinal() override;
+    virtual uint64_t hashFinalValue() override;
 
 private:
-    static const std::size_t m_hashSize = std::numeric_limits<uint32_t>::digits;
+    static const std::size_t m_hashSize = std::numeric_limits<uint64_t>::digits;
 
     /// magic constants :-)
     static const uint64_t Prime1 = UINT64_C(11400714785074694791);
@@ -74,7 +75,7 @@ private:
 
 #define rotateLeft(x,y) keeg::endian::rotateLeft((x),(y))
 
-XxHash64::XxHash64(const uint64_t &seed) : HashAlgorithm(), m_seed(seed)
+XxHash64::XxHash64(const uint64_t &seed) : IntegerHashAlgorithm<uint64_t>(), m_seed(seed)
 {
     initialize();
 }
@@ -84,6 +85,11 @@ std::size_t XxHash64::hashSize()
     return m_hashSize;
 }
 
+std::unique_ptr<HashAlgorithm> XxHash64::copy() const
+{
+    return std::unique_ptr<HashAlgorithm>(new XxHash64(*this));
+}
+
 void XxHash64::initialize()
 {
     m_state[0] = m_seed + Prime1 + Prime2;
@@ -146,7 +152,7 @@ void XxHash64::hashCore(const void *data, const size_t &dataLength, const size_t
     }
 }
 
-std::vector<uint8_t> XxHash64::hashFinal()
+uint64_t XxHash64::hashFinalValue()
 {
     // fold 256 bit state into one single 64 bit value
     uint64_t result;
@@ -196,10 +202,7 @@ std::vector<uint8_t> XxHash64::hashFinal()
     result *= Prime3;
     result ^= result >> 32;
 
-    result = endian::native_to_big(result);
-
-    return std::move(std::vector<uint8_t>(reinterpret_cast<uint8_t*>(&result),
-                                          reinterpret_cast<uint8_t*>(&result) + sizeof(uint64_t)));
+    return result;
 }
 
 uint64_t XxHash64::processSingle(const uint64_t &previous, const uint64_t &input)
@@ -209,11 +212,11 @@ uint64_t XxHash64::processSingle(const uint64_t &previous, const uint64_t &input
 
 void XxHash64::process(const void *data, uint64_t &state0, uint64_t &state1, uint64_t &state2, uint64_t &state3)
 {
-    const uint64_t* block = static_cast<const uint64_t*>(data);
-    state0 = processSingle(state0, block[0]);
-    state1 = processSingle(state1, block[1]);
-    state2 = processSingle(state2, block[2]);
-    state3 = processSingle(state3, block[3]);
+    const uint8_t* block = static_cast<const uint8_t*>(data);
+    state0 = processSingle(state0, GET64BITS(block + 0));
+    state1 = processSingle(state1, GET64BITS(block + 8));
+    state2 = processSingle(state2, GET64BITS(block + 16));
+    state3 = processSingle(state3, GET64BITS(block + 24));
 }
 
 } // noncryptographic namespace
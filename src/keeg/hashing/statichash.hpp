@@ -0,0 +1,124 @@
+/*
+ * Copyright (C) 2017 Larry Lopez
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to
+ * deal in the Software without restriction, including without limitation the
+ * rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+ * sell copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ */
+#ifndef STATICHASH_HPP
+#define STATICHASH_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <string>
+#include <type_traits>
+#include <utility>
+
+namespace keeg { namespace hashing {
+
+namespace detail {
+
+/// Whether Policy::update() takes char data, which is what lets it run at compile time.
+template<typename Policy, typename = void>
+struct HasCharUpdate : std::false_type { };
+
+template<typename Policy>
+struct HasCharUpdate<Policy, decltype(void(std::declval<const Policy&>().update(
+    std::declval<const Policy&>().initial(), std::declval<const char*>(), std::declval<const std::size_t&>())))>
+    : std::true_type { };
+
+} // detail namespace
+
+/// Hash of length characters of text with a policy, see StaticHash. Works in a constant
+/// expression when the policy's functions are constexpr and update() accepts char.
+template<typename Policy>
+constexpr typename Policy::result_type constexprHash(const Policy &policy, const char *text, const std::size_t &length)
+{
+    return policy.finalize(policy.update(policy.initial(), text, length));
+}
+
+/// Hash function without any virtual calls, so the whole loop inlines into the caller.
+/// The algorithm comes from a policy, the same one its HashAlgorithm class uses:
+///   result_type                 unsigned integer type of the hash
+///   initial()                   state before any data
+///   update(state, data, length) state after length more bytes
+///   finalize(state)             hash value of the state
+/// Policies may carry parameters such as a seed. Works as a drop in for std::hash,
+///   std::unordered_map<std::string, int, noncryptographic::StaticFnv1aHash64> index;
+/// Policies whose update() also takes char are constexpr, for those hash(text, length)
+/// works in constant expressions.
+template<typename Policy>
+class StaticHash : private Policy
+{
+public:
+    using result_type = typename Policy::result_type;
+
+    static_assert(std::is_integral<result_type>::value && std::is_unsigned<result_type>::value,
+                  "Policy::result_type must be an unsigned integer type!");
+
+    constexpr StaticHash() = default;
+    constexpr explicit StaticHash(const Policy &policy) : Policy(policy) { }
+
+    /// Hash of a memory block.
+    result_type hash(const void* data, const std::size_t &dataLength) const
+    {
+        const Policy &policy = *this;
+        return policy.finalize(policy.update(policy.initial(), static_cast<const uint8_t*>(data), dataLength));
+    }
+
+    /// Hash of length characters of text, usable at compile time with a constexpr policy.
+    template<typename P = Policy, typename std::enable_if<detail::HasCharUpdate<P>::value, int>::type = 0>
+    constexpr result_type hash(const char *text, const std::size_t &length) const
+    {
+        return constexprHash(static_cast<const Policy&>(*this), text, length);
+    }
+
+    /// Policies whose update() only takes uint8_t hash text as a memory block.
+    template<typename P = Policy, typename std::enable_if<!detail::HasCharUpdate<P>::value, int>::type = 0>
+    result_type hash(const char *text, const std::size_t &length) const
+    {
+        return hash(static_cast<const void*>(text), length);
+    }
+
+    /// Hash of a string, excluding final zero. Runtime strings take the memory block
+    /// overload, policies may have a faster update() for uint8_t.
+    result_type hash(const std::string &text) const
+    {
+        return hash(static_cast<const void*>(text.data()), text.size());
+    }
+
+    std::size_t operator()(const std::string &text) const
+    {
+        return static_cast<std::size_t>(hash(text));
+    }
+
+    std::size_t operator()(const char *text) const
+    {
+        return static_cast<std::size_t>(hash(static_cast<const void*>(text), std::strlen(text)));
+    }
+
+    std::size_t operator()(const void* data, const std::size_t &dataLength) const
+    {
+        return static_cast<std::size_t>(hash(data, dataLength));
+    }
+};
+
+} // hashing namespace
+} // keeg namespace
+
+#endif // STATICHASH_HPP
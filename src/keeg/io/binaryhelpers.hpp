@@ -23,6 +23,8 @@
 #define BINARYHELPERS_HPP
 
 #include <keeg/io/binaryreaders.hpp>
+#include <keeg/io/memoryreader.hpp>
 #include <keeg/io/binarywriters.hpp>
+#include <keeg/io/bufferedwriter.hpp>
 
 #endif // BINARYHELPERS_HPP
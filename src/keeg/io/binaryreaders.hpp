@@ -25,11 +25,16 @@
 #include <algorithm>
 #include <cstddef>
 #include <cstdint>
+#include <cstring>
 #include <iostream>
-#include <sstream>
+#include <string>
 #include <type_traits>
 #include <vector>
+#include <keeg/common/arena.hpp>
+#include <keeg/common/instrumentation.hpp>
 #include <keeg/endian/conversion.hpp>
+#include <keeg/endian/recordswap.hpp>
+#include <keeg/io/views.hpp>
 
 namespace keeg { namespace io {
 
@@ -45,6 +50,7 @@ std::size_t readIntType(std::istream &instream, T &data, const endian::Order &en
         {
             if (instream.read(reinterpret_cast<char*>(&data), sizeof(T)))
             {
+                KEEG_INSTRUMENT_READ(sizeof(T));
                 endian::convertToEndianInplace<T>(data, endian);
                 return static_cast<std::size_t>(instream.gcount());
             }
@@ -69,6 +75,7 @@ std::size_t readPODType(std::istream &instream, T &data)
         if (instream)
         {
             instream.read(reinterpret_cast<char*>(&data), sizeof(T));
+            KEEG_INSTRUMENT_READ(instream.gcount());
             return static_cast<std::size_t>(instream.gcount());
         }
     }
@@ -81,6 +88,37 @@ std::size_t readPODType(std::istream &instream, T &data)
     return 0;
 }
 
+/// Reads count PODs into data with a single stream read. When endian isn't native the
+/// integer fields listed in Fields are converted afterwards, a whole array at a time:
+///   readPODArray<Entry, EntryFields>(instream, entries.data(), entries.size(), endian::Order::big);
+/// Returns the bytes read, only whole records are converted when the stream ends early.
+template<typename T, typename Fields = endian::RecordFields<>>
+std::size_t readPODArray(std::istream &instream, T *data, const std::size_t &count,
+                         const endian::Order &endian = endian::Order::native)
+{
+    static_assert(std::is_pod<T>::value && std::is_trivially_copyable<T>::value, "T must be a POD!");
+    try
+    {
+        if (instream && count > 0)
+        {
+            instream.read(reinterpret_cast<char*>(data), static_cast<std::streamsize>(count * sizeof(T)));
+            const std::size_t numBytesRead = static_cast<std::size_t>(instream.gcount());
+            KEEG_INSTRUMENT_READ(numBytesRead);
+
+            if (endian != endian::Order::native)
+                endian::swapRecords<T, Fields>(data, numBytesRead / sizeof(T));
+            return numBytesRead;
+        }
+    }
+    catch(const std::exception &ex)
+    {
+        std::cerr << ex.what() << std::endl;
+        return 0;
+    }
+
+    return 0;
+}
+
 template<typename T>
 std::size_t readPrefixString(std::istream &instream, std::string &data,
                              const endian::Order &endian = endian::Order::native,
@@ -96,14 +134,14 @@ std::size_t readPrefixString(std::istream &instream, std::string &data,
             if(readIntType<T>(instream, size, endian) > 0)
             {
                 data.resize(size);
-                instream.read(reinterpret_cast<char*>(&data[0]), size);
+                instream.read(&data[0], size);
+                const std::size_t count = static_cast<std::size_t>(instream.gcount());
+                KEEG_INSTRUMENT_READ(count);
 
-                if(isNullTerminated)
-                {
-                    /// Removes all nulls from a string by shifting all non-null characters to the left
-                    /// and then erasing the extra.
-                    data.erase(std::remove(std::begin(data), std::end(data), '\0'), std::end(data));
-                }
+                /// The text ends at the first null, anything after it is padding.
+                const void *terminator = isNullTerminated ? std::memchr(data.data(), '\0', count) : nullptr;
+                data.resize(terminator == nullptr ? count :
+                            static_cast<std::size_t>(static_cast<const char*>(terminator) - data.data()));
 
                 return static_cast<std::size_t>(instream.gcount() + sizeof(T));
             }
@@ -179,7 +217,10 @@ inline std::size_t readBytes(std::istream &instream, std::vector<uint8_t> &data,
                 data.resize(length + index);
 
             if (instream.read(reinterpret_cast<char*>(&data[index]), length))
+            {
+                KEEG_INSTRUMENT_READ(length);
                 return instream.gcount();
+            }
         }
     }
     catch(const std::exception &ex)
@@ -233,19 +274,134 @@ inline std::size_t readZString(std::istream &instream, std::string &data)
     {
         if (instream)
         {
-            std::stringstream ss;
-            char c;
+            /// getline reads from the stream buffer a block at a time and reuses data's capacity.
+            data.clear();
+            std::getline(instream, data, '\0');
+            KEEG_INSTRUMENT_READ(data.length() + 1);
+            return data.length() + 1;
+        }
+    }
+    catch(const std::exception &ex)
+    {
+        std::cerr << ex.what() << std::endl;
+        return 0;
+    }
+
+    return 0;
+}
+
+/// Arena readers. Text and bytes are allocated out of arena instead of a string or vector
+/// per field, the views stay valid until the arena is released or reset.
+
+template<typename T>
+std::size_t readPrefixString(std::istream &instream, common::MonotonicArena &arena, TextView &data,
+                             const endian::Order &endian = endian::Order::native,
+                             const bool &isNullTerminated = false)
+{
+    static_assert(std::is_integral<T>::value &&
+                  !std::is_same<T, bool>::value, "T must be any integer type!");
+    try
+    {
+        if (instream)
+        {
+            T size;
+            if(readIntType<T>(instream, size, endian) > 0)
+            {
+                char *text = static_cast<char*>(arena.allocate(static_cast<std::size_t>(size), 1));
+                instream.read(text, size);
+                const std::size_t count = static_cast<std::size_t>(instream.gcount());
+                KEEG_INSTRUMENT_READ(count);
+
+                const void *terminator = isNullTerminated ? std::memchr(text, '\0', count) : nullptr;
+                data.data = text;
+                data.size = terminator == nullptr ? count :
+                            static_cast<std::size_t>(static_cast<const char*>(terminator) - text);
+
+                return static_cast<std::size_t>(count + sizeof(T));
+            }
+        }
+    }
+    catch(const std::exception &ex)
+    {
+        std::cerr << ex.what() << std::endl;
+        return 0;
+    }
+
+    return 0;
+}
 
-            while (instream.read(&c, sizeof(char)))
+/// Reads length bytes into a view allocated out of arena, the bytes have no alignment.
+inline std::size_t readBytes(std::istream &instream, common::MonotonicArena &arena, ByteView &data,
+                             const std::size_t &length)
+{
+    try
+    {
+        if (instream)
+        {
+            uint8_t *bytes = static_cast<uint8_t*>(arena.allocate(length, 1));
+            if (instream.read(reinterpret_cast<char*>(bytes), length))
             {
-                if (c != '\0')
-                    ss << c;
-                else
-                    break;
+                KEEG_INSTRUMENT_READ(length);
+                data.data = bytes;
+                data.size = length;
+                return instream.gcount();
             }
+        }
+    }
+    catch(const std::exception &ex)
+    {
+        std::cerr << ex.what() << std::endl;
+        return 0;
+    }
 
-            data = ss.str();
-            return data.length() + 1;
+    return 0;
+}
+
+/// Read a string prefixed with a uint8_t length. NOT zero terminated.
+inline std::size_t readBString(std::istream &instream, common::MonotonicArena &arena, TextView &data,
+                               const endian::Order &endian = endian::Order::native)
+{
+    return readPrefixString<uint8_t>(instream, arena, data, endian, false);
+}
+
+/// Read a string prefixed with a uint8_t length. zero terminated.
+inline std::size_t readBZString(std::istream &instream, common::MonotonicArena &arena, TextView &data,
+                                const endian::Order &endian = endian::Order::native)
+{
+    return readPrefixString<uint8_t>(instream, arena, data, endian, true);
+}
+
+/// Read a string prefixed with a uint16 length. NOT zero terminated.
+inline std::size_t readWString(std::istream &instream, common::MonotonicArena &arena, TextView &data,
+                               const endian::Order &endian = endian::Order::native)
+{
+    return readPrefixString<uint16_t>(instream, arena, data, endian, false);
+}
+
+/// Read a string prefixed with a uint16 length. zero terminated.
+inline std::size_t readWZString(std::istream &instream, common::MonotonicArena &arena, TextView &data,
+                                const endian::Order &endian = endian::Order::native)
+{
+    return readPrefixString<uint16_t>(instream, arena, data, endian, true);
+}
+
+/// Zero terminated string, the length isn't known up front so it's read into a per thread
+/// scratch string first and then copied into arena.
+/// Size is size of string text + 1 for string terminator.
+inline std::size_t readZString(std::istream &instream, common::MonotonicArena &arena, TextView &data)
+{
+    static thread_local std::string scratch;
+    try
+    {
+        if (instream)
+        {
+            scratch.clear();
+            std::getline(instream, scratch, '\0');
+
+            data.data = static_cast<const char*>(arena.copy(scratch.data(), scratch.size()));
+            data.size = scratch.size();
+            KEEG_INSTRUMENT_READ(data.size + 1);
+            return data.size + 1;
         }
     }
     catch(const std::exception &ex)
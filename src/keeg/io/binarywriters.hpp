@@ -26,10 +26,18 @@
 #include <cstddef>
 #include <cstdint>
 #include <iostream>
+#include <memory>
 #include <sstream>
 #include <type_traits>
 #include <vector>
+#include <keeg/common/instrumentation.hpp>
 #include <keeg/endian/conversion.hpp>
+#include <keeg/endian/recordswap.hpp>
+
+#ifndef POD_ARRAY_CHUNK_SIZE
+    // Bytes of records converted at a time by writePODArray before being written.
+    #define POD_ARRAY_CHUNK_SIZE (64 * 1024)
+#endif
 
 namespace keeg { namespace io {
 
@@ -46,6 +54,7 @@ std::size_t writeIntType(std::ostream &outstream, const T &data, const endian::O
             T buffer;
             buffer = endian::convertToEndian<T>(data, endian);
             outstream.write(reinterpret_cast<char*>(&buffer), sizeof(T));
+            KEEG_INSTRUMENT_WRITE(sizeof(T));
             return sizeof(T);
         }
     }
@@ -68,6 +77,7 @@ std::size_t writePODType(std::ostream &outstream, const T &data)
         if (outstream)
         {
             outstream.write(reinterpret_cast<const char*>(&data), sizeof(T));
+            KEEG_INSTRUMENT_WRITE(sizeof(T));
             return sizeof(T);
         }
     }
@@ -80,6 +90,51 @@ std::size_t writePODType(std::ostream &outstream, const T &data)
     return 0;
 }
 
+/// Writes count PODs from data. Native order goes out in a single stream write, otherwise
+/// the records are converted in chunks of POD_ARRAY_CHUNK_SIZE bytes with the integer
+/// fields listed in Fields reversed, data itself is left untouched. Returns the bytes written.
+template<typename T, typename Fields = endian::RecordFields<>>
+std::size_t writePODArray(std::ostream &outstream, const T *data, const std::size_t &count,
+                          const endian::Order &endian = endian::Order::native)
+{
+    static_assert(std::is_pod<T>::value && std::is_trivially_copyable<T>::value, "T must be a POD!");
+    try
+    {
+        if (outstream && count > 0)
+        {
+            const std::size_t bytes = count * sizeof(T);
+            if (endian == endian::Order::native || std::is_same<Fields, endian::RecordFields<>>::value)
+            {
+                if (!outstream.write(reinterpret_cast<const char*>(data), static_cast<std::streamsize>(bytes)))
+                    return 0;
+
+                KEEG_INSTRUMENT_WRITE(bytes);
+                return bytes;
+            }
+
+            const std::size_t chunk = std::max<std::size_t>(POD_ARRAY_CHUNK_SIZE / sizeof(T), 1);
+            std::unique_ptr<T[]> buffer(new T[std::min(chunk, count)]);
+            for (std::size_t done = 0; done < count; done += chunk)
+            {
+                const std::size_t length = std::min(chunk, count - done);
+                endian::swapRecords<T, Fields>(data + done, buffer.get(), length);
+                if (!outstream.write(reinterpret_cast<const char*>(buffer.get()), static_cast<std::streamsize>(length * sizeof(T))))
+                    return 0;
+            }
+
+            KEEG_INSTRUMENT_WRITE(bytes);
+            return bytes;
+        }
+    }
+    catch(const std::exception &ex)
+    {
+        std::cerr << ex.what() << std::endl;
+        return 0;
+    }
+
+    return 0;
+}
+
 template<typename T>
 std::size_t writePrefixString(std::ostream &outstream, const std::string &data,
                              const endian::Order &endian = endian::Order::native,
@@ -100,6 +155,7 @@ std::size_t writePrefixString(std::ostream &outstream, const std::string &data,
             if(writeIntType<T>(outstream, size, endian) > 0)
             {
                 outstream.write(ss.str().c_str(), size);
+                KEEG_INSTRUMENT_WRITE(size);
                 return size + sizeof(T);
             }
         }
@@ -161,7 +217,10 @@ inline std::size_t writeBytes(std::ostream &outstream, const std::vector<uint8_t
         if (outstream && ((length + index) <= data.size()))
         {
             if (outstream.write(reinterpret_cast<const char*>(&data[index]), length))
+            {
+                KEEG_INSTRUMENT_WRITE(length);
                 return length;
+            }
         }
     }
     catch(const std::exception &ex)
@@ -218,6 +277,7 @@ inline std::size_t writeZString(std::ostream &outstream, const std::string &data
             std::stringstream ss{data};
             ss << '\0';
             outstream.write(ss.str().c_str(), ss.str().size());
+            KEEG_INSTRUMENT_WRITE(ss.str().size());
             return ss.str().size();
         }
     }
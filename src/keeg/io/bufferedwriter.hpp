@@ -0,0 +1,460 @@
+/*
+ * Copyright (C) 2017 Larry Lopez
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to
+ * deal in the Software without restriction, including without limitation the
+ * rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+ * sell copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ */
+#ifndef BUFFEREDWRITER_HPP
+#define BUFFEREDWRITER_HPP
+
+#include <algorithm>
+#include <cerrno>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <iostream>
+#include <string>
+#include <type_traits>
+#include <vector>
+#include <keeg/common/instrumentation.hpp>
+#include <keeg/endian/byteswaparray.hpp>
+#include <keeg/endian/conversion.hpp>
+
+#if defined(_WIN32)
+    #include <io.h>
+#else
+    #include <unistd.h>
+#endif
+
+/// Bytes gathered before a stream or descriptor writer flushes.
+#define BUFFERED_WRITER_CAPACITY (64 * 1024)
+
+namespace keeg { namespace io {
+
+/// Gathers writes in a byte buffer so each one is a bounds check and a memcpy, the same
+/// writes as binarywriters.hpp without a stream call per value. The buffer is either owned
+/// or supplied by the caller, and is flushed to a std::ostream or a file descriptor when
+/// full, on flush() and on destruction. Without a sink an owned buffer grows to hold
+/// everything, see data(), while a caller buffer fails writes that don't fit.
+/// Writes return the bytes written, or 0 when they could not be done. Once the sink fails
+/// good() is false and every later write returns 0.
+class BufferedWriter
+{
+public:
+    /// Grows in memory, never flushes.
+    BufferedWriter();
+    /// Flushes to the stream, which must outlive the writer.
+    explicit BufferedWriter(std::ostream &outstream, const std::size_t &capacity = BUFFERED_WRITER_CAPACITY);
+    /// Flushes to an open file descriptor, which is not closed by the writer.
+    explicit BufferedWriter(const int &fileDescriptor, const std::size_t &capacity = BUFFERED_WRITER_CAPACITY);
+    /// Writes into capacity bytes at buffer, flushing to outstream when one is given.
+    BufferedWriter(void *buffer, const std::size_t &capacity, std::ostream *outstream = nullptr);
+    BufferedWriter(const BufferedWriter&) = delete;
+    BufferedWriter &operator=(const BufferedWriter&) = delete;
+    ~BufferedWriter();
+
+    /// Hands buffered bytes to the sink. True if there is no sink or everything was written.
+    bool flush();
+    bool good() const;
+
+    /// The buffered bytes, everything written for a writer without a sink.
+    const uint8_t *data() const;
+    std::size_t size() const;
+    std::size_t capacity() const;
+    /// Drops the buffered bytes without writing them.
+    void clear();
+
+    /// Endian aware integer write.
+    template<typename T>
+    std::size_t writeIntType(const T &data, const endian::Order &endian = endian::Order::native);
+
+    /// Plain copy of a POD, usually a simple struct.
+    template<typename T>
+    std::size_t writePODType(const T &data);
+
+    /// bool stored with the size of bool on this platform, as writeBoolean in binarywriters.hpp.
+    std::size_t writeBoolean(const bool &data, const endian::Order &endian = endian::Order::native);
+
+    std::size_t writeBytes(const void *data, const std::size_t &length);
+    std::size_t writeBytes(const std::vector<uint8_t> &data);
+
+    /// count integers in the given byte order. When that isn't the native order the whole
+    /// array is byte swapped with vector shuffles straight into the buffer.
+    template<typename T>
+    std::size_t writeArray(const T *data, const std::size_t &count, const endian::Order &endian = endian::Order::native);
+
+    /// String prefixed with a T length. With isNullTerminated a zero is written after the
+    /// text and counted in the length.
+    template<typename T>
+    std::size_t writePrefixString(const std::string &data, const endian::Order &endian = endian::Order::native,
+                                  const bool &isNullTerminated = false);
+    /// String prefixed with a uint8_t length. NOT zero terminated.
+    std::size_t writeBString(const std::string &data);
+    /// String prefixed with a uint8_t length. zero terminated.
+    std::size_t writeBZString(const std::string &data);
+    /// String prefixed with a uint16 length. NOT zero terminated.
+    std::size_t writeWString(const std::string &data, const endian::Order &endian = endian::Order::native);
+    /// String prefixed with a uint16 length. zero terminated.
+    std::size_t writeWZString(const std::string &data, const endian::Order &endian = endian::Order::native);
+    /// Zero terminated string, returns the text length + 1 for the terminator.
+    std::size_t writeZString(const std::string &data);
+
+private:
+    enum class Sink
+    {
+        Memory, Stream, Descriptor, None
+    };
+
+    Sink m_sink;
+    std::ostream *m_stream;
+    int m_descriptor;
+    std::vector<uint8_t> m_storage;
+    uint8_t *m_buffer;
+    std::size_t m_capacity;
+    std::size_t m_size;
+    bool m_good;
+
+    /// Makes room for length more bytes, flushing or growing. False if there can't be.
+    bool reserve(const std::size_t &length);
+    /// Writes straight to the sink, bypassing the buffer.
+    bool sinkWrite(const uint8_t *data, std::size_t length);
+};
+
+BufferedWriter::BufferedWriter() :
+    m_sink(Sink::Memory), m_stream(nullptr), m_descriptor(-1), m_buffer(nullptr), m_capacity(0), m_size(0), m_good(true)
+{ }
+
+BufferedWriter::BufferedWriter(std::ostream &outstream, const std::size_t &capacity) :
+    m_sink(Sink::Stream), m_stream(&outstream), m_descriptor(-1), m_storage(std::max<std::size_t>(capacity, 1)),
+    m_buffer(m_storage.data()), m_capacity(m_storage.size()), m_size(0), m_good(true)
+{ }
+
+BufferedWriter::BufferedWriter(const int &fileDescriptor, const std::size_t &capacity) :
+    m_sink(Sink::Descriptor), m_stream(nullptr), m_descriptor(fileDescriptor),
+    m_storage(std::max<std::size_t>(capacity, 1)), m_buffer(m_storage.data()), m_capacity(m_storage.size()),
+    m_size(0), m_good(fileDescriptor >= 0)
+{ }
+
+BufferedWriter::BufferedWriter(void *buffer, const std::size_t &capacity, std::ostream *outstream) :
+    m_sink(outstream != nullptr ? Sink::Stream : Sink::None), m_stream(outstream), m_descriptor(-1),
+    m_buffer(static_cast<uint8_t*>(buffer)), m_capacity(buffer != nullptr ? capacity : 0), m_size(0), m_good(true)
+{ }
+
+BufferedWriter::~BufferedWriter()
+{
+    flush();
+}
+
+bool BufferedWriter::flush()
+{
+    if (m_sink == Sink::Memory || m_sink == Sink::None)
+        return m_good;
+
+    if (m_size > 0)
+    {
+        const bool written = sinkWrite(m_buffer, m_size);
+        m_size = 0;
+        if (!written)
+            return false;
+    }
+
+    if (m_sink == Sink::Stream && m_good)
+    {
+        try
+        {
+            if (!m_stream->flush())
+                m_good = false;
+        }
+        catch(const std::exception &ex)
+        {
+            std::cerr << ex.what() << std::endl;
+            m_good = false;
+        }
+    }
+
+    return m_good;
+}
+
+bool BufferedWriter::good() const
+{
+    return m_good;
+}
+
+const uint8_t *BufferedWriter::data() const
+{
+    return m_buffer;
+}
+
+std::size_t BufferedWriter::size() const
+{
+    return m_size;
+}
+
+std::size_t BufferedWriter::capacity() const
+{
+    return m_capacity;
+}
+
+void BufferedWriter::clear()
+{
+    m_size = 0;
+}
+
+bool BufferedWriter::reserve(const std::size_t &length)
+{
+    if (length <= m_capacity - m_size)
+        return m_good;
+
+    if (!m_good)
+        return false;
+
+    switch (m_sink) {
+    case Sink::Memory:
+    {
+        if (length > m_storage.max_size() - m_size)
+            return false;
+
+        m_storage.resize(std::max(m_size + length, std::max<std::size_t>(m_capacity * 2, 256)));
+        m_buffer = m_storage.data();
+        m_capacity = m_storage.size();
+        return true;
+    }
+    case Sink::Stream:
+    case Sink::Descriptor:
+        return flush() && length <= m_capacity;
+    default:
+        return false;
+    }
+}
+
+bool BufferedWriter::sinkWrite(const uint8_t *data, std::size_t length)
+{
+    if (!m_good)
+        return false;
+
+    KEEG_INSTRUMENT_FLUSH(length);
+    if (m_sink == Sink::Stream)
+    {
+        try
+        {
+            if (!m_stream->write(reinterpret_cast<const char*>(data), static_cast<std::streamsize>(length)))
+                m_good = false;
+        }
+        catch(const std::exception &ex)
+        {
+            std::cerr << ex.what() << std::endl;
+            m_good = false;
+        }
+
+        return m_good;
+    }
+
+    while (length > 0)
+    {
+#if defined(_WIN32)
+        const unsigned int chunk = static_cast<unsigned int>(std::min<std::size_t>(length, 1u << 30));
+        const int written = _write(m_descriptor, data, chunk);
+#else
+        const ssize_t written = ::write(m_descriptor, data, length);
+#endif
+        if (written < 0)
+        {
+            if (errno == EINTR)
+                continue;
+
+            m_good = false;
+            return false;
+        }
+
+        data += written;
+        length -= static_cast<std::size_t>(written);
+    }
+
+    return true;
+}
+
+template<typename T>
+std::size_t BufferedWriter::writeIntType(const T &data, const endian::Order &endian)
+{
+    static_assert(std::is_integral<T>::value
+                  && !std::is_same<T, bool>::value, "T must be an integer type!");
+
+    if (!reserve(sizeof(T)))
+        return 0;
+
+    const T value = endian::convertToEndian<T>(data, endian);
+    std::memcpy(m_buffer + m_size, &value, sizeof(T));
+    m_size += sizeof(T);
+    KEEG_INSTRUMENT_WRITE(sizeof(T));
+    return sizeof(T);
+}
+
+template<typename T>
+std::size_t BufferedWriter::writePODType(const T &data)
+{
+    static_assert(std::is_pod<T>::value && std::is_trivially_copyable<T>::value, "T must be a POD!");
+
+    if (!reserve(sizeof(T)))
+        return 0;
+
+    std::memcpy(m_buffer + m_size, &data, sizeof(T));
+    m_size += sizeof(T);
+    KEEG_INSTRUMENT_WRITE(sizeof(T));
+    return sizeof(T);
+}
+
+std::size_t BufferedWriter::writeBoolean(const bool &data, const endian::Order &endian)
+{
+    switch (sizeof(bool)) {
+    case sizeof(uint64_t):
+        return writeIntType<uint64_t>(static_cast<uint64_t>(data), endian);
+    case sizeof(uint32_t):
+        return writeIntType<uint32_t>(static_cast<uint32_t>(data), endian);
+    case sizeof(uint16_t):
+        return writeIntType<uint16_t>(static_cast<uint16_t>(data), endian);
+    case sizeof(uint8_t):
+        return writeIntType<uint8_t>(static_cast<uint8_t>(data), endian);
+    default:
+        return 0;
+    }
+}
+
+std::size_t BufferedWriter::writeBytes(const void *data, const std::size_t &length)
+{
+    if (length == 0)
+        return 0;
+
+    if (length <= m_capacity - m_size && m_good)
+    {
+        std::memcpy(m_buffer + m_size, data, length);
+        m_size += length;
+        KEEG_INSTRUMENT_WRITE(length);
+        return length;
+    }
+
+    // Runs bigger than the buffer go straight to the sink rather than through it.
+    if ((m_sink == Sink::Stream || m_sink == Sink::Descriptor) && length >= m_capacity)
+    {
+        if (!flush() || !sinkWrite(static_cast<const uint8_t*>(data), length))
+            return 0;
+
+        KEEG_INSTRUMENT_WRITE(length);
+        return length;
+    }
+
+    if (!reserve(length))
+        return 0;
+
+    std::memcpy(m_buffer + m_size, data, length);
+    m_size += length;
+    KEEG_INSTRUMENT_WRITE(length);
+    return length;
+}
+
+std::size_t BufferedWriter::writeBytes(const std::vector<uint8_t> &data)
+{
+    return writeBytes(data.data(), data.size());
+}
+
+template<typename T>
+std::size_t BufferedWriter::writeArray(const T *data, const std::size_t &count, const endian::Order &endian)
+{
+    static_assert(std::is_integral<T>::value
+                  && !std::is_same<T, bool>::value, "T must be an integer type!");
+
+    if (sizeof(T) == 1 || endian == endian::Order::native)
+        return writeBytes(data, count * sizeof(T));
+
+    const std::size_t bytes = count * sizeof(T);
+    if (m_sink == Sink::Memory || m_sink == Sink::None)
+    {
+        // Nowhere to flush to, so the whole array has to fit at once.
+        if (!reserve(bytes))
+            return 0;
+
+        endian::swapArray<T>(data, reinterpret_cast<T*>(m_buffer + m_size), count);
+        m_size += bytes;
+        KEEG_INSTRUMENT_WRITE(bytes);
+        return bytes;
+    }
+
+    // Swapped in buffer sized chunks, each flushed before the next.
+    std::size_t done = 0;
+    while (done < count)
+    {
+        if (!reserve(sizeof(T)))
+            return 0;
+
+        const std::size_t chunk = std::min(count - done, (m_capacity - m_size) / sizeof(T));
+        endian::swapArray<T>(data + done, reinterpret_cast<T*>(m_buffer + m_size), chunk);
+        m_size += chunk * sizeof(T);
+        done += chunk;
+    }
+
+    KEEG_INSTRUMENT_WRITE(bytes);
+    return bytes;
+}
+
+template<typename T>
+std::size_t BufferedWriter::writePrefixString(const std::string &data, const endian::Order &endian,
+                                              const bool &isNullTerminated)
+{
+    static_assert(std::is_integral<T>::value &&
+                  !std::is_same<T, bool>::value, "T must be any integer type!");
+
+    // c_str() is zero terminated, so the terminator is just one more byte of it.
+    const std::size_t size = data.size() + (isNullTerminated ? 1 : 0);
+    const T length = static_cast<T>(size);
+    if (static_cast<std::size_t>(length) != size || writeIntType<T>(length, endian) == 0)
+        return 0;
+
+    if (size > 0 && writeBytes(data.c_str(), size) == 0)
+        return 0;
+
+    return size + sizeof(T);
+}
+
+std::size_t BufferedWriter::writeBString(const std::string &data)
+{
+    return writePrefixString<uint8_t>(data, endian::Order::native, false);
+}
+
+std::size_t BufferedWriter::writeBZString(const std::string &data)
+{
+    return writePrefixString<uint8_t>(data, endian::Order::native, true);
+}
+
+std::size_t BufferedWriter::writeWString(const std::string &data, const endian::Order &endian)
+{
+    return writePrefixString<uint16_t>(data, endian, false);
+}
+
+std::size_t BufferedWriter::writeWZString(const std::string &data, const endian::Order &endian)
+{
+    return writePrefixString<uint16_t>(data, endian, true);
+}
+
+std::size_t BufferedWriter::writeZString(const std::string &data)
+{
+    return writeBytes(data.c_str(), data.size() + 1);
+}
+
+} // io namespace
+} // keeg namespace
+
+#endif // BUFFEREDWRITER_HPP
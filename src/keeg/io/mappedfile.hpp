@@ -0,0 +1,227 @@
+/*
+ * Copyright (C) 2017 Larry Lopez
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to
+ * deal in the Software without restriction, including without limitation the
+ * rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+ * sell copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ */
+#ifndef MAPPEDFILE_HPP
+#define MAPPEDFILE_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <string>
+#include <utility>
+
+#if defined(_WIN32)
+    #ifndef NOMINMAX
+        #define NOMINMAX
+    #endif
+    #include <windows.h>
+#else
+    #include <fcntl.h>
+    #include <sys/mman.h>
+    #include <sys/stat.h>
+    #include <unistd.h>
+#endif
+
+namespace keeg { namespace io {
+
+/// Read only view of a whole file mapped into memory.
+/// The file must not be truncated while mapped, on POSIX that raises SIGBUS on access.
+class MappedFile
+{
+public:
+    MappedFile() = default;
+    explicit MappedFile(const std::string &path);
+    MappedFile(const MappedFile&) = delete;
+    MappedFile &operator=(const MappedFile&) = delete;
+    MappedFile(MappedFile &&other);
+    MappedFile &operator=(MappedFile &&other);
+    ~MappedFile();
+
+    /// Maps the file, hinting the OS it will be read once from start to end.
+    /// Returns false if it could not be opened or mapped. A file reporting a size of 0 isn't
+    /// mapped either, procfs and sysfs files do that and still have content to read.
+    bool open(const std::string &path);
+    void close();
+
+    bool isOpen() const;
+    const uint8_t *data() const;
+    std::size_t size() const;
+
+private:
+    const uint8_t *m_data = nullptr;
+    std::size_t m_size = 0;
+    bool m_open = false;
+
+    void swap(MappedFile &other);
+};
+
+MappedFile::MappedFile(const std::string &path)
+{
+    open(path);
+}
+
+MappedFile::MappedFile(MappedFile &&other)
+{
+    swap(other);
+}
+
+MappedFile &MappedFile::operator=(MappedFile &&other)
+{
+    if (this != &other)
+    {
+        close();
+        swap(other);
+    }
+
+    return *this;
+}
+
+MappedFile::~MappedFile()
+{
+    close();
+}
+
+bool MappedFile::open(const std::string &path)
+{
+    close();
+
+#if defined(_WIN32)
+    HANDLE file = CreateFileA(path.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr,
+                              OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL | FILE_FLAG_SEQUENTIAL_SCAN, nullptr);
+    if (file == INVALID_HANDLE_VALUE)
+        return false;
+
+    LARGE_INTEGER fileSize;
+    if (!GetFileSizeEx(file, &fileSize) ||
+        static_cast<uint64_t>(fileSize.QuadPart) > std::numeric_limits<std::size_t>::max())
+    {
+        CloseHandle(file);
+        return false;
+    }
+
+    if (fileSize.QuadPart == 0)
+    {
+        CloseHandle(file);
+        return false;
+    }
+
+    HANDLE mapping = CreateFileMappingA(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+    // The view keeps the file and mapping alive, the handles aren't needed any more.
+    CloseHandle(file);
+    if (mapping == nullptr)
+        return false;
+
+    const void *view = MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0);
+    CloseHandle(mapping);
+    if (view == nullptr)
+        return false;
+
+    const std::size_t length = static_cast<std::size_t>(fileSize.QuadPart);
+    #if (_WIN32_WINNT >= 0x0602)
+        // Windows 8 and later can start the reads ahead of the first access.
+        WIN32_MEMORY_RANGE_ENTRY range;
+        range.VirtualAddress = const_cast<void*>(view);
+        range.NumberOfBytes = length;
+        PrefetchVirtualMemory(GetCurrentProcess(), 1, &range, 0);
+    #endif
+#else
+    // Opening a fifo would take the writer's connection away from the reader the caller
+    // falls back to, so anything that isn't a regular file is turned down unopened.
+    struct stat status;
+    if (stat(path.c_str(), &status) != 0 || !S_ISREG(status.st_mode))
+        return false;
+
+    const int fd = ::open(path.c_str(), O_RDONLY);
+    if (fd < 0)
+        return false;
+
+    if (fstat(fd, &status) != 0 || !S_ISREG(status.st_mode) ||
+        static_cast<uint64_t>(status.st_size) > std::numeric_limits<std::size_t>::max())
+    {
+        ::close(fd);
+        return false;
+    }
+
+    if (status.st_size == 0)
+    {
+        ::close(fd);
+        return false;
+    }
+
+    const std::size_t length = static_cast<std::size_t>(status.st_size);
+    void *view = mmap(nullptr, length, PROT_READ, MAP_PRIVATE, fd, 0);
+    // The mapping holds its own reference to the file.
+    ::close(fd);
+    if (view == MAP_FAILED)
+        return false;
+
+    madvise(view, length, MADV_SEQUENTIAL);
+    madvise(view, length, MADV_WILLNEED);
+#endif
+
+    m_data = static_cast<const uint8_t*>(view);
+    m_size = length;
+    m_open = true;
+    return true;
+}
+
+void MappedFile::close()
+{
+    if (m_data != nullptr)
+    {
+#if defined(_WIN32)
+        UnmapViewOfFile(m_data);
+#else
+        munmap(const_cast<uint8_t*>(m_data), m_size);
+#endif
+    }
+
+    m_data = nullptr;
+    m_size = 0;
+    m_open = false;
+}
+
+bool MappedFile::isOpen() const
+{
+    return m_open;
+}
+
+const uint8_t *MappedFile::data() const
+{
+    return m_data;
+}
+
+std::size_t MappedFile::size() const
+{
+    return m_size;
+}
+
+void MappedFile::swap(MappedFile &other)
+{
+    std::swap(m_data, other.m_data);
+    std::swap(m_size, other.m_size);
+    std::swap(m_open, other.m_open);
+}
+
+} // io namespace
+} // keeg namespace
+
+#endif // MAPPEDFILE_HPP
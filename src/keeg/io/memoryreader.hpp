@@ -0,0 +1,359 @@
+/*
+ * Copyright (C) 2017 Larry Lopez
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to
+ * deal in the Software without restriction, including without limitation the
+ * rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+ * sell copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ */
+#ifndef MEMORYREADER_HPP
+#define MEMORYREADER_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <string>
+#include <type_traits>
+#include <vector>
+#include <keeg/common/instrumentation.hpp>
+#include <keeg/endian/conversion.hpp>
+#include <keeg/io/mappedfile.hpp>
+#include <keeg/io/views.hpp>
+
+namespace keeg { namespace io {
+
+/// Cursor over a block of memory with the same reads as binaryreaders.hpp. Nothing is
+/// copied or allocated, strings and byte runs come back as views into the buffer.
+/// Checked reads return the bytes consumed, or 0 with the position unchanged when there
+/// isn't enough data left. The Unchecked reads skip the bounds test for hot loops where
+/// the caller has already made sure of remaining(), they are undefined past the end.
+class MemoryReader
+{
+public:
+    MemoryReader();
+    MemoryReader(const void *data, const std::size_t &size);
+    explicit MemoryReader(const ByteView &view);
+    /// The file must stay open while the reader is in use.
+    explicit MemoryReader(const MappedFile &file);
+
+    const uint8_t *data() const;
+    std::size_t size() const;
+    std::size_t position() const;
+    std::size_t remaining() const;
+    /// Pointer to the next unread byte.
+    const uint8_t *current() const;
+    bool atEnd() const;
+    bool canRead(const std::size_t &length) const;
+
+    /// Moves to an absolute position, false if it's past the end.
+    bool seek(const std::size_t &position);
+    /// Moves forward length bytes, false if there aren't that many.
+    bool skip(const std::size_t &length);
+
+    /// Endian aware integer read.
+    template<typename T>
+    std::size_t readIntType(T &data, const endian::Order &endian = endian::Order::native);
+    template<typename T>
+    T readIntUnchecked(const endian::Order &endian = endian::Order::native);
+
+    /// Plain copy of a POD, usually a simple struct.
+    template<typename T>
+    std::size_t readPODType(T &data);
+    template<typename T>
+    T readPODUnchecked();
+
+    /// bool stored with the size of bool on this platform, as readBoolean in binaryreaders.hpp.
+    std::size_t readBoolean(bool &data, const endian::Order &endian = endian::Order::native);
+
+    /// View of the next length bytes.
+    std::size_t readBytes(ByteView &data, const std::size_t &length);
+    ByteView readBytesUnchecked(const std::size_t &length);
+
+    /// String prefixed with a T length. With isNullTerminated the view ends at the first
+    /// zero, the whole length is still consumed.
+    template<typename T>
+    std::size_t readPrefixString(TextView &data, const endian::Order &endian = endian::Order::native,
+                                 const bool &isNullTerminated = false);
+    /// String prefixed with a uint8_t length. NOT zero terminated.
+    std::size_t readBString(TextView &data);
+    /// String prefixed with a uint8_t length. zero terminated.
+    std::size_t readBZString(TextView &data);
+    /// String prefixed with a uint16 length. NOT zero terminated.
+    std::size_t readWString(TextView &data, const endian::Order &endian = endian::Order::native);
+    /// String prefixed with a uint16 length. zero terminated.
+    std::size_t readWZString(TextView &data, const endian::Order &endian = endian::Order::native);
+    /// Zero terminated string, returns the text length + 1 for the terminator.
+    /// Fails when there is no terminator before the end of the buffer.
+    std::size_t readZString(TextView &data);
+
+private:
+    const uint8_t *m_data;
+    std::size_t m_size;
+    std::size_t m_position;
+};
+
+MemoryReader::MemoryReader() : m_data(nullptr), m_size(0), m_position(0)
+{ }
+
+MemoryReader::MemoryReader(const void *data, const std::size_t &size) :
+    m_data(static_cast<const uint8_t*>(data)), m_size(data != nullptr ? size : 0), m_position(0)
+{ }
+
+MemoryReader::MemoryReader(const ByteView &view) : MemoryReader(view.data, view.size)
+{ }
+
+MemoryReader::MemoryReader(const MappedFile &file) : MemoryReader(file.data(), file.size())
+{ }
+
+const uint8_t *MemoryReader::data() const
+{
+    return m_data;
+}
+
+std::size_t MemoryReader::size() const
+{
+    return m_size;
+}
+
+std::size_t MemoryReader::position() const
+{
+    return m_position;
+}
+
+std::size_t MemoryReader::remaining() const
+{
+    return m_size - m_position;
+}
+
+const uint8_t *MemoryReader::current() const
+{
+    return m_data + m_position;
+}
+
+bool MemoryReader::atEnd() const
+{
+    return m_position == m_size;
+}
+
+bool MemoryReader::canRead(const std::size_t &length) const
+{
+    return length <= m_size - m_position;
+}
+
+bool MemoryReader::seek(const std::size_t &position)
+{
+    if (position > m_size)
+        return false;
+
+    m_position = position;
+    return true;
+}
+
+bool MemoryReader::skip(const std::size_t &length)
+{
+    if (!canRead(length))
+        return false;
+
+    m_position += length;
+    return true;
+}
+
+template<typename T>
+std::size_t MemoryReader::readIntType(T &data, const endian::Order &endian)
+{
+    static_assert(std::is_integral<T>::value
+                  && !std::is_same<T, bool>::value, "T must be an integer type!");
+
+    if (!canRead(sizeof(T)))
+        return 0;
+
+    data = readIntUnchecked<T>(endian);
+    return sizeof(T);
+}
+
+template<typename T>
+T MemoryReader::readIntUnchecked(const endian::Order &endian)
+{
+    static_assert(std::is_integral<T>::value
+                  && !std::is_same<T, bool>::value, "T must be an integer type!");
+
+    T value;
+    std::memcpy(&value, m_data + m_position, sizeof(T));
+    m_position += sizeof(T);
+    KEEG_INSTRUMENT_READ(sizeof(T));
+    return endian::convertFromEndian<T>(value, endian);
+}
+
+template<typename T>
+std::size_t MemoryReader::readPODType(T &data)
+{
+    static_assert(std::is_pod<T>::value && std::is_trivially_copyable<T>::value, "T must be a POD!");
+
+    if (!canRead(sizeof(T)))
+        return 0;
+
+    data = readPODUnchecked<T>();
+    return sizeof(T);
+}
+
+template<typename T>
+T MemoryReader::readPODUnchecked()
+{
+    static_assert(std::is_pod<T>::value && std::is_trivially_copyable<T>::value, "T must be a POD!");
+
+    T value;
+    std::memcpy(&value, m_data + m_position, sizeof(T));
+    m_position += sizeof(T);
+    KEEG_INSTRUMENT_READ(sizeof(T));
+    return value;
+}
+
+std::size_t MemoryReader::readBoolean(bool &data, const endian::Order &endian)
+{
+    switch (sizeof(bool)) {
+    case sizeof(uint64_t):
+    {
+        uint64_t buffer64;
+        const std::size_t status = readIntType<uint64_t>(buffer64, endian);
+        if (status)
+            data = static_cast<bool>(buffer64);
+        return status;
+    }
+    case sizeof(uint32_t):
+    {
+        uint32_t buffer32;
+        const std::size_t status = readIntType<uint32_t>(buffer32, endian);
+        if (status)
+            data = static_cast<bool>(buffer32);
+        return status;
+    }
+    case sizeof(uint16_t):
+    {
+        uint16_t buffer16;
+        const std::size_t status = readIntType<uint16_t>(buffer16, endian);
+        if (status)
+            data = static_cast<bool>(buffer16);
+        return status;
+    }
+    case sizeof(uint8_t):
+    {
+        uint8_t buffer;
+        const std::size_t status = readIntType<uint8_t>(buffer, endian);
+        if (status)
+            data = static_cast<bool>(buffer);
+        return status;
+    }
+    default:
+        return 0;
+    }
+}
+
+std::size_t MemoryReader::readBytes(ByteView &data, const std::size_t &length)
+{
+    if (!canRead(length))
+        return 0;
+
+    data = readBytesUnchecked(length);
+    return length;
+}
+
+ByteView MemoryReader::readBytesUnchecked(const std::size_t &length)
+{
+    ByteView view;
+    view.data = m_data + m_position;
+    view.size = length;
+    m_position += length;
+    KEEG_INSTRUMENT_READ(length);
+    return view;
+}
+
+template<typename T>
+std::size_t MemoryReader::readPrefixString(TextView &data, const endian::Order &endian, const bool &isNullTerminated)
+{
+    static_assert(std::is_integral<T>::value &&
+                  !std::is_same<T, bool>::value, "T must be any integer type!");
+
+    const std::size_t start = m_position;
+    T length;
+    if (readIntType<T>(length, endian) == 0)
+        return 0;
+
+    const std::size_t size = static_cast<std::size_t>(length);
+    if (!canRead(size))
+    {
+        m_position = start;
+        return 0;
+    }
+
+    const char *text = reinterpret_cast<const char*>(m_data + m_position);
+    m_position += size;
+    KEEG_INSTRUMENT_READ(size);
+
+    std::size_t textSize = size;
+    if (isNullTerminated)
+    {
+        const void *terminator = std::memchr(text, '\0', size);
+        if (terminator != nullptr)
+            textSize = static_cast<std::size_t>(static_cast<const char*>(terminator) - text);
+    }
+
+    data.data = text;
+    data.size = textSize;
+    return size + sizeof(T);
+}
+
+std::size_t MemoryReader::readBString(TextView &data)
+{
+    return readPrefixString<uint8_t>(data, endian::Order::native, false);
+}
+
+std::size_t MemoryReader::readBZString(TextView &data)
+{
+    return readPrefixString<uint8_t>(data, endian::Order::native, true);
+}
+
+std::size_t MemoryReader::readWString(TextView &data, const endian::Order &endian)
+{
+    return readPrefixString<uint16_t>(data, endian, false);
+}
+
+std::size_t MemoryReader::readWZString(TextView &data, const endian::Order &endian)
+{
+    return readPrefixString<uint16_t>(data, endian, true);
+}
+
+std::size_t MemoryReader::readZString(TextView &data)
+{
+    if (atEnd())
+        return 0;
+
+    const uint8_t *text = m_data + m_position;
+    const void *terminator = std::memchr(text, '\0', remaining());
+    if (terminator == nullptr)
+        return 0;
+
+    const std::size_t length = static_cast<std::size_t>(static_cast<const uint8_t*>(terminator) - text);
+    data.data = reinterpret_cast<const char*>(text);
+    data.size = length;
+    m_position += length + 1;
+    KEEG_INSTRUMENT_READ(length + 1);
+    return length + 1;
+}
+
+} // io namespace
+} // keeg namespace
+
+#endif // MEMORYREADER_HPP
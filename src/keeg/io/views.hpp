@@ -0,0 +1,72 @@
+/*
+ * Copyright (C) 2017 Larry Lopez
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to
+ * deal in the Software without restriction, including without limitation the
+ * rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+ * sell copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ */
+#ifndef VIEWS_HPP
+#define VIEWS_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <string>
+#include <vector>
+
+namespace keeg { namespace io {
+
+/// Bytes inside a buffer, valid for as long as the buffer is. A span for C++14.
+struct ByteView
+{
+    const uint8_t *data = nullptr;
+    std::size_t size = 0;
+
+    const uint8_t *begin() const { return data; }
+    const uint8_t *end() const { return data + size; }
+    bool empty() const { return size == 0; }
+    const uint8_t &operator[](const std::size_t &index) const { return data[index]; }
+
+    std::vector<uint8_t> toVector() const { return std::vector<uint8_t>(begin(), end()); }
+};
+
+/// Characters inside a buffer, valid for as long as the buffer is. A string_view for C++14.
+struct TextView
+{
+    const char *data = nullptr;
+    std::size_t size = 0;
+
+    const char *begin() const { return data; }
+    const char *end() const { return data + size; }
+    bool empty() const { return size == 0; }
+    const char &operator[](const std::size_t &index) const { return data[index]; }
+
+    std::string toString() const { return std::string(data, size); }
+
+    bool operator==(const TextView &other) const
+    {
+        return size == other.size && (size == 0 || std::memcmp(data, other.data, size) == 0);
+    }
+    bool operator!=(const TextView &other) const { return !(*this == other); }
+    bool operator==(const std::string &text) const { return *this == TextView{ text.data(), text.size() }; }
+    bool operator!=(const std::string &text) const { return !(*this == text); }
+};
+
+} // io namespace
+} // keeg namespace
+
+#endif // VIEWS_HPP